@@ -4,6 +4,7 @@
 #include <QEventLoop>
 #include <QTimer>
 #include <QUrlQuery>
+#include "batchcbor/batchcbor.h"
 #include "logger/logger.h"
 
 APIManager::APIManager(QObject *parent)
@@ -410,7 +411,20 @@ bool APIManager::endAfkPeriod(const QUuid &afkId, const QJsonObject &afkData, QJ
 }
 
 bool APIManager::sendRequest(const QString &endpoint, const QJsonObject &data, QJsonObject &responseData,
-                           const QString &method, bool requiresAuth)
+                           const QString &method, bool requiresAuth,
+                           const QHash<QByteArray, QByteArray> &extraHeaders)
+{
+    QByteArray body;
+    if (method == "POST" || method == "PUT") {
+        body = QJsonDocument(data).toJson();
+    }
+
+    return sendRequest(endpoint, body, "application/json", responseData, method, requiresAuth, extraHeaders);
+}
+
+bool APIManager::sendRequest(const QString &endpoint, const QByteArray &body, const QByteArray &contentType,
+                           QJsonObject &responseData, const QString &method, bool requiresAuth,
+                           const QHash<QByteArray, QByteArray> &extraHeaders)
 {
     if (!m_initialized) {
         LOG_ERROR("APIManager not initialized");
@@ -423,7 +437,10 @@ bool APIManager::sendRequest(const QString &endpoint, const QJsonObject &data, Q
     // Create request
     QNetworkRequest request;
     request.setUrl(QUrl(url));
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    request.setHeader(QNetworkRequest::ContentTypeHeader, contentType);
+    for (auto it = extraHeaders.constBegin(); it != extraHeaders.constEnd(); ++it) {
+        request.setRawHeader(it.key(), it.value());
+    }
 
     // Add authentication if required
     if (requiresAuth) {
@@ -475,15 +492,15 @@ bool APIManager::sendRequest(const QString &endpoint, const QJsonObject &data, Q
     if (method == "GET") {
         reply = m_networkManager->get(request);
     } else if (method == "POST") {
-        QJsonDocument doc(data);
-        QByteArray jsonData = doc.toJson();
-        LOG_DEBUG(QString("POST data: %1").arg(QString::fromUtf8(jsonData)));
-        reply = m_networkManager->post(request, jsonData);
+        if (contentType == "application/json") {
+            LOG_DEBUG(QString("POST data: %1").arg(QString::fromUtf8(body)));
+        }
+        reply = m_networkManager->post(request, body);
     } else if (method == "PUT") {
-        QJsonDocument doc(data);
-        QByteArray jsonData = doc.toJson();
-        LOG_DEBUG(QString("PUT data: %1").arg(QString::fromUtf8(jsonData)));
-        reply = m_networkManager->put(request, jsonData);
+        if (contentType == "application/json") {
+            LOG_DEBUG(QString("PUT data: %1").arg(QString::fromUtf8(body)));
+        }
+        reply = m_networkManager->put(request, body);
     } else if (method == "DELETE") {
         reply = m_networkManager->deleteResource(request);
     } else {
@@ -537,7 +554,7 @@ bool APIManager::sendRequest(const QString &endpoint, const QJsonObject &data, Q
                     LOG_INFO("Token refreshed successfully, retrying request");
 
                     // Retry the request with the new token
-                    return sendRequest(endpoint, data, responseData, method, requiresAuth);
+                    return sendRequest(endpoint, body, contentType, responseData, method, requiresAuth, extraHeaders);
                 } else {
                     LOG_ERROR("Failed to refresh token");
                 }
@@ -1250,7 +1267,7 @@ bool APIManager::processBatch(const QJsonObject &batchData, QJsonObject &respons
         return false;
     }
 
-    return sendRequest("batch", batchData, responseData);
+    return sendBatchRequest("batch", batchData, responseData);
 }
 
 bool APIManager::processSessionBatch(const QUuid &sessionId, const QJsonObject &batchData, QJsonObject &responseData)
@@ -1262,7 +1279,45 @@ bool APIManager::processSessionBatch(const QUuid &sessionId, const QJsonObject &
 
     QString endpoint = "sessions/" + sessionId.toString().remove('{').remove('}') + "/batch";
 
-    return sendRequest(endpoint, batchData, responseData);
+    return sendBatchRequest(endpoint, batchData, responseData);
+}
+
+bool APIManager::sendBatchRequest(const QString &endpoint, const QJsonObject &batchData, QJsonObject &responseData)
+{
+    // After a rejection the server is asked again now and then, since it may have been upgraded
+    const bool cbor = m_cborBatches && (!m_cborRejected.isValid() || m_cborRejected.hasExpired(CborReprobeMs));
+    if (cbor) {
+        QByteArray body = BatchCbor::encode(batchData);
+        LOG_DEBUG(QString("Sending batch as CBOR (%1 bytes)").arg(body.size()));
+
+        m_lastErrorCode = 0;
+        if (sendRequest(endpoint, body, BatchCbor::contentType(), responseData, "POST", true, batchHeaders(batchData))) {
+            m_cborRejected.invalidate();
+            return true;
+        }
+
+        // Only a rejected format means nothing was written; any other failure is the batch's own
+        if (m_lastErrorCode != 415 && m_lastErrorMessage != QLatin1String(BatchCbor::UnsupportedFormatMessage)) {
+            return false;
+        }
+        LOG_WARNING(QString("Server rejected CBOR batch (HTTP %1), sending JSON for the next %2 minutes")
+                   .arg(m_lastErrorCode).arg(CborReprobeMs / 60000));
+        m_cborRejected.start();
+        responseData = QJsonObject();
+    }
+
+    return sendRequest(endpoint, batchData, responseData, "POST", true, batchHeaders(batchData));
+}
+
+QHash<QByteArray, QByteArray> APIManager::batchHeaders(const QJsonObject &batchData) const
+{
+    // Resending a batch with the same key lets the server answer from its stored response
+    QHash<QByteArray, QByteArray> headers;
+    QString batchId = batchData["client_batch_id"].toString();
+    if (!batchId.isEmpty()) {
+        headers.insert("Idempotency-Key", batchId.toUtf8());
+    }
+    return headers;
 }
 
 bool APIManager::ping(QJsonObject &responseData)
@@ -2,6 +2,7 @@
 #ifndef APIMANAGER_H
 #define APIMANAGER_H
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
@@ -10,6 +11,7 @@
 #include <QUuid>
 #include <QDate>
 #include <QMutex>
+#include <QHash>
 
 class APIManager : public QObject
 {
@@ -101,6 +103,10 @@ public:
     bool processBatch(const QJsonObject &batchData, QJsonObject &responseData);
     bool processSessionBatch(const QUuid &sessionId, const QJsonObject &batchData, QJsonObject &responseData);
 
+    // Send batches as columnar CBOR; JSON is sent for a while whenever the server rejects the format
+    void setCborBatchesEnabled(bool enabled) { m_cborBatches = enabled; }
+    bool cborBatchesEnabled() const { return m_cborBatches; }
+
     // Server status
     bool ping(QJsonObject &responseData);
     bool getServerHealth(QJsonObject &responseData);
@@ -115,7 +121,13 @@ public:
 
 private:
     bool sendRequest(const QString &endpoint, const QJsonObject &data, QJsonObject &responseData,
-                    const QString &method = "POST", bool requiresAuth = true);
+                    const QString &method = "POST", bool requiresAuth = true,
+                    const QHash<QByteArray, QByteArray> &extraHeaders = QHash<QByteArray, QByteArray>());
+    bool sendRequest(const QString &endpoint, const QByteArray &body, const QByteArray &contentType,
+                    QJsonObject &responseData, const QString &method, bool requiresAuth,
+                    const QHash<QByteArray, QByteArray> &extraHeaders);
+    bool sendBatchRequest(const QString &endpoint, const QJsonObject &batchData, QJsonObject &responseData);
+    QHash<QByteArray, QByteArray> batchHeaders(const QJsonObject &batchData) const;
     bool processReply(QNetworkReply *reply, QJsonObject &responseData);
 
     QNetworkAccessManager *m_networkManager;
@@ -127,6 +139,9 @@ private:
     QString m_machineId;
     int m_lastErrorCode = 0;
     QString m_lastErrorMessage;
+    bool m_cborBatches = true;
+    QElapsedTimer m_cborRejected; // started when the server last answered CBOR with 415
+    static constexpr qint64 CborReprobeMs = 30 * 60 * 1000;
 
 };
 
@@ -21,6 +21,7 @@ SyncManager::SyncManager(APIManager* apiManager, SessionManager* sessionManager,
     , m_initialized(false)
     , m_maxQueueSize(1000)
     , m_syncInterval(60000)
+    , m_nextClientSeq(QDateTime::currentMSecsSinceEpoch() * 1000)
 {
     // Set up sync timer
     connect(&m_syncTimer, &QTimer::timeout, this, &SyncManager::onSyncTimerTriggered);
@@ -249,6 +250,21 @@ bool SyncManager::queueData(DataType type, const QUuid& sessionId, const QJsonOb
     queuedData.data = data;
     queuedData.timestamp = timestamp.isValid() ? timestamp : QDateTime::currentDateTime();
     queuedData.retryCount = 0;
+
+    // Rows sent in batches get a sequence number that stays with them across resends.
+    // Seeding the counter from the clock keeps it increasing across restarts.
+    if (type == DataType::SessionEvent || type == DataType::ActivityEvent || type == DataType::SystemMetrics) {
+        QMutexLocker seqLocker(&m_queueMutex);
+        if (!queuedData.data.contains("client_seq")) {
+            queuedData.data["client_seq"] = ++m_nextClientSeq;
+        }
+
+        // Stamp the capture time so a queued row is not recorded at the time it reaches the server
+        const QString timeKey = type == DataType::SystemMetrics ? "measurement_time" : "event_time";
+        if (!queuedData.data.contains(timeKey)) {
+            queuedData.data[timeKey] = queuedData.timestamp.toUTC().toString(Qt::ISODateWithMs);
+        }
+    }
     
     // If sync interval is 0, send immediately
     if (m_syncInterval <= 0 && !m_offlineMode) {
@@ -551,6 +567,8 @@ bool SyncManager::sendBatchedData(const QUuid& sessionId, const QJsonArray& sess
         batchData["system_metrics"] = systemMetrics;
     }
 
+    batchData["client_batch_id"] = clientBatchId(sessionId, batchData);
+
     QJsonObject responseData;
 
     // Use the general batch endpoint directly instead of trying session-specific endpoint first
@@ -758,4 +776,20 @@ bool SyncManager::processAppUsageData(const QueuedData& item) {
     }
 
     return success;
-}
\ No newline at end of file
+}
+
+QString SyncManager::clientBatchId(const QUuid& sessionId, const QJsonObject& batchData)
+{
+    // Derived from the rows' sequence numbers so the same rows always resend under the same key
+    QByteArray seqs;
+    for (const char* key : { "session_events", "activity_events", "system_metrics" }) {
+        const QJsonArray rows = batchData[key].toArray();
+        for (const QJsonValue& row : rows) {
+            seqs += QByteArray::number(row.toObject()["client_seq"].toInteger());
+            seqs += ',';
+        }
+        seqs += ';';
+    }
+
+    return QUuid::createUuidV5(sessionId, seqs).toString(QUuid::WithoutBraces);
+}
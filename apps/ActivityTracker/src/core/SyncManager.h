@@ -83,6 +83,9 @@ private:
     QDateTime m_lastSyncTime;
     QDateTime m_lastConnectionCheck;
 
+    // Per-row client_seq sent with batched rows; the server drops sequence numbers it already committed
+    qint64 m_nextClientSeq;
+
     int m_consecutiveFailures = 0;
     static const int MAX_CONSECUTIVE_FAILURES = 5;
     bool m_enablePersistence = false;
@@ -104,6 +107,7 @@ private:
     bool registerMachine(const QString& hostname, QString& machineId);
     bool authenticateUser(const QString& username, const QString& machineId);
     void storeFailedBatchForRetry(const QUuid& sessionId, const QJsonObject& batchData);
+    static QString clientBatchId(const QUuid& sessionId, const QJsonObject& batchData);
 };
 
 #endif // SYNCMANAGER_H
\ No newline at end of file
@@ -75,6 +75,7 @@ void ConfigManager::loadDefaults()
     m_defaultUsername = "";
     m_logLevel = "info";
     m_logFilePath = "";
+    m_logCategories = "";
 }
 
 QString ConfigManager::configFilePath() const
@@ -149,6 +150,7 @@ bool ConfigManager::loadLocalConfig()
         m_defaultUsername = m_settings->value("DefaultUsername", m_defaultUsername).toString();
         m_logLevel = m_settings->value("LogLevel", m_logLevel).toString();
         m_logFilePath = m_settings->value("LogFilePath", m_logFilePath).toString();
+        m_logCategories = m_settings->value("LogCategories", m_logCategories).toString();
 
         // Validate and correct settings
         if (m_dataSendInterval < 0) {
@@ -180,6 +182,9 @@ bool ConfigManager::loadLocalConfig()
         Logger::instance()->setLogLevel(Logger::Error);
     }
 
+    // Per-category overrides, e.g. "SyncManager=debug" to chase a sync problem quietly
+    Logger::instance()->setCategoryLevels(m_logCategories);
+
     if (!m_logFilePath.isEmpty()) {
         Logger::instance()->setLogFile(m_logFilePath);
     }
@@ -218,6 +223,7 @@ bool ConfigManager::saveLocalConfig()
         m_settings->setValue("DefaultUsername", m_defaultUsername);
         m_settings->setValue("LogLevel", m_logLevel);
         m_settings->setValue("LogFilePath", m_logFilePath);
+        m_settings->setValue("LogCategories", m_logCategories);
 
         // Ensure settings are written to disk
         m_settings->sync();
@@ -314,6 +320,12 @@ QString ConfigManager::logFilePath() const
     return m_logFilePath;
 }
 
+QString ConfigManager::logCategories() const
+{
+    QMutexLocker locker(const_cast<QMutex*>(&m_mutex));
+    return m_logCategories;
+}
+
 // Setter implementations remain the same
 void ConfigManager::setServerUrl(const QString &url)
 {
@@ -423,4 +435,14 @@ void ConfigManager::setLogFilePath(const QString &path)
         m_logFilePath = path;
         emit configChanged();
     }
+}
+
+void ConfigManager::setLogCategories(const QString &categories)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_logCategories != categories) {
+        m_logCategories = categories;
+        Logger::instance()->setCategoryLevels(categories);
+        emit configChanged();
+    }
 }
\ No newline at end of file
@@ -31,6 +31,7 @@ public:
     QString defaultUsername() const;
     QString logLevel() const;
     QString logFilePath() const;
+    QString logCategories() const;
 
     // Setters
     void setServerUrl(const QString &url);
@@ -45,6 +46,7 @@ public:
     void setDefaultUsername(const QString &username);
     void setLogLevel(const QString &level);
     void setLogFilePath(const QString &path);
+    void setLogCategories(const QString &categories);
 
     // Configuration operations
     bool loadLocalConfig();
@@ -81,6 +83,7 @@ private:
     QString m_defaultUsername;
     QString m_logLevel;
     QString m_logFilePath;
+    QString m_logCategories;
     bool m_initialized;
 };
 #endif // CONFIGMANAGER_H
\ No newline at end of file
@@ -38,7 +38,12 @@ int main(int argc, char *argv[])
 
     parser.process(app);
 
-    // Initialize logger
+    // Initialize logger; keep the agent's footprint on laptop disks bounded
+    Logger::RotationPolicy rotationPolicy;
+    rotationPolicy.maxFileSize = 10 * 1024 * 1024;
+    rotationPolicy.maxRetainedFiles = 5;
+    Logger::instance()->setRotationPolicy(rotationPolicy);
+
     if (parser.isSet(logFileOption)) {
         Logger::instance()->setLogFile(parser.value(logFileOption));
     } else {
@@ -0,0 +1,165 @@
+#include <QtTest/QtTest>
+#include <QCborMap>
+#include <QCborValue>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "batchcbor/batchcbor.h"
+
+class BatchCborTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testRoundTrip() {
+        QJsonObject batch;
+        batch["session_id"] = "3f2a6c1e-8b7d-4e2f-9a10-5c6d7e8f9a0b";
+        batch["client_batch_id"] = "batch-42";
+        batch["sequence"] = 7;
+
+        QJsonArray activityEvents;
+        for (int i = 0; i < 5; ++i) {
+            QJsonObject event;
+            event["event_type"] = i % 2 == 0 ? "mouse_click" : "keyboard";
+            event["event_time"] = QDateTime(QDate(2024, 3, 1), QTime(9, 0, i, i * 7), Qt::UTC)
+                                      .toString(Qt::ISODateWithMs);
+            event["client_seq"] = 100 + i;
+            if (i != 3) {
+                // Missing keys must stay missing
+                event["app_id"] = QString("app-%1").arg(i % 2);
+            }
+            QJsonObject data;
+            data["x"] = i * 10;
+            data["label"] = "button";
+            event["event_data"] = data;
+            activityEvents.append(event);
+        }
+        batch["activity_events"] = activityEvents;
+
+        QJsonArray systemMetrics;
+        for (int i = 0; i < 3; ++i) {
+            QJsonObject metric;
+            metric["measurement_time"] = QDateTime(QDate(2024, 3, 1), QTime(9, i, 0), Qt::UTC).toString(Qt::ISODate);
+            metric["cpu_usage"] = 12.5 + i;
+            metric["gpu_usage"] = i == 1 ? QJsonValue() : QJsonValue(3.25);
+            systemMetrics.append(metric);
+        }
+        batch["system_metrics"] = systemMetrics;
+
+        // Times the encoder cannot reproduce exactly stay plain strings
+        QJsonArray sessionEvents;
+        QJsonObject sessionEvent;
+        sessionEvent["event_type"] = "lock";
+        sessionEvent["event_time"] = "2024-03-01T09:00:00+02:00";
+        sessionEvents.append(sessionEvent);
+        batch["session_events"] = sessionEvents;
+
+        QJsonObject decoded;
+        QString error;
+        bool unsupportedVersion = false;
+        QVERIFY2(BatchCbor::decode(BatchCbor::encode(batch), decoded, error, &unsupportedVersion), qPrintable(error));
+        QVERIFY(!unsupportedVersion);
+        QCOMPARE(decoded, batch);
+    }
+
+    void testEmptyBatch() {
+        QJsonObject batch;
+        batch["session_id"] = "3f2a6c1e-8b7d-4e2f-9a10-5c6d7e8f9a0b";
+        batch["activity_events"] = QJsonArray();
+
+        QJsonObject decoded;
+        QString error;
+        QVERIFY2(BatchCbor::decode(BatchCbor::encode(batch), decoded, error), qPrintable(error));
+        QCOMPARE(decoded, batch);
+    }
+
+    void testOtherVersionIsUnsupported() {
+        QCborMap root = QCborValue::fromCbor(BatchCbor::encode(QJsonObject())).toMap();
+        root[QLatin1String("v")] = BatchCbor::FormatVersion + 1;
+
+        QJsonObject decoded;
+        QString error;
+        bool unsupportedVersion = false;
+        QVERIFY(!BatchCbor::decode(root.toCborValue().toCbor(), decoded, error, &unsupportedVersion));
+        QVERIFY(unsupportedVersion);
+    }
+
+    void testMalformedBodyIsNotAVersionMismatch() {
+        QJsonObject decoded;
+        QString error;
+        bool unsupportedVersion = false;
+        QVERIFY(!BatchCbor::decode(QByteArray("not cbor"), decoded, error, &unsupportedVersion));
+        QVERIFY(!unsupportedVersion);
+        QVERIFY(!error.isEmpty());
+    }
+
+    void testRepresentativeBatchSize() {
+        // Five minutes of agent rows: keyboard and mouse batches every second, clicks, a metric sample a minute
+        const QJsonObject batch = agentBatch(300);
+        const QByteArray cbor = BatchCbor::encode(batch);
+        const QByteArray json = QJsonDocument(batch).toJson(QJsonDocument::Compact);
+
+        qInfo("%lld rows: CBOR %lld bytes, compact JSON %lld bytes (%.1fx)",
+              static_cast<long long>(batch["activity_events"].toArray().size() + batch["system_metrics"].toArray().size()),
+              static_cast<long long>(cbor.size()), static_cast<long long>(json.size()),
+              double(json.size()) / cbor.size());
+        QVERIFY2(cbor.size() * 5 <= json.size(), "CBOR body is not a fifth of the JSON body");
+
+        QJsonObject decoded;
+        QString error;
+        QVERIFY2(BatchCbor::decode(cbor, decoded, error), qPrintable(error));
+        QCOMPARE(decoded, batch);
+    }
+
+    void testContentType() {
+        QVERIFY(BatchCbor::isSupportedContentType(BatchCbor::contentType()));
+        QVERIFY(BatchCbor::isSupportedContentType("application/cbor"));
+        QVERIFY(BatchCbor::isCborContentType("application/cbor; version=99"));
+        QVERIFY(!BatchCbor::isSupportedContentType("application/cbor; version=99"));
+        QVERIFY(!BatchCbor::isCborContentType("application/json"));
+    }
+
+private:
+    // Rows shaped like the ones ActivityTrackerClient queues, stamped and numbered as SyncManager does
+    static QJsonObject agentBatch(int seconds) {
+        const QDateTime start(QDate(2026, 3, 1), QTime(9, 0), Qt::UTC);
+        qint64 seq = start.toMSecsSinceEpoch() * 1000;
+        QJsonArray activityEvents;
+        QJsonArray systemMetrics;
+
+        auto stamp = [&start](int s, int offsetMs) {
+            return start.addMSecs(s * 1000LL + offsetMs).toString(Qt::ISODateWithMs);
+        };
+
+        for (int s = 0; s < seconds; ++s) {
+            activityEvents.append(QJsonObject{
+                {"type", "keyboard"}, {"count", 1 + (s * 7) % 12}, {"event_type", "keyboard"},
+                {"client_seq", ++seq}, {"event_time", stamp(s, (s * 13) % 40)}});
+            activityEvents.append(QJsonObject{
+                {"type", "move"}, {"count", 1 + (s * 11) % 60}, {"x", (s * 37) % 1920}, {"y", (s * 53) % 1080},
+                {"event_type", "mouse_move"}, {"client_seq", ++seq}, {"event_time", stamp(s, 40 + (s * 17) % 40)}});
+            if (s % 3 == 0) {
+                activityEvents.append(QJsonObject{
+                    {"type", "click"}, {"count", 1 + s % 3}, {"event_type", "mouse_click"},
+                    {"client_seq", ++seq}, {"event_time", stamp(s, 80 + (s * 19) % 40)}});
+            }
+            if (s % 60 == 0) {
+                systemMetrics.append(QJsonObject{
+                    {"cpu_usage", 12.5 + (s % 7) * 3.25}, {"gpu_usage", 1.75 + (s % 5) * 0.5},
+                    {"memory_usage", 41.25 + (s % 3) * 2.5}, {"client_seq", ++seq},
+                    {"measurement_time", stamp(s, 0)}});
+            }
+        }
+
+        QJsonObject batch;
+        batch["session_id"] = "3f2a6c1e-8b7d-4e2f-9a10-5c6d7e8f9a0b";
+        batch["client_batch_id"] = "batch-42";
+        batch["activity_events"] = activityEvents;
+        batch["system_metrics"] = systemMetrics;
+        return batch;
+    }
+};
+
+QTEST_MAIN(BatchCborTest)
+#include "BatchCborTest.moc"
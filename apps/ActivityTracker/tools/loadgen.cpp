@@ -0,0 +1,1017 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QMutex>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTextStream>
+#include <QTimer>
+#include <QUuid>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <random>
+
+#include "batchcbor/batchcbor.h"
+
+// Simulates a fleet of tracker agents against ActivityTrackerAPI. Each agent
+// makes the requests the service makes through APIManager, with the same
+// bodies, but asynchronously so thousands fit in one process.
+
+namespace {
+
+const char* const ServiceId = "activity-tracker-service";
+
+struct AppEntry {
+    const char* name;
+    const char* path;
+};
+
+const AppEntry AppCatalog[] = {
+    { "chrome.exe", "C:\\Program Files\\Google\\Chrome\\Application\\chrome.exe" },
+    { "outlook.exe", "C:\\Program Files\\Microsoft Office\\root\\Office16\\OUTLOOK.EXE" },
+    { "Teams.exe", "C:\\Program Files\\WindowsApps\\MSTeams\\ms-teams.exe" },
+    { "code.exe", "C:\\Program Files\\Microsoft VS Code\\Code.exe" },
+    { "explorer.exe", "C:\\Windows\\explorer.exe" },
+    { "excel.exe", "C:\\Program Files\\Microsoft Office\\root\\Office16\\EXCEL.EXE" },
+    { "maya.exe", "C:\\Program Files\\Autodesk\\Maya2024\\bin\\maya.exe" },
+    { "houdini.exe", "C:\\Program Files\\Side Effects Software\\Houdini 20.0\\bin\\houdini.exe" },
+    { "nuke.exe", "C:\\Program Files\\Nuke15.0v2\\Nuke15.0.exe" },
+    { "photoshop.exe", "C:\\Program Files\\Adobe\\Adobe Photoshop 2024\\Photoshop.exe" },
+    { "blender.exe", "C:\\Program Files\\Blender Foundation\\Blender 4.1\\blender.exe" },
+    { "slack.exe", "C:\\Users\\Public\\AppData\\Local\\slack\\slack.exe" }
+};
+
+QString isoNow()
+{
+    return QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs);
+}
+
+// Latency buckets grow by 2^(1/4) from 0.25 ms, so a percentile is off by at most ~19%
+class LatencyHistogram
+{
+public:
+    static constexpr int BucketCount = 80;
+
+    static double upperBoundMs(int bucket) { return 0.25 * std::pow(2.0, bucket / 4.0); }
+
+    void record(double ms)
+    {
+        const int bucket = ms <= 0.25 ? 0 : static_cast<int>(std::ceil(std::log2(ms / 0.25) * 4.0));
+        m_counts[qMin(bucket, BucketCount - 1)]++;
+        m_count++;
+        m_sumMs += ms;
+        m_maxMs = qMax(m_maxMs, ms);
+    }
+
+    void merge(const LatencyHistogram& other)
+    {
+        for (int i = 0; i < BucketCount; ++i) {
+            m_counts[i] += other.m_counts[i];
+        }
+        m_count += other.m_count;
+        m_sumMs += other.m_sumMs;
+        m_maxMs = qMax(m_maxMs, other.m_maxMs);
+    }
+
+    double percentile(double p) const
+    {
+        if (m_count == 0) {
+            return 0.0;
+        }
+        const qint64 rank = qMax<qint64>(1, static_cast<qint64>(std::ceil(p / 100.0 * m_count)));
+        qint64 seen = 0;
+        for (int i = 0; i < BucketCount; ++i) {
+            seen += m_counts[i];
+            if (seen >= rank) {
+                return qMin(upperBoundMs(i), m_maxMs);
+            }
+        }
+        return m_maxMs;
+    }
+
+    qint64 count() const { return m_count; }
+    qint64 bucket(int i) const { return m_counts[i]; }
+    double meanMs() const { return m_count > 0 ? m_sumMs / m_count : 0.0; }
+    double maxMs() const { return m_maxMs; }
+
+private:
+    std::array<qint64, BucketCount> m_counts{};
+    qint64 m_count = 0;
+    double m_sumMs = 0.0;
+    double m_maxMs = 0.0;
+};
+
+struct EndpointStats {
+    qint64 errors = 0;
+    QMap<int, qint64> statuses; // 0 is a network error or timeout
+    LatencyHistogram latency;
+
+    void merge(const EndpointStats& other)
+    {
+        errors += other.errors;
+        for (auto it = other.statuses.constBegin(); it != other.statuses.constEnd(); ++it) {
+            statuses[it.key()] += it.value();
+        }
+        latency.merge(other.latency);
+    }
+};
+
+using StatsMap = QMap<QString, EndpointStats>;
+
+EndpointStats combined(const StatsMap& stats)
+{
+    EndpointStats all;
+    for (const EndpointStats& endpoint : stats) {
+        all.merge(endpoint);
+    }
+    return all;
+}
+
+class LoadStats
+{
+public:
+    void record(const QString& endpoint, int status, bool ok, double ms)
+    {
+        QMutexLocker locker(&m_mutex);
+        for (StatsMap* map : { &m_total, &m_interval }) {
+            EndpointStats& stats = (*map)[endpoint];
+            stats.latency.record(ms);
+            stats.statuses[status]++;
+            if (!ok) {
+                stats.errors++;
+            }
+        }
+    }
+
+    StatsMap takeInterval()
+    {
+        QMutexLocker locker(&m_mutex);
+        StatsMap interval;
+        interval.swap(m_interval);
+        return interval;
+    }
+
+    StatsMap total() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_total;
+    }
+
+    int runningAgents = 0;
+
+private:
+    mutable QMutex m_mutex;
+    StatsMap m_total;
+    StatsMap m_interval;
+};
+
+struct AgentOptions {
+    QString serverUrl;
+    QString userPrefix = "loadgen";
+    QString password;
+    bool cborBatches = true;
+    int sampleIntervalMs = 5000;
+    int batchIntervalMs = 60000;
+    int metricsIntervalMs = 60000;
+    int dayLengthMs = 0;
+    int timeoutMs = 10000;
+    double locksPerHour = 2.0;
+    double appSwitchesPerHour = 40.0;
+    double restartsPerHour = 0.0;
+    quint32 seed = 1;
+};
+
+class SimulatedAgent : public QObject
+{
+public:
+    using Reply = std::function<void(bool ok, int status, const QJsonObject& body)>;
+
+    SimulatedAgent(int index, const AgentOptions& options, QNetworkAccessManager* network, LoadStats* stats,
+                   QObject* parent = nullptr)
+        : QObject(parent)
+        , m_index(index)
+        , m_options(options)
+        , m_network(network)
+        , m_stats(stats)
+        , m_rng(options.seed * 7919u + static_cast<quint32>(index))
+        , m_username(QString("%1%2").arg(options.userPrefix).arg(index + 1, 5, 10, QChar('0')))
+        , m_hostname(QString("%1-WS%2").arg(options.userPrefix.toUpper()).arg(index + 1, 5, 10, QChar('0')))
+        , m_cborBatches(options.cborBatches)
+    {
+        m_tickTimer.setInterval(options.sampleIntervalMs);
+        connect(&m_tickTimer, &QTimer::timeout, this, [this]() { tick(); });
+    }
+
+    void start() { registerMachine(); }
+
+    void stop()
+    {
+        m_stopped = true;
+        m_tickTimer.stop();
+    }
+
+private:
+    void post(const QString& label, const QString& endpoint, const QByteArray& body, const QByteArray& contentType,
+              bool auth, const Reply& done, const QHash<QByteArray, QByteArray>& headers = {})
+    {
+        QNetworkRequest request(QUrl(m_options.serverUrl + "api/" + endpoint));
+        request.setHeader(QNetworkRequest::ContentTypeHeader, contentType);
+        request.setTransferTimeout(m_options.timeoutMs);
+        for (auto it = headers.constBegin(); it != headers.constEnd(); ++it) {
+            request.setRawHeader(it.key(), it.value());
+        }
+        if (auth) {
+            request.setRawHeader("Authorization", QString("Bearer %1").arg(m_token).toUtf8());
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        QNetworkReply* reply = m_network->post(request, body);
+        connect(reply, &QNetworkReply::finished, this, [this, reply, timer, label, done]() {
+            const double ms = timer.nsecsElapsed() / 1e6;
+            const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+            const bool ok = reply->error() == QNetworkReply::NoError && status >= 200 && status < 300;
+            const QJsonObject body = QJsonDocument::fromJson(reply->readAll()).object();
+            reply->deleteLater();
+
+            m_stats->record(label, status, ok, ms);
+            if (!m_stopped) {
+                done(ok, status, body);
+            }
+        });
+    }
+
+    void postJson(const QString& label, const QString& endpoint, const QJsonObject& data, bool auth, const Reply& done)
+    {
+        post(label, endpoint, QJsonDocument(data).toJson(QJsonDocument::Compact), "application/json", auth, done);
+    }
+
+    // Setup steps are retried with a growing delay, like an agent waiting for the server
+    void retryLater(const std::function<void()>& step)
+    {
+        m_setupFailures++;
+        const int delayMs = qMin(60000, 1000 * (1 << qMin(m_setupFailures, 6)));
+        QTimer::singleShot(delayMs, this, [this, step]() {
+            if (!m_stopped) {
+                step();
+            }
+        });
+    }
+
+    // SessionManager::registerMachine
+    void registerMachine()
+    {
+        QJsonObject data;
+        data["name"] = m_hostname;
+        data["operatingSystem"] = "Windows 11 Pro";
+        data["machineUniqueId"] = QString("%1-%2").arg(m_options.userPrefix).arg(m_index + 1);
+        data["macAddress"] = QString("02:00:00:%1:%2:%3")
+                                 .arg((m_index >> 16) & 0xff, 2, 16, QChar('0'))
+                                 .arg((m_index >> 8) & 0xff, 2, 16, QChar('0'))
+                                 .arg(m_index & 0xff, 2, 16, QChar('0'));
+        data["cpuInfo"] = "x86_64";
+        data["ramSizeGB"] = 64;
+
+        postJson("POST /api/machines/register", "machines/register", data, false,
+                 [this](bool ok, int, const QJsonObject& body) {
+            m_machineId = body.contains("id") ? body["id"].toString() : body["machine_id"].toString();
+            if (!ok || m_machineId.isEmpty()) {
+                retryLater([this]() { registerMachine(); });
+                return;
+            }
+            authenticate([this]() { openSession([this]() { detectApps(); }); });
+        });
+    }
+
+    // APIManager::authenticate, or an interactive login when a password is configured
+    void authenticate(const std::function<void()>& next)
+    {
+        auto handle = [this, next](bool ok, int, const QJsonObject& body) {
+            m_token = body["token"].toString();
+            if (!ok || m_token.isEmpty()) {
+                retryLater([this, next]() { authenticate(next); });
+                return;
+            }
+            m_setupFailures = 0;
+            next();
+        };
+
+        QJsonObject data;
+        data["username"] = m_username;
+        if (m_options.password.isEmpty()) {
+            data["machine_id"] = m_machineId;
+            data["service_id"] = ServiceId;
+            postJson("POST /api/auth/service-token", "auth/service-token", data, false, handle);
+        } else {
+            data["password"] = m_options.password;
+            postJson("POST /api/auth/login", "auth/login", data, false, handle);
+        }
+    }
+
+    // SessionManager::getOrCreateSession; the server reopens today's session if there is one
+    void openSession(const std::function<void()>& next)
+    {
+        QJsonObject data;
+        data["username"] = m_username;
+        data["machine_id"] = m_machineId;
+
+        postJson("POST /api/sessions", "sessions", data, true, [this, next](bool ok, int status, const QJsonObject& body) {
+            const QString sessionId = body.contains("session_id") ? body["session_id"].toString() : body["id"].toString();
+            if (!ok || sessionId.isEmpty()) {
+                if (status == 401) {
+                    authenticate([this, next]() { openSession(next); });
+                } else {
+                    retryLater([this, next]() { openSession(next); });
+                }
+                return;
+            }
+            m_sessionId = QUuid(sessionId);
+            m_dayTimer.start();
+            m_setupFailures = 0;
+            next();
+        });
+    }
+
+    // SessionManager::detectApplication for the applications this machine runs
+    void detectApps()
+    {
+        if (m_apps.size() >= 4 + static_cast<int>(m_index % 5)) {
+            beginRunning();
+            return;
+        }
+
+        const AppEntry& app = AppCatalog[std::uniform_int_distribution<int>(0, static_cast<int>(std::size(AppCatalog)) - 1)(m_rng)];
+        QJsonObject data;
+        data["app_name"] = QString(app.name);
+        data["app_path"] = QString(app.path);
+        data["is_restricted"] = false;
+        data["tracking_enabled"] = true;
+
+        postJson("POST /api/applications/detect", "applications/detect", data, true,
+                 [this, app](bool ok, int, const QJsonObject& body) {
+            if (!ok || body["id"].toString().isEmpty()) {
+                retryLater([this]() { detectApps(); });
+                return;
+            }
+            m_apps.append(qMakePair(body["id"].toString(), QString(app.name)));
+            detectApps();
+        });
+    }
+
+    void beginRunning()
+    {
+        if (!m_running) {
+            m_running = true;
+            m_stats->runningAgents++;
+        }
+        m_lastBatch.start();
+        m_lastMetrics.start();
+        switchApp();
+        m_tickTimer.start();
+    }
+
+    void tick()
+    {
+        const double hours = m_options.sampleIntervalMs / 3600000.0;
+
+        if (m_options.dayLengthMs > 0 && m_dayTimer.elapsed() >= m_options.dayLengthMs && !m_batchInFlight) {
+            changeDay();
+            return;
+        }
+        if (chance(m_options.restartsPerHour * hours) && !m_batchInFlight) {
+            restart();
+            return;
+        }
+
+        if (m_locked) {
+            if (QDateTime::currentMSecsSinceEpoch() >= m_unlockAtMs) {
+                m_locked = false;
+                queueSessionEvent("unlock");
+            }
+        } else if (chance(m_options.locksPerHour * hours)) {
+            m_locked = true;
+            m_unlockAtMs = QDateTime::currentMSecsSinceEpoch() +
+                           static_cast<qint64>(std::exponential_distribution<double>(1.0 / 300000.0)(m_rng));
+            queueSessionEvent("lock");
+        } else {
+            // ActivityTrackerClient::onBatchedKeyboardActivity / onBatchedMouseActivity
+            const double intensity = std::uniform_real_distribution<double>(0.2, 1.5)(m_rng);
+            const int keys = poisson(3.0 * intensity * m_options.sampleIntervalMs / 1000.0);
+            const int moves = poisson(6.0 * intensity * m_options.sampleIntervalMs / 1000.0);
+            const int clicks = poisson(0.4 * intensity * m_options.sampleIntervalMs / 1000.0);
+
+            if (keys > 0) {
+                QJsonObject data;
+                data["type"] = "keyboard";
+                data["count"] = keys;
+                queueActivityEvent("keyboard", data);
+            }
+            if (moves > 0) {
+                QJsonObject data;
+                data["type"] = "move";
+                data["count"] = moves;
+                data["x"] = std::uniform_int_distribution<int>(0, 3839)(m_rng);
+                data["y"] = std::uniform_int_distribution<int>(0, 2159)(m_rng);
+                queueActivityEvent("mouse_move", data);
+            }
+            if (clicks > 0) {
+                QJsonObject data;
+                data["type"] = "click";
+                data["count"] = clicks;
+                queueActivityEvent("mouse_click", data);
+            }
+
+            if (chance(m_options.appSwitchesPerHour * hours)) {
+                switchApp();
+            }
+        }
+
+        if (m_lastMetrics.elapsed() >= m_options.metricsIntervalMs) {
+            m_lastMetrics.restart();
+            queueMetrics();
+        }
+
+        if (m_lastBatch.elapsed() >= m_options.batchIntervalMs) {
+            m_lastBatch.restart();
+            flushBatch();
+        }
+    }
+
+    // ActivityTrackerClient::onBatchedAppActivity: end the previous usage and start the next
+    void switchApp()
+    {
+        if (m_apps.isEmpty() || m_sessionId.isNull()) {
+            return;
+        }
+
+        const QString session = m_sessionId.toString(QUuid::WithoutBraces);
+        if (!m_usageId.isEmpty()) {
+            QJsonObject data;
+            data["session_id"] = session;
+            data["end_time"] = isoNow();
+            postJson("POST /api/app-usages/{id}/end", "app-usages/" + m_usageId + "/end", data, true,
+                     [](bool, int, const QJsonObject&) {});
+            m_usageId.clear();
+        }
+
+        m_currentApp = m_apps.at(std::uniform_int_distribution<int>(0, static_cast<int>(m_apps.size()) - 1)(m_rng));
+
+        QJsonObject data;
+        data["session_id"] = session;
+        data["app_id"] = m_currentApp.first;
+        data["window_title"] = QString("%1 - file %2").arg(m_currentApp.second).arg(std::uniform_int_distribution<int>(1, 40)(m_rng));
+        data["start_time"] = isoNow();
+        postJson("POST /api/app-usages", "app-usages", data, true, [this](bool ok, int, const QJsonObject& body) {
+            if (ok) {
+                m_usageId = body["id"].toString();
+            }
+        });
+    }
+
+    // SyncManager::queueData stamps a sequence number and capture time on every row
+    void stamp(QJsonObject& data, const char* timeKey)
+    {
+        data["client_seq"] = ++m_clientSeq;
+        data[timeKey] = isoNow();
+    }
+
+    void queueActivityEvent(const QString& eventType, QJsonObject data)
+    {
+        data["event_type"] = eventType;
+        if (!m_currentApp.first.isEmpty()) {
+            data["app_id"] = m_currentApp.first;
+        }
+        stamp(data, "event_time");
+        m_activityEvents.append(data);
+    }
+
+    void queueSessionEvent(const QString& eventType)
+    {
+        QJsonObject data;
+        data["event_type"] = eventType;
+        data["machine_id"] = m_machineId;
+        stamp(data, "event_time");
+        m_sessionEvents.append(data);
+    }
+
+    // ActivityTrackerClient::recordSystemMetrics
+    void queueMetrics()
+    {
+        m_cpu = qBound(0.5, m_cpu + 0.3 * ((m_locked ? 4.0 : 22.0) - m_cpu) + std::normal_distribution<double>(0, 6)(m_rng), 99.5);
+        m_memory = qBound(20.0, m_memory + std::normal_distribution<double>(0, 0.8)(m_rng), 95.0);
+
+        QJsonObject data;
+        data["cpu_usage"] = m_cpu;
+        data["gpu_usage"] = qBound(0.0, std::normal_distribution<double>(m_locked ? 1.0 : 6.0, 3)(m_rng), 100.0);
+        data["memory_usage"] = m_memory;
+        stamp(data, "measurement_time");
+        m_systemMetrics.append(data);
+    }
+
+    // SyncManager::clientBatchId
+    static QString clientBatchId(const QUuid& sessionId, const QJsonObject& batchData)
+    {
+        QByteArray seqs;
+        for (const char* key : { "session_events", "activity_events", "system_metrics" }) {
+            const QJsonArray rows = batchData[key].toArray();
+            for (const QJsonValue& row : rows) {
+                seqs += QByteArray::number(row.toObject()["client_seq"].toInteger());
+                seqs += ',';
+            }
+            seqs += ';';
+        }
+        return QUuid::createUuidV5(sessionId, seqs).toString(QUuid::WithoutBraces);
+    }
+
+    // SyncManager::sendBatchedData; a failed batch is resent under the same Idempotency-Key
+    void flushBatch(const std::function<void()>& after = {})
+    {
+        if (m_batchInFlight) {
+            return;
+        }
+
+        if (m_pendingBatch.isEmpty()) {
+            if (m_sessionEvents.isEmpty() && m_activityEvents.isEmpty() && m_systemMetrics.isEmpty()) {
+                if (after) {
+                    after();
+                }
+                return;
+            }
+
+            m_pendingBatch["session_id"] = m_sessionId.toString(QUuid::WithoutBraces);
+            if (!m_sessionEvents.isEmpty()) {
+                m_pendingBatch["session_events"] = m_sessionEvents;
+            }
+            if (!m_activityEvents.isEmpty()) {
+                m_pendingBatch["activity_events"] = m_activityEvents;
+            }
+            if (!m_systemMetrics.isEmpty()) {
+                m_pendingBatch["system_metrics"] = m_systemMetrics;
+            }
+            m_pendingBatch["client_batch_id"] = clientBatchId(m_sessionId, m_pendingBatch);
+            m_sessionEvents = QJsonArray();
+            m_activityEvents = QJsonArray();
+            m_systemMetrics = QJsonArray();
+        }
+
+        QHash<QByteArray, QByteArray> headers;
+        headers.insert("Idempotency-Key", m_pendingBatch["client_batch_id"].toString().toUtf8());
+
+        const bool cbor = m_cborBatches;
+        const QByteArray body = cbor ? BatchCbor::encode(m_pendingBatch)
+                                     : QJsonDocument(m_pendingBatch).toJson(QJsonDocument::Compact);
+
+        m_batchInFlight = true;
+        post("POST /api/batch", "batch", body, cbor ? BatchCbor::contentType() : QByteArray("application/json"), true,
+             [this, cbor, after](bool ok, int status, const QJsonObject&) {
+            m_batchInFlight = false;
+            if (ok) {
+                m_pendingBatch = QJsonObject();
+            } else if (cbor && status == 415) {
+                // APIManager::sendBatchRequest falls back to JSON for servers without CBOR
+                m_cborBatches = false;
+                flushBatch(after);
+                return;
+            } else if (status == 401) {
+                m_token.clear();
+                authenticate([]() {});
+            }
+            if (after) {
+                after();
+            }
+        }, headers);
+    }
+
+    // The agent closes yesterday's session and opens today's at the first activity after midnight
+    void changeDay()
+    {
+        m_tickTimer.stop();
+        queueSessionEvent("logout");
+        flushBatch([this]() {
+            postJson("POST /api/sessions/{id}/end", "sessions/" + m_sessionId.toString(QUuid::WithoutBraces) + "/end",
+                     QJsonObject(), true, [this](bool, int, const QJsonObject&) {
+                m_usageId.clear();
+                openSession([this]() { beginRunning(); });
+            });
+        });
+    }
+
+    // A service restart authenticates again and reopens the current session
+    void restart()
+    {
+        m_tickTimer.stop();
+        flushBatch([this]() {
+            m_token.clear();
+            m_usageId.clear();
+            authenticate([this]() { openSession([this]() { beginRunning(); }); });
+        });
+    }
+
+    bool chance(double p) { return p > 0 && std::bernoulli_distribution(qMin(1.0, p))(m_rng); }
+    int poisson(double mean) { return mean > 0 ? std::poisson_distribution<int>(mean)(m_rng) : 0; }
+
+    int m_index;
+    AgentOptions m_options;
+    QNetworkAccessManager* m_network;
+    LoadStats* m_stats;
+    std::mt19937 m_rng;
+
+    QString m_username;
+    QString m_hostname;
+    QString m_machineId;
+    QString m_token;
+    QUuid m_sessionId;
+    QList<QPair<QString, QString>> m_apps;
+    QPair<QString, QString> m_currentApp;
+    QString m_usageId;
+
+    QTimer m_tickTimer;
+    QElapsedTimer m_dayTimer;
+    QElapsedTimer m_lastBatch;
+    QElapsedTimer m_lastMetrics;
+
+    QJsonArray m_sessionEvents;
+    QJsonArray m_activityEvents;
+    QJsonArray m_systemMetrics;
+    QJsonObject m_pendingBatch;
+    qint64 m_clientSeq = 0;
+
+    bool m_cborBatches;
+    bool m_batchInFlight = false;
+    bool m_running = false;
+    bool m_stopped = false;
+    bool m_locked = false;
+    qint64 m_unlockAtMs = 0;
+    int m_setupFailures = 0;
+    double m_cpu = 15.0;
+    double m_memory = 50.0;
+};
+
+// Samples the process section of /api/status/health
+class ServerMonitor : public QObject
+{
+public:
+    struct Sample {
+        qint64 elapsedMs = 0;
+        double cpuPercent = -1;
+        qint64 rssBytes = -1;
+        int threads = -1;
+        int openFds = -1;
+    };
+
+    ServerMonitor(const AgentOptions& options, QObject* parent = nullptr)
+        : QObject(parent), m_options(options)
+    {
+        m_clock.start();
+    }
+
+    void start()
+    {
+        QJsonObject data;
+        data["username"] = m_options.userPrefix + "-monitor";
+        data["service_id"] = ServiceId;
+        QNetworkRequest request(QUrl(m_options.serverUrl + "api/auth/service-token"));
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+        QNetworkReply* reply = m_network.post(request, QJsonDocument(data).toJson(QJsonDocument::Compact));
+        connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+            m_token = QJsonDocument::fromJson(reply->readAll()).object()["token"].toString();
+            reply->deleteLater();
+        });
+    }
+
+    // Ask for a fresh sample; the previous answer is what the caller reports
+    void poll()
+    {
+        if (m_token.isEmpty()) {
+            return;
+        }
+        QNetworkRequest request(QUrl(m_options.serverUrl + "api/status/health"));
+        request.setRawHeader("Authorization", QString("Bearer %1").arg(m_token).toUtf8());
+        request.setTransferTimeout(m_options.timeoutMs);
+        QNetworkReply* reply = m_network.get(request);
+        connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+            const QJsonObject process = QJsonDocument::fromJson(reply->readAll()).object()["process"].toObject();
+            reply->deleteLater();
+            if (process.isEmpty()) {
+                return;
+            }
+
+            Sample sample;
+            sample.elapsedMs = m_clock.elapsed();
+            const double cpuSeconds = process["cpu_seconds"].toDouble(-1);
+            if (cpuSeconds >= 0 && m_lastCpuSeconds >= 0 && sample.elapsedMs > m_lastSampleMs) {
+                sample.cpuPercent = 100.0 * (cpuSeconds - m_lastCpuSeconds) * 1000.0 / (sample.elapsedMs - m_lastSampleMs);
+            }
+            m_lastCpuSeconds = cpuSeconds;
+            m_lastSampleMs = sample.elapsedMs;
+            sample.rssBytes = process["rss_bytes"].toInteger(-1);
+            sample.threads = process["threads"].toInt(-1);
+            sample.openFds = process["open_fds"].toInt(-1);
+            m_latest = sample;
+        });
+    }
+
+    Sample latest() const { return m_latest; }
+
+private:
+    AgentOptions m_options;
+    QNetworkAccessManager m_network;
+    QString m_token;
+    QElapsedTimer m_clock;
+    double m_lastCpuSeconds = -1;
+    qint64 m_lastSampleMs = 0;
+    Sample m_latest;
+};
+
+QJsonObject endpointJson(const EndpointStats& stats)
+{
+    QJsonObject statuses;
+    for (auto it = stats.statuses.constBegin(); it != stats.statuses.constEnd(); ++it) {
+        statuses[QString::number(it.key())] = it.value();
+    }
+
+    QJsonArray histogram;
+    for (int i = 0; i < LatencyHistogram::BucketCount; ++i) {
+        if (stats.latency.bucket(i) > 0) {
+            histogram.append(QJsonArray{ LatencyHistogram::upperBoundMs(i), stats.latency.bucket(i) });
+        }
+    }
+
+    QJsonObject json;
+    json["requests"] = stats.latency.count();
+    json["errors"] = stats.errors;
+    json["statuses"] = statuses;
+    json["mean_ms"] = stats.latency.meanMs();
+    json["p50_ms"] = stats.latency.percentile(50);
+    json["p90_ms"] = stats.latency.percentile(90);
+    json["p99_ms"] = stats.latency.percentile(99);
+    json["max_ms"] = stats.latency.maxMs();
+    json["histogram"] = histogram;
+    return json;
+}
+
+double errorPercent(const EndpointStats& stats)
+{
+    return stats.latency.count() > 0 ? 100.0 * stats.errors / stats.latency.count() : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tms_loadgen");
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Simulate a fleet of Activity Tracker agents against ActivityTrackerAPI");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption urlOption(QStringList() << "s" << "server",
+                                 QCoreApplication::translate("main", "Server URL"),
+                                 QCoreApplication::translate("main", "url"), "http://127.0.0.1:8080");
+    QCommandLineOption agentsOption(QStringList() << "a" << "agents",
+                                    QCoreApplication::translate("main", "Number of simulated agents"),
+                                    QCoreApplication::translate("main", "count"), "100");
+    QCommandLineOption durationOption(QStringList() << "d" << "duration",
+                                      QCoreApplication::translate("main", "Run time in seconds"),
+                                      QCoreApplication::translate("main", "seconds"), "300");
+    QCommandLineOption rampOption("ramp-up",
+                                  QCoreApplication::translate("main", "Seconds over which agents start"),
+                                  QCoreApplication::translate("main", "seconds"), "30");
+    QCommandLineOption batchOption("batch-interval",
+                                   QCoreApplication::translate("main", "Seconds between /api/batch uploads per agent"),
+                                   QCoreApplication::translate("main", "seconds"), "60");
+    QCommandLineOption sampleOption("sample-interval",
+                                    QCoreApplication::translate("main", "Seconds between input activity samples"),
+                                    QCoreApplication::translate("main", "seconds"), "5");
+    QCommandLineOption metricsOption("metrics-interval",
+                                     QCoreApplication::translate("main", "Seconds between system metric samples"),
+                                     QCoreApplication::translate("main", "seconds"), "60");
+    QCommandLineOption locksOption("locks-per-hour",
+                                   QCoreApplication::translate("main", "Screen locks per agent per hour"),
+                                   QCoreApplication::translate("main", "rate"), "2");
+    QCommandLineOption switchesOption("app-switches-per-hour",
+                                      QCoreApplication::translate("main", "Application focus changes per agent per hour"),
+                                      QCoreApplication::translate("main", "rate"), "40");
+    QCommandLineOption restartsOption("restarts-per-hour",
+                                      QCoreApplication::translate("main", "Service restarts (re-login and session reopen) per agent per hour"),
+                                      QCoreApplication::translate("main", "rate"), "0");
+    QCommandLineOption dayOption("day-length",
+                                 QCoreApplication::translate("main", "Seconds of simulated working day before a day change (0: never)"),
+                                 QCoreApplication::translate("main", "seconds"), "0");
+    QCommandLineOption connectionsOption("connections",
+                                         QCoreApplication::translate("main", "HTTP connections to spread agents over (default: one per agent)"),
+                                         QCoreApplication::translate("main", "count"));
+    QCommandLineOption prefixOption("user-prefix",
+                                    QCoreApplication::translate("main", "Prefix of simulated user and machine names"),
+                                    QCoreApplication::translate("main", "prefix"), "loadgen");
+    QCommandLineOption passwordOption("password",
+                                      QCoreApplication::translate("main", "Log in through /api/auth/login with this password instead of service tokens"),
+                                      QCoreApplication::translate("main", "password"));
+    QCommandLineOption jsonBatchesOption("json-batches",
+                                         QCoreApplication::translate("main", "Send batches as JSON instead of CBOR"));
+    QCommandLineOption reportOption("report-interval",
+                                    QCoreApplication::translate("main", "Seconds between progress lines"),
+                                    QCoreApplication::translate("main", "seconds"), "10");
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    QCoreApplication::translate("main", "Write the full report as JSON to this file"),
+                                    QCoreApplication::translate("main", "file"));
+    QCommandLineOption seedOption("seed",
+                                  QCoreApplication::translate("main", "Random seed"),
+                                  QCoreApplication::translate("main", "seed"), "1");
+
+    parser.addOptions({ urlOption, agentsOption, durationOption, rampOption, batchOption, sampleOption,
+                        metricsOption, locksOption, switchesOption, restartsOption, dayOption, connectionsOption,
+                        prefixOption, passwordOption, jsonBatchesOption, reportOption, outputOption, seedOption });
+    parser.process(app);
+
+    AgentOptions options;
+    options.serverUrl = parser.value(urlOption);
+    if (!options.serverUrl.endsWith('/')) {
+        options.serverUrl += '/';
+    }
+    options.userPrefix = parser.value(prefixOption);
+    options.password = parser.value(passwordOption);
+    options.cborBatches = !parser.isSet(jsonBatchesOption);
+    options.sampleIntervalMs = qMax(1000, static_cast<int>(parser.value(sampleOption).toDouble() * 1000));
+    options.batchIntervalMs = qMax(1000, static_cast<int>(parser.value(batchOption).toDouble() * 1000));
+    options.metricsIntervalMs = qMax(1000, static_cast<int>(parser.value(metricsOption).toDouble() * 1000));
+    options.dayLengthMs = qMax(0, static_cast<int>(parser.value(dayOption).toDouble() * 1000));
+    options.locksPerHour = qMax(0.0, parser.value(locksOption).toDouble());
+    options.appSwitchesPerHour = qMax(0.0, parser.value(switchesOption).toDouble());
+    options.restartsPerHour = qMax(0.0, parser.value(restartsOption).toDouble());
+    options.seed = parser.value(seedOption).toUInt();
+
+    const int agentCount = parser.value(agentsOption).toInt();
+    const int durationSeconds = parser.value(durationOption).toInt();
+    const int rampMs = qMax(0, parser.value(rampOption).toInt() * 1000);
+    const int reportSeconds = qMax(1, parser.value(reportOption).toInt());
+    if (agentCount <= 0 || durationSeconds <= 0) {
+        QTextStream(stderr) << "Agents and duration must be positive" << Qt::endl;
+        return 1;
+    }
+
+    // Each QNetworkAccessManager keeps at most six connections to a host
+    const int connections = parser.isSet(connectionsOption) ? qMax(1, parser.value(connectionsOption).toInt()) : agentCount;
+    const int managerCount = qMax(1, (qMin(connections, agentCount) + 5) / 6);
+    QList<QNetworkAccessManager*> managers;
+    for (int i = 0; i < managerCount; ++i) {
+        managers.append(new QNetworkAccessManager(&app));
+    }
+
+    LoadStats stats;
+    QList<SimulatedAgent*> agents;
+    for (int i = 0; i < agentCount; ++i) {
+        auto* agent = new SimulatedAgent(i, options, managers.at(i % managerCount), &stats, &app);
+        agents.append(agent);
+        QTimer::singleShot(static_cast<int>(static_cast<qint64>(rampMs) * i / agentCount), agent,
+                           [agent]() { agent->start(); });
+    }
+
+    ServerMonitor monitor(options);
+    monitor.start();
+
+    QTextStream out(stdout);
+    out << QString("Simulating %1 agents against %2 for %3 s over %4 connections")
+               .arg(agentCount).arg(options.serverUrl).arg(durationSeconds).arg(managerCount * 6)
+        << Qt::endl;
+
+    QJsonArray timeline;
+    QElapsedTimer clock;
+    clock.start();
+
+    QTimer reportTimer;
+    reportTimer.setInterval(reportSeconds * 1000);
+    QObject::connect(&reportTimer, &QTimer::timeout, [&]() {
+        const EndpointStats interval = combined(stats.takeInterval());
+        const ServerMonitor::Sample server = monitor.latest();
+        monitor.poll();
+
+        const double elapsed = clock.elapsed() / 1000.0;
+        const double rate = interval.latency.count() / static_cast<double>(reportSeconds);
+
+        QString line = QString("[%1 s] agents %2/%3  req/s %4  err %5%  p50 %6 ms  p95 %7 ms  p99 %8 ms")
+                           .arg(elapsed, 6, 'f', 0)
+                           .arg(stats.runningAgents).arg(agentCount)
+                           .arg(rate, 0, 'f', 1)
+                           .arg(errorPercent(interval), 0, 'f', 2)
+                           .arg(interval.latency.percentile(50), 0, 'f', 1)
+                           .arg(interval.latency.percentile(95), 0, 'f', 1)
+                           .arg(interval.latency.percentile(99), 0, 'f', 1);
+        if (server.rssBytes >= 0) {
+            line += QString("  | server cpu %1%  rss %2 MB  threads %3  fds %4")
+                        .arg(server.cpuPercent >= 0 ? QString::number(server.cpuPercent, 'f', 0) : QString("-"))
+                        .arg(server.rssBytes / (1024 * 1024))
+                        .arg(server.threads)
+                        .arg(server.openFds);
+        }
+        out << line << Qt::endl;
+
+        QJsonObject point;
+        point["elapsed_s"] = elapsed;
+        point["running_agents"] = stats.runningAgents;
+        point["requests_per_s"] = rate;
+        point["error_percent"] = errorPercent(interval);
+        point["p50_ms"] = interval.latency.percentile(50);
+        point["p95_ms"] = interval.latency.percentile(95);
+        point["p99_ms"] = interval.latency.percentile(99);
+        if (server.rssBytes >= 0) {
+            point["server_cpu_percent"] = server.cpuPercent;
+            point["server_rss_bytes"] = server.rssBytes;
+            point["server_threads"] = server.threads;
+            point["server_open_fds"] = server.openFds;
+        }
+        timeline.append(point);
+    });
+    reportTimer.start();
+
+    QTimer::singleShot(durationSeconds * 1000, &app, [&]() {
+        reportTimer.stop();
+        for (SimulatedAgent* agent : agents) {
+            agent->stop();
+        }
+
+        const StatsMap total = stats.total();
+        const EndpointStats all = combined(total);
+        const double seconds = clock.elapsed() / 1000.0;
+
+        out << Qt::endl
+            << QString("%1 %2 %3 %4 %5 %6 %7 %8")
+                   .arg("endpoint", -36).arg("requests", 9).arg("err%", 7).arg("mean", 9)
+                   .arg("p50", 9).arg("p90", 9).arg("p99", 9).arg("max", 9)
+            << Qt::endl;
+        auto row = [&out](const QString& name, const EndpointStats& s) {
+            out << QString("%1 %2 %3 %4 %5 %6 %7 %8")
+                       .arg(name, -36)
+                       .arg(s.latency.count(), 9)
+                       .arg(errorPercent(s), 7, 'f', 2)
+                       .arg(s.latency.meanMs(), 9, 'f', 1)
+                       .arg(s.latency.percentile(50), 9, 'f', 1)
+                       .arg(s.latency.percentile(90), 9, 'f', 1)
+                       .arg(s.latency.percentile(99), 9, 'f', 1)
+                       .arg(s.latency.maxMs(), 9, 'f', 1)
+                << Qt::endl;
+        };
+        for (auto it = total.constBegin(); it != total.constEnd(); ++it) {
+            row(it.key(), it.value());
+        }
+        row("all", all);
+
+        out << Qt::endl << "Latency histogram (all requests, ms upper bound)" << Qt::endl;
+        qint64 largest = 1;
+        for (int i = 0; i < LatencyHistogram::BucketCount; ++i) {
+            largest = qMax(largest, all.latency.bucket(i));
+        }
+        for (int i = 0; i < LatencyHistogram::BucketCount; ++i) {
+            if (all.latency.bucket(i) == 0) {
+                continue;
+            }
+            out << QString("%1 %2 %3")
+                       .arg(LatencyHistogram::upperBoundMs(i), 10, 'f', 2)
+                       .arg(all.latency.bucket(i), 9)
+                       .arg(QString(static_cast<int>(50 * all.latency.bucket(i) / largest), QChar('#')))
+                << Qt::endl;
+        }
+        out << QString("%1 requests in %2 s (%3 req/s)")
+                   .arg(all.latency.count()).arg(seconds, 0, 'f', 1)
+                   .arg(all.latency.count() / seconds, 0, 'f', 1)
+            << Qt::endl;
+
+        if (parser.isSet(outputOption)) {
+            QJsonObject endpoints;
+            for (auto it = total.constBegin(); it != total.constEnd(); ++it) {
+                endpoints[it.key()] = endpointJson(it.value());
+            }
+            QJsonObject report;
+            report["agents"] = agentCount;
+            report["duration_s"] = seconds;
+            report["batch_interval_s"] = options.batchIntervalMs / 1000.0;
+            report["cbor_batches"] = options.cborBatches;
+            report["all"] = endpointJson(all);
+            report["endpoints"] = endpoints;
+            report["timeline"] = timeline;
+
+            QFile file(parser.value(outputOption));
+            if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                file.write(QJsonDocument(report).toJson());
+            } else {
+                QTextStream(stderr) << "Cannot write " << file.fileName() << ": " << file.errorString() << Qt::endl;
+            }
+        }
+
+        app.exit(all.errors > 0 && all.errors == all.latency.count() ? 1 : 0);
+    });
+
+    return app.exec();
+}
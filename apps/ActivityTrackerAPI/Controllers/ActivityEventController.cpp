@@ -892,48 +892,17 @@ QString ActivityEventController::uuidToString(const QUuid &uuid) const
 // Helper method: stringToEventType - Converts a string to an EventTypes::ActivityEventType
 EventTypes::ActivityEventType ActivityEventController::stringToEventType(const QString &eventTypeStr)
 {
-    if (eventTypeStr == "mouse_click") {
-        return EventTypes::ActivityEventType::MouseClick;
-    } else if (eventTypeStr == "mouse_move") {
-        return EventTypes::ActivityEventType::MouseMove;
-    } else if (eventTypeStr == "keyboard") {
-        return EventTypes::ActivityEventType::Keyboard;
-    } else if (eventTypeStr == "afk_start") {
-        return EventTypes::ActivityEventType::AfkStart;
-    } else if (eventTypeStr == "afk_end") {
-        return EventTypes::ActivityEventType::AfkEnd;
-    } else if (eventTypeStr == "app_focus") {
-        return EventTypes::ActivityEventType::AppFocus;
-    } else if (eventTypeStr == "app_unfocus") {
-        return EventTypes::ActivityEventType::AppUnfocus;
-    } else {
+    EventTypes::ActivityEventType eventType = EventTypes::ActivityEventType::MouseClick;
+    if (!EventTypes::activityEventTypeFromString(eventTypeStr, eventType)) {
         LOG_WARNING(QString("Unknown event type string: %1, defaulting to MouseClick").arg(eventTypeStr));
-        return EventTypes::ActivityEventType::MouseClick;
     }
+    return eventType;
 }
 
 // Helper method: eventTypeToString - Converts an EventTypes::ActivityEventType to a string
 QString ActivityEventController::eventTypeToString(EventTypes::ActivityEventType eventType) const
 {
-    switch (eventType) {
-        case EventTypes::ActivityEventType::MouseClick:
-            return "mouse_click";
-        case EventTypes::ActivityEventType::MouseMove:
-            return "mouse_move";
-        case EventTypes::ActivityEventType::Keyboard:
-            return "keyboard";
-        case EventTypes::ActivityEventType::AfkStart:
-            return "afk_start";
-        case EventTypes::ActivityEventType::AfkEnd:
-            return "afk_end";
-        case EventTypes::ActivityEventType::AppFocus:
-            return "app_focus";
-        case EventTypes::ActivityEventType::AppUnfocus:
-            return "app_unfocus";
-        default:
-            LOG_WARNING(QString("Unknown event type enum: %1, mapping to unknown").arg(static_cast<int>(eventType)));
-            return "unknown";
-    }
+    return EventTypes::activityEventTypeToString(eventType);
 }
 
 // Method to set the repository dependencies should be called in ApiServer initialization
@@ -862,7 +862,7 @@ QHttpServerResponse AuthController::handleGetTokenInfo(const QHttpServerRequest
 
 QHttpServerResponse AuthController::handleRevokeToken(const QString &tokenId, const QHttpServerRequest &request)
 {
-    LOG_INFO(QString("Revoke token request received for token: %1").arg(tokenId));
+    LOG_FIELDS(Logger::Info, "Revoke token request received for token", LogField::secret("token", tokenId));
 
     QJsonObject userData;
     if (!isUserAuthorized(request, userData, true)) {
@@ -875,12 +875,14 @@ QHttpServerResponse AuthController::handleRevokeToken(const QString &tokenId, co
     // Verify the token belongs to this user
     auto token = m_tokenRepository->getByTokenId(tokenId);
     if (!token) {
-        LOG_WARNING(QString("Token not found: %1").arg(tokenId));
+        LOG_FIELDS(Logger::Warning, "Token not found", LogField::secret("token", tokenId));
         return Http::Response::notFound("Token not found");
     }
 
     if (token->userId() != userId) {
-        LOG_WARNING(QString("Unauthorized attempt to revoke token %1 by user %2").arg(tokenId, userId.toString()));
+        LOG_FIELDS(Logger::Warning, "Unauthorized attempt to revoke token",
+                   LogField::secret("token", tokenId),
+                   LogField::value("user_id", userId.toString()));
         return Http::Response::forbidden("Cannot revoke tokens belonging to other users");
     }
 
@@ -888,10 +890,12 @@ QHttpServerResponse AuthController::handleRevokeToken(const QString &tokenId, co
     bool success = m_tokenRepository->revokeToken(token->tokenId(), "User-initiated revocation");
 
     if (success) {
-        LOG_INFO(QString("Token %1 revoked successfully by user %2").arg(tokenId, userId.toString()));
+        LOG_FIELDS(Logger::Info, "Token revoked successfully",
+                   LogField::secret("token", tokenId),
+                   LogField::value("user_id", userId.toString()));
         return Http::Response::json(QJsonObject{{"success", true}, {"message", "Token revoked successfully"}});
     } else {
-        LOG_ERROR(QString("Failed to revoke token %1").arg(tokenId));
+        LOG_FIELDS(Logger::Error, "Failed to revoke token", LogField::secret("token", tokenId));
         return Http::Response::internalError("Failed to revoke token");
     }
 }
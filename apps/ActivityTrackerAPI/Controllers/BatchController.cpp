@@ -3,9 +3,15 @@
 #include <QJsonArray>
 #include <QDateTime>
 #include <QUrlQuery>
+#include <QScopedPointer>
+#include <vector>
 #include "logger/logger.h"
 #include "httpserver/response.h"
 #include "Core/ModelFactory.h"
+#include "batchcbor/batchcbor.h"
+#include "Services/BatchSpool.h"
+#include "Services/BatchDedupeIndex.h"
+#include "Services/BatchWorkerPool.h"
 
 BatchController::BatchController(QObject *parent)
     : ApiControllerBase(parent)
@@ -197,10 +203,15 @@ QHttpServerResponse BatchController::handleProcessBatch(const QHttpServerRequest
 
     try {
         bool ok;
-        QJsonObject json = extractJsonFromRequest(request, ok);
+        bool unsupportedFormat = false;
+        QJsonObject json = extractJsonFromRequest(request, ok, unsupportedFormat);
+        if (unsupportedFormat) {
+            return createErrorResponse(BatchCbor::UnsupportedFormatMessage,
+                                       QHttpServerResponder::StatusCode::UnsupportedMediaType);
+        }
         if (!ok) {
-            LOG_WARNING("Invalid JSON data in batch request");
-            return createErrorResponse("Invalid JSON data", QHttpServerResponder::StatusCode::BadRequest);
+            LOG_WARNING("Invalid data in batch request");
+            return createErrorResponse("Invalid batch data", QHttpServerResponder::StatusCode::BadRequest);
         }
 
         // Validate required fields
@@ -213,65 +224,12 @@ QHttpServerResponse BatchController::handleProcessBatch(const QHttpServerRequest
         QUuid userId = QUuid(userData["id"].toString());
 
         // Verify session exists
-        auto session = m_sessionRepository->getById(sessionId);
-        if (!session) {
+        if (!sessionExists(sessionId)) {
             LOG_WARNING(QString("Session not found with ID: %1").arg(sessionId.toString()));
             return Http::Response::notFound("Session not found");
         }
 
-        // Initialize results object
-        QJsonObject results;
-        results["session_id"] = sessionId.toString(QUuid::WithoutBraces);
-        results["processing_time"] = QDateTime::currentDateTimeUtc().toUTC().toString();
-        results["success"] = true;
-        results["processed_counts"] = QJsonObject();
-
-        // Process different types of batch data if available
-        bool hasAnyData = false;
-
-        // Process activity events
-        if (json.contains("activity_events") && json["activity_events"].isArray()) {
-            QJsonArray events = json["activity_events"].toArray();
-            hasAnyData = true;
-            if (!processActivityEvents(events, sessionId, userId, results)) {
-                results["success"] = false;
-            }
-        }
-
-        // Process app usages
-        if (json.contains("app_usages") && json["app_usages"].isArray()) {
-            QJsonArray appUsages = json["app_usages"].toArray();
-            hasAnyData = true;
-            if (!processAppUsages(appUsages, sessionId, userId, results)) {
-                results["success"] = false;
-            }
-        }
-
-        // Process system metrics
-        if (json.contains("system_metrics") && json["system_metrics"].isArray()) {
-            QJsonArray metrics = json["system_metrics"].toArray();
-            hasAnyData = true;
-            if (!processSystemMetrics(metrics, sessionId, userId, results)) {
-                results["success"] = false;
-            }
-        }
-
-        // Process session events
-        if (json.contains("session_events") && json["session_events"].isArray()) {
-            QJsonArray events = json["session_events"].toArray();
-            hasAnyData = true;
-            if (!processSessionEvents(events, sessionId, userId, results)) {
-                results["success"] = false;
-            }
-        }
-
-        if (!hasAnyData) {
-            LOG_WARNING("Batch request contained no valid data arrays");
-            return createErrorResponse("No valid data arrays found in request", QHttpServerResponder::StatusCode::BadRequest);
-        }
-
-        LOG_INFO(QString("Batch processing completed for session %1").arg(sessionId.toString()));
-        return createSuccessResponse(results);
+        return processBatchData(json, sessionId, userId, extractIdempotencyKey(request, json));
     }
     catch (const std::exception &e) {
         LOG_ERROR(QString("Exception processing batch: %1").arg(e.what()));
@@ -299,74 +257,26 @@ QHttpServerResponse BatchController::handleProcessSessionBatch(const qint64 sess
         QUuid sessionUuid = stringToUuid(QString::number(sessionId));
 
         // Verify session exists
-        auto session = m_sessionRepository->getById(sessionUuid);
-        if (!session) {
+        if (!sessionExists(sessionUuid)) {
             LOG_WARNING(QString("Session not found with ID: %1").arg(sessionId));
             return Http::Response::notFound("Session not found");
         }
 
         bool ok;
-        QJsonObject json = extractJsonFromRequest(request, ok);
+        bool unsupportedFormat = false;
+        QJsonObject json = extractJsonFromRequest(request, ok, unsupportedFormat);
+        if (unsupportedFormat) {
+            return createErrorResponse(BatchCbor::UnsupportedFormatMessage,
+                                       QHttpServerResponder::StatusCode::UnsupportedMediaType);
+        }
         if (!ok) {
-            LOG_WARNING("Invalid JSON data in batch request");
-            return createErrorResponse("Invalid JSON data", QHttpServerResponder::StatusCode::BadRequest);
+            LOG_WARNING("Invalid data in batch request");
+            return createErrorResponse("Invalid batch data", QHttpServerResponder::StatusCode::BadRequest);
         }
 
         QUuid userId = QUuid(userData["id"].toString());
 
-        // Initialize results object
-        QJsonObject results;
-        results["session_id"] = sessionUuid.toString(QUuid::WithoutBraces);
-        results["processing_time"] = QDateTime::currentDateTimeUtc().toUTC().toString();
-        results["success"] = true;
-        results["processed_counts"] = QJsonObject();
-
-        // Process different types of batch data if available
-        bool hasAnyData = false;
-
-        // Process activity events
-        if (json.contains("activity_events") && json["activity_events"].isArray()) {
-            QJsonArray events = json["activity_events"].toArray();
-            hasAnyData = true;
-            if (!processActivityEvents(events, sessionUuid, userId, results)) {
-                results["success"] = false;
-            }
-        }
-
-        // Process app usages
-        if (json.contains("app_usages") && json["app_usages"].isArray()) {
-            QJsonArray appUsages = json["app_usages"].toArray();
-            hasAnyData = true;
-            if (!processAppUsages(appUsages, sessionUuid, userId, results)) {
-                results["success"] = false;
-            }
-        }
-
-        // Process system metrics
-        if (json.contains("system_metrics") && json["system_metrics"].isArray()) {
-            QJsonArray metrics = json["system_metrics"].toArray();
-            hasAnyData = true;
-            if (!processSystemMetrics(metrics, sessionUuid, userId, results)) {
-                results["success"] = false;
-            }
-        }
-
-        // Process session events
-        if (json.contains("session_events") && json["session_events"].isArray()) {
-            QJsonArray events = json["session_events"].toArray();
-            hasAnyData = true;
-            if (!processSessionEvents(events, sessionUuid, userId, results)) {
-                results["success"] = false;
-            }
-        }
-
-        if (!hasAnyData) {
-            LOG_WARNING("Batch request contained no valid data arrays");
-            return createErrorResponse("No valid data arrays found in request", QHttpServerResponder::StatusCode::BadRequest);
-        }
-
-        LOG_INFO(QString("Batch processing completed for session %1").arg(sessionId));
-        return createSuccessResponse(results);
+        return processBatchData(json, sessionUuid, userId, extractIdempotencyKey(request, json));
     }
     catch (const std::exception &e) {
         LOG_ERROR(QString("Exception processing batch for session: %1").arg(e.what()));
@@ -374,344 +284,263 @@ QHttpServerResponse BatchController::handleProcessSessionBatch(const qint64 sess
     }
 }
 
-bool BatchController::processActivityEvents(const QJsonArray &events, QUuid sessionId, QUuid userId, QJsonObject &results)
+QHttpServerResponse BatchController::processBatchData(const QJsonObject &json, const QUuid &sessionId, const QUuid &userId,
+                                                      const QString &idempotencyKey)
 {
-    LOG_DEBUG(QString("Processing %1 activity events").arg(events.size()));
-
-    int successCount = 0;
-    int failureCount = 0;
-    QJsonArray failures;
+    bool hasAnyData = json["activity_events"].isArray() || json["app_usages"].isArray() ||
+                      json["system_metrics"].isArray() || json["session_events"].isArray();
+    if (!hasAnyData) {
+        LOG_WARNING("Batch request contained no valid data arrays");
+        return createErrorResponse("No valid data arrays found in request", QHttpServerResponder::StatusCode::BadRequest);
+    }
 
-    for (int i = 0; i < events.size(); i++) {
-        if (!events[i].isObject()) {
-            LOG_WARNING(QString("Invalid activity event at index %1 - not an object").arg(i));
-            failureCount++;
-            failures.append(QJsonObject{{"index", i}, {"error", "Not a valid JSON object"}});
-            continue;
+    // A resent batch gets the response of the request that committed it
+    bool useReceipts = m_dedupeIndex && !idempotencyKey.isEmpty();
+    if (useReceipts) {
+        int statusCode = 0;
+        QJsonObject stored;
+        if (m_dedupeIndex->findReceipt(userId, idempotencyKey, statusCode, stored)) {
+            LOG_INFO(QString("Replaying batch %1 for session %2").arg(idempotencyKey, sessionId.toString()));
+            stored["replayed"] = true;
+            return createSuccessResponse(stored, static_cast<QHttpServerResponder::StatusCode>(statusCode));
         }
+    }
 
-        QJsonObject eventData = events[i].toObject();
+    QJsonObject batch = json;
+    int duplicatesSkipped = m_dedupeIndex ? m_dedupeIndex->filterCommitted(sessionId, batch) : 0;
 
-        try {
-            // Create activity event
-            ActivityEventModel *event = new ActivityEventModel();
-            event->setSessionId(sessionId);
-
-            // Set event type
-            if (eventData.contains("event_type") && !eventData["event_type"].toString().isEmpty()) {
-                // Convert string event type to enum
-                QString eventTypeStr = eventData["event_type"].toString();
-                EventTypes::ActivityEventType eventType;
-
-                if (eventTypeStr == "mouse_click") {
-                    eventType = EventTypes::ActivityEventType::MouseClick;
-                } else if (eventTypeStr == "mouse_move") {
-                    eventType = EventTypes::ActivityEventType::MouseMove;
-                } else if (eventTypeStr == "keyboard") {
-                    eventType = EventTypes::ActivityEventType::Keyboard;
-                } else if (eventTypeStr == "afk_start") {
-                    eventType = EventTypes::ActivityEventType::AfkStart;
-                } else if (eventTypeStr == "afk_end") {
-                    eventType = EventTypes::ActivityEventType::AfkEnd;
-                } else if (eventTypeStr == "app_focus") {
-                    eventType = EventTypes::ActivityEventType::AppFocus;
-                } else if (eventTypeStr == "app_unfocus") {
-                    eventType = EventTypes::ActivityEventType::AppUnfocus;
-                } else {
-                    // Default to mouse click if unknown
-                    eventType = EventTypes::ActivityEventType::MouseClick;
-                }
+    // In asynchronous mode the batch is acknowledged once it is durable in the spool
+    if (m_batchSpool && m_batchSpool->isOpen()) {
+        QUuid batchId = m_batchSpool->append(sessionId, userId, batch);
+        if (!batchId.isNull()) {
+            QJsonObject accepted;
+            accepted["batch_id"] = batchId.toString(QUuid::WithoutBraces);
+            accepted["session_id"] = sessionId.toString(QUuid::WithoutBraces);
+            accepted["status"] = "queued";
+            accepted["duplicates_skipped"] = duplicatesSkipped;
+            LOG_INFO(QString("Batch %1 queued for session %2").arg(batchId.toString(), sessionId.toString()));
 
-                event->setEventType(eventType);
-            } else {
-                event->setEventType(EventTypes::ActivityEventType::MouseClick);
+            if (m_dedupeIndex) {
+                m_dedupeIndex->markCommitted(sessionId, batch);
             }
-
-            // Set app ID if provided
-            if (eventData.contains("app_id") && !eventData["app_id"].toString().isEmpty()) {
-                event->setAppId(QUuid(eventData["app_id"].toString()));
-            }
-
-            // Set event time
-            if (eventData.contains("event_time") && !eventData["event_time"].toString().isEmpty()) {
-                QDateTime eventTime = QDateTime::fromString(eventData["event_time"].toString(), Qt::ISODate);
-                if (eventTime.isValid()) {
-                    event->setEventTime(eventTime);
-                } else {
-                    event->setEventTime(QDateTime::currentDateTimeUtc());
-                }
-            } else {
-                event->setEventTime(QDateTime::currentDateTimeUtc());
-            }
-
-            // Set event data
-            if (eventData.contains("event_data") && eventData["event_data"].isObject()) {
-                event->setEventData(eventData["event_data"].toObject());
+            if (useReceipts) {
+                m_dedupeIndex->storeReceipt(userId, idempotencyKey, sessionId,
+                                            static_cast<int>(QHttpServerResponder::StatusCode::Accepted), accepted);
             }
+            return createSuccessResponse(accepted, QHttpServerResponder::StatusCode::Accepted);
+        }
 
-            // Set metadata
-            event->setCreatedBy(userId);
-            event->setUpdatedBy(userId);
-            event->setCreatedAt(QDateTime::currentDateTimeUtc());
-            event->setUpdatedAt(QDateTime::currentDateTimeUtc());
+        LOG_WARNING("Failed to spool batch, processing it synchronously");
+    }
 
-            // Save event
-            bool success = m_activityEventRepository->save(event);
+    // Initialize results object
+    QJsonObject results;
+    results["session_id"] = sessionId.toString(QUuid::WithoutBraces);
+    results["processing_time"] = QDateTime::currentDateTimeUtc().toUTC().toString();
+    results["success"] = true;
+    results["processed_counts"] = QJsonObject();
+    results["duplicates_skipped"] = duplicatesSkipped;
 
-            if (success) {
-                successCount++;
-            } else {
-                failureCount++;
-                failures.append(QJsonObject{{"index", i}, {"error", "Failed to save to database"}});
-            }
+    if (!processBatchArrays(batch, sessionId, userId, results)) {
+        results["success"] = false;
+    }
 
-            delete event;
-        }
-        catch (const std::exception &e) {
-            LOG_ERROR(QString("Exception processing session event at index %1: %2").arg(i).arg(e.what()));
-            failureCount++;
-            failures.append(QJsonObject{
-                {"index", i},
-                {"error", QString("Exception: %1").arg(e.what())}
-            });
+    // Rows whose client_seq a concurrent resend committed first were skipped inside the transaction
+    const QJsonObject counts = results["processed_counts"].toObject();
+    for (auto it = counts.constBegin(); it != counts.constEnd(); ++it) {
+        if (it.key().endsWith("_duplicate")) {
+            duplicatesSkipped += it.value().toInt();
         }
     }
+    results["duplicates_skipped"] = duplicatesSkipped;
 
-    // Update results
-    QJsonObject counts = results["processed_counts"].toObject();
-    counts["session_events_success"] = successCount;
-    counts["session_events_failure"] = failureCount;
-    counts["session_events_total"] = events.size();
-    results["processed_counts"] = counts;
-
-    if (failureCount > 0) {
-        results["session_events_failures"] = failures;
+    if (m_dedupeIndex) {
+        m_dedupeIndex->markCommitted(sessionId, batch, results);
     }
 
-    LOG_INFO(QString("Processed %1 session events: %2 successful, %3 failed")
-            .arg(events.size()).arg(successCount).arg(failureCount));
+    // A partly failed batch keeps no receipt so the agent can resend the rows that failed
+    if (useReceipts && results["success"].toBool()) {
+        m_dedupeIndex->storeReceipt(userId, idempotencyKey, sessionId,
+                                    static_cast<int>(QHttpServerResponder::StatusCode::Ok), results);
+    }
 
-    return (failureCount == 0);
+    LOG_INFO(QString("Batch processing completed for session %1").arg(sessionId.toString()));
+    return createSuccessResponse(results);
 }
 
-QJsonObject BatchController::extractJsonFromRequest(const QHttpServerRequest &request, bool &ok)
+bool BatchController::processBatchArrays(const QJsonObject &batch, const QUuid &sessionId, const QUuid &userId,
+                                         QJsonObject &results)
 {
-    ok = false;
+    using Repositories = BatchWorkerPool::Repositories;
 
-    // Parse JSON body
-    QByteArray body = request.body();
-    QJsonDocument doc = QJsonDocument::fromJson(body);
-    if (doc.isNull() || !doc.isObject()) {
-        LOG_WARNING("Failed to parse JSON from request body");
-        return QJsonObject();
-    }
+    // One writer per array; a null Repositories means this thread's own repositories
+    QList<std::function<bool(const Repositories*, QJsonObject&)>> writers;
 
-    ok = true;
-    LOG_DEBUG(QString("Extracted JSON: %1").arg(QString::fromUtf8(body)));
-    return doc.object();
-}
-
-QUuid BatchController::stringToUuid(const QString &str) const
-{
-    // Handle both simple format and UUID format
-    if (str.contains('-')) {
-        return QUuid(str);
-    } else {
-        // Create UUID from simple format (without dashes)
-        QString withDashes = str;
-        withDashes.insert(8, '-');
-        withDashes.insert(13, '-');
-        withDashes.insert(18, '-');
-        withDashes.insert(23, '-');
-        return QUuid(withDashes);
+    if (batch["activity_events"].isArray()) {
+        const QJsonArray rows = batch["activity_events"].toArray();
+        writers.append([=](const Repositories* repositories, QJsonObject& out) {
+            return processActivityEvents(rows, sessionId, userId, out,
+                repositories ? repositories->activityEvents : m_activityEventRepository);
+        });
     }
-}
 
-QString BatchController::uuidToString(const QUuid &uuid) const
-{
-    return uuid.toString(QUuid::WithoutBraces);
-}
+    if (batch["app_usages"].isArray()) {
+        const QJsonArray rows = batch["app_usages"].toArray();
+        writers.append([=](const Repositories* repositories, QJsonObject& out) {
+            return processAppUsages(rows, sessionId, userId, out,
+                repositories ? repositories->appUsages : m_appUsageRepository);
+        });
+    }
 
-bool BatchController::processAppUsages(const QJsonArray &appUsages, QUuid sessionId, QUuid userId, QJsonObject &results)
-{
-    LOG_DEBUG(QString("Processing %1 app usages").arg(appUsages.size()));
+    if (batch["system_metrics"].isArray()) {
+        const QJsonArray rows = batch["system_metrics"].toArray();
+        writers.append([=](const Repositories* repositories, QJsonObject& out) {
+            return processSystemMetrics(rows, sessionId, userId, out,
+                repositories ? repositories->systemMetrics : m_systemMetricsRepository);
+        });
+    }
 
-    int successCount = 0;
-    int failureCount = 0;
-    QJsonArray failures;
+    if (batch["session_events"].isArray()) {
+        const QJsonArray rows = batch["session_events"].toArray();
+        writers.append([=](const Repositories* repositories, QJsonObject& out) {
+            return processSessionEvents(rows, sessionId, userId, out,
+                repositories ? repositories->sessionEvents : m_sessionEventRepository);
+        });
+    }
 
-    for (int i = 0; i < appUsages.size(); i++) {
-        if (!appUsages[i].isObject()) {
-            LOG_WARNING(QString("Invalid app usage at index %1 - not an object").arg(i));
-            failureCount++;
-            failures.append(QJsonObject{{"index", i}, {"error", "Not a valid JSON object"}});
-            continue;
+    if (writers.size() < 2 || !m_workerPool || !m_workerPool->isRunning()) {
+        bool success = true;
+        for (const auto &writer : writers) {
+            if (!writer(nullptr, results)) {
+                success = false;
+            }
         }
+        return success;
+    }
 
-        QJsonObject usageData = appUsages[i].toObject();
+    // Each array lands in its own partitioned table, so they can be written concurrently
+    std::vector<QJsonObject> partials(writers.size());
+    std::vector<char> succeeded(writers.size(), 0);
+    QList<BatchWorkerPool::Task> tasks;
+    for (int i = 0; i < writers.size(); ++i) {
+        tasks.append([&, i](const Repositories& repositories) {
+            succeeded[i] = writers[i](&repositories, partials[i]);
+        });
+    }
+    m_workerPool->runAll(tasks);
 
-        try {
-            // Create app usage
-            AppUsageModel *appUsage = new AppUsageModel();
-            appUsage->setSessionId(sessionId);
+    // Merge the per-array results; each writer used its own keys
+    bool success = true;
+    QJsonObject counts = results["processed_counts"].toObject();
+    for (int i = 0; i < writers.size(); ++i) {
+        if (!succeeded[i]) {
+            success = false;
+        }
 
-            // Check required app_id
-            if (!usageData.contains("app_id") || usageData["app_id"].toString().isEmpty()) {
-                LOG_WARNING(QString("App usage at index %1 missing required app_id").arg(i));
-                failureCount++;
-                failures.append(QJsonObject{{"index", i}, {"error", "Missing required app_id"}});
-                delete appUsage;
+        for (auto it = partials[i].constBegin(); it != partials[i].constEnd(); ++it) {
+            if (it.key() != "processed_counts") {
+                results[it.key()] = it.value();
                 continue;
             }
 
-            appUsage->setAppId(QUuid(usageData["app_id"].toString()));
-
-            // Set window title if provided
-            if (usageData.contains("window_title")) {
-                appUsage->setWindowTitle(usageData["window_title"].toString());
-            }
-
-            // Set start time
-            if (usageData.contains("start_time") && !usageData["start_time"].toString().isEmpty()) {
-                QDateTime startTime = QDateTime::fromString(usageData["start_time"].toString(), Qt::ISODate);
-                if (startTime.isValid()) {
-                    appUsage->setStartTime(startTime);
-                } else {
-                    appUsage->setStartTime(QDateTime::currentDateTimeUtc());
-                }
-            } else {
-                appUsage->setStartTime(QDateTime::currentDateTimeUtc());
-            }
-
-            // Set end time if provided (for completed app usages)
-            if (usageData.contains("end_time") && !usageData["end_time"].toString().isEmpty()) {
-                QDateTime endTime = QDateTime::fromString(usageData["end_time"].toString(), Qt::ISODate);
-                if (endTime.isValid()) {
-                    appUsage->setEndTime(endTime);
-                }
+            const QJsonObject partialCounts = it.value().toObject();
+            for (auto count = partialCounts.constBegin(); count != partialCounts.constEnd(); ++count) {
+                counts[count.key()] = count.value();
             }
-
-            // Set metadata
-            appUsage->setCreatedBy(userId);
-            appUsage->setUpdatedBy(userId);
-            appUsage->setCreatedAt(QDateTime::currentDateTimeUtc());
-            appUsage->setUpdatedAt(QDateTime::currentDateTimeUtc());
-
-            // Save app usage
-            bool success = m_appUsageRepository->save(appUsage);
-
-            if (success) {
-                successCount++;
-            } else {
-                failureCount++;
-                failures.append(QJsonObject{{"index", i}, {"error", "Failed to save to database"}});
-            }
-
-            delete appUsage;
-        }
-        catch (const std::exception &e) {
-            LOG_ERROR(QString("Exception processing app usage at index %1: %2").arg(i).arg(e.what()));
-            failureCount++;
-            failures.append(QJsonObject{
-                {"index", i},
-                {"error", QString("Exception: %1").arg(e.what())}
-            });
         }
     }
-
-    // Update results
-    QJsonObject counts = results["processed_counts"].toObject();
-    counts["app_usages_success"] = successCount;
-    counts["app_usages_failure"] = failureCount;
-    counts["app_usages_total"] = appUsages.size();
     results["processed_counts"] = counts;
 
-    if (failureCount > 0) {
-        results["app_usages_failures"] = failures;
-    }
-
-    LOG_INFO(QString("Processed %1 app usages: %2 successful, %3 failed")
-            .arg(appUsages.size()).arg(successCount).arg(failureCount));
-
-    return (failureCount == 0);
+    return success;
 }
 
-bool BatchController::processSystemMetrics(const QJsonArray &metrics, QUuid sessionId, QUuid userId, QJsonObject &results)
+namespace {
+
+// Builds and saves one model per row, recording <key>_success/_failure/_duplicate/_total counts.
+// All rows of the array are written in one transaction with a savepoint per row,
+// so a rejected row is rolled back on its own and the rest commit together.
+// With a valid claimExpiresAt each row first claims its client_seq under the same
+// savepoint; a row whose claim another request holds or committed is skipped.
+template<typename Model, typename Repository, typename Builder>
+bool processBatchRows(const QJsonArray &rows, const QString &key, const QString &label,
+                      Repository *repository, const QUuid &sessionId, const QDateTime &claimExpiresAt,
+                      Builder build, QJsonObject &results)
 {
-    LOG_DEBUG(QString("Processing %1 system metrics").arg(metrics.size()));
+    LOG_DEBUG(QString("Processing %1 %2").arg(rows.size()).arg(label));
+
+    static const QString savepoint = "batch_row";
 
-    int successCount = 0;
     int failureCount = 0;
+    int duplicateCount = 0;
     QJsonArray failures;
+    QList<int> savedIndices;
+
+    // Without a transaction every row is committed on its own, as before
+    bool inTransaction = !rows.isEmpty() && repository->beginTransaction();
+    bool transactionAborted = false;
 
-    for (int i = 0; i < metrics.size(); i++) {
-        if (!metrics[i].isObject()) {
-            LOG_WARNING(QString("Invalid system metric at index %1 - not an object").arg(i));
+    int i = 0;
+    for (; i < rows.size(); i++) {
+        if (!rows[i].isObject()) {
+            LOG_WARNING(QString("Invalid %1 at index %2 - not an object").arg(label).arg(i));
             failureCount++;
             failures.append(QJsonObject{{"index", i}, {"error", "Not a valid JSON object"}});
             continue;
         }
 
-        QJsonObject metricData = metrics[i].toObject();
-
         try {
-            // Create system metrics
-            SystemMetricsModel *systemMetric = new SystemMetricsModel();
-            systemMetric->setSessionId(sessionId);
-
-            // Set CPU usage
-            if (metricData.contains("cpu_usage") && metricData["cpu_usage"].isDouble()) {
-                systemMetric->setCpuUsage(metricData["cpu_usage"].toDouble());
-            } else {
-                systemMetric->setCpuUsage(0.0);
-            }
-
-            // Set GPU usage
-            if (metricData.contains("gpu_usage") && metricData["gpu_usage"].isDouble()) {
-                systemMetric->setGpuUsage(metricData["gpu_usage"].toDouble());
-            } else {
-                systemMetric->setGpuUsage(0.0);
+            QString error;
+            QScopedPointer<Model> model(build(rows[i].toObject(), error));
+            if (!model) {
+                LOG_WARNING(QString("Invalid %1 at index %2: %3").arg(label).arg(i).arg(error));
+                failureCount++;
+                failures.append(QJsonObject{{"index", i}, {"error", error}});
+                continue;
             }
 
-            // Set memory usage
-            if (metricData.contains("memory_usage") && metricData["memory_usage"].isDouble()) {
-                systemMetric->setMemoryUsage(metricData["memory_usage"].toDouble());
-            } else {
-                systemMetric->setMemoryUsage(0.0);
+            if (inTransaction && !repository->createSavepoint(savepoint)) {
+                transactionAborted = true;
+                break;
             }
 
-            // Set measurement time
-            if (metricData.contains("measurement_time") && !metricData["measurement_time"].toString().isEmpty()) {
-                QDateTime measurementTime = QDateTime::fromString(metricData["measurement_time"].toString(), Qt::ISODate);
-                if (measurementTime.isValid()) {
-                    systemMetric->setMeasurementTime(measurementTime);
-                } else {
-                    systemMetric->setMeasurementTime(QDateTime::currentDateTimeUtc());
+            // Outside a transaction a claim would outlive a failed save, so only the prefilter applies
+            const QJsonValue seq = rows[i].toObject().value("client_seq");
+            if (inTransaction && claimExpiresAt.isValid() && !seq.isUndefined()) {
+                const auto claimed = repository->claimClientSequences(sessionId, {seq.toInteger()}, claimExpiresAt);
+                if (claimed && claimed->isEmpty()) {
+                    duplicateCount++;
+                    repository->releaseSavepoint(savepoint);
+                    continue;
+                }
+                if (!claimed) {
+                    failureCount++;
+                    failures.append(QJsonObject{{"index", i}, {"error", "Failed to claim client_seq"}});
+                    if (!repository->rollbackToSavepoint(savepoint)) {
+                        i++;
+                        transactionAborted = true;
+                        break;
+                    }
+                    continue;
                 }
-            } else {
-                systemMetric->setMeasurementTime(QDateTime::currentDateTimeUtc());
             }
 
-            // Set metadata
-            systemMetric->setCreatedBy(userId);
-            systemMetric->setUpdatedBy(userId);
-            systemMetric->setCreatedAt(QDateTime::currentDateTimeUtc());
-            systemMetric->setUpdatedAt(QDateTime::currentDateTimeUtc());
-
-            // Save system metric
-            bool success = m_systemMetricsRepository->save(systemMetric);
-
-            if (success) {
-                successCount++;
+            if (repository->save(model.data())) {
+                savedIndices.append(i);
+                if (inTransaction) {
+                    repository->releaseSavepoint(savepoint);
+                }
             } else {
                 failureCount++;
                 failures.append(QJsonObject{{"index", i}, {"error", "Failed to save to database"}});
+                if (inTransaction && !repository->rollbackToSavepoint(savepoint)) {
+                    i++;
+                    transactionAborted = true;
+                    break;
+                }
             }
-
-            delete systemMetric;
         }
         catch (const std::exception &e) {
-            LOG_ERROR(QString("Exception processing system metric at index %1: %2").arg(i).arg(e.what()));
+            LOG_ERROR(QString("Exception processing %1 at index %2: %3").arg(label).arg(i).arg(e.what()));
             failureCount++;
             failures.append(QJsonObject{
                 {"index", i},
@@ -720,171 +549,192 @@ bool BatchController::processSystemMetrics(const QJsonArray &metrics, QUuid sess
         }
     }
 
+    if (inTransaction && !transactionAborted && !repository->commitTransaction()) {
+        transactionAborted = true;
+    }
+
+    // Nothing in an aborted transaction was written, so rows saved before it failed are reported too
+    if (transactionAborted) {
+        LOG_ERROR(QString("Transaction for %1 aborted, rolling back %2 saved rows").arg(label).arg(savedIndices.size()));
+        repository->rollbackTransaction();
+
+        for (int index : savedIndices) {
+            failures.append(QJsonObject{{"index", index}, {"error", "Batch transaction rolled back"}});
+        }
+        for (; i < rows.size(); i++) {
+            failures.append(QJsonObject{{"index", i}, {"error", "Batch transaction rolled back"}});
+        }
+        failureCount = failures.size();
+        savedIndices.clear();
+        duplicateCount = 0;
+    }
+
+    int successCount = savedIndices.size();
+
     // Update results
     QJsonObject counts = results["processed_counts"].toObject();
-    counts["system_metrics_success"] = successCount;
-    counts["system_metrics_failure"] = failureCount;
-    counts["system_metrics_total"] = metrics.size();
+    counts[key + "_success"] = successCount;
+    counts[key + "_failure"] = failureCount;
+    counts[key + "_duplicate"] = duplicateCount;
+    counts[key + "_total"] = rows.size();
     results["processed_counts"] = counts;
 
     if (failureCount > 0) {
-        results["system_metrics_failures"] = failures;
+        results[key + "_failures"] = failures;
     }
 
-    LOG_INFO(QString("Processed %1 system metrics: %2 successful, %3 failed")
-            .arg(metrics.size()).arg(successCount).arg(failureCount));
+    LOG_INFO(QString("Processed %1 %2: %3 successful, %4 failed, %5 already committed")
+            .arg(rows.size()).arg(label).arg(successCount).arg(failureCount).arg(duplicateCount));
 
     return (failureCount == 0);
 }
 
-bool BatchController::processSessionEvents(const QJsonArray &events, QUuid sessionId, QUuid userId, QJsonObject &results)
+} // namespace
+
+bool BatchController::processActivityEvents(const QJsonArray &events, QUuid sessionId, QUuid userId, QJsonObject &results,
+                                            ActivityEventRepository *repository)
 {
-    LOG_DEBUG(QString("Processing %1 session events").arg(events.size()));
+    const QDateTime receivedAt = QDateTime::currentDateTimeUtc();
+    return processBatchRows<ActivityEventModel>(events, "activity_events", "activity events",
+        repository, sessionId, claimExpiresAt(),
+        [&](const QJsonObject &row, QString &error) {
+            return ModelFactory::createActivityEventFromBatch(row, sessionId, userId, receivedAt, error);
+        }, results);
+}
 
-    int successCount = 0;
-    int failureCount = 0;
-    QJsonArray failures;
+bool BatchController::processAppUsages(const QJsonArray &appUsages, QUuid sessionId, QUuid userId, QJsonObject &results,
+                                       AppUsageRepository *repository)
+{
+    const QDateTime receivedAt = QDateTime::currentDateTimeUtc();
+    return processBatchRows<AppUsageModel>(appUsages, "app_usages", "app usages",
+        repository, sessionId, claimExpiresAt(),
+        [&](const QJsonObject &row, QString &error) {
+            return ModelFactory::createAppUsageFromBatch(row, sessionId, userId, receivedAt, error);
+        }, results);
+}
 
-    for (int i = 0; i < events.size(); i++) {
-        if (!events[i].isObject()) {
-            LOG_WARNING(QString("Invalid session event at index %1 - not an object").arg(i));
-            failureCount++;
-            failures.append(QJsonObject{{"index", i}, {"error", "Not a valid JSON object"}});
-            continue;
-        }
+bool BatchController::processSystemMetrics(const QJsonArray &metrics, QUuid sessionId, QUuid userId, QJsonObject &results,
+                                           SystemMetricsRepository *repository)
+{
+    const QDateTime receivedAt = QDateTime::currentDateTimeUtc();
+    return processBatchRows<SystemMetricsModel>(metrics, "system_metrics", "system metrics",
+        repository, sessionId, claimExpiresAt(),
+        [&](const QJsonObject &row, QString &error) {
+            return ModelFactory::createSystemMetricsFromBatch(row, sessionId, userId, receivedAt, error);
+        }, results);
+}
 
-        QJsonObject eventData = events[i].toObject();
+bool BatchController::processSessionEvents(const QJsonArray &events, QUuid sessionId, QUuid userId, QJsonObject &results,
+                                           SessionEventRepository *repository)
+{
+    const QDateTime receivedAt = QDateTime::currentDateTimeUtc();
+    return processBatchRows<SessionEventModel>(events, "session_events", "session events",
+        repository, sessionId, claimExpiresAt(),
+        [&](const QJsonObject &row, QString &error) {
+            return ModelFactory::createSessionEventFromBatch(row, sessionId, userId, receivedAt, error);
+        }, results);
+}
 
-        try {
-            // Create session event - note the correct type: SessionEventModel, not ActivityEventModel
-            SessionEventModel *event = new SessionEventModel();
-            event->setSessionId(sessionId);
-
-            // Set event type
-            if (eventData.contains("event_type") && !eventData["event_type"].toString().isEmpty()) {
-                QString eventTypeStr = eventData["event_type"].toString();
-                EventTypes::SessionEventType eventType;
-
-                if (eventTypeStr == "login") {
-                    eventType = EventTypes::SessionEventType::Login;
-                } else if (eventTypeStr == "logout") {
-                    eventType = EventTypes::SessionEventType::Logout;
-                } else if (eventTypeStr == "lock") {
-                    eventType = EventTypes::SessionEventType::Lock;
-                } else if (eventTypeStr == "unlock") {
-                    eventType = EventTypes::SessionEventType::Unlock;
-                } else if (eventTypeStr == "switch_user") {
-                    eventType = EventTypes::SessionEventType::SwitchUser;
-                } else if (eventTypeStr == "remote_connect") {
-                    eventType = EventTypes::SessionEventType::RemoteConnect;
-                } else if (eventTypeStr == "remote_disconnect") {
-                    eventType = EventTypes::SessionEventType::RemoteDisconnect;
-                } else {
-                    // Default to login if unknown
-                    eventType = EventTypes::SessionEventType::Login;
-                    LOG_WARNING(QString("Unknown session event type: %1, defaulting to Login").arg(eventTypeStr));
-                }
+QDateTime BatchController::claimExpiresAt() const
+{
+    return m_dedupeIndex ? m_dedupeIndex->sequenceExpiresAt() : QDateTime();
+}
 
-                event->setEventType(eventType);
-            } else {
-                event->setEventType(EventTypes::SessionEventType::Login);
-                LOG_WARNING("Session event missing event_type, defaulting to Login");
-            }
+QJsonObject BatchController::extractJsonFromRequest(const QHttpServerRequest &request, bool &ok,
+                                                    bool &unsupportedFormat)
+{
+    ok = false;
+    unsupportedFormat = false;
 
-            // Set user ID if provided
-            if (eventData.contains("user_id") && !eventData["user_id"].toString().isEmpty()) {
-                event->setUserId(QUuid(eventData["user_id"].toString()));
-            } else {
-                // Default to the authenticated user
-                event->setUserId(userId);
-            }
+    QByteArray body = request.body();
 
-            // Set previous user ID if provided (for switch user events)
-            if (eventData.contains("previous_user_id") && !eventData["previous_user_id"].toString().isEmpty()) {
-                event->setPreviousUserId(QUuid(eventData["previous_user_id"].toString()));
-            }
+    // Agents send the columnar CBOR form when the server accepts it; a format version this
+    // build does not read gets 415, so the agent falls back to JSON
+    const QByteArray contentType = request.value("Content-Type");
+    if (BatchCbor::isCborContentType(contentType)) {
+        if (!BatchCbor::isSupportedContentType(contentType)) {
+            LOG_WARNING(QString("Unsupported CBOR batch format: %1").arg(QString::fromUtf8(contentType)));
+            unsupportedFormat = true;
+            return QJsonObject();
+        }
 
-            // Set machine ID if provided
-            if (eventData.contains("machine_id") && !eventData["machine_id"].toString().isEmpty()) {
-                event->setMachineId(QUuid(eventData["machine_id"].toString()));
-            } else {
-                LOG_WARNING(QString("Session event at index %1 missing machine_id").arg(i));
-                // We'll still process it, but machine ID is generally expected
-            }
+        QJsonObject json;
+        QString error;
+        if (!BatchCbor::decode(body, json, error, &unsupportedFormat)) {
+            LOG_WARNING(QString("Failed to decode CBOR batch: %1").arg(error));
+            return QJsonObject();
+        }
 
-            // Set terminal session ID if provided
-            if (eventData.contains("terminal_session_id") && !eventData["terminal_session_id"].toString().isEmpty()) {
-                event->setTerminalSessionId(eventData["terminal_session_id"].toString());
-            }
+        ok = true;
+        LOG_DEBUG(QString("Decoded CBOR batch of %1 bytes").arg(body.size()));
+        return json;
+    }
 
-            // Set is_remote flag if provided
-            if (eventData.contains("is_remote")) {
-                event->setIsRemote(eventData["is_remote"].toBool());
-            }
+    // Parse JSON body
+    QJsonDocument doc = QJsonDocument::fromJson(body);
+    if (doc.isNull() || !doc.isObject()) {
+        LOG_WARNING("Failed to parse JSON from request body");
+        return QJsonObject();
+    }
 
-            // Set event time
-            if (eventData.contains("event_time") && !eventData["event_time"].toString().isEmpty()) {
-                QDateTime eventTime = QDateTime::fromString(eventData["event_time"].toString(), Qt::ISODate);
-                if (eventTime.isValid()) {
-                    event->setEventTime(eventTime);
-                } else {
-                    LOG_WARNING(QString("Invalid event_time format at index %1, using current time").arg(i));
-                    event->setEventTime(QDateTime::currentDateTimeUtc());
-                }
-            } else {
-                event->setEventTime(QDateTime::currentDateTimeUtc());
-            }
+    ok = true;
+    LOG_DEBUG(QString("Extracted JSON: %1").arg(QString::fromUtf8(body)));
+    return doc.object();
+}
 
-            // Set event data
-            if (eventData.contains("event_data") && eventData["event_data"].isObject()) {
-                event->setEventData(eventData["event_data"].toObject());
-            }
+QString BatchController::extractIdempotencyKey(const QHttpServerRequest &request, const QJsonObject &json) const
+{
+    // Agents that cannot set headers may send the key as client_batch_id in the body
+    QString key = QString::fromUtf8(request.value("Idempotency-Key")).trimmed();
+    if (key.isEmpty()) {
+        key = json["client_batch_id"].toString().trimmed();
+    }
 
-            // Set metadata
-            event->setCreatedBy(userId);
-            event->setUpdatedBy(userId);
-            event->setCreatedAt(QDateTime::currentDateTimeUtc());
-            event->setUpdatedAt(QDateTime::currentDateTimeUtc());
+    return key.left(128);
+}
 
-            // Save event using the SessionEventRepository (fixed)
-            bool success = m_sessionEventRepository->save(event);
+bool BatchController::sessionExists(const QUuid &sessionId)
+{
+    static const qint64 CacheTtlMs = 60 * 1000;
+    static const int MaxCachedSessions = 10000;
 
-            if (success) {
-                successCount++;
-                LOG_DEBUG(QString("Successfully saved session event %1 of type %2")
-                         .arg(event->id().toString(), event->eventType() == EventTypes::SessionEventType::Login ? "Login" :
-                             (event->eventType() == EventTypes::SessionEventType::Logout ? "Logout" : "Other")));
-            } else {
-                failureCount++;
-                LOG_ERROR(QString("Failed to save session event at index %1").arg(i));
-                failures.append(QJsonObject{{"index", i}, {"error", "Failed to save to database"}});
-            }
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    auto it = m_knownSessions.constFind(sessionId);
+    if (it != m_knownSessions.constEnd() && it.value() > now) {
+        return true;
+    }
 
-            delete event;
-        }
-        catch (const std::exception &e) {
-            LOG_ERROR(QString("Exception processing session event at index %1: %2").arg(i).arg(e.what()));
-            failureCount++;
-            failures.append(QJsonObject{
-                {"index", i},
-                {"error", QString("Exception: %1").arg(e.what())}
-            });
-        }
+    // Only hits are cached, so a session created after a miss is found on the next batch
+    if (!m_sessionRepository->exists(sessionId)) {
+        m_knownSessions.remove(sessionId);
+        return false;
     }
 
-    // Update results
-    QJsonObject counts = results["processed_counts"].toObject();
-    counts["session_events_success"] = successCount;
-    counts["session_events_failure"] = failureCount;
-    counts["session_events_total"] = events.size();
-    results["processed_counts"] = counts;
+    if (m_knownSessions.size() >= MaxCachedSessions) {
+        m_knownSessions.clear();
+    }
+    m_knownSessions.insert(sessionId, now + CacheTtlMs);
+    return true;
+}
 
-    if (failureCount > 0) {
-        results["session_events_failures"] = failures;
+QUuid BatchController::stringToUuid(const QString &str) const
+{
+    // Handle both simple format and UUID format
+    if (str.contains('-')) {
+        return QUuid(str);
+    } else {
+        // Create UUID from simple format (without dashes)
+        QString withDashes = str;
+        withDashes.insert(8, '-');
+        withDashes.insert(13, '-');
+        withDashes.insert(18, '-');
+        withDashes.insert(23, '-');
+        return QUuid(withDashes);
     }
+}
 
-    LOG_INFO(QString("Processed %1 session events: %2 successful, %3 failed")
-            .arg(events.size()).arg(successCount).arg(failureCount));
+QString BatchController::uuidToString(const QUuid &uuid) const
+{
+    return uuid.toString(QUuid::WithoutBraces);
+}
 
-    return (failureCount == 0);
-}
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "ApiControllerBase.h"
 #include <QSharedPointer>
+#include <QHash>
 #include <QJsonArray>
 #include <QJsonObject>
 
@@ -14,6 +15,10 @@
 #include "../Repositories/SessionRepository.h"
 #include "AuthController.h"
 
+class BatchSpool;
+class BatchDedupeIndex;
+class BatchWorkerPool;
+
 class BatchController : public ApiControllerBase
 {
     Q_OBJECT
@@ -33,6 +38,15 @@ public:
 
     void setupRoutes(QHttpServer &server) override;
     void setAuthController(AuthController* authController) { m_authController = authController; }
+
+    // Queue batches to the spool and answer 202 instead of writing them inline
+    void setBatchSpool(BatchSpool* batchSpool) { m_batchSpool = batchSpool; }
+
+    // Answer resent batches from their stored response and skip rows already committed
+    void setDedupeIndex(BatchDedupeIndex* dedupeIndex) { m_dedupeIndex = dedupeIndex; }
+
+    // Write the arrays of a synchronous batch concurrently on the pool's connections
+    void setWorkerPool(BatchWorkerPool* workerPool) { m_workerPool = workerPool; }
     QString getControllerName() const override { return "BatchController"; }
 
 private:
@@ -40,14 +54,32 @@ private:
     QHttpServerResponse handleProcessBatch(const QHttpServerRequest &request);
     QHttpServerResponse handleProcessSessionBatch(const qint64 sessionId, const QHttpServerRequest &request);
 
-    // Specific batch processing methods
-    bool processActivityEvents(const QJsonArray &events, QUuid sessionId, QUuid userId, QJsonObject &results);
-    bool processAppUsages(const QJsonArray &appUsages, QUuid sessionId, QUuid userId, QJsonObject &results);
-    bool processSystemMetrics(const QJsonArray &metrics, QUuid sessionId, QUuid userId, QJsonObject &results);
-    bool processSessionEvents(const QJsonArray &events, QUuid sessionId, QUuid userId, QJsonObject &results);
+    // Spool the validated batch, or write it synchronously and report per-type counts
+    QHttpServerResponse processBatchData(const QJsonObject &json, const QUuid &sessionId, const QUuid &userId,
+                                         const QString &idempotencyKey);
+
+    // Write every array in the batch, on the worker pool when there is more than one
+    bool processBatchArrays(const QJsonObject &batch, const QUuid &sessionId, const QUuid &userId, QJsonObject &results);
+
+    // Specific batch processing methods; the repository decides which connection is used
+    bool processActivityEvents(const QJsonArray &events, QUuid sessionId, QUuid userId, QJsonObject &results,
+                               ActivityEventRepository *repository);
+    bool processAppUsages(const QJsonArray &appUsages, QUuid sessionId, QUuid userId, QJsonObject &results,
+                          AppUsageRepository *repository);
+    bool processSystemMetrics(const QJsonArray &metrics, QUuid sessionId, QUuid userId, QJsonObject &results,
+                              SystemMetricsRepository *repository);
+    bool processSessionEvents(const QJsonArray &events, QUuid sessionId, QUuid userId, QJsonObject &results,
+                              SessionEventRepository *repository);
+
+    // Expiry for the rows' client_seq claims; invalid when there is no dedupe index
+    QDateTime claimExpiresAt() const;
 
     // Helper methods
-    QJsonObject extractJsonFromRequest(const QHttpServerRequest &request, bool &ok);
+    QJsonObject extractJsonFromRequest(const QHttpServerRequest &request, bool &ok, bool &unsupportedFormat);
+    QString extractIdempotencyKey(const QHttpServerRequest &request, const QJsonObject &json) const;
+
+    // Session lookups are cached briefly; agents post many batches to the same session
+    bool sessionExists(const QUuid &sessionId);
     QUuid stringToUuid(const QString &str) const;
     QString uuidToString(const QUuid &uuid) const;
 
@@ -58,6 +90,10 @@ private:
     SessionEventRepository *m_sessionEventRepository;
     SessionRepository *m_sessionRepository;
     AuthController *m_authController = nullptr;
+    BatchSpool *m_batchSpool = nullptr;
+    BatchDedupeIndex *m_dedupeIndex = nullptr;
+    BatchWorkerPool *m_workerPool = nullptr;
+    QHash<QUuid, qint64> m_knownSessions;   ///< Session ID -> cache expiry (ms since epoch)
     bool m_initialized;
 };
 
@@ -1,11 +1,19 @@
 #include "ServerStatusController.h"
 #include "logger/logger.h"
 #include "httpserver/response.h"
+#include "dbservice/querystats.h"
 #include <QCoreApplication>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QSysInfo>
 #include <QHostInfo>
+#include <QDir>
+#include <QFile>
+#include <QUrlQuery>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
 
 ServerStatusController::ServerStatusController(QObject *parent)
     : ApiControllerBase(parent)
@@ -52,6 +60,23 @@ void ServerStatusController::setupRoutes(QHttpServer &server)
             return response;
         });
 
+    // Database time per statement and the slow-query log
+    server.route("/api/status/queries", QHttpServerRequest::Method::Get,
+        [this](const QHttpServerRequest &request) {
+            logRequestReceived(request);
+            auto response = handleQueryStats(request);
+            logRequestCompleted(request, response.statusCode());
+            return response;
+        });
+
+    server.route("/api/status/queries/reset", QHttpServerRequest::Method::Post,
+        [this](const QHttpServerRequest &request) {
+            logRequestReceived(request);
+            auto response = handleQueryStatsReset(request);
+            logRequestCompleted(request, response.statusCode());
+            return response;
+        });
+
     LOG_INFO("ServerStatusController routes configured");
 }
 
@@ -96,11 +121,71 @@ QHttpServerResponse ServerStatusController::handleHealthCheck(const QHttpServerR
     response["version"] = m_version;
     response["build_date"] = m_buildDate;
 
-    // Add memory usage if available
-    #ifdef Q_OS_LINUX
-    // On Linux we could add memory info from /proc/meminfo
-    #endif
+    // Resource usage of this process, sampled over time by load tests
+    QJsonObject process = processUsage();
+    if (!process.isEmpty()) {
+        response["process"] = process;
+    }
+
+    return createSuccessResponse(response);
+}
+
+QJsonObject ServerStatusController::processUsage() const
+{
+    QJsonObject process;
+    process["pid"] = QCoreApplication::applicationPid();
+
+#ifdef Q_OS_LINUX
+    QFile statFile("/proc/self/stat");
+    if (statFile.open(QIODevice::ReadOnly)) {
+        // Fields after the parenthesised command name, starting at the state (field 3)
+        const QByteArray stat = statFile.readAll();
+        const QList<QByteArray> fields = stat.mid(stat.lastIndexOf(')') + 2).split(' ');
+        if (fields.size() > 21) {
+            const double ticksPerSecond = sysconf(_SC_CLK_TCK);
+            process["cpu_seconds"] = (fields[11].toLongLong() + fields[12].toLongLong()) / ticksPerSecond;
+            process["threads"] = fields[17].toInt();
+            process["rss_bytes"] = fields[21].toLongLong() * sysconf(_SC_PAGESIZE);
+        }
+    }
+    process["open_fds"] = QDir("/proc/self/fd").entryList(QDir::AllEntries | QDir::System | QDir::NoDotAndDotDot).size();
+#endif
+
+    return process;
+}
+
+QHttpServerResponse ServerStatusController::handleQueryStats(const QHttpServerRequest &request)
+{
+    QJsonObject userData;
+    if (!isUserAuthorized(request, userData)) {
+        LOG_WARNING("Unauthorized query statistics request");
+        return Http::Response::unauthorized("Unauthorized");
+    }
+
+    // Statements ordered by total time; limit=0 returns all of them
+    const QUrlQuery query(request.url().query());
+    bool ok = false;
+    int limit = query.queryItemValue("limit").toInt(&ok);
+    if (!ok) {
+        limit = 25;
+    }
+
+    return createSuccessResponse(QueryStats::instance().snapshot(limit));
+}
+
+QHttpServerResponse ServerStatusController::handleQueryStatsReset(const QHttpServerRequest &request)
+{
+    QJsonObject userData;
+    if (!isUserAuthorized(request, userData)) {
+        LOG_WARNING("Unauthorized query statistics reset request");
+        return Http::Response::unauthorized("Unauthorized");
+    }
+
+    QueryStats::instance().reset();
+    LOG_INFO("Query statistics reset");
 
+    QJsonObject response;
+    response["success"] = true;
     return createSuccessResponse(response);
 }
 
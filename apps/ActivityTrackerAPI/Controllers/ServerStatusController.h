@@ -3,6 +3,7 @@
 
 #include "ApiControllerBase.h"
 #include <QDateTime>
+#include <QJsonObject>
 
 /**
  * @brief The ServerStatusController class provides status endpoints for health checking
@@ -24,6 +25,11 @@ private:
     QHttpServerResponse handlePingRequest(const QHttpServerRequest &request);
     QHttpServerResponse handleHealthCheck(const QHttpServerRequest &request);
     QHttpServerResponse handleVersionInfo(const QHttpServerRequest &request);
+    QHttpServerResponse handleQueryStats(const QHttpServerRequest &request);
+    QHttpServerResponse handleQueryStatsReset(const QHttpServerRequest &request);
+
+    // CPU time, resident memory, threads and open descriptors where the platform exposes them
+    QJsonObject processUsage() const;
 
     // Server start time for uptime calculation
     QDateTime m_startTime;
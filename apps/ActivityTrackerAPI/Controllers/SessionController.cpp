@@ -1236,6 +1236,7 @@ QHttpServerResponse SessionController::handleGetUserStats(const qint64 userId, c
         QDateTime endDate = endDateStr.isEmpty() ? QDateTime::currentDateTimeUtc() : QDateTime::fromString(endDateStr, Qt::ISODate);
 
         QJsonObject stats = m_repository->getUserSessionStats(userUuid, startDate, endDate);
+        stats["top_apps"] = m_appUsageRepository->getUserTopApps(userUuid, startDate.toUTC().date(), endDate.toUTC().date());
 
         LOG_INFO(QString("User stats retrieved for user %1").arg(userId));
         return createSuccessResponse(stats);
@@ -1089,46 +1089,15 @@ QString SessionEventController::uuidToString(const QUuid &uuid) const
 
 EventTypes::SessionEventType SessionEventController::stringToEventType(const QString &eventTypeStr) const
 {
-    if (eventTypeStr == "login") {
-        return EventTypes::SessionEventType::Login;
-    } else if (eventTypeStr == "logout") {
-        return EventTypes::SessionEventType::Logout;
-    } else if (eventTypeStr == "lock") {
-        return EventTypes::SessionEventType::Lock;
-    } else if (eventTypeStr == "unlock") {
-        return EventTypes::SessionEventType::Unlock;
-    } else if (eventTypeStr == "switch_user") {
-        return EventTypes::SessionEventType::SwitchUser;
-    } else if (eventTypeStr == "remote_connect") {
-        return EventTypes::SessionEventType::RemoteConnect;
-    } else if (eventTypeStr == "remote_disconnect") {
-        return EventTypes::SessionEventType::RemoteDisconnect;
-    } else {
+    EventTypes::SessionEventType eventType = EventTypes::SessionEventType::Login;
+    if (!EventTypes::sessionEventTypeFromString(eventTypeStr, eventType)) {
         LOG_WARNING(QString("Unknown event type string: %1, defaulting to Login").arg(eventTypeStr));
-        return EventTypes::SessionEventType::Login;
     }
+    return eventType;
 }
 
 QString SessionEventController::eventTypeToString(EventTypes::SessionEventType eventType) const
 {
-    switch (eventType) {
-    case EventTypes::SessionEventType::Login:
-        return "login";
-    case EventTypes::SessionEventType::Logout:
-        return "logout";
-    case EventTypes::SessionEventType::Lock:
-        return "lock";
-    case EventTypes::SessionEventType::Unlock:
-        return "unlock";
-    case EventTypes::SessionEventType::SwitchUser:
-        return "switch_user";
-    case EventTypes::SessionEventType::RemoteConnect:
-        return "remote_connect";
-    case EventTypes::SessionEventType::RemoteDisconnect:
-        return "remote_disconnect";
-    default:
-        LOG_WARNING(QString("Unknown event type enum: %1, mapping to unknown").arg(static_cast<int>(eventType)));
-        return "unknown";
-    }
+    return EventTypes::sessionEventTypeToString(eventType);
 }
 
@@ -3,6 +3,7 @@
 #include <QJsonArray>
 #include <QDateTime>
 #include <QUrlQuery>
+#include <QHash>
 #include <algorithm>
 #include "../Utils/SystemInfo.h"
 #include "logger/logger.h"
@@ -569,63 +570,60 @@ QHttpServerResponse SystemMetricsController::handleGetMetricsTimeSeries(const qi
             return createErrorResponse(QString("Invalid metric type. Must be one of: cpu, gpu, memory, all"), QHttpServerResponder::StatusCode::BadRequest);
         }
 
-        // Since getMetricsTimeSeries doesn't exist, we'll generate the time series manually
-        QList<QSharedPointer<SystemMetricsModel>> allMetrics = m_systemMetricsRepository->getAll();
-
-        // Filter by session ID
-        QList<QSharedPointer<SystemMetricsModel>> sessionMetrics;
-        for (const auto &metric : allMetrics) {
-            if (metric->sessionId() == sessionUuid) {
-                sessionMetrics.append(metric);
+        // bucket=1m|5m|1h aggregates in SQL; max_points=N downsamples the raw samples
+        QUrlQuery query(request.url().query());
+        QString bucket = query.queryItemValue("bucket");
+        int maxPoints = 0;
+        if (query.hasQueryItem("max_points")) {
+            // LTTB keeps the first and last sample plus one per bucket, so fewer than 3 cannot be honoured
+            bool validMaxPoints = false;
+            maxPoints = query.queryItemValue("max_points").toInt(&validMaxPoints);
+            if (!validMaxPoints || maxPoints < 3) {
+                LOG_WARNING(QString("Invalid max_points: %1").arg(query.queryItemValue("max_points")));
+                return createErrorResponse("Invalid max_points. Must be an integer of at least 3", QHttpServerResponder::StatusCode::BadRequest);
             }
         }
 
-        // Sort by measurement time
-        std::sort(sessionMetrics.begin(), sessionMetrics.end(),
-            [](const QSharedPointer<SystemMetricsModel> &a, const QSharedPointer<SystemMetricsModel> &b) {
-                return a->measurementTime() < b->measurementTime();
-            });
+        static const QHash<QString, int> bucketSeconds = {{"1m", 60}, {"5m", 300}, {"1h", 3600}};
+        if (!bucket.isEmpty() && !bucketSeconds.contains(bucket)) {
+            LOG_WARNING(QString("Invalid bucket: %1").arg(bucket));
+            return createErrorResponse("Invalid bucket. Must be one of: 1m, 5m, 1h", QHttpServerResponder::StatusCode::BadRequest);
+        }
 
         QJsonObject timeSeriesData;
         timeSeriesData["session_id"] = uuidToString(sessionUuid);
         timeSeriesData["metric_type"] = metricType;
-
-        // Build the time series data arrays
-        if (metricType == "cpu" || metricType == "all") {
-            QJsonArray cpuSeries;
-            for (const auto &metric : sessionMetrics) {
-                QJsonObject dataPoint;
-                dataPoint["time"] = metric->measurementTime().toUTC().toString();
-                dataPoint["value"] = metric->cpuUsage();
-                cpuSeries.append(dataPoint);
-            }
-            timeSeriesData["cpu_usage"] = cpuSeries;
+        if (!bucket.isEmpty()) {
+            timeSeriesData["bucket"] = bucket;
+        } else if (maxPoints > 0) {
+            timeSeriesData["max_points"] = maxPoints;
         }
 
-        if (metricType == "gpu" || metricType == "all") {
-            QJsonArray gpuSeries;
-            for (const auto &metric : sessionMetrics) {
-                QJsonObject dataPoint;
-                dataPoint["time"] = metric->measurementTime().toUTC().toString();
-                dataPoint["value"] = metric->gpuUsage();
-                gpuSeries.append(dataPoint);
+        static const QList<QPair<QString, QString>> metrics = {
+            {"cpu", "cpu_usage"}, {"gpu", "gpu_usage"}, {"memory", "memory_usage"}
+        };
+
+        int pointCount = 0;
+        for (const auto &metric : metrics) {
+            if (metricType != metric.first && metricType != "all") {
+                continue;
             }
-            timeSeriesData["gpu_usage"] = gpuSeries;
-        }
 
-        if (metricType == "memory" || metricType == "all") {
-            QJsonArray memorySeries;
-            for (const auto &metric : sessionMetrics) {
-                QJsonObject dataPoint;
-                dataPoint["time"] = metric->measurementTime().toUTC().toString();
-                dataPoint["value"] = metric->memoryUsage();
-                memorySeries.append(dataPoint);
+            QJsonArray series;
+            if (!bucket.isEmpty()) {
+                series = m_systemMetricsRepository->getBucketedMetricsTimeSeries(sessionUuid, metric.second, bucketSeconds.value(bucket));
+            } else if (maxPoints > 0) {
+                series = m_systemMetricsRepository->getDownsampledMetricsTimeSeries(sessionUuid, metric.second, maxPoints);
+            } else {
+                series = m_systemMetricsRepository->getMetricsTimeSeries(sessionUuid, metric.second);
             }
-            timeSeriesData["memory_usage"] = memorySeries;
+
+            pointCount += series.size();
+            timeSeriesData[metric.second] = series;
         }
 
         LOG_INFO(QString("Time series data generated with %1 points for session %2, metric type %3")
-                .arg(sessionMetrics.size()).arg(sessionId).arg(metricType));
+                .arg(pointCount).arg(sessionId).arg(metricType));
         return createSuccessResponse(timeSeriesData);
     }
     catch (const std::exception &e) {
@@ -74,7 +74,7 @@ QString AuthFramework::extractToken(const QHttpServerRequest& request) {
     }
 
     QString token = QString::fromUtf8(authHeader.mid(7));
-    LOG_DEBUG(QString("Token extracted from request: %1").arg(token));
+    LOG_FIELDS(Logger::Debug, "Token extracted from request", LogField::secret("token", token));
     return token;
 }
 
@@ -86,7 +86,7 @@ QString AuthFramework::extractServiceToken(const QHttpServerRequest& request) {
     }
 
     QString token = QString::fromUtf8(authHeader.mid(13));
-    LOG_DEBUG(QString("Service token extracted from request: %1").arg(token));
+    LOG_FIELDS(Logger::Debug, "Service token extracted from request", LogField::secret("token", token));
     return token;
 }
 
@@ -98,7 +98,7 @@ QString AuthFramework::extractApiKey(const QHttpServerRequest& request) {
     }
 
     QString key = QString::fromUtf8(authHeader);
-    LOG_DEBUG(QString("API key extracted from request: %1").arg(key));
+    LOG_FIELDS(Logger::Debug, "API key extracted from request", LogField::secret("api_key", key));
     return key;
 }
 
@@ -107,7 +107,7 @@ QString AuthFramework::extractApiKey(const QHttpServerRequest& request) {
 //------------------------------------------------------------------------------
 
 bool AuthFramework::validateToken(const QString& token, QJsonObject& userData) {
-    LOG_DEBUG(QString("Validating token: %1").arg(token));
+    LOG_FIELDS(Logger::Debug, "Validating token", LogField::secret("token", token));
 
     if (!m_tokenRepository || !m_tokenRepository->isInitialized()) {
         LOG_WARNING("Token repository not initialized, token validation failed");
@@ -117,16 +117,17 @@ bool AuthFramework::validateToken(const QString& token, QJsonObject& userData) {
     bool valid = m_tokenRepository->validateToken(token, userData);
 
     if (valid) {
-        LOG_DEBUG(QString("Token validated from database: %1").arg(token));
+        LOG_FIELDS(Logger::Debug, "Token validated from database", LogField::secret("token", token));
         return true;
     }
 
-    LOG_WARNING(QString("Token validation failed: Token not found or invalid - %1").arg(token));
+    LOG_FIELDS(Logger::Warning, "Token validation failed: Token not found or invalid",
+               LogField::secret("token", token));
     return false;
 }
 
 bool AuthFramework::validateServiceToken(const QString& token, QJsonObject& tokenData) {
-    LOG_DEBUG(QString("Validating service token: %1").arg(token));
+    LOG_FIELDS(Logger::Debug, "Validating service token", LogField::secret("token", token));
 
     if (!m_tokenRepository || !m_tokenRepository->isInitialized()) {
         LOG_WARNING("Token repository not initialized, service token validation failed");
@@ -143,16 +144,16 @@ bool AuthFramework::validateServiceToken(const QString& token, QJsonObject& toke
         // Update last used time
         m_tokenRepository->updateTokenLastUsed(token);
 
-        LOG_DEBUG(QString("Service token validated from database: %1").arg(token));
+        LOG_FIELDS(Logger::Debug, "Service token validated from database", LogField::secret("token", token));
         return true;
     }
 
-    LOG_WARNING(QString("Service token validation failed: %1").arg(token));
+    LOG_FIELDS(Logger::Warning, "Service token validation failed", LogField::secret("token", token));
     return false;
 }
 
 bool AuthFramework::validateApiKey(const QString& key, QJsonObject& apiKeyData) {
-    LOG_DEBUG(QString("Validating API key: %1").arg(key));
+    LOG_FIELDS(Logger::Debug, "Validating API key", LogField::secret("api_key", key));
 
     if (!m_tokenRepository || !m_tokenRepository->isInitialized()) {
         LOG_WARNING("Token repository not initialized, API key validation failed");
@@ -169,11 +170,11 @@ bool AuthFramework::validateApiKey(const QString& key, QJsonObject& apiKeyData)
         // Update last used time
         m_tokenRepository->updateTokenLastUsed(key);
 
-        LOG_DEBUG(QString("API key validated from database: %1").arg(key));
+        LOG_FIELDS(Logger::Debug, "API key validated from database", LogField::secret("api_key", key));
         return true;
     }
 
-    LOG_WARNING(QString("API key validation failed: %1").arg(key));
+    LOG_FIELDS(Logger::Warning, "API key validation failed", LogField::secret("api_key", key));
     return false;
 }
 
@@ -212,10 +213,10 @@ QString AuthFramework::generateToken(const QJsonObject& userData, int expiryHour
             token, "user", userId, tokenData, expiryTime, createdBy);
 
         if (!storedInDb) {
-            LOG_ERROR(QString("Failed to store token in database: %1 - %2")
-                     .arg(token, m_tokenRepository->lastError()));
+            LOG_FIELDS(Logger::Error, "Failed to store token in database",
+                       LogField::secret("token", token), LogField::value("error", m_tokenRepository->lastError()));
         } else {
-            LOG_DEBUG(QString("Token stored in database: %1").arg(token));
+            LOG_FIELDS(Logger::Debug, "Token stored in database", LogField::secret("token", token));
         }
     } else {
         LOG_WARNING("Token repository not available, token cannot be stored");
@@ -282,11 +283,12 @@ QString AuthFramework::generateServiceToken(
                 token, "service", user->id(), tokenData, expiryTime);
 
             if (!storedInDb) {
-                LOG_ERROR(QString("Failed to store service token in database: %1 - %2")
-                         .arg(token, m_tokenRepository->lastError()));
+                LOG_FIELDS(Logger::Error, "Failed to store service token in database",
+                           LogField::secret("token", token), LogField::value("error", m_tokenRepository->lastError()));
                 return QString(); // Return empty string to indicate failure
             } else {
-                LOG_DEBUG(QString("Service token stored in database: %1").arg(token));
+                LOG_FIELDS(Logger::Debug, "Service token stored in database",
+                           LogField::secret("token", token));
             }
         } else {
             LOG_ERROR(QString("Failed to find or create user for service token: %1")
@@ -340,11 +342,11 @@ QString AuthFramework::generateApiKey(
             key, "api", createdBy, keyData, expiryTime, createdBy);
 
         if (!storedInDb) {
-            LOG_ERROR(QString("Failed to store API key in database: %1 - %2")
-                     .arg(key, m_tokenRepository->lastError()));
+            LOG_FIELDS(Logger::Error, "Failed to store API key in database",
+                       LogField::secret("api_key", key), LogField::value("error", m_tokenRepository->lastError()));
             return QString(); // Return empty string to indicate failure
         } else {
-            LOG_DEBUG(QString("API key stored in database: %1").arg(key));
+            LOG_FIELDS(Logger::Debug, "API key stored in database", LogField::secret("api_key", key));
         }
     } else {
         LOG_WARNING("Token repository not available, API key cannot be stored");
@@ -396,11 +398,11 @@ QString AuthFramework::generateRefreshToken(const QJsonObject& userData, int exp
             token, "refresh", userId, tokenData, expiryTime, createdBy);
 
         if (!storedInDb) {
-            LOG_ERROR(QString("Failed to store refresh token in database: %1 - %2")
-                     .arg(token, m_tokenRepository->lastError()));
+            LOG_FIELDS(Logger::Error, "Failed to store refresh token in database",
+                       LogField::secret("token", token), LogField::value("error", m_tokenRepository->lastError()));
             return QString(); // Return empty string to indicate failure
         } else {
-            LOG_DEBUG(QString("Refresh token stored in database: %1").arg(token));
+            LOG_FIELDS(Logger::Debug, "Refresh token stored in database", LogField::secret("token", token));
         }
     } else {
         LOG_WARNING("Token repository not available, refresh token cannot be stored");
@@ -414,7 +416,7 @@ QString AuthFramework::generateRefreshToken(const QJsonObject& userData, int exp
 }
 
 bool AuthFramework::refreshUserToken(const QString& refreshToken, QString& newToken, QJsonObject& userData) {
-    LOG_DEBUG(QString("Refreshing token with refresh token: %1").arg(refreshToken));
+    LOG_FIELDS(Logger::Debug, "Refreshing token with refresh token", LogField::secret("token", refreshToken));
 
     if (!m_tokenRepository || !m_tokenRepository->isInitialized()) {
         LOG_WARNING("Token repository not initialized, token refresh failed");
@@ -425,7 +427,8 @@ bool AuthFramework::refreshUserToken(const QString& refreshToken, QString& newTo
     auto tokenModel = m_tokenRepository->getByTokenId(refreshToken);
 
     if (!tokenModel || tokenModel->isRevoked() || tokenModel->isExpired()) {
-        LOG_WARNING(QString("Refresh token not found in database or invalid: %1").arg(refreshToken));
+        LOG_FIELDS(Logger::Warning, "Refresh token not found in database or invalid",
+                   LogField::secret("token", refreshToken));
         return false;
     }
 
@@ -457,7 +460,7 @@ bool AuthFramework::refreshUserToken(const QString& refreshToken, QString& newTo
 }
 
 bool AuthFramework::removeToken(const QString& token) {
-    LOG_INFO(QString("Removing token: %1").arg(token));
+    LOG_FIELDS(Logger::Info, "Removing token", LogField::secret("token", token));
 
     if (!m_tokenRepository || !m_tokenRepository->isInitialized()) {
         LOG_WARNING("Token repository not available, token cannot be removed");
@@ -483,10 +486,10 @@ bool AuthFramework::removeToken(const QString& token) {
     bool removed = m_tokenRepository->revokeToken(token, reason);
 
     if (removed) {
-        LOG_DEBUG(QString("Token revoked in database: %1").arg(token));
+        LOG_FIELDS(Logger::Debug, "Token revoked in database", LogField::secret("token", token));
     } else {
-        LOG_WARNING(QString("Failed to revoke token in database: %1 - %2")
-                   .arg(token, m_tokenRepository->lastError()));
+        LOG_FIELDS(Logger::Warning, "Failed to revoke token in database",
+                   LogField::secret("token", token), LogField::value("error", m_tokenRepository->lastError()));
     }
 
     return removed;
@@ -23,6 +23,7 @@
 #include <QSqlRecord>
 #include <QSysInfo>
 #include "logger/logger.h"
+#include "Utils/IsoDateTime.h"
 
 //------------------------------------------------------------------------------
 // Model creation from database query results
@@ -263,6 +264,141 @@ UserRoleDisciplineModel* ModelFactory::createUserRoleDisciplineFromQuery(const Q
     return urd;
 }
 
+//------------------------------------------------------------------------------
+// Model creation from batch upload rows
+//------------------------------------------------------------------------------
+
+namespace {
+
+// Batch rows carry ISO-8601 strings; missing or unparsable times fall back to the default
+QDateTime batchTimeOrDefault(const QJsonObject& json, const QString& key, const QDateTime& defaultValue) {
+    QString value = json.value(key).toString();
+    if (value.isEmpty()) {
+        return defaultValue;
+    }
+
+    QDateTime time = IsoDateTime::parse(value);
+    return time.isValid() ? time : defaultValue;
+}
+
+QUuid batchUuid(const QJsonObject& json, const QString& key) {
+    QString value = json.value(key).toString();
+    return value.isEmpty() ? QUuid() : QUuid(value);
+}
+
+template<typename T>
+void setBatchAuditFields(T* model, const QUuid& userId, const QDateTime& receivedAt) {
+    model->setCreatedBy(userId);
+    model->setUpdatedBy(userId);
+    model->setCreatedAt(receivedAt);
+    model->setUpdatedAt(receivedAt);
+}
+
+} // namespace
+
+ActivityEventModel* ModelFactory::createActivityEventFromBatch(const QJsonObject& json, const QUuid& sessionId, const QUuid& userId, const QDateTime& receivedAt, QString& error) {
+    Q_UNUSED(error);
+
+    ActivityEventModel* event = new ActivityEventModel();
+    event->setSessionId(sessionId);
+
+    // Unknown or missing event types are recorded as mouse clicks
+    EventTypes::ActivityEventType eventType = EventTypes::ActivityEventType::MouseClick;
+    EventTypes::activityEventTypeFromString(json.value("event_type").toString(), eventType);
+    event->setEventType(eventType);
+
+    event->setAppId(batchUuid(json, "app_id"));
+    event->setEventTime(batchTimeOrDefault(json, "event_time", receivedAt));
+
+    if (json.value("event_data").isObject()) {
+        event->setEventData(json.value("event_data").toObject());
+    }
+
+    setBatchAuditFields(event, userId, receivedAt);
+    return event;
+}
+
+AppUsageModel* ModelFactory::createAppUsageFromBatch(const QJsonObject& json, const QUuid& sessionId, const QUuid& userId, const QDateTime& receivedAt, QString& error) {
+    if (json.value("app_id").toString().isEmpty()) {
+        error = "Missing required app_id";
+        return nullptr;
+    }
+
+    AppUsageModel* appUsage = new AppUsageModel();
+    appUsage->setSessionId(sessionId);
+    appUsage->setAppId(QUuid(json.value("app_id").toString()));
+
+    if (json.contains("window_title")) {
+        appUsage->setWindowTitle(json.value("window_title").toString());
+    }
+
+    appUsage->setStartTime(batchTimeOrDefault(json, "start_time", receivedAt));
+
+    // Completed usages carry an end time
+    QDateTime endTime = batchTimeOrDefault(json, "end_time", QDateTime());
+    if (endTime.isValid()) {
+        appUsage->setEndTime(endTime);
+    }
+
+    setBatchAuditFields(appUsage, userId, receivedAt);
+    return appUsage;
+}
+
+SystemMetricsModel* ModelFactory::createSystemMetricsFromBatch(const QJsonObject& json, const QUuid& sessionId, const QUuid& userId, const QDateTime& receivedAt, QString& error) {
+    Q_UNUSED(error);
+
+    SystemMetricsModel* metrics = new SystemMetricsModel();
+    metrics->setSessionId(sessionId);
+    metrics->setCpuUsage(json.value("cpu_usage").toDouble(0.0));
+    metrics->setGpuUsage(json.value("gpu_usage").toDouble(0.0));
+    metrics->setMemoryUsage(json.value("memory_usage").toDouble(0.0));
+    metrics->setMeasurementTime(batchTimeOrDefault(json, "measurement_time", receivedAt));
+
+    setBatchAuditFields(metrics, userId, receivedAt);
+    return metrics;
+}
+
+SessionEventModel* ModelFactory::createSessionEventFromBatch(const QJsonObject& json, const QUuid& sessionId, const QUuid& userId, const QDateTime& receivedAt, QString& error) {
+    Q_UNUSED(error);
+
+    SessionEventModel* event = new SessionEventModel();
+    event->setSessionId(sessionId);
+
+    QString eventTypeStr = json.value("event_type").toString();
+    EventTypes::SessionEventType eventType = EventTypes::SessionEventType::Login;
+    if (!EventTypes::sessionEventTypeFromString(eventTypeStr, eventType)) {
+        LOG_WARNING(QString("Unknown session event type: %1, defaulting to Login").arg(eventTypeStr));
+    }
+    event->setEventType(eventType);
+
+    // Events default to the authenticated user
+    QUuid eventUserId = batchUuid(json, "user_id");
+    event->setUserId(eventUserId.isNull() ? userId : eventUserId);
+    event->setPreviousUserId(batchUuid(json, "previous_user_id"));
+
+    event->setMachineId(batchUuid(json, "machine_id"));
+    if (event->machineId().isNull()) {
+        LOG_WARNING("Session event in batch is missing machine_id");
+    }
+
+    if (!json.value("terminal_session_id").toString().isEmpty()) {
+        event->setTerminalSessionId(json.value("terminal_session_id").toString());
+    }
+
+    if (json.contains("is_remote")) {
+        event->setIsRemote(json.value("is_remote").toBool());
+    }
+
+    event->setEventTime(batchTimeOrDefault(json, "event_time", receivedAt));
+
+    if (json.value("event_data").isObject()) {
+        event->setEventData(json.value("event_data").toObject());
+    }
+
+    setBatchAuditFields(event, userId, receivedAt);
+    return event;
+}
+
 //------------------------------------------------------------------------------
 // Default model creation
 //------------------------------------------------------------------------------
@@ -51,6 +51,13 @@ public:
     static SessionEventModel* createSessionEventFromQuery(const QSqlQuery& query);
     static UserRoleDisciplineModel* createUserRoleDisciplineFromQuery(const QSqlQuery& query);
 
+    // Create models from the rows of an agent batch upload; return nullptr and set error for unusable rows.
+    // receivedAt stands in for missing row times and is used for the audit timestamps.
+    static ActivityEventModel* createActivityEventFromBatch(const QJsonObject& json, const QUuid& sessionId, const QUuid& userId, const QDateTime& receivedAt, QString& error);
+    static AppUsageModel* createAppUsageFromBatch(const QJsonObject& json, const QUuid& sessionId, const QUuid& userId, const QDateTime& receivedAt, QString& error);
+    static SystemMetricsModel* createSystemMetricsFromBatch(const QJsonObject& json, const QUuid& sessionId, const QUuid& userId, const QDateTime& receivedAt, QString& error);
+    static SessionEventModel* createSessionEventFromBatch(const QJsonObject& json, const QUuid& sessionId, const QUuid& userId, const QDateTime& receivedAt, QString& error);
+
     // Create default models
     static UserModel* createDefaultUser(const QString& name = QString(), const QString& email = QString());
     static TokenModel* createDefaultToken(const QString& tokenId = QString(), const QUuid& userId = QUuid(), const QString& tokenType = "user");
@@ -357,7 +357,43 @@ IF table_name = 'activity_events' THEN
             partition_name || '_session_idx',
             partition_name
         );
+    ELSIF table_name = 'app_usage' THEN
+        -- getBySessionId and getActiveAppUsages filter by session and sort by start_time
+        EXECUTE format(
+            'CREATE INDEX IF NOT EXISTS %I ON %I (session_id, start_time DESC)',
+            partition_name || '_session_start_idx',
+            partition_name
+        );
+        EXECUTE format(
+            'CREATE INDEX IF NOT EXISTS %I ON %I (session_id) WHERE is_active',
+            partition_name || '_session_active_idx',
+            partition_name
+        );
+    ELSIF table_name = 'session_events' THEN
+        EXECUTE format(
+            'CREATE INDEX IF NOT EXISTS %I ON %I (session_id, event_time DESC)',
+            partition_name || '_session_time_idx',
+            partition_name
+        );
+        EXECUTE format(
+            'CREATE INDEX IF NOT EXISTS %I ON %I (session_id, event_type)',
+            partition_name || '_session_event_idx',
+            partition_name
+        );
 END IF;
+
+    -- Rows arrive roughly in time order, so a BRIN index on the partition key stays
+    -- a few pages per partition and serves time-range scans
+    EXECUTE format(
+        'CREATE INDEX IF NOT EXISTS %I ON %I USING brin (%I)',
+        partition_name || '_time_brin_idx',
+        partition_name,
+        CASE table_name
+            WHEN 'system_metrics' THEN 'measurement_time'
+            WHEN 'app_usage' THEN 'start_time'
+            ELSE 'event_time'
+        END
+    );
 END;
 $BODY$
 LANGUAGE plpgsql;
@@ -399,10 +435,13 @@ BEGIN
 
     FOREACH table_name IN ARRAY tables LOOP
         FOR partition_name IN
-SELECT partitiontablename::text
-FROM pg_partitions
-WHERE tablename = table_name
-  AND to_date(split_part(partitiontablename, '_y', 2), 'YYYYmMM') < cutoff_date
+SELECT c.relname::text
+FROM pg_inherits i
+         JOIN pg_class c ON c.oid = i.inhrelid
+         JOIN pg_class p ON p.oid = i.inhparent
+WHERE p.relname = table_name
+  AND c.relname ~ '_y[0-9]{4}m[0-9]{2}$'
+  AND to_date(right(c.relname, 7), 'YYYY"m"MM') < cutoff_date
     LOOP
             sql := format(
                 'ALTER TABLE %I DETACH PARTITION %I',
@@ -719,6 +758,573 @@ CREATE INDEX IF NOT EXISTS idx_auth_tokens_user_id ON auth_tokens(user_id);
 CREATE INDEX IF NOT EXISTS idx_auth_tokens_expires_at ON auth_tokens(expires_at);
 CREATE INDEX IF NOT EXISTS idx_auth_tokens_revoked ON auth_tokens(revoked) WHERE revoked = false;
 
+-- Responses to /api/batch requests keyed by the agent's Idempotency-Key, so resent batches are not inserted twice
+CREATE TABLE IF NOT EXISTS batch_idempotency_keys (
+    user_id UUID NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+    idempotency_key VARCHAR(128) NOT NULL,
+    session_id UUID REFERENCES sessions(id) ON DELETE CASCADE,
+    status_code INTEGER NOT NULL,
+    response JSONB NOT NULL,
+    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL,
+    expires_at TIMESTAMP NOT NULL,
+    PRIMARY KEY (user_id, idempotency_key)
+    );
+
+CREATE INDEX IF NOT EXISTS idx_batch_idempotency_keys_expires_at ON batch_idempotency_keys(expires_at);
+
+-- client_seq values already committed per session (one agent on one device), so rows resent
+-- outside their original batch are skipped after a restart or on another API worker
+CREATE TABLE IF NOT EXISTS batch_client_sequences (
+    session_id UUID NOT NULL REFERENCES sessions(id) ON DELETE CASCADE,
+    client_seq BIGINT NOT NULL,
+    expires_at TIMESTAMP NOT NULL,
+    PRIMARY KEY (session_id, client_seq)
+    );
+
+CREATE INDEX IF NOT EXISTS idx_batch_client_sequences_expires_at ON batch_client_sequences(expires_at);
+
+-- App usage rollups, kept current by trg_app_usage_rollup. Rows count every use; total_seconds
+-- holds closed uses only, so readers add the open ones (end_time IS NULL) at query time.
+CREATE TABLE IF NOT EXISTS app_usage_session_rollup (
+    session_id UUID NOT NULL REFERENCES sessions(id) ON DELETE CASCADE,
+    app_id UUID NOT NULL REFERENCES applications(id),
+    usage_count BIGINT NOT NULL DEFAULT 0,
+    total_seconds DOUBLE PRECISION NOT NULL DEFAULT 0,
+    updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL,
+    PRIMARY KEY (session_id, app_id)
+    );
+
+-- Closed time is split at midnight (UTC); a use is counted on the day it started
+CREATE TABLE IF NOT EXISTS app_usage_daily_rollup (
+    user_id UUID NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+    day DATE NOT NULL,
+    app_id UUID NOT NULL REFERENCES applications(id),
+    usage_count BIGINT NOT NULL DEFAULT 0,
+    total_seconds DOUBLE PRECISION NOT NULL DEFAULT 0,
+    updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL,
+    PRIMARY KEY (user_id, day, app_id)
+    );
+
+CREATE INDEX IF NOT EXISTS idx_app_usage_daily_rollup_day ON app_usage_daily_rollup(day, app_id);
+CREATE INDEX IF NOT EXISTS idx_app_usage_open ON app_usage(session_id) WHERE end_time IS NULL;
+
+-- Add (p_sign = 1) or remove (p_sign = -1) one app_usage row from both rollups
+CREATE OR REPLACE FUNCTION app_usage_rollup_apply(
+    p_session_id uuid,
+    p_app_id uuid,
+    p_start_time timestamp,
+    p_end_time timestamp,
+    p_sign int
+) RETURNS void AS
+$BODY$
+DECLARE
+v_user_id uuid;
+    v_day date;
+    v_from timestamp;
+    v_to timestamp;
+BEGIN
+    IF p_session_id IS NULL OR p_app_id IS NULL THEN
+        RETURN;
+END IF;
+
+INSERT INTO app_usage_session_rollup AS r (session_id, app_id, usage_count, total_seconds, updated_at)
+VALUES (
+           p_session_id,
+           p_app_id,
+           p_sign,
+           CASE WHEN p_end_time IS NULL THEN 0 ELSE p_sign * EXTRACT(EPOCH FROM (p_end_time - p_start_time)) END,
+           CURRENT_TIMESTAMP
+       )
+    ON CONFLICT (session_id, app_id) DO UPDATE
+                                           SET usage_count = r.usage_count + EXCLUDED.usage_count,
+                                           total_seconds = r.total_seconds + EXCLUDED.total_seconds,
+                                           updated_at = EXCLUDED.updated_at;
+
+SELECT user_id INTO v_user_id FROM sessions WHERE id = p_session_id;
+IF v_user_id IS NULL THEN
+        RETURN;
+END IF;
+
+INSERT INTO app_usage_daily_rollup AS r (user_id, day, app_id, usage_count, total_seconds, updated_at)
+VALUES (v_user_id, p_start_time::date, p_app_id, p_sign, 0, CURRENT_TIMESTAMP)
+    ON CONFLICT (user_id, day, app_id) DO UPDATE
+                                               SET usage_count = r.usage_count + EXCLUDED.usage_count,
+                                               updated_at = EXCLUDED.updated_at;
+
+IF p_end_time IS NULL THEN
+        RETURN;
+END IF;
+
+    FOR v_day IN
+SELECT generate_series(p_start_time::date::timestamp, (p_end_time - interval '1 microsecond')::date::timestamp, interval '1 day')::date
+    LOOP
+        v_from := GREATEST(p_start_time, v_day::timestamp);
+        v_to := LEAST(p_end_time, v_day::timestamp + interval '1 day');
+
+INSERT INTO app_usage_daily_rollup AS r (user_id, day, app_id, usage_count, total_seconds, updated_at)
+VALUES (v_user_id, v_day, p_app_id, 0, p_sign * EXTRACT(EPOCH FROM (v_to - v_from)), CURRENT_TIMESTAMP)
+    ON CONFLICT (user_id, day, app_id) DO UPDATE
+                                               SET total_seconds = r.total_seconds + EXCLUDED.total_seconds,
+                                               updated_at = EXCLUDED.updated_at;
+END LOOP;
+END;
+$BODY$
+LANGUAGE plpgsql;
+
+CREATE OR REPLACE FUNCTION app_usage_rollup_trigger() RETURNS trigger AS
+$BODY$
+BEGIN
+    IF TG_OP = 'UPDATE'
+        AND OLD.session_id IS NOT DISTINCT FROM NEW.session_id
+        AND OLD.app_id IS NOT DISTINCT FROM NEW.app_id
+        AND OLD.start_time IS NOT DISTINCT FROM NEW.start_time
+        AND OLD.end_time IS NOT DISTINCT FROM NEW.end_time THEN
+        RETURN NULL;
+END IF;
+
+    IF TG_OP IN ('UPDATE', 'DELETE') THEN
+        PERFORM app_usage_rollup_apply(OLD.session_id, OLD.app_id, OLD.start_time, OLD.end_time, -1);
+END IF;
+
+    IF TG_OP IN ('INSERT', 'UPDATE') THEN
+        PERFORM app_usage_rollup_apply(NEW.session_id, NEW.app_id, NEW.start_time, NEW.end_time, 1);
+END IF;
+
+RETURN NULL;
+END;
+$BODY$
+LANGUAGE plpgsql;
+
+DROP TRIGGER IF EXISTS trg_app_usage_rollup ON app_usage;
+CREATE TRIGGER trg_app_usage_rollup
+    AFTER INSERT OR UPDATE OF session_id, app_id, start_time, end_time OR DELETE ON app_usage
+    FOR EACH ROW EXECUTE FUNCTION app_usage_rollup_trigger();
+
+-- Recompute both rollups from app_usage, for the first install or after a bulk load with triggers disabled
+CREATE OR REPLACE FUNCTION rebuild_app_usage_rollups() RETURNS void AS
+$BODY$
+BEGIN
+    LOCK TABLE app_usage IN SHARE MODE;
+
+DELETE FROM app_usage_session_rollup;
+DELETE FROM app_usage_daily_rollup;
+
+INSERT INTO app_usage_session_rollup (session_id, app_id, usage_count, total_seconds)
+SELECT session_id,
+       app_id,
+       COUNT(*),
+       COALESCE(SUM(EXTRACT(EPOCH FROM (end_time - start_time))), 0)
+FROM app_usage
+WHERE session_id IS NOT NULL AND app_id IS NOT NULL
+GROUP BY session_id, app_id;
+
+INSERT INTO app_usage_daily_rollup (user_id, day, app_id, usage_count, total_seconds)
+SELECT user_id, day, app_id, SUM(usage_count), SUM(total_seconds)
+FROM (
+         SELECT s.user_id, u.start_time::date AS day, u.app_id, COUNT(*) AS usage_count, 0::double precision AS total_seconds
+         FROM app_usage u
+                  JOIN sessions s ON s.id = u.session_id
+         WHERE u.app_id IS NOT NULL
+         GROUP BY s.user_id, u.start_time::date, u.app_id
+         UNION ALL
+         SELECT s.user_id,
+                d.day::date,
+                u.app_id,
+                0,
+                SUM(EXTRACT(EPOCH FROM (LEAST(u.end_time, d.day + interval '1 day') - GREATEST(u.start_time, d.day))))
+         FROM app_usage u
+                  JOIN sessions s ON s.id = u.session_id
+                  CROSS JOIN LATERAL generate_series(u.start_time::date::timestamp, (u.end_time - interval '1 microsecond')::date::timestamp, interval '1 day') AS d(day)
+         WHERE u.app_id IS NOT NULL AND u.end_time IS NOT NULL
+         GROUP BY s.user_id, d.day::date, u.app_id
+     ) parts
+GROUP BY user_id, day, app_id;
+END;
+$BODY$
+LANGUAGE plpgsql;
+
+DO
+$$
+BEGIN
+    IF NOT EXISTS (SELECT 1 FROM app_usage_session_rollup) AND EXISTS (SELECT 1 FROM app_usage) THEN
+        PERFORM rebuild_app_usage_rollups();
+END IF;
+END
+$$;
+
+-- Per-user, per-day activity read by /api/users/<id>/stats. ApiServer refreshes the recent
+-- days on a schedule with refresh_user_daily_summaries(), and older days that late batches
+-- touched with refresh_dirty_user_daily_summaries(); days are UTC.
+CREATE TABLE IF NOT EXISTS user_daily_summaries (
+    user_id UUID NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+    day DATE NOT NULL,
+    session_count INTEGER NOT NULL DEFAULT 0,
+    machine_ids UUID[] NOT NULL DEFAULT '{}',
+    total_seconds DOUBLE PRECISION NOT NULL DEFAULT 0,
+    afk_count INTEGER NOT NULL DEFAULT 0,
+    afk_seconds DOUBLE PRECISION NOT NULL DEFAULT 0,
+    active_seconds DOUBLE PRECISION NOT NULL DEFAULT 0,
+    first_login TIMESTAMP,
+    last_activity TIMESTAMP,
+    top_apps JSONB NOT NULL DEFAULT '[]',
+    refreshed_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL,
+    PRIMARY KEY (user_id, day)
+    );
+
+CREATE INDEX IF NOT EXISTS idx_user_daily_summaries_day ON user_daily_summaries(day);
+
+-- Recompute the summaries for p_from..p_to. Sessions and AFK periods that cross midnight are
+-- split between days; a session or AFK period is counted on the day it started.
+CREATE OR REPLACE FUNCTION refresh_user_daily_summaries(
+    p_from date,
+    p_to date
+) RETURNS integer AS
+$BODY$
+DECLARE
+v_now timestamp := now() AT TIME ZONE 'UTC';
+    v_rows integer;
+BEGIN
+DELETE FROM user_daily_summaries WHERE day BETWEEN p_from AND p_to;
+
+INSERT INTO user_daily_summaries (
+    user_id, day, session_count, machine_ids, total_seconds, afk_count, afk_seconds,
+    active_seconds, first_login, last_activity, top_apps, refreshed_at
+)
+WITH session_days AS (
+    SELECT s.user_id,
+           d.day::date AS day,
+           s.id AS session_id,
+           s.machine_id,
+           s.login_time,
+           GREATEST(s.login_time, d.day) AS day_from,
+           LEAST(COALESCE(s.logout_time, v_now), d.day + interval '1 day') AS day_to
+    FROM sessions s
+             CROSS JOIN LATERAL generate_series(
+            GREATEST(s.login_time::date, p_from)::timestamp,
+            LEAST((COALESCE(s.logout_time, v_now) - interval '1 microsecond')::date, p_to)::timestamp,
+            interval '1 day') AS d(day)
+    WHERE s.login_time < (p_to + 1)::timestamp
+      AND COALESCE(s.logout_time, v_now) > p_from::timestamp
+),
+     totals AS (
+         SELECT user_id,
+                day,
+                COUNT(DISTINCT session_id) FILTER (WHERE login_time >= day::timestamp) AS session_count,
+                ARRAY_AGG(DISTINCT machine_id) FILTER (WHERE machine_id IS NOT NULL) AS machine_ids,
+                SUM(EXTRACT(EPOCH FROM (day_to - day_from))) AS total_seconds,
+                MIN(day_from) AS first_login,
+                MAX(day_to) AS last_activity
+         FROM session_days
+         GROUP BY user_id, day
+     ),
+     afk_days AS (
+         SELECT s.user_id,
+                d.day::date AS day,
+                COUNT(*) FILTER (WHERE a.start_time >= d.day) AS afk_count,
+                SUM(EXTRACT(EPOCH FROM (LEAST(COALESCE(a.end_time, v_now), d.day + interval '1 day') -
+                                        GREATEST(a.start_time, d.day)))) AS afk_seconds
+         FROM afk_periods a
+                  JOIN sessions s ON s.id = a.session_id
+                  CROSS JOIN LATERAL generate_series(
+                 GREATEST(a.start_time::date, p_from)::timestamp,
+                 LEAST((COALESCE(a.end_time, v_now) - interval '1 microsecond')::date, p_to)::timestamp,
+                 interval '1 day') AS d(day)
+         WHERE a.start_time < (p_to + 1)::timestamp
+           AND COALESCE(a.end_time, v_now) > p_from::timestamp
+         GROUP BY s.user_id, d.day::date
+     ),
+     app_days AS (
+         SELECT user_id,
+                day,
+                jsonb_agg(jsonb_build_object('app_id', app_id, 'usage_count', usage_count, 'total_seconds', total_seconds)
+                          ORDER BY total_seconds DESC) AS top_apps
+         FROM (
+                  SELECT r.user_id, r.day, r.app_id, r.usage_count, r.total_seconds,
+                         ROW_NUMBER() OVER (PARTITION BY r.user_id, r.day ORDER BY r.total_seconds DESC) AS app_rank
+                  FROM app_usage_daily_rollup r
+                  WHERE r.day BETWEEN p_from AND p_to
+                    AND r.usage_count > 0
+              ) ranked
+         WHERE app_rank <= 5
+         GROUP BY user_id, day
+     )
+SELECT t.user_id,
+       t.day,
+       t.session_count,
+       COALESCE(t.machine_ids, '{}'),
+       t.total_seconds,
+       COALESCE(a.afk_count, 0),
+       COALESCE(a.afk_seconds, 0),
+       GREATEST(t.total_seconds - COALESCE(a.afk_seconds, 0), 0),
+       t.first_login,
+       t.last_activity,
+       COALESCE(p.top_apps, '[]'::jsonb),
+       v_now
+FROM totals t
+         LEFT JOIN afk_days a ON a.user_id = t.user_id AND a.day = t.day
+         LEFT JOIN app_days p ON p.user_id = t.user_id AND p.day = t.day
+-- A concurrent refresh of the same days may have inserted the row since the DELETE
+    ON CONFLICT (user_id, day) DO UPDATE
+                                      SET session_count = EXCLUDED.session_count,
+                                      machine_ids = EXCLUDED.machine_ids,
+                                      total_seconds = EXCLUDED.total_seconds,
+                                      afk_count = EXCLUDED.afk_count,
+                                      afk_seconds = EXCLUDED.afk_seconds,
+                                      active_seconds = EXCLUDED.active_seconds,
+                                      first_login = EXCLUDED.first_login,
+                                      last_activity = EXCLUDED.last_activity,
+                                      top_apps = EXCLUDED.top_apps,
+                                      refreshed_at = EXCLUDED.refreshed_at;
+
+GET DIAGNOSTICS v_rows = ROW_COUNT;
+RETURN v_rows;
+END;
+$BODY$
+LANGUAGE plpgsql;
+
+DO
+$$
+DECLARE
+v_first date;
+BEGIN
+    IF NOT EXISTS (SELECT 1 FROM user_daily_summaries) THEN
+SELECT MIN(login_time)::date INTO v_first FROM sessions;
+IF v_first IS NOT NULL THEN
+            PERFORM refresh_user_daily_summaries(v_first, CURRENT_DATE);
+END IF;
+END IF;
+END
+$$;
+
+-- Days before yesterday whose sessions, AFK periods or app usage changed since they were
+-- summarized. Batches are stamped with capture time, so a client that was offline can deliver
+-- days the scheduled refresh no longer covers; the triggers below note those days here.
+CREATE TABLE IF NOT EXISTS user_daily_summary_dirty_days (
+    day DATE PRIMARY KEY,
+    marked_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL
+    );
+
+-- Mark the days p_from..p_to overlaps. Today and yesterday are skipped: the scheduled refresh
+-- covers them anyway, and every ingest would otherwise contend on the same row.
+CREATE OR REPLACE FUNCTION mark_user_daily_summary_dirty(
+    p_from timestamp,
+    p_to timestamp
+) RETURNS void AS
+$BODY$
+DECLARE
+v_last date := LEAST(COALESCE(p_to, now() AT TIME ZONE 'UTC')::date, (now() AT TIME ZONE 'UTC')::date - 2);
+BEGIN
+    IF p_from IS NULL OR p_from::date > v_last THEN
+        RETURN;
+END IF;
+
+INSERT INTO user_daily_summary_dirty_days (day)
+SELECT generate_series(p_from::date::timestamp, v_last::timestamp, interval '1 day')::date
+    ON CONFLICT (day) DO NOTHING;
+END;
+$BODY$
+LANGUAGE plpgsql;
+
+CREATE OR REPLACE FUNCTION user_daily_summary_dirty_trigger() RETURNS trigger AS
+$BODY$
+BEGIN
+    IF TG_TABLE_NAME = 'app_usage_daily_rollup' THEN
+        IF TG_OP IN ('UPDATE', 'DELETE') THEN
+            PERFORM mark_user_daily_summary_dirty(OLD.day::timestamp, OLD.day::timestamp);
+END IF;
+        IF TG_OP IN ('INSERT', 'UPDATE') THEN
+            PERFORM mark_user_daily_summary_dirty(NEW.day::timestamp, NEW.day::timestamp);
+END IF;
+ELSIF TG_TABLE_NAME = 'sessions' THEN
+        IF TG_OP IN ('UPDATE', 'DELETE') THEN
+            PERFORM mark_user_daily_summary_dirty(OLD.login_time, OLD.logout_time);
+END IF;
+        IF TG_OP IN ('INSERT', 'UPDATE') THEN
+            PERFORM mark_user_daily_summary_dirty(NEW.login_time, NEW.logout_time);
+END IF;
+ELSE
+        IF TG_OP IN ('UPDATE', 'DELETE') THEN
+            PERFORM mark_user_daily_summary_dirty(OLD.start_time, OLD.end_time);
+END IF;
+        IF TG_OP IN ('INSERT', 'UPDATE') THEN
+            PERFORM mark_user_daily_summary_dirty(NEW.start_time, NEW.end_time);
+END IF;
+END IF;
+RETURN NULL;
+END;
+$BODY$
+LANGUAGE plpgsql;
+
+DROP TRIGGER IF EXISTS sessions_daily_summary_dirty ON sessions;
+CREATE TRIGGER sessions_daily_summary_dirty
+    AFTER INSERT OR DELETE OR UPDATE OF user_id, machine_id, login_time, logout_time ON sessions
+    FOR EACH ROW EXECUTE FUNCTION user_daily_summary_dirty_trigger();
+
+DROP TRIGGER IF EXISTS afk_periods_daily_summary_dirty ON afk_periods;
+CREATE TRIGGER afk_periods_daily_summary_dirty
+    AFTER INSERT OR DELETE OR UPDATE OF session_id, start_time, end_time ON afk_periods
+    FOR EACH ROW EXECUTE FUNCTION user_daily_summary_dirty_trigger();
+
+DROP TRIGGER IF EXISTS app_usage_daily_rollup_summary_dirty ON app_usage_daily_rollup;
+CREATE TRIGGER app_usage_daily_rollup_summary_dirty
+    AFTER INSERT OR DELETE OR UPDATE ON app_usage_daily_rollup
+    FOR EACH ROW EXECUTE FUNCTION user_daily_summary_dirty_trigger();
+
+-- Recompute every dirty day and clear it. A day marked again while this runs stays dirty for
+-- the next call, since its new mark commits after this transaction's snapshot was taken.
+CREATE OR REPLACE FUNCTION refresh_dirty_user_daily_summaries() RETURNS integer AS
+$BODY$
+DECLARE
+v_day date;
+    v_rows integer := 0;
+BEGIN
+    FOR v_day IN
+DELETE FROM user_daily_summary_dirty_days RETURNING day
+    LOOP
+        v_rows := v_rows + refresh_user_daily_summaries(v_day, v_day);
+END LOOP;
+RETURN v_rows;
+END;
+$BODY$
+LANGUAGE plpgsql;
+
+-- Session chains are stored on the rows: the root session id and the 1-based position in the
+-- chain. continueSession maintains them, so /api/sessions/<id>/chain is one indexed lookup
+-- instead of the recursive get_session_chain(). A NULL chain_id is a session that was never
+-- continued, i.e. a chain of one.
+ALTER TABLE sessions ADD COLUMN IF NOT EXISTS chain_id UUID;
+ALTER TABLE sessions ADD COLUMN IF NOT EXISTS chain_position INTEGER;
+
+CREATE INDEX IF NOT EXISTS idx_sessions_chain ON sessions(chain_id, chain_position);
+
+DO
+$$
+BEGIN
+    IF NOT EXISTS (SELECT 1 FROM sessions WHERE chain_id IS NOT NULL) THEN
+WITH RECURSIVE chain_walk AS (
+    SELECT id, id AS root_id, 1 AS position
+    FROM sessions
+    WHERE continued_from_session IS NULL
+      AND continued_by_session IS NOT NULL
+
+    UNION ALL
+
+    SELECT s.id, cw.root_id, cw.position + 1
+    FROM sessions s
+             JOIN chain_walk cw ON s.continued_from_session = cw.id
+)
+UPDATE sessions s
+SET chain_id = cw.root_id,
+    chain_position = cw.position
+    FROM chain_walk cw
+WHERE s.id = cw.id;
+END IF;
+END
+$$;
+
+-- Add the session and BRIN indexes to partitions created before create_partition_for_month had them
+DO
+$$
+DECLARE
+v_partition record;
+BEGIN
+FOR v_partition IN
+SELECT p.relname::text AS table_name,
+       to_date(right(c.relname, 7), 'YYYY"m"MM') AS partition_date
+FROM pg_inherits i
+         JOIN pg_class c ON c.oid = i.inhrelid
+         JOIN pg_class p ON p.oid = i.inhparent
+WHERE p.relname IN ('activity_events', 'system_metrics', 'app_usage', 'session_events')
+  AND c.relname ~ '_y[0-9]{4}m[0-9]{2}$'
+    LOOP
+        PERFORM create_partition_for_month(v_partition.table_name, v_partition.partition_date);
+END LOOP;
+END
+$$;
+
+-- Per-minute activity counts kept after raw activity_events rows pass their retention period.
+-- Filled by compact_activity_events_partition(); counts come from event_data.count, which the
+-- client sets on keyboard and mouse batches, and default to one per event.
+CREATE TABLE IF NOT EXISTS activity_minute_summaries (
+    session_id UUID NOT NULL REFERENCES sessions(id) ON DELETE CASCADE,
+    minute TIMESTAMP NOT NULL,
+    event_count INTEGER NOT NULL DEFAULT 0,
+    keystrokes BIGINT NOT NULL DEFAULT 0,
+    mouse_clicks BIGINT NOT NULL DEFAULT 0,
+    mouse_moves BIGINT NOT NULL DEFAULT 0,
+    focus_changes INTEGER NOT NULL DEFAULT 0,
+    afk_transitions INTEGER NOT NULL DEFAULT 0,
+    compacted_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL,
+    PRIMARY KEY (session_id, minute)
+    );
+
+CREATE INDEX IF NOT EXISTS idx_activity_minute_summaries_minute ON activity_minute_summaries USING brin (minute);
+
+-- Compact the rows of one activity_events partition older than p_before into
+-- activity_minute_summaries and remove them. A partition that lies wholly before p_before is
+-- truncated, otherwise only the older rows are deleted. The partition is locked against writes
+-- for the rest of the calling transaction. Returns the raw rows removed.
+CREATE OR REPLACE FUNCTION compact_activity_events_partition(
+    p_partition text,
+    p_before timestamp
+) RETURNS bigint AS
+$BODY$
+DECLARE
+v_month date;
+    v_rows bigint;
+BEGIN
+    IF p_partition !~ '^activity_events_y[0-9]{4}m[0-9]{2}$' THEN
+        RAISE EXCEPTION 'Not an activity_events partition: %', p_partition;
+END IF;
+
+    v_month := to_date(right(p_partition, 7), 'YYYY"m"MM');
+    IF v_month >= p_before THEN
+        RETURN 0;
+END IF;
+
+    -- Late rows stamped with their capture time still arrive for old minutes. Holding off inserts
+    -- until the transaction ends keeps any of them from being removed without being summarized.
+EXECUTE format('LOCK TABLE %I IN SHARE ROW EXCLUSIVE MODE', p_partition);
+
+EXECUTE format(
+        'INSERT INTO activity_minute_summaries AS m (
+            session_id, minute, event_count, keystrokes, mouse_clicks, mouse_moves, focus_changes, afk_transitions
+        )
+        SELECT session_id,
+               date_trunc(''minute'', event_time),
+               COUNT(*),
+               COALESCE(SUM(COALESCE((event_data->>''count'')::bigint, 1)) FILTER (WHERE event_type = ''keyboard''), 0),
+               COALESCE(SUM(COALESCE((event_data->>''count'')::bigint, 1)) FILTER (WHERE event_type = ''mouse_click''), 0),
+               COALESCE(SUM(COALESCE((event_data->>''count'')::bigint, 1)) FILTER (WHERE event_type = ''mouse_move''), 0),
+               COUNT(*) FILTER (WHERE event_type = ''app_focus''),
+               COUNT(*) FILTER (WHERE event_type IN (''afk_start'', ''afk_end''))
+        FROM %I
+        WHERE event_time < $1 AND session_id IS NOT NULL
+        GROUP BY 1, 2
+        ON CONFLICT (session_id, minute) DO UPDATE SET
+            event_count = m.event_count + EXCLUDED.event_count,
+            keystrokes = m.keystrokes + EXCLUDED.keystrokes,
+            mouse_clicks = m.mouse_clicks + EXCLUDED.mouse_clicks,
+            mouse_moves = m.mouse_moves + EXCLUDED.mouse_moves,
+            focus_changes = m.focus_changes + EXCLUDED.focus_changes,
+            afk_transitions = m.afk_transitions + EXCLUDED.afk_transitions,
+            compacted_at = CURRENT_TIMESTAMP',
+        p_partition)
+    USING p_before;
+
+IF (v_month + interval '1 month') <= p_before THEN
+        EXECUTE format('SELECT COUNT(*) FROM %I', p_partition) INTO v_rows;
+EXECUTE format('TRUNCATE %I', p_partition);
+ELSE
+        EXECUTE format('DELETE FROM %I WHERE event_time < $1', p_partition) USING p_before;
+        GET DIAGNOSTICS v_rows = ROW_COUNT;
+END IF;
+
+RETURN v_rows;
+END;
+$BODY$
+LANGUAGE plpgsql;
+
 -- Add default values to columns that are missing them
 ALTER TABLE sessions
     ALTER COLUMN created_at TYPE TIMESTAMP WITHOUT TIME ZONE,
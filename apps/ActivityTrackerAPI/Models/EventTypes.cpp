@@ -0,0 +1,81 @@
+#include "EventTypes.h"
+#include <QHash>
+
+namespace EventTypes {
+
+namespace {
+
+// Indexed by enum value
+const QString ActivityEventLabels[] = {
+    QStringLiteral("mouse_click"),
+    QStringLiteral("mouse_move"),
+    QStringLiteral("keyboard"),
+    QStringLiteral("afk_start"),
+    QStringLiteral("afk_end"),
+    QStringLiteral("app_focus"),
+    QStringLiteral("app_unfocus")
+};
+
+const QString SessionEventLabels[] = {
+    QStringLiteral("login"),
+    QStringLiteral("logout"),
+    QStringLiteral("lock"),
+    QStringLiteral("unlock"),
+    QStringLiteral("switch_user"),
+    QStringLiteral("remote_connect"),
+    QStringLiteral("remote_disconnect")
+};
+
+template<typename Enum, int Count>
+QHash<QString, Enum> buildLookup(const QString (&labels)[Count])
+{
+    QHash<QString, Enum> lookup;
+    lookup.reserve(Count);
+    for (int i = 0; i < Count; ++i) {
+        lookup.insert(labels[i], static_cast<Enum>(i));
+    }
+    return lookup;
+}
+
+template<typename Enum, int Count>
+QString labelFor(Enum type, const QString (&labels)[Count])
+{
+    const int index = static_cast<int>(type);
+    return (index >= 0 && index < Count) ? labels[index] : QStringLiteral("unknown");
+}
+
+} // namespace
+
+bool activityEventTypeFromString(const QString &label, ActivityEventType &type)
+{
+    static const QHash<QString, ActivityEventType> lookup = buildLookup<ActivityEventType>(ActivityEventLabels);
+    auto it = lookup.constFind(label);
+    if (it == lookup.constEnd()) {
+        return false;
+    }
+    type = it.value();
+    return true;
+}
+
+QString activityEventTypeToString(ActivityEventType type)
+{
+    return labelFor(type, ActivityEventLabels);
+}
+
+bool sessionEventTypeFromString(const QString &label, SessionEventType &type)
+{
+    static const QHash<QString, SessionEventType> lookup = buildLookup<SessionEventType>(SessionEventLabels);
+    auto it = lookup.constFind(label);
+    if (it == lookup.constEnd()) {
+        return false;
+    }
+    type = it.value();
+    return true;
+}
+
+QString sessionEventTypeToString(SessionEventType type)
+{
+    return labelFor(type, SessionEventLabels);
+}
+
+} // namespace EventTypes
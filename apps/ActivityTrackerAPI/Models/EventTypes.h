@@ -2,6 +2,7 @@
 #define EVENTTYPES_H
 
 #include <QObject>
+#include <QString>
 
 namespace EventTypes {
 
@@ -31,6 +32,14 @@ namespace EventTypes {
     };
     Q_ENUM_NS(SessionEventType)
 
+    // Conversions to and from the labels of the database ENUMs. The label
+    // tables are built once; fromString returns false for unknown labels.
+    bool activityEventTypeFromString(const QString &label, ActivityEventType &type);
+    QString activityEventTypeToString(ActivityEventType type);
+
+    bool sessionEventTypeFromString(const QString &label, SessionEventType &type);
+    QString sessionEventTypeToString(SessionEventType type);
+
 }
 
 #endif // EVENTTYPES_H
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <QJsonDocument>
 #include "logger/logger.h"
 #include "Core/ModelFactory.h"
+#include "Services/ArchiveStore.h"
 
 ActivityEventRepository::ActivityEventRepository(QObject *parent)
     : BaseRepository<ActivityEventModel>(parent)
@@ -343,7 +344,8 @@ QJsonObject ActivityEventRepository::getActivitySummary(const QUuid &sessionId)
             ActivityEventModel* model = ModelFactory::createDefaultActivityEvent();
             model->setEventData(data);
             return model;
-        }
+        },
+        ReportRouting
     );
 
     if (totalResult) {
@@ -373,7 +375,8 @@ QJsonObject ActivityEventRepository::getActivitySummary(const QUuid &sessionId)
             ActivityEventModel* model = ModelFactory::createDefaultActivityEvent();
             model->setEventData(data);
             return model;
-        }
+        },
+        ReportRouting
     );
 
     for (auto model : typeCounts) {
@@ -391,10 +394,13 @@ QJsonObject ActivityEventRepository::getActivitySummary(const QUuid &sessionId)
     QString timeQuery = "SELECT MIN(event_time) as first_event, MAX(event_time) as last_event "
                        "FROM activity_events WHERE session_id = :session_id";
 
+    QDateTime lastEvent;
     auto timeResult = m_dbService->executeSingleSelectQuery(
         timeQuery,
         timeParams,
-        [](const QSqlQuery& query) -> ActivityEventModel* {
+        [&lastEvent](const QSqlQuery& query) -> ActivityEventModel* {
+            lastEvent = query.value("last_event").toDateTime();
+
             QJsonObject data;
             data["first_event"] = query.value("first_event").toDateTime().toUTC().toString();
             data["last_event"] = query.value("last_event").toDateTime().toUTC().toString();
@@ -409,7 +415,8 @@ QJsonObject ActivityEventRepository::getActivitySummary(const QUuid &sessionId)
             ActivityEventModel* model = ModelFactory::createDefaultActivityEvent();
             model->setEventData(data);
             return model;
-        }
+        },
+        ReportRouting
     );
 
     if (timeResult) {
@@ -427,52 +434,78 @@ QJsonObject ActivityEventRepository::getActivitySummary(const QUuid &sessionId)
         delete *timeResult;
     }
 
+    // Events of partitions moved to the archive, which are older than the rows still in the table
+    if (m_archiveStore && m_archiveStore->hasSession("activity_events", sessionId)) {
+        int archivedTotal = 0;
+        QDateTime archivedFirst;
+        QDateTime archivedLast;
+
+        m_archiveStore->visitSession("activity_events", sessionId, [&](const ArchiveStore::Row &row) {
+            const QString eventType = row.value("event_type").toString();
+            eventCounts[eventType] = eventCounts[eventType].toInt() + 1;
+
+            const QDateTime eventTime = row.value("event_time").toDateTime();
+            if (!archivedFirst.isValid()) {
+                archivedFirst = eventTime;
+            }
+            archivedLast = eventTime;
+            archivedTotal++;
+        });
+
+        if (archivedTotal > 0) {
+            const QDateTime last = lastEvent.isValid() ? lastEvent : archivedLast;
+            summary["total_events"] = summary["total_events"].toInt() + archivedTotal;
+            summary["event_counts"] = eventCounts;
+            summary["first_event"] = archivedFirst.toUTC().toString();
+            summary["last_event"] = last.toUTC().toString();
+            summary["duration_seconds"] = archivedFirst.secsTo(last);
+            summary["archived_events"] = archivedTotal;
+        }
+    }
+
+    // Raw events past their retention period survive as per-minute counts
+    QMap<QString, QVariant> compactedParams;
+    compactedParams["session_id"] = sessionId.toString(QUuid::WithoutBraces);
+
+    QString compactedQuery =
+        "SELECT COUNT(*) AS minutes, COALESCE(SUM(event_count), 0) AS events, "
+        "COALESCE(SUM(keystrokes), 0) AS keystrokes, COALESCE(SUM(mouse_clicks), 0) AS mouse_clicks, "
+        "COALESCE(SUM(mouse_moves), 0) AS mouse_moves, COALESCE(SUM(focus_changes), 0) AS focus_changes, "
+        "MIN(minute) AS first_minute, MAX(minute) AS last_minute "
+        "FROM activity_minute_summaries WHERE session_id = :session_id";
+
+    m_dbService->executeVisitQuery(compactedQuery, compactedParams, [&summary](const QSqlQuery& query) {
+        if (query.value("minutes").toInt() == 0) {
+            return;
+        }
+
+        QJsonObject compacted;
+        compacted["minutes"] = query.value("minutes").toInt();
+        compacted["events"] = query.value("events").toLongLong();
+        compacted["keystrokes"] = query.value("keystrokes").toLongLong();
+        compacted["mouse_clicks"] = query.value("mouse_clicks").toLongLong();
+        compacted["mouse_moves"] = query.value("mouse_moves").toLongLong();
+        compacted["focus_changes"] = query.value("focus_changes").toLongLong();
+        compacted["first_minute"] = query.value("first_minute").toDateTime().toUTC().toString();
+        compacted["last_minute"] = query.value("last_minute").toDateTime().toUTC().toString();
+        summary["compacted"] = compacted;
+    }, ReportRouting);
+
     LOG_INFO(QString("Generated activity summary for session %1").arg(sessionId.toString()));
     return summary;
 }
 
 QString ActivityEventRepository::eventTypeToString(EventTypes::ActivityEventType eventType)
 {
-    switch (eventType) {
-        case EventTypes::ActivityEventType::MouseClick:
-            return "mouse_click";
-        case EventTypes::ActivityEventType::MouseMove:
-            return "mouse_move";
-        case EventTypes::ActivityEventType::Keyboard:
-            return "keyboard";
-        case EventTypes::ActivityEventType::AfkStart:
-            return "afk_start";
-        case EventTypes::ActivityEventType::AfkEnd:
-            return "afk_end";
-        case EventTypes::ActivityEventType::AppFocus:
-            return "app_focus";
-        case EventTypes::ActivityEventType::AppUnfocus:
-            return "app_unfocus";
-        default:
-            return "unknown";
-    }
+    return EventTypes::activityEventTypeToString(eventType);
 }
 
 EventTypes::ActivityEventType ActivityEventRepository::stringToEventType(const QString &eventTypeStr)
 {
-    if (eventTypeStr == "mouse_click") {
-        return EventTypes::ActivityEventType::MouseClick;
-    } else if (eventTypeStr == "mouse_move") {
-        return EventTypes::ActivityEventType::MouseMove;
-    } else if (eventTypeStr == "keyboard") {
-        return EventTypes::ActivityEventType::Keyboard;
-    } else if (eventTypeStr == "afk_start") {
-        return EventTypes::ActivityEventType::AfkStart;
-    } else if (eventTypeStr == "afk_end") {
-        return EventTypes::ActivityEventType::AfkEnd;
-    } else if (eventTypeStr == "app_focus") {
-        return EventTypes::ActivityEventType::AppFocus;
-    } else if (eventTypeStr == "app_unfocus") {
-        return EventTypes::ActivityEventType::AppUnfocus;
-    } else {
-        // Default to MouseClick if unknown
+    EventTypes::ActivityEventType eventType = EventTypes::ActivityEventType::MouseClick;
+    if (!EventTypes::activityEventTypeFromString(eventTypeStr, eventType)) {
         LOG_WARNING(QString("Unknown activity event type: %1, defaulting to MouseClick").arg(eventTypeStr));
-        return EventTypes::ActivityEventType::MouseClick;
     }
+    return eventType;
 }
 
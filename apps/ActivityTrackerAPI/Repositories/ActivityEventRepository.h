@@ -10,6 +10,8 @@
 #include <QDateTime>
 #include <QJsonObject>
 
+class ArchiveStore;
+
 class ActivityEventRepository : public BaseRepository<ActivityEventModel>
 {
     Q_OBJECT
@@ -38,6 +40,9 @@ public:
     int getEventCountByType(const QUuid &sessionId, EventTypes::ActivityEventType eventType);
     QJsonObject getActivitySummary(const QUuid &sessionId);
 
+    // The summary also counts events of partitions moved to the archive
+    void setArchiveStore(const ArchiveStore *archiveStore) { m_archiveStore = archiveStore; }
+
 protected:
     // BaseRepository abstract method implementations
     QString getEntityName() const override;
@@ -55,6 +60,8 @@ private:
     // Helper method to convert between string and enum
     QString eventTypeToString(EventTypes::ActivityEventType eventType);
     EventTypes::ActivityEventType stringToEventType(const QString &eventTypeStr);
+
+    const ArchiveStore *m_archiveStore = nullptr;
 };
 
 #endif // ACTIVITYEVENTREPOSITORY_H
\ No newline at end of file
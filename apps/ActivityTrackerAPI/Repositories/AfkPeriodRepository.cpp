@@ -247,7 +247,8 @@ QJsonObject AfkPeriodRepository::getAfkSummary(const QUuid &sessionId)
             helper->totalAfkSeconds = query.value("total_afk_seconds").toDouble();
 
             return helper;
-        }
+        },
+        ReportRouting
     );
 
     if (result) {
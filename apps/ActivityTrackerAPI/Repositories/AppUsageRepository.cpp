@@ -273,12 +273,18 @@ QJsonObject AppUsageRepository::getAppUsageSummary(const QUuid &sessionId)
     QMap<QString, QVariant> params;
     params["session_id"] = sessionId.toString(QUuid::WithoutBraces);
 
+    // Closed time comes from the rollup; only uses still open are read from app_usage
     QString query =
         "SELECT "
         "COUNT(DISTINCT app_id) as unique_apps, "
-        "COALESCE(SUM(EXTRACT(EPOCH FROM (COALESCE(end_time, CURRENT_TIMESTAMP) - start_time))), 0) as total_seconds "
-        "FROM app_usage "
-        "WHERE session_id = :session_id";
+        "COALESCE(SUM(total_seconds), 0) as total_seconds "
+        "FROM ("
+        "  SELECT app_id, total_seconds FROM app_usage_session_rollup "
+        "  WHERE session_id = :session_id AND usage_count > 0 "
+        "  UNION ALL "
+        "  SELECT app_id, EXTRACT(EPOCH FROM (CURRENT_TIMESTAMP - start_time)) FROM app_usage "
+        "  WHERE session_id = :session_id AND end_time IS NULL"
+        ") usage";
 
     logQueryWithValues(query, params);
     auto result = m_dbService->executeSingleSelectQuery(
@@ -297,7 +303,8 @@ QJsonObject AppUsageRepository::getAppUsageSummary(const QUuid &sessionId)
             model->setWindowTitle(QString::fromUtf8(QJsonDocument(stats).toJson()));
 
             return model;
-        }
+        },
+        ReportRouting
     );
 
     if (result) {
@@ -352,10 +359,15 @@ QJsonArray AppUsageRepository::getTopApps(const QUuid &sessionId, int limit)
     QString query =
         "SELECT "
         "app_id, "
-        "COUNT(*) as usage_count, "
-        "COALESCE(SUM(EXTRACT(EPOCH FROM (COALESCE(end_time, CURRENT_TIMESTAMP) - start_time))), 0) as total_seconds "
-        "FROM app_usage "
-        "WHERE session_id = :session_id "
+        "SUM(usage_count) as usage_count, "
+        "COALESCE(SUM(total_seconds), 0) as total_seconds "
+        "FROM ("
+        "  SELECT app_id, usage_count, total_seconds FROM app_usage_session_rollup "
+        "  WHERE session_id = :session_id AND usage_count > 0 "
+        "  UNION ALL "
+        "  SELECT app_id, 0, EXTRACT(EPOCH FROM (CURRENT_TIMESTAMP - start_time)) FROM app_usage "
+        "  WHERE session_id = :session_id AND end_time IS NULL"
+        ") usage "
         "GROUP BY app_id "
         "ORDER BY total_seconds DESC "
         "LIMIT :limit";
@@ -379,7 +391,8 @@ QJsonArray AppUsageRepository::getTopApps(const QUuid &sessionId, int limit)
             model->setWindowTitle(QString::fromUtf8(QJsonDocument(stats).toJson()));
 
             return model;
-        }
+        },
+        ReportRouting
     );
 
     // Process all the results
@@ -409,6 +422,82 @@ QJsonArray AppUsageRepository::getTopApps(const QUuid &sessionId, int limit)
     return topApps;
 }
 
+QJsonArray AppUsageRepository::getUserTopApps(const QUuid &userId, const QDate &startDay, const QDate &endDay, int limit)
+{
+    LOG_DEBUG(QString("Getting top %1 apps for user %2 from %3 to %4")
+              .arg(limit)
+              .arg(userId.toString())
+              .arg(startDay.toString(Qt::ISODate))
+              .arg(endDay.toString(Qt::ISODate)));
+
+    QJsonArray topApps;
+
+    if (!isInitialized()) {
+        LOG_ERROR("Cannot get user top apps: Repository not initialized");
+        return topApps;
+    }
+
+    QMap<QString, QVariant> params;
+    params["user_id"] = userId.toString(QUuid::WithoutBraces);
+    params["start_day"] = startDay;
+    params["end_day"] = endDay;
+    params["limit"] = QString::number(limit);
+
+    // One row per user, day and app; open uses are added from app_usage
+    QString query =
+        "SELECT "
+        "app_id, "
+        "SUM(usage_count) as usage_count, "
+        "COALESCE(SUM(total_seconds), 0) as total_seconds "
+        "FROM ("
+        "  SELECT app_id, usage_count, total_seconds FROM app_usage_daily_rollup "
+        "  WHERE user_id = :user_id AND day BETWEEN :start_day AND :end_day "
+        "  UNION ALL "
+        "  SELECT u.app_id, 0, EXTRACT(EPOCH FROM (CURRENT_TIMESTAMP - GREATEST(u.start_time, CAST(:start_day AS timestamp)))) "
+        "  FROM app_usage u JOIN sessions s ON s.id = u.session_id "
+        "  WHERE s.user_id = :user_id AND s.logout_time IS NULL AND u.end_time IS NULL "
+        "  AND CURRENT_DATE BETWEEN :start_day AND :end_day"
+        ") usage "
+        "WHERE app_id IS NOT NULL "
+        "GROUP BY app_id "
+        "HAVING SUM(usage_count) > 0 OR SUM(total_seconds) > 0 "
+        "ORDER BY total_seconds DESC "
+        "LIMIT :limit";
+
+    logQueryWithValues(query, params);
+    auto appList = m_dbService->executeSelectQuery(
+        query,
+        params,
+        [](const QSqlQuery& query) -> AppUsageModel* {
+            AppUsageModel* model = ModelFactory::createDefaultAppUsage();
+            model->setAppId(QUuid(query.value("app_id").toString()));
+
+            QJsonObject stats;
+            stats["usage_count"] = query.value("usage_count").toInt();
+            stats["total_seconds"] = query.value("total_seconds").toDouble();
+            model->setWindowTitle(QString::fromUtf8(QJsonDocument(stats).toJson()));
+
+            return model;
+        },
+        ReportRouting
+    );
+
+    for (auto app : appList) {
+        QJsonObject appObject;
+        appObject["app_id"] = app->appId().toString(QUuid::WithoutBraces);
+
+        QJsonObject stats = QJsonDocument::fromJson(app->windowTitle().toUtf8()).object();
+        appObject["usage_count"] = stats["usage_count"].toInt();
+        appObject["total_seconds"] = stats["total_seconds"].toDouble();
+
+        topApps.append(appObject);
+        delete app;
+    }
+
+    LOG_INFO(QString("Retrieved top %1 apps for user %2").arg(topApps.size()).arg(userId.toString()));
+    return topApps;
+}
+
 void AppUsageRepository::logQueryWithValues(const QString& query, const QMap<QString, QVariant>& params)
 {
     LOG_DEBUG("Executing query: " + query);
@@ -5,6 +5,7 @@
 #include "../Models/AppUsageModel.h"
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QDate>
 
 class AppUsageRepository : public BaseRepository<AppUsageModel>
 {
@@ -21,6 +22,9 @@ public:
     QJsonObject getAppUsageSummary(const QUuid &sessionId);
     QJsonArray getTopApps(const QUuid &sessionId, int limit = 5);
 
+    // Read from app_usage_daily_rollup; days are UTC and inclusive
+    QJsonArray getUserTopApps(const QUuid &userId, const QDate &startDay, const QDate &endDay, int limit = 10);
+
 protected:
     // Required BaseRepository abstract method implementations
     QString getEntityName() const override;
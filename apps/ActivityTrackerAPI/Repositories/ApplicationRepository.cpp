@@ -10,11 +10,18 @@ ApplicationRepository::ApplicationRepository(QObject *parent)
     LOG_DEBUG("ApplicationRepository created");
 }
 
+const QString ApplicationRepository::InvalidationChannel = QStringLiteral("application_invalidation");
+
 QString ApplicationRepository::getEntityName() const
 {
     return "Application";
 }
 
+QString ApplicationRepository::invalidationChannel() const
+{
+    return InvalidationChannel;
+}
+
 QString ApplicationRepository::getModelId(ApplicationModel* model) const
 {
     return model->id().toString();
@@ -321,6 +328,7 @@ bool ApplicationRepository::assignApplicationToRole(const QUuid &appId, const QU
     bool success = m_dbService->executeModificationQuery(query, params);
 
     if (success) {
+        publishInvalidation(appId.toString(QUuid::WithoutBraces));
         LOG_INFO(QString("Application %1 assigned to Role %2 successfully")
                 .arg(appId.toString(), roleId.toString()));
     } else {
@@ -351,6 +359,7 @@ bool ApplicationRepository::removeApplicationFromRole(const QUuid &appId, const
     bool success = m_dbService->executeModificationQuery(query, params);
 
     if (success) {
+        publishInvalidation(appId.toString(QUuid::WithoutBraces));
         LOG_INFO(QString("Application %1 removed from Role %2 successfully")
                 .arg(appId.toString(), roleId.toString()));
     } else {
@@ -412,6 +421,7 @@ bool ApplicationRepository::assignApplicationToDiscipline(const QUuid &appId, co
     bool success = m_dbService->executeModificationQuery(query, params);
 
     if (success) {
+        publishInvalidation(appId.toString(QUuid::WithoutBraces));
         LOG_INFO(QString("Application %1 assigned to Discipline %2 successfully")
                 .arg(appId.toString(), disciplineId.toString()));
     } else {
@@ -442,6 +452,7 @@ bool ApplicationRepository::removeApplicationFromDiscipline(const QUuid &appId,
     bool success = m_dbService->executeModificationQuery(query, params);
 
     if (success) {
+        publishInvalidation(appId.toString(QUuid::WithoutBraces));
         LOG_INFO(QString("Application %1 removed from Discipline %2 successfully")
                 .arg(appId.toString(), disciplineId.toString()));
     } else {
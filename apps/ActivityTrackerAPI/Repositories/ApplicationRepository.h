@@ -14,6 +14,9 @@ class ApplicationRepository : public BaseRepository<ApplicationModel>
 public:
     explicit ApplicationRepository(QObject *parent = nullptr);
 
+    // Payloads are application IDs; role and discipline assignments publish the application's ID
+    static const QString InvalidationChannel;
+
     // Additional application-specific operations
     QSharedPointer<ApplicationModel> getByPath(const QString &appPath);
     QSharedPointer<ApplicationModel> getByPathAndName(const QString &appPath, const QString &appName);
@@ -41,6 +44,7 @@ public:
 protected:
     // BaseRepository abstract method implementations
     QString getEntityName() const override;
+    QString invalidationChannel() const override;
     QString getModelId(ApplicationModel* model) const override;
     QString buildSaveQuery() override;
     QString buildUpdateQuery() override;
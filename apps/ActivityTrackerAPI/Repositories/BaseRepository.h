@@ -11,8 +11,12 @@
 #include <QJsonArray>
 #include <functional>
 #include <QJsonDocument>
+#include <QRegularExpression>
+#include <QSet>
+#include <optional>
 
 #include "dbservice/dbservice.hpp"
+#include "dbservice/notificationbus.h"
 #include "logger/logger.h"
 #include "Core/ModelFactory.h"
 
@@ -135,8 +139,9 @@ public:
                 // Update the model with the generated ID
                 if (!generatedId.isNull()) {
                     model->setId(generatedId);
+                    publishInvalidation(generatedId.toString(QUuid::WithoutBraces));
                     LOG_INFO(QString("%1 saved successfully with database-generated ID: %2")
-                            .arg(getEntityName(), generatedId.toString()));
+                            .arg(getEntityName(), loggableId(generatedId.toString(QUuid::WithoutBraces))));
                 } else {
                     LOG_WARNING(QString("%1 saved but failed to retrieve generated ID")
                                .arg(getEntityName()));
@@ -152,17 +157,100 @@ public:
             bool success = m_dbService->executeModificationQuery(query, params);
 
             if (success) {
+                publishInvalidation(getModelId(model));
                 LOG_INFO(QString("%1 saved successfully with ID: %2")
-                        .arg(getEntityName(), getModelId(model)));
+                        .arg(getEntityName(), loggableId(getModelId(model))));
             } else {
                 LOG_ERROR(QString("Failed to save %1: %2 - %3")
-                         .arg(getEntityName(), getModelId(model), m_dbService->lastError()));
+                         .arg(getEntityName(), loggableId(getModelId(model)), m_dbService->lastError()));
             }
 
             return success;
         }
     }
 
+    /**
+     * @brief Insert many new models with multi-row INSERT statements
+     *
+     * Expands the VALUES tuple of buildSaveQuery() once per row, so a chunk of
+     * rows costs one round trip. Generated IDs are not read back. Models that
+     * fail validation are skipped. Run it inside a transaction when the chunks
+     * must succeed or fail together.
+     *
+     * @param models The models to insert
+     * @param rowsPerStatement Maximum rows per INSERT statement
+     * @return Number of rows inserted, or -1 if a statement failed
+     */
+    virtual int saveAll(const QList<T*>& models, int rowsPerStatement = 500) {
+        if (!ensureInitialized()) {
+            return -1;
+        }
+
+        QString saveQuery = buildSaveQuery();
+        int valuesPos = saveQuery.indexOf("VALUES", 0, Qt::CaseInsensitive);
+        if (valuesPos < 0) {
+            LOG_ERROR(QString("Cannot bulk insert %1: save query has no VALUES clause").arg(getEntityName()));
+            return -1;
+        }
+
+        int tupleStart = valuesPos + 6;
+        int returningPos = saveQuery.indexOf("RETURNING", tupleStart, Qt::CaseInsensitive);
+        QString insertHead = saveQuery.left(tupleStart);
+        QString tuple = saveQuery.mid(tupleStart, returningPos < 0 ? -1 : returningPos - tupleStart).trimmed();
+
+        // Named placeholders, but not the second half of a ::type cast
+        static const QRegularExpression placeholder("(?<!:):([A-Za-z_][A-Za-z0-9_]*)");
+
+        QList<T*> validModels;
+        validModels.reserve(models.size());
+        for (T* model : models) {
+            QStringList validationErrors;
+            if (validateModel(model, validationErrors)) {
+                validModels.append(model);
+            } else {
+                LOG_WARNING(QString("Skipping %1 in bulk insert: validation failed - %2")
+                           .arg(getEntityName(), validationErrors.join(", ")));
+            }
+        }
+
+        rowsPerStatement = qMax(1, rowsPerStatement);
+        int inserted = 0;
+
+        for (int chunkStart = 0; chunkStart < validModels.size(); chunkStart += rowsPerStatement) {
+            int chunkEnd = qMin(chunkStart + rowsPerStatement, int(validModels.size()));
+
+            QStringList tuples;
+            QMap<QString, QVariant> params;
+            for (int row = chunkStart; row < chunkEnd; ++row) {
+                QString suffix = QString("_%1").arg(row - chunkStart);
+                tuples.append(QString(tuple).replace(placeholder, ":\\1" + suffix));
+
+                QMap<QString, QVariant> rowParams = prepareParamsForSave(validModels[row]);
+                for (auto it = rowParams.constBegin(); it != rowParams.constEnd(); ++it) {
+                    params.insert(it.key() + suffix, it.value());
+                }
+            }
+
+            QString query = insertHead + " " + tuples.join(", ");
+            if (!m_dbService->executeModificationQuery(query, params)) {
+                LOG_ERROR(QString("Bulk insert of %1 rows failed after %2 rows: %3")
+                         .arg(getEntityName())
+                         .arg(inserted)
+                         .arg(m_dbService->lastError()));
+                return -1;
+            }
+
+            inserted += chunkEnd - chunkStart;
+        }
+
+        if (inserted > 0) {
+            publishInvalidation(NotificationBus::AllKeys);
+        }
+
+        LOG_DEBUG(QString("Bulk inserted %1 %2 rows").arg(inserted).arg(getEntityName()));
+        return inserted;
+    }
+
     /**
      * @brief Update a model in the database
      * @param model The model to update
@@ -191,10 +279,11 @@ public:
         bool success = m_dbService->executeModificationQuery(query, params);
 
         if (success) {
-            LOG_INFO(QString("%1 updated successfully: %2").arg(getEntityName(), getModelId(model)));
+            publishInvalidation(getModelId(model));
+            LOG_INFO(QString("%1 updated successfully: %2").arg(getEntityName(), loggableId(getModelId(model))));
         } else {
             LOG_ERROR(QString("Failed to update %1: %2 - %3")
-                     .arg(getEntityName(), getModelId(model), m_dbService->lastError()));
+                     .arg(getEntityName(), loggableId(getModelId(model)), m_dbService->lastError()));
         }
 
         return success;
@@ -224,11 +313,11 @@ public:
         );
 
         if (result) {
-            LOG_DEBUG(QString("%1 found with ID: %2").arg(getEntityName(), id.toString()));
+            LOG_DEBUG(QString("%1 found with ID: %2").arg(getEntityName(), loggableId(id.toString(QUuid::WithoutBraces))));
             return QSharedPointer<T>(*result);
         }
 
-        LOG_DEBUG(QString("%1 not found with ID: %2").arg(getEntityName(), id.toString()));
+        LOG_DEBUG(QString("%1 not found with ID: %2").arg(getEntityName(), loggableId(id.toString(QUuid::WithoutBraces))));
         return nullptr;
     }
 
@@ -350,10 +439,11 @@ public:
         bool success = m_dbService->executeModificationQuery(query, params);
 
         if (success) {
-            LOG_INFO(QString("%1 removed successfully: %2").arg(getEntityName(), id.toString()));
+            publishInvalidation(id.toString(QUuid::WithoutBraces));
+            LOG_INFO(QString("%1 removed successfully: %2").arg(getEntityName(), loggableId(id.toString(QUuid::WithoutBraces))));
         } else {
             LOG_ERROR(QString("Failed to remove %1: %2 - %3")
-                     .arg(getEntityName(), id.toString(), m_dbService->lastError()));
+                     .arg(getEntityName(), loggableId(id.toString(QUuid::WithoutBraces)), m_dbService->lastError()));
         }
 
         return success;
@@ -397,7 +487,7 @@ public:
         }
 
         LOG_DEBUG(QString("%1 with ID %2 exists: %3")
-                 .arg(getEntityName(), id.toString(), exists ? "yes" : "no"));
+                 .arg(getEntityName(), loggableId(id.toString(QUuid::WithoutBraces)), exists ? "yes" : "no"));
 
         return exists;
     }
@@ -459,6 +549,24 @@ public:
         return success;
     }
 
+    /**
+     * @brief Savepoint helpers for use inside an open transaction
+     *
+     * Rolling back to a savepoint undoes a failed statement without aborting
+     * the surrounding transaction.
+     */
+    bool createSavepoint(const QString& name) {
+        return ensureInitialized() && m_dbService->createSavepoint(name);
+    }
+
+    bool releaseSavepoint(const QString& name) {
+        return ensureInitialized() && m_dbService->releaseSavepoint(name);
+    }
+
+    bool rollbackToSavepoint(const QString& name) {
+        return ensureInitialized() && m_dbService->rollbackToSavepoint(name);
+    }
+
     /**
      * @brief Execute a function within a transaction
      * @param operation The function to execute
@@ -498,49 +606,14 @@ public:
 
     bool logQueryWithValues(const QString& queryTemplate, const QMap<QString, QVariant>& params)
     {
-        // Create a copy of the query template that we'll replace parameters in
-        QString queryWithValues = queryTemplate;
-
-        // Enhanced logging header
-        LOG_DEBUG("======= DETAILED SQL QUERY LOGGING =======");
-        LOG_DEBUG(QString("Original query: %1").arg(queryTemplate));
-        LOG_DEBUG("Parameters:");
-
-        // Replace each parameter with its value
-        for (auto it = params.constBegin(); it != params.constEnd(); ++it) {
-            QString paramName = ":" + it.key();
-            QString paramValue;
-
-            // Format the value based on its type
-            if (it.value().type() == QVariant::String) {
-                paramValue = "'" + it.value().toString() + "'";
-                LOG_DEBUG(QString("  %1 (String) = %2").arg(it.key(), paramValue));
-            } else if (it.value().type() == QVariant::DateTime) {
-                paramValue = "'" + it.value().toDateTime().toUTC().toString() + "'";
-                LOG_DEBUG(QString("  %1 (DateTime) = %2").arg(it.key(), paramValue));
-            } else if (it.value().isNull()) {
-                paramValue = "NULL";
-                LOG_DEBUG(QString("  %1 = NULL").arg(it.key()));
-            } else {
-                paramValue = it.value().toString();
-                LOG_DEBUG(QString("  %1 (Other) = %2").arg(it.key(), paramValue));
-            }
-
-            // Replace all occurrences of the parameter in the query
-            queryWithValues.replace(paramName, paramValue);
-        }
-
-        // Log the complete query with values
-        LOG_DEBUG(QString("COMPLETE SQL QUERY: %1").arg(queryWithValues));
+        // Interpolation and redaction of token/password parameters run only if the record is written
+        LOG_FIELDS(Logger::Debug, QString("Executing %1 query").arg(getEntityName()),
+                   LogField::sql("query", queryTemplate, params),
+                   LogField::value("parameters", params.size()));
 
-        // Log additional DB metadata
-        if (m_dbService) {
-            LOG_DEBUG(QString("Using database service: %1").arg(typeid(*m_dbService).name()));
-            LOG_DEBUG(QString("Last error: %1").arg(m_dbService->lastError()));
-        } else {
+        if (!m_dbService) {
             LOG_WARNING("Database service is NULL!");
         }
-        LOG_DEBUG("=========================================");
 
         return true;
     }
@@ -549,9 +622,11 @@ public:
      * @brief Execute a custom select query that returns a single result
      * @param query The SQL query string
      * @param params The query parameters
+     * @param routing Whether the query may run on a read replica
      * @return Shared pointer to the model or nullptr if not found
      */
-    QSharedPointer<T> executeSingleSelectQuery(const QString& query, const QMap<QString, QVariant>& params) {
+    QSharedPointer<T> executeSingleSelectQuery(const QString& query, const QMap<QString, QVariant>& params,
+                                               QueryRouting routing = QueryRouting::Primary) {
         if (!ensureInitialized()) {
             return nullptr;
         }
@@ -561,7 +636,8 @@ public:
             params,
             [this](const QSqlQuery& query) -> T* {
                 return createModelFromQuery(query);
-            }
+            },
+            routing
         );
 
         if (result) {
@@ -575,9 +651,11 @@ public:
      * @brief Execute a custom select query that returns multiple results
      * @param query The SQL query string
      * @param params The query parameters
+     * @param routing Whether the query may run on a read replica
      * @return List of models
      */
-    QList<QSharedPointer<T>> executeSelectQuery(const QString& query, const QMap<QString, QVariant>& params) {
+    QList<QSharedPointer<T>> executeSelectQuery(const QString& query, const QMap<QString, QVariant>& params,
+                                                QueryRouting routing = QueryRouting::Primary) {
         if (!ensureInitialized()) {
             return QList<QSharedPointer<T>>();
         }
@@ -587,7 +665,8 @@ public:
             params,
             [this](const QSqlQuery& query) -> T* {
                 return createModelFromQuery(query);
-            }
+            },
+            routing
         );
 
         QList<QSharedPointer<T>> result;
@@ -621,6 +700,55 @@ public:
         return success;
     }
 
+    /**
+     * @brief Claim client_seq values of a session in batch_client_sequences
+     *
+     * Runs on this repository's connection, so inside an open transaction the
+     * claim commits or rolls back with the rows it covers. A value claimed by
+     * a transaction still in flight blocks until that transaction ends, and an
+     * expired claim is taken over.
+     *
+     * @param sessionId Session the values belong to
+     * @param sequences client_seq values to claim
+     * @param expiresAt When the claims may be purged
+     * @return The values this call claimed, or std::nullopt if the statement failed
+     */
+    std::optional<QSet<qint64>> claimClientSequences(const QUuid& sessionId, const QList<qint64>& sequences,
+                                                     const QDateTime& expiresAt) {
+        QSet<qint64> claimed;
+        if (sequences.isEmpty()) {
+            return claimed;
+        }
+        if (!ensureInitialized()) {
+            return std::nullopt;
+        }
+
+        // A value listed twice would make ON CONFLICT DO UPDATE touch its row twice
+        const QSet<qint64> unique(sequences.constBegin(), sequences.constEnd());
+
+        QString query = "INSERT INTO batch_client_sequences (session_id, client_seq, expires_at) "
+                        "SELECT :session_id, unnest(:sequences::bigint[]), :expires_at "
+                        "ON CONFLICT (session_id, client_seq) DO UPDATE SET expires_at = EXCLUDED.expires_at "
+                        "WHERE batch_client_sequences.expires_at <= CURRENT_TIMESTAMP "
+                        "RETURNING client_seq";
+
+        QMap<QString, QVariant> params;
+        params["session_id"] = sessionId.toString(QUuid::WithoutBraces);
+        params["sequences"] = bigintArrayLiteral(QList<qint64>(unique.constBegin(), unique.constEnd()));
+        params["expires_at"] = expiresAt.toUTC();
+
+        int rows = m_dbService->executeVisitQuery(query, params, [&claimed](const QSqlQuery& row) {
+            claimed.insert(row.value("client_seq").toLongLong());
+        });
+        if (rows < 0) {
+            LOG_ERROR(QString("Failed to claim client_seq values for session %1: %2")
+                     .arg(sessionId.toString(), m_dbService->lastError()));
+            return std::nullopt;
+        }
+
+        return claimed;
+    }
+
     /**
      * @brief Get the database service
      * @return Pointer to the database service
@@ -631,6 +759,82 @@ public:
 
 protected:
 
+    /**
+     * @brief Routing for session listings, which should show current sessions
+     */
+    static constexpr QueryRouting ListingRouting = QueryRouting::ReadOnly;
+
+    /**
+     * @brief Routing for report aggregates, which tolerate replica lag
+     */
+    static constexpr QueryRouting ReportRouting = QueryRouting::StaleTolerant;
+
+    /**
+     * @brief Postgres array literal for binding a list of integers as text
+     *
+     * Bind the result as one parameter and cast it in the query, e.g.
+     * ANY(:values::bigint[]).
+     */
+    static QString bigintArrayLiteral(const QList<qint64>& values) {
+        QStringList parts;
+        parts.reserve(values.size());
+        for (qint64 value : values) {
+            parts.append(QString::number(value));
+        }
+        return "{" + parts.join(',') + "}";
+    }
+
+    /**
+     * @brief NOTIFY channel that caches of this entity subscribe to
+     * @return Channel name, or an empty string when nothing caches the entity
+     */
+    virtual QString invalidationChannel() const {
+        return QString();
+    }
+
+    /**
+     * @brief Tell every node that the row behind key changed
+     *
+     * save(), update() and remove() call this themselves; custom write queries
+     * must call it after they succeed. Sent on the repository connection, so
+     * inside a transaction it is delivered on commit.
+     *
+     * @param key Model ID, or NotificationBus::AllKeys
+     */
+    void publishInvalidation(const QString& key) {
+        const QString channel = invalidationChannel();
+        if (!channel.isEmpty() && m_dbService) {
+            NotificationBus::publish(*m_dbService, channel,
+                                     key == NotificationBus::AllKeys ? key : invalidationKey(key));
+        }
+    }
+
+    /**
+     * @brief Key a model ID is published under on the invalidation channel
+     *
+     * Payloads travel in clear to every listener and may show up in the server
+     * log, so a repository whose IDs are secrets publishes a digest instead.
+     *
+     * @param id Model ID
+     * @return The ID itself by default
+     */
+    virtual QString invalidationKey(const QString& id) const {
+        return id;
+    }
+
+    /**
+     * @brief Form of a model ID written to the log
+     *
+     * Every log line here that names a model goes through this, so a
+     * repository whose IDs are secrets never writes them in clear.
+     *
+     * @param id Model ID
+     * @return The ID itself by default
+     */
+    virtual QString loggableId(const QString& id) const {
+        return id;
+    }
+
     /**
      * @brief Build the SQL query for saving with RETURNING clause
      * @return SQL query string
@@ -6,6 +6,7 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QSet>
 
 #include "EventTypes.h"
 #include "Core/ModelFactory.h"
@@ -187,7 +188,8 @@ QList<QSharedPointer<SessionModel>> SessionRepository::getByUserId(const QUuid &
         params,
         [this](const QSqlQuery& query) -> SessionModel* {
             return createModelFromQuery(query);
-        }
+        },
+        ListingRouting
     );
 
     QList<QSharedPointer<SessionModel>> result;
@@ -226,7 +228,8 @@ QList<QSharedPointer<SessionModel>> SessionRepository::getByMachineId(const QUui
         params,
         [this](const QSqlQuery& query) -> SessionModel* {
             return createModelFromQuery(query);
-        }
+        },
+        ListingRouting
     );
 
     QList<QSharedPointer<SessionModel>> result;
@@ -374,11 +377,12 @@ bool SessionRepository::continueSession(const QUuid &previousSessionId, const QU
     }
 
     try {
-        // Get the previous session
+        // Get the previous session, locked until commit so two sessions cannot both
+        // be appended after it and take the same chain position
         QMap<QString, QVariant> prevParams;
         prevParams["id"] = previousSessionId.toString(QUuid::WithoutBraces);
 
-        QString prevQuery = "SELECT * FROM sessions WHERE id = :id";
+        QString prevQuery = "SELECT * FROM sessions WHERE id = :id FOR UPDATE";
 
         auto prevResult = m_dbService->executeSingleSelectQuery(
             prevQuery,
@@ -396,11 +400,20 @@ bool SessionRepository::continueSession(const QUuid &previousSessionId, const QU
 
         QSharedPointer<SessionModel> previousSession(*prevResult);
 
+        // Only the last session of a chain can be continued
+        if (!previousSession->continuedBySession().isNull()
+            && previousSession->continuedBySession() != newSessionId) {
+            LOG_ERROR(QString("Previous session %1 is already continued by %2")
+                      .arg(previousSessionId.toString(), previousSession->continuedBySession().toString()));
+            m_dbService->rollbackTransaction();
+            return false;
+        }
+
         // Get the new session
         QMap<QString, QVariant> newParams;
         newParams["id"] = newSessionId.toString(QUuid::WithoutBraces);
 
-        QString newQuery = "SELECT * FROM sessions WHERE id = :id";
+        QString newQuery = "SELECT * FROM sessions WHERE id = :id FOR UPDATE";
 
         auto newResult = m_dbService->executeSingleSelectQuery(
             newQuery,
@@ -418,6 +431,14 @@ bool SessionRepository::continueSession(const QUuid &previousSessionId, const QU
 
         QSharedPointer<SessionModel> newSession(*newResult);
 
+        if (!newSession->continuedFromSession().isNull()
+            && newSession->continuedFromSession() != previousSessionId) {
+            LOG_ERROR(QString("New session %1 already continues %2")
+                      .arg(newSessionId.toString(), newSession->continuedFromSession().toString()));
+            m_dbService->rollbackTransaction();
+            return false;
+        }
+
         // Make sure the previous session has ended
         if (!previousSession->logoutTime().isValid()) {
             LOG_ERROR(QString("Previous session has not ended yet: %1").arg(previousSessionId.toString()));
@@ -425,7 +446,8 @@ bool SessionRepository::continueSession(const QUuid &previousSessionId, const QU
             return false;
         }
 
-        // Update the previous session to point to the new session
+        // Update the previous session to point to the new session; a session that
+        // was never continued becomes the root of its own chain
         QMap<QString, QVariant> params1;
         params1["id"] = previousSessionId.toString(QUuid::WithoutBraces);
         params1["continued_by_session"] = newSessionId.toString(QUuid::WithoutBraces);
@@ -434,6 +456,8 @@ bool SessionRepository::continueSession(const QUuid &previousSessionId, const QU
         QString query1 =
             "UPDATE sessions SET "
             "continued_by_session = :continued_by_session, "
+            "chain_id = COALESCE(chain_id, id), "
+            "chain_position = COALESCE(chain_position, 1), "
             "updated_at = :updated_at "
             "WHERE id = :id";
 
@@ -477,6 +501,33 @@ bool SessionRepository::continueSession(const QUuid &previousSessionId, const QU
             return false;
         }
 
+        // Move the new session, and any sessions already chained after it, to the end
+        // of the previous session's chain
+        QMap<QString, QVariant> params3;
+        params3["previous_id"] = previousSessionId.toString(QUuid::WithoutBraces);
+        params3["new_id"] = newSessionId.toString(QUuid::WithoutBraces);
+
+        QString query3 =
+            "UPDATE sessions s SET "
+            "chain_id = p.chain_id, "
+            "chain_position = p.chain_position + 1 + COALESCE(s.chain_position, 1) - n.chain_position "
+            "FROM (SELECT chain_id, chain_position FROM sessions WHERE id = :previous_id) p, "
+            "(SELECT chain_id, COALESCE(chain_position, 1) AS chain_position FROM sessions WHERE id = :new_id) n "
+            "WHERE s.id = :new_id "
+            "OR (s.chain_id = n.chain_id AND s.chain_position > n.chain_position)";
+
+        LOG_DEBUG(QString("Appending session %1 to the chain of %2")
+                  .arg(newSessionId.toString(), previousSessionId.toString()));
+
+        bool success3 = m_dbService->executeModificationQuery(query3, params3);
+
+        if (!success3) {
+            LOG_ERROR(QString("Failed to update session chain for: %1, error: %2")
+                      .arg(newSessionId.toString(), m_dbService->lastError()));
+            m_dbService->rollbackTransaction();
+            return false;
+        }
+
         // Commit transaction
         bool commitSuccess = m_dbService->commitTransaction();
         if (commitSuccess) {
@@ -510,9 +561,12 @@ QList<QSharedPointer<SessionModel>> SessionRepository::getSessionChain(const QUu
     QMap<QString, QVariant> params;
     params["id"] = id.toString(QUuid::WithoutBraces);
 
+    // chain_id is NULL for a session that was never continued
     QString query =
-        "SELECT * FROM get_session_chain(:id) "
-        "ORDER BY position";
+        "SELECT * FROM sessions "
+        "WHERE chain_id = (SELECT chain_id FROM sessions WHERE id = :id) "
+        "OR id = :id "
+        "ORDER BY COALESCE(chain_position, 1)";
 
     LOG_DEBUG(QString("Executing session chain query with id: %1").arg(params["id"].toString()));
 
@@ -521,41 +575,9 @@ QList<QSharedPointer<SessionModel>> SessionRepository::getSessionChain(const QUu
             query,
             params,
             [this](const QSqlQuery& query) -> SessionModel* {
-                // For stored procedure results that might not have all fields,
-                // we handle this separately instead of using ModelFactory
-
-                SessionModel* session = new SessionModel();
-
-                // Populate the basic session data from the query
-                if (!query.value("id").isNull()) {
-                    session->setId(QUuid(query.value("id").toString()));
-                }
-
-                if (!query.value("user_id").isNull()) {
-                    session->setUserId(QUuid(query.value("user_id").toString()));
-                }
-
-                if (!query.value("machine_id").isNull()) {
-                    // In PostgreSQL, machine_id might be stored as text, not UUID
-                    QString machineIdStr = query.value("machine_id").toString();
-                    if (QUuid::fromString(machineIdStr).isNull()) {
-                        // If it's not a valid UUID, use a null UUID or handle appropriately
-                        LOG_WARNING(QString("Machine ID in session chain is not a valid UUID: %1").arg(machineIdStr));
-                    } else {
-                        session->setMachineId(QUuid(machineIdStr));
-                    }
-                }
-
-                if (!query.value("login_time").isNull()) {
-                    session->setLoginTime(query.value("login_time").toDateTime());
-                }
-
-                if (!query.value("logout_time").isNull()) {
-                    session->setLogoutTime(query.value("logout_time").toDateTime());
-                }
-
-                return session;
-            }
+                return createModelFromQuery(query);
+            },
+            ReportRouting
         );
 
         for (auto model : sessions) {
@@ -589,8 +611,29 @@ QJsonObject SessionRepository::getSessionChainStats(const QUuid &id)
     QMap<QString, QVariant> params;
     params["id"] = id.toString(QUuid::WithoutBraces);
 
-    // PostgreSQL function that returns chain statistics
-    QString query = "SELECT * FROM get_session_chain_stats(:id)";
+    // Same figures as get_session_chain_stats(), over the indexed chain columns
+    QString query =
+        "WITH chain_data AS ("
+        "SELECT COALESCE(chain_id, id) AS chain_id, login_time, logout_time, "
+        "EXTRACT(EPOCH FROM (login_time - LAG(logout_time) OVER (ORDER BY COALESCE(chain_position, 1)))) AS gap_seconds "
+        "FROM sessions "
+        "WHERE chain_id = (SELECT chain_id FROM sessions WHERE id = :id) "
+        "OR id = :id"
+        ") "
+        "SELECT "
+        "MIN(chain_id::text) AS chain_id, "
+        "COUNT(*) AS total_sessions, "
+        "MIN(login_time) AS first_login, "
+        "MAX(COALESCE(logout_time, CURRENT_TIMESTAMP)) AS last_activity, "
+        "SUM(EXTRACT(EPOCH FROM (COALESCE(logout_time, CURRENT_TIMESTAMP) - login_time))) AS total_duration_seconds, "
+        "COALESCE(SUM(gap_seconds), 0) AS total_gap_seconds, "
+        "EXTRACT(EPOCH FROM (MAX(COALESCE(logout_time, CURRENT_TIMESTAMP)) - MIN(login_time))) AS real_time_span_seconds, "
+        "CASE "
+        "WHEN EXTRACT(EPOCH FROM (MAX(COALESCE(logout_time, CURRENT_TIMESTAMP)) - MIN(login_time))) = 0 THEN 100.0 "
+        "ELSE SUM(EXTRACT(EPOCH FROM (COALESCE(logout_time, CURRENT_TIMESTAMP) - login_time))) * 100.0 / "
+        "EXTRACT(EPOCH FROM (MAX(COALESCE(logout_time, CURRENT_TIMESTAMP)) - MIN(login_time))) "
+        "END AS continuity_percentage "
+        "FROM chain_data";
 
     LOG_DEBUG(QString("Executing session chain stats query: %1").arg(query));
     LOG_DEBUG(QString("With parameters: id = %1").arg(params["id"].toString()));
@@ -633,7 +676,8 @@ QJsonObject SessionRepository::getSessionChainStats(const QUuid &id)
                      .arg(chainStats->continuityPercentage, 0, 'f', 2));
 
             return chainStats;
-        }
+        },
+        ReportRouting
     );
 
     if (result) {
@@ -657,6 +701,174 @@ QJsonObject SessionRepository::getSessionChainStats(const QUuid &id)
 }
 
 QJsonObject SessionRepository::getUserSessionStats(const QUuid &userId, const QDateTime &startDate, const QDateTime &endDate)
+{
+    QJsonObject stats;
+
+    if (!isInitialized()) {
+        LOG_ERROR("Cannot get user session stats: Repository not initialized");
+        return stats;
+    }
+
+    if (getUserStatsFromDailySummaries(userId, startDate.toUTC().date(), endDate.toUTC().date(), stats)) {
+        return stats;
+    }
+
+    LOG_WARNING("Daily summaries unavailable, computing user session stats from sessions");
+    return getUserStatsFromSessions(userId, startDate, endDate);
+}
+
+bool SessionRepository::getUserStatsFromDailySummaries(const QUuid &userId, const QDate &startDay, const QDate &endDay,
+                                                       QJsonObject &stats)
+{
+    QMap<QString, QVariant> params;
+    params["user_id"] = userId.toString(QUuid::WithoutBraces);
+    params["start_day"] = startDay;
+    params["end_day"] = endDay;
+
+    QString query =
+        "SELECT day, session_count, machine_ids, total_seconds, afk_count, afk_seconds, active_seconds, "
+        "first_login, last_activity, top_apps "
+        "FROM user_daily_summaries "
+        "WHERE user_id = :user_id "
+        "AND day BETWEEN CAST(:start_day AS date) AND CAST(:end_day AS date) "
+        "ORDER BY day";
+
+    logQueryWithValues(query, params);
+
+    int totalSessions = 0;
+    int totalAfk = 0;
+    double totalSeconds = 0;
+    double totalAfkSeconds = 0;
+    double activeSeconds = 0;
+    QDateTime firstLogin;
+    QDateTime lastActivity;
+    QSet<QString> machines;
+    QJsonArray daily;
+
+    int rows = m_dbService->executeVisitQuery(query, params, [&](const QSqlQuery& row) {
+        // QPSQL returns UUID[] in its text form, e.g. {a,b}
+        QString machineList = row.value("machine_ids").toString();
+        machineList.remove('{').remove('}');
+        for (const QString& machineId : machineList.split(',', Qt::SkipEmptyParts)) {
+            machines.insert(machineId);
+        }
+
+        const QDateTime dayFirst = row.value("first_login").toDateTime();
+        const QDateTime dayLast = row.value("last_activity").toDateTime();
+        if (!firstLogin.isValid() || dayFirst < firstLogin) {
+            firstLogin = dayFirst;
+        }
+        if (!lastActivity.isValid() || dayLast > lastActivity) {
+            lastActivity = dayLast;
+        }
+
+        QJsonObject day;
+        day["day"] = row.value("day").toDate().toString(Qt::ISODate);
+        day["sessions"] = row.value("session_count").toInt();
+        day["total_seconds"] = row.value("total_seconds").toDouble();
+        day["afk_periods"] = row.value("afk_count").toInt();
+        day["afk_seconds"] = row.value("afk_seconds").toDouble();
+        day["active_seconds"] = row.value("active_seconds").toDouble();
+        day["top_apps"] = QJsonDocument::fromJson(row.value("top_apps").toByteArray()).array();
+        daily.append(day);
+
+        totalSessions += day["sessions"].toInt();
+        totalSeconds += day["total_seconds"].toDouble();
+        totalAfk += day["afk_periods"].toInt();
+        totalAfkSeconds += day["afk_seconds"].toDouble();
+        activeSeconds += day["active_seconds"].toDouble();
+    }, ReportRouting);
+
+    if (rows < 0) {
+        return false;
+    }
+
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    if (!firstLogin.isValid()) {
+        firstLogin = now;
+        lastActivity = now;
+    }
+
+    stats["total_sessions"] = totalSessions;
+    stats["total_seconds"] = totalSeconds;
+    stats["first_login"] = firstLogin.toUTC().toString();
+    stats["last_activity"] = lastActivity.toUTC().toString();
+    stats["unique_machines"] = machines.size();
+    stats["total_afk_periods"] = totalAfk;
+    stats["total_afk_seconds"] = totalAfkSeconds;
+    stats["daily"] = daily;
+
+    int days = firstLogin.daysTo(lastActivity) + 1;
+    if (days > 0) {
+        stats["average_seconds_per_day"] = totalSeconds / days;
+        stats["average_sessions_per_day"] = (double)totalSessions / days;
+    }
+
+    if (totalSeconds > 0) {
+        stats["afk_percentage"] = (totalAfkSeconds / totalSeconds) * 100.0;
+        stats["active_seconds"] = activeSeconds;
+    }
+
+    LOG_DEBUG(QString("User stats from %1 daily summaries: %2 sessions, %3 seconds total")
+              .arg(rows)
+              .arg(totalSessions)
+              .arg(totalSeconds));
+
+    return true;
+}
+
+int SessionRepository::refreshDailySummaries(const QDate &fromDay, const QDate &toDay)
+{
+    if (!ensureInitialized()) {
+        LOG_ERROR("Cannot refresh daily summaries: Repository not initialized");
+        return -1;
+    }
+
+    QMap<QString, QVariant> params;
+    params["from_day"] = fromDay;
+    params["to_day"] = toDay;
+
+    QString query = "SELECT refresh_user_daily_summaries(CAST(:from_day AS date), CAST(:to_day AS date)) AS refreshed";
+
+    logQueryWithValues(query, params);
+
+    int refreshed = -1;
+    int rows = m_dbService->executeVisitQuery(query, params, [&refreshed](const QSqlQuery& row) {
+        refreshed = row.value("refreshed").toInt();
+    });
+
+    if (rows < 0) {
+        LOG_ERROR(QString("Failed to refresh daily summaries from %1 to %2")
+                  .arg(fromDay.toString(Qt::ISODate), toDay.toString(Qt::ISODate)));
+        return -1;
+    }
+
+    return refreshed;
+}
+
+int SessionRepository::refreshDirtyDailySummaries()
+{
+    if (!ensureInitialized()) {
+        LOG_ERROR("Cannot refresh daily summaries: Repository not initialized");
+        return -1;
+    }
+
+    QString query = "SELECT refresh_dirty_user_daily_summaries() AS refreshed";
+
+    int refreshed = -1;
+    int rows = m_dbService->executeVisitQuery(query, QMap<QString, QVariant>(), [&refreshed](const QSqlQuery& row) {
+        refreshed = row.value("refreshed").toInt();
+    });
+
+    if (rows < 0) {
+        LOG_ERROR("Failed to refresh the daily summaries of late batches");
+        return -1;
+    }
+
+    return refreshed;
+}
+
+QJsonObject SessionRepository::getUserStatsFromSessions(const QUuid &userId, const QDateTime &startDate, const QDateTime &endDate)
 {
     LOG_DEBUG(QString("Getting user session stats for user %1 from %2 to %3")
               .arg(userId.toString())
@@ -719,7 +931,8 @@ QJsonObject SessionRepository::getUserSessionStats(const QUuid &userId, const QD
                      .arg(userStats->totalSeconds));
 
             return userStats;
-        }
+        },
+        ReportRouting
     );
 
     if (result) {
@@ -785,7 +998,8 @@ QJsonObject SessionRepository::getUserSessionStats(const QUuid &userId, const QD
                      .arg(afkStats->totalAfkSeconds));
 
             return afkStats;
-        }
+        },
+        ReportRouting
     );
 
     if (afkResult) {
@@ -1755,3 +1969,141 @@ bool SessionRepository::verifyLoginLogoutPairs(const QUuid &sessionId, SessionEv
 
     return consistent;
 }
+
+bool SessionRepository::findBatchReceipt(const QUuid& userId, const QString& idempotencyKey,
+                                         int& statusCode, QJsonObject& response)
+{
+    if (!ensureInitialized()) {
+        return false;
+    }
+
+    QString query = "SELECT status_code, response FROM batch_idempotency_keys "
+                    "WHERE user_id = :user_id AND idempotency_key = :idempotency_key "
+                    "AND expires_at > CURRENT_TIMESTAMP";
+
+    QSqlQuery sqlQuery = m_dbService->createQuery();
+    sqlQuery.prepare(query);
+    sqlQuery.bindValue(":user_id", userId.toString(QUuid::WithoutBraces));
+    sqlQuery.bindValue(":idempotency_key", idempotencyKey);
+
+    if (!sqlQuery.exec()) {
+        LOG_ERROR(QString("Failed to look up batch receipt: %1").arg(sqlQuery.lastError().text()));
+        return false;
+    }
+
+    if (!sqlQuery.next()) {
+        return false;
+    }
+
+    statusCode = sqlQuery.value("status_code").toInt();
+    response = QJsonDocument::fromJson(sqlQuery.value("response").toString().toUtf8()).object();
+    return true;
+}
+
+bool SessionRepository::saveBatchReceipt(const QUuid& userId, const QString& idempotencyKey, const QUuid& sessionId,
+                                         int statusCode, const QJsonObject& response, const QDateTime& expiresAt)
+{
+    if (!ensureInitialized()) {
+        return false;
+    }
+
+    // The first receipt for a key wins; a concurrent duplicate keeps the original response
+    QString query = "INSERT INTO batch_idempotency_keys "
+                    "(user_id, idempotency_key, session_id, status_code, response, created_at, expires_at) "
+                    "VALUES (:user_id, :idempotency_key, :session_id, :status_code, :response::jsonb, "
+                    "CURRENT_TIMESTAMP, :expires_at) "
+                    "ON CONFLICT (user_id, idempotency_key) DO NOTHING";
+
+    QMap<QString, QVariant> params;
+    params["user_id"] = userId.toString(QUuid::WithoutBraces);
+    params["idempotency_key"] = idempotencyKey;
+    params["session_id"] = sessionId.toString(QUuid::WithoutBraces);
+    params["status_code"] = statusCode;
+    params["response"] = QString::fromUtf8(QJsonDocument(response).toJson(QJsonDocument::Compact));
+    params["expires_at"] = expiresAt.toUTC();
+
+    logQueryWithValues(query, params);
+
+    if (!executeModificationQuery(query, params)) {
+        LOG_WARNING(QString("Failed to save batch receipt for key %1: %2").arg(idempotencyKey, lastError()));
+        return false;
+    }
+
+    return true;
+}
+
+int SessionRepository::purgeExpiredBatchReceipts()
+{
+    if (!ensureInitialized()) {
+        LOG_ERROR("Cannot purge batch receipts: Repository not initialized");
+        return 0;
+    }
+
+    QString query = "DELETE FROM batch_idempotency_keys WHERE expires_at < CURRENT_TIMESTAMP RETURNING idempotency_key";
+
+    logQueryWithValues(query, QMap<QString, QVariant>());
+
+    QSqlQuery sqlQuery = m_dbService->createQuery();
+    sqlQuery.prepare(query);
+
+    int count = 0;
+    if (sqlQuery.exec()) {
+        while (sqlQuery.next()) {
+            count++;
+        }
+        LOG_INFO(QString("Purged %1 expired batch receipts").arg(count));
+    } else {
+        LOG_ERROR(QString("Failed to purge expired batch receipts: %1").arg(sqlQuery.lastError().text()));
+    }
+
+    return count;
+}
+
+QSet<qint64> SessionRepository::findCommittedSequences(const QUuid& sessionId, const QList<qint64>& sequences)
+{
+    QSet<qint64> committed;
+    if (sequences.isEmpty() || !ensureInitialized()) {
+        return committed;
+    }
+
+    QString query = "SELECT client_seq FROM batch_client_sequences "
+                    "WHERE session_id = :session_id AND client_seq = ANY(:sequences::bigint[]) "
+                    "AND expires_at > CURRENT_TIMESTAMP";
+
+    QSqlQuery sqlQuery = m_dbService->createQuery();
+    sqlQuery.prepare(query);
+    sqlQuery.bindValue(":session_id", sessionId.toString(QUuid::WithoutBraces));
+    sqlQuery.bindValue(":sequences", bigintArrayLiteral(sequences));
+
+    if (!sqlQuery.exec()) {
+        LOG_ERROR(QString("Failed to look up committed client_seq values: %1").arg(sqlQuery.lastError().text()));
+        return committed;
+    }
+
+    while (sqlQuery.next()) {
+        committed.insert(sqlQuery.value("client_seq").toLongLong());
+    }
+    return committed;
+}
+
+int SessionRepository::purgeExpiredBatchSequences()
+{
+    if (!ensureInitialized()) {
+        LOG_ERROR("Cannot purge batch sequences: Repository not initialized");
+        return 0;
+    }
+
+    QString query = "DELETE FROM batch_client_sequences WHERE expires_at < CURRENT_TIMESTAMP";
+
+    QSqlQuery sqlQuery = m_dbService->createQuery();
+    sqlQuery.prepare(query);
+
+    if (!sqlQuery.exec()) {
+        LOG_ERROR(QString("Failed to purge expired batch sequences: %1").arg(sqlQuery.lastError().text()));
+        return 0;
+    }
+
+    int count = sqlQuery.numRowsAffected();
+    LOG_INFO(QString("Purged %1 expired batch sequences").arg(count));
+    return count;
+}
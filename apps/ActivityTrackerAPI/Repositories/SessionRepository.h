@@ -8,6 +8,7 @@
 #include <QUuid>
 #include <QDateTime>
 #include <QJsonObject>
+#include <QSet>
 
 #include "SessionEventRepository.h"
 
@@ -42,6 +43,11 @@ public:
     // Session analytics
     QJsonObject getUserSessionStats(const QUuid &userId, const QDateTime &startDate, const QDateTime &endDate);
 
+    // Recompute user_daily_summaries for the given UTC days; returns the rows written or -1
+    int refreshDailySummaries(const QDate &fromDay, const QDate &toDay);
+    // Recompute the older days late batches changed since their last refresh; returns the rows written or -1
+    int refreshDirtyDailySummaries();
+
     // Get session for a user/machine for a specific day
     QSharedPointer<SessionModel> getSessionForDay(const QUuid& userId, const QUuid& machineId, const QDate& date);
 
@@ -69,6 +75,17 @@ public:
     bool createLoginEvent(const QUuid& sessionId, const QUuid& userId, const QUuid& machineId,
         const QDateTime& loginTime, bool isRemote, const QString& terminalSessionId, bool afterLogout);
 
+    // Batch idempotency receipts (batch_idempotency_keys)
+    bool findBatchReceipt(const QUuid& userId, const QString& idempotencyKey, int& statusCode, QJsonObject& response);
+    bool saveBatchReceipt(const QUuid& userId, const QString& idempotencyKey, const QUuid& sessionId,
+                          int statusCode, const QJsonObject& response, const QDateTime& expiresAt);
+    int purgeExpiredBatchReceipts();
+
+    // Committed client_seq values per session (batch_client_sequences); rows are claimed
+    // through BaseRepository::claimClientSequences() in the transaction that writes them
+    QSet<qint64> findCommittedSequences(const QUuid& sessionId, const QList<qint64>& sequences);
+    int purgeExpiredBatchSequences();
+
     void setSessionEventRepository(SessionEventRepository* sessionEventRepository);
     bool hasSessionEventRepository() const { return m_sessionEventRepository != nullptr && m_sessionEventRepository->isInitialized(); }
 
@@ -86,6 +103,9 @@ protected:
     SessionModel* createModelFromQuery(const QSqlQuery &query) override;
 
 private:
+    bool getUserStatsFromDailySummaries(const QUuid &userId, const QDate &startDay, const QDate &endDay, QJsonObject &stats);
+    QJsonObject getUserStatsFromSessions(const QUuid &userId, const QDateTime &startDate, const QDateTime &endDate);
+
     SessionEventRepository* m_sessionEventRepository = nullptr;
 };
 
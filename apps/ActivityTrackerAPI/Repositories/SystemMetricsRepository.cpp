@@ -2,7 +2,139 @@
 #include <QDebug>
 #include <QSqlError>
 #include <QSqlRecord>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
 #include "Core/ModelFactory.h"
+#include "Services/ArchiveStore.h"
+
+namespace {
+
+struct MetricSample {
+    qint64 timeMs;
+    double value;
+};
+
+// Largest-triangle-three-buckets: keeps the first and last sample and, from each
+// bucket in between, the sample that forms the largest triangle with the sample
+// kept before it and the average of the next bucket. Preserves peaks that plain
+// averaging would flatten.
+QVector<MetricSample> downsampleLttb(const QVector<MetricSample> &samples, int threshold)
+{
+    const int count = samples.size();
+    if (threshold < 3 || count <= threshold) {
+        return samples;
+    }
+
+    QVector<MetricSample> sampled;
+    sampled.reserve(threshold);
+    sampled.append(samples.first());
+
+    const double bucketSize = double(count - 2) / (threshold - 2);
+    int kept = 0;
+
+    for (int bucket = 0; bucket < threshold - 2; ++bucket) {
+        // Average of the next bucket (the last sample for the final bucket)
+        int nextStart = int(std::floor((bucket + 1) * bucketSize)) + 1;
+        int nextEnd = qMin(int(std::floor((bucket + 2) * bucketSize)) + 1, count);
+        if (nextStart >= nextEnd) {
+            nextStart = count - 1;
+            nextEnd = count;
+        }
+
+        double avgTime = 0;
+        double avgValue = 0;
+        for (int i = nextStart; i < nextEnd; ++i) {
+            avgTime += samples[i].timeMs;
+            avgValue += samples[i].value;
+        }
+        avgTime /= (nextEnd - nextStart);
+        avgValue /= (nextEnd - nextStart);
+
+        const int start = int(std::floor(bucket * bucketSize)) + 1;
+        const int end = int(std::floor((bucket + 1) * bucketSize)) + 1;
+        const MetricSample &previous = samples[kept];
+
+        double maxArea = -1;
+        int selected = start;
+        for (int i = start; i < end; ++i) {
+            const double area = std::fabs((previous.timeMs - avgTime) * (samples[i].value - previous.value) -
+                                          (previous.timeMs - samples[i].timeMs) * (avgValue - previous.value));
+            if (area > maxArea) {
+                maxArea = area;
+                selected = i;
+            }
+        }
+
+        sampled.append(samples[selected]);
+        kept = selected;
+    }
+
+    sampled.append(samples.last());
+    return sampled;
+}
+
+// Samples of the session in archived partitions, oldest first
+QVector<MetricSample> archivedSamples(const ArchiveStore *store, const QUuid &sessionId, const QString &metricType)
+{
+    QVector<MetricSample> samples;
+    if (!store || !store->hasSession("system_metrics", sessionId)) {
+        return samples;
+    }
+
+    store->visitSession("system_metrics", sessionId, [&samples, &metricType](const ArchiveStore::Row &row) {
+        const QVariant value = row.value(metricType);
+        const QVariant time = row.value("measurement_time");
+        if (!value.isNull() && !time.isNull()) {
+            samples.append(MetricSample{time.toDateTime().toMSecsSinceEpoch(), value.toDouble()});
+        }
+    });
+    return samples;
+}
+
+// The bucketed series query, for archived samples
+QJsonArray bucketSamples(const QVector<MetricSample> &samples, int bucketSeconds)
+{
+    QJsonArray result;
+    const qint64 bucketMs = static_cast<qint64>(bucketSeconds) * 1000;
+
+    int start = 0;
+    while (start < samples.size()) {
+        const qint64 bucketStart = (samples[start].timeMs / bucketMs) * bucketMs;
+        QVector<double> values;
+        int end = start;
+        while (end < samples.size() && samples[end].timeMs < bucketStart + bucketMs) {
+            values.append(samples[end].value);
+            end++;
+        }
+
+        std::sort(values.begin(), values.end());
+        double sum = 0;
+        for (double value : values) {
+            sum += value;
+        }
+
+        // percentile_cont: linear interpolation between the closest ranks
+        const double rank = 0.95 * (values.size() - 1);
+        const int lower = static_cast<int>(std::floor(rank));
+        const int upper = qMin(lower + 1, static_cast<int>(values.size()) - 1);
+        const double p95 = values[lower] + (rank - lower) * (values[upper] - values[lower]);
+
+        QJsonObject dataPoint;
+        dataPoint["time"] = QDateTime::fromMSecsSinceEpoch(bucketStart, Qt::UTC).toString();
+        dataPoint["value"] = sum / values.size();
+        dataPoint["max"] = values.last();
+        dataPoint["p95"] = p95;
+        dataPoint["samples"] = static_cast<int>(values.size());
+        result.append(dataPoint);
+
+        start = end;
+    }
+
+    return result;
+}
+
+} // namespace
 
 SystemMetricsRepository::SystemMetricsRepository(QObject *parent)
     : BaseRepository<SystemMetricsModel>(parent)
@@ -276,7 +408,8 @@ QJsonObject SystemMetricsRepository::getAverageMetrics(const QUuid &sessionId)
             // Create a default metrics model - we're not actually using this for the returned data
             // but it's required by the API
             return ModelFactory::createDefaultSystemMetrics(sessionId);
-        }
+        },
+        ReportRouting
     );
 
     if (metrics) {
@@ -314,26 +447,25 @@ QJsonArray SystemMetricsRepository::getMetricsTimeSeries(const QUuid &sessionId,
 
     QJsonArray result;
 
-    auto metrics = m_dbService->executeSelectQuery(
+    for (const MetricSample &sample : archivedSamples(m_archiveStore, sessionId, metricType)) {
+        QJsonObject dataPoint;
+        dataPoint["time"] = QDateTime::fromMSecsSinceEpoch(sample.timeMs, Qt::UTC).toString();
+        dataPoint["value"] = sample.value;
+        result.append(dataPoint);
+    }
+
+    m_dbService->executeVisitQuery(
         query,
         params,
-        [&result](const QSqlQuery& query) -> SystemMetricsModel* {
-            if (query.isValid()) {
-                QJsonObject dataPoint;
-                dataPoint["time"] = query.value("measurement_time").toDateTime().toUTC().toString();
-                dataPoint["value"] = query.value("value").toDouble();
-                result.append(dataPoint);
-            }
-            // Create a default model to satisfy API requirements - not actually used
-            return ModelFactory::createDefaultSystemMetrics();
-        }
+        [&result](const QSqlQuery& query) {
+            QJsonObject dataPoint;
+            dataPoint["time"] = query.value(0).toDateTime().toUTC().toString();
+            dataPoint["value"] = query.value(1).toDouble();
+            result.append(dataPoint);
+        },
+        ReportRouting
     );
 
-    // Clean up all the dummy models created
-    for (auto model : metrics) {
-        delete model;
-    }
-
     LOG_INFO(QString("Time series data retrieved for session %1, metric %2").arg(sessionId.toString()).arg(metricType));
     return result;
 }
@@ -358,6 +490,22 @@ QJsonArray SystemMetricsRepository::getMetricsTimeSeries(const QUuid &sessionId,
 
     QMap<QString, QVariant> params;
     params["session_id"] = sessionId.toString(QUuid::WithoutBraces);
+
+    // Archived samples are older than anything still in the table, so they come first
+    QJsonArray result;
+    for (const MetricSample &sample : archivedSamples(m_archiveStore, sessionId, metricType)) {
+        if (limit > 0 && result.size() >= limit) {
+            break;
+        }
+        QJsonObject dataPoint;
+        dataPoint["time"] = QDateTime::fromMSecsSinceEpoch(sample.timeMs, Qt::UTC).toString();
+        dataPoint["value"] = sample.value;
+        result.append(dataPoint);
+    }
+
+    if (limit > 0 && result.size() >= limit) {
+        return result;
+    }
     
     QString query = QString(
         "SELECT measurement_time, %1 as value "
@@ -367,31 +515,21 @@ QJsonArray SystemMetricsRepository::getMetricsTimeSeries(const QUuid &sessionId,
     ).arg(metricType);
     
     if (limit > 0) {
-        query += QString(" LIMIT %1").arg(limit);
+        query += QString(" LIMIT %1").arg(limit - result.size());
     }
 
-    QJsonArray result;
-
-    auto metrics = m_dbService->executeSelectQuery(
+    m_dbService->executeVisitQuery(
         query,
         params,
-        [&result](const QSqlQuery& query) -> SystemMetricsModel* {
-            if (query.isValid()) {
-                QJsonObject dataPoint;
-                dataPoint["time"] = query.value("measurement_time").toDateTime().toUTC().toString();
-                dataPoint["value"] = query.value("value").toDouble();
-                result.append(dataPoint);
-            }
-            // Create a default model to satisfy API requirements - not actually used
-            return ModelFactory::createDefaultSystemMetrics();
-        }
+        [&result](const QSqlQuery& query) {
+            QJsonObject dataPoint;
+            dataPoint["time"] = query.value(0).toDateTime().toUTC().toString();
+            dataPoint["value"] = query.value(1).toDouble();
+            result.append(dataPoint);
+        },
+        ReportRouting
     );
 
-    // Clean up all the dummy models created
-    for (auto model : metrics) {
-        delete model;
-    }
-
     LOG_INFO(QString("Time series data retrieved for session %1, metric %2 (limit: %3)")
             .arg(sessionId.toString())
             .arg(metricType)
@@ -399,3 +537,125 @@ QJsonArray SystemMetricsRepository::getMetricsTimeSeries(const QUuid &sessionId,
     return result;
 }
 
+QJsonArray SystemMetricsRepository::getBucketedMetricsTimeSeries(const QUuid &sessionId, const QString &metricType, int bucketSeconds)
+{
+    LOG_DEBUG(QString("Getting bucketed metrics time series for session: %1, metric: %2, bucket: %3s")
+             .arg(sessionId.toString())
+             .arg(metricType)
+             .arg(bucketSeconds));
+
+    if (!isInitialized()) {
+        LOG_ERROR("Cannot get bucketed metrics time series: Repository not initialized");
+        return QJsonArray();
+    }
+
+    // Validate metric type
+    if (metricType != "cpu_usage" && metricType != "gpu_usage" && metricType != "memory_usage") {
+        LOG_WARNING(QString("Invalid metric type: %1").arg(metricType));
+        return QJsonArray();
+    }
+
+    if (bucketSeconds <= 0) {
+        LOG_WARNING(QString("Invalid bucket size: %1").arg(bucketSeconds));
+        return QJsonArray();
+    }
+
+    QMap<QString, QVariant> params;
+    params["session_id"] = sessionId.toString(QUuid::WithoutBraces);
+    params["bucket_seconds"] = bucketSeconds;
+
+    // measurement_time is stored in UTC without a zone, so the epoch arithmetic stays in UTC
+    QString query = QString(
+        "SELECT "
+        "to_timestamp(floor(EXTRACT(EPOCH FROM measurement_time) / :bucket_seconds) * :bucket_seconds) "
+        "AT TIME ZONE 'UTC' as bucket_start, "
+        "AVG(%1) as avg_value, "
+        "MAX(%1) as max_value, "
+        "percentile_cont(0.95) WITHIN GROUP (ORDER BY %1) as p95_value, "
+        "COUNT(*) as samples "
+        "FROM system_metrics "
+        "WHERE session_id = :session_id AND %1 IS NOT NULL "
+        "GROUP BY 1 "
+        "ORDER BY 1 ASC"
+    ).arg(metricType);
+
+    QJsonArray result = bucketSamples(archivedSamples(m_archiveStore, sessionId, metricType), bucketSeconds);
+
+    m_dbService->executeVisitQuery(
+        query,
+        params,
+        [&result](const QSqlQuery& query) {
+            QJsonObject dataPoint;
+            dataPoint["time"] = query.value(0).toDateTime().toUTC().toString();
+            dataPoint["value"] = query.value(1).toDouble();
+            dataPoint["max"] = query.value(2).toDouble();
+            dataPoint["p95"] = query.value(3).toDouble();
+            dataPoint["samples"] = query.value(4).toInt();
+            result.append(dataPoint);
+        },
+        ReportRouting
+    );
+
+    LOG_INFO(QString("Bucketed time series retrieved for session %1, metric %2: %3 buckets")
+            .arg(sessionId.toString())
+            .arg(metricType)
+            .arg(result.size()));
+    return result;
+}
+
+QJsonArray SystemMetricsRepository::getDownsampledMetricsTimeSeries(const QUuid &sessionId, const QString &metricType, int maxPoints)
+{
+    LOG_DEBUG(QString("Getting downsampled metrics time series for session: %1, metric: %2, max points: %3")
+             .arg(sessionId.toString())
+             .arg(metricType)
+             .arg(maxPoints));
+
+    if (!isInitialized()) {
+        LOG_ERROR("Cannot get downsampled metrics time series: Repository not initialized");
+        return QJsonArray();
+    }
+
+    // Validate metric type
+    if (metricType != "cpu_usage" && metricType != "gpu_usage" && metricType != "memory_usage") {
+        LOG_WARNING(QString("Invalid metric type: %1").arg(metricType));
+        return QJsonArray();
+    }
+
+    QMap<QString, QVariant> params;
+    params["session_id"] = sessionId.toString(QUuid::WithoutBraces);
+
+    QString query = QString(
+        "SELECT measurement_time, %1 as value "
+        "FROM system_metrics "
+        "WHERE session_id = :session_id AND %1 IS NOT NULL "
+        "ORDER BY measurement_time ASC"
+    ).arg(metricType);
+
+    QVector<MetricSample> samples = archivedSamples(m_archiveStore, sessionId, metricType);
+
+    m_dbService->executeVisitQuery(
+        query,
+        params,
+        [&samples](const QSqlQuery& query) {
+            samples.append(MetricSample{query.value(0).toDateTime().toMSecsSinceEpoch(), query.value(1).toDouble()});
+        },
+        ReportRouting
+    );
+
+    const QVector<MetricSample> sampled = downsampleLttb(samples, maxPoints);
+
+    QJsonArray result;
+    for (const MetricSample &sample : sampled) {
+        QJsonObject dataPoint;
+        dataPoint["time"] = QDateTime::fromMSecsSinceEpoch(sample.timeMs, Qt::UTC).toString();
+        dataPoint["value"] = sample.value;
+        result.append(dataPoint);
+    }
+
+    LOG_INFO(QString("Downsampled time series for session %1, metric %2 from %3 to %4 points")
+            .arg(sessionId.toString())
+            .arg(metricType)
+            .arg(samples.size())
+            .arg(result.size()));
+    return result;
+}
@@ -6,6 +6,8 @@
 #include <QJsonObject>
 #include <QJsonArray>
 
+class ArchiveStore;
+
 class SystemMetricsRepository : public BaseRepository<SystemMetricsModel>
 {
     Q_OBJECT
@@ -24,8 +26,17 @@ public:
 
     QJsonArray getMetricsTimeSeries(const QUuid &sessionId, const QString &metricType);
     QJsonArray getMetricsTimeSeries(const QUuid &sessionId, const QString &metricType, int limit);
+
+    // One point per bucket with avg ("value"), max, p95 and sample count, aggregated in SQL
+    QJsonArray getBucketedMetricsTimeSeries(const QUuid &sessionId, const QString &metricType, int bucketSeconds);
+
+    // Raw samples reduced to at most maxPoints with largest-triangle-three-buckets
+    QJsonArray getDownsampledMetricsTimeSeries(const QUuid &sessionId, const QString &metricType, int maxPoints);
     QJsonObject getAverageMetrics(const QUuid &sessionId);
 
+    // Time series also include samples of partitions moved to the archive
+    void setArchiveStore(const ArchiveStore *archiveStore) { m_archiveStore = archiveStore; }
+
 protected:
     // Required BaseRepository abstract method implementations
     QString getEntityName() const override;
@@ -41,6 +52,9 @@ protected:
     QMap<QString, QVariant> prepareParamsForUpdate(SystemMetricsModel* model) override;
     SystemMetricsModel* createModelFromQuery(const QSqlQuery &query) override;
     bool validateModel(SystemMetricsModel* model, QStringList& errors) override;
+
+private:
+    const ArchiveStore *m_archiveStore = nullptr;
 };
 
 #endif // SYSTEMMETRICSREPOSITORY_H
@@ -1,15 +1,28 @@
 #include "TokenRepository.h"
+#include <QCryptographicHash>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QJsonDocument>
 #include "logger/logger.h"
 #include "Core/ModelFactory.h"
 #include "dbservice/dbmanager.h"
+#include "dbservice/notificationbus.h"
+#include "UserRoleDisciplineRepository.h"
+
+const QString TokenRepository::InvalidationChannel = QStringLiteral("token_invalidation");
 
 TokenRepository::TokenRepository(QObject *parent)
     : BaseRepository<TokenModel>(parent)
 {
     LOG_DEBUG("TokenRepository instance created");
+
+    // Revocations on any node end cached validations, as do role changes since token data carries roles
+    NotificationBus::instance().subscribe(InvalidationChannel, this, [this](const QString& key) {
+        dropCachedToken(key);
+    });
+    NotificationBus::instance().subscribe(UserRoleDisciplineRepository::InvalidationChannel, this, [this](const QString&) {
+        dropCachedToken(NotificationBus::AllKeys);
+    });
 }
 
 QString TokenRepository::getEntityName() const
@@ -17,6 +30,11 @@ QString TokenRepository::getEntityName() const
     return "AuthToken";
 }
 
+QString TokenRepository::invalidationChannel() const
+{
+    return InvalidationChannel;
+}
+
 QString TokenRepository::getTableName() const
 {
     return "auth_tokens";
@@ -32,6 +50,17 @@ QString TokenRepository::getModelId(TokenModel* model) const
     return model->tokenId();
 }
 
+QString TokenRepository::invalidationKey(const QString& id) const
+{
+    return QString::fromLatin1(QCryptographicHash::hash(id.toUtf8(), QCryptographicHash::Sha256).toHex());
+}
+
+QString TokenRepository::loggableId(const QString& id) const
+{
+    // Same form as LogField::secret, so these lines match the token's other log records
+    return LogField::redact(id);
+}
+
 QString TokenRepository::buildSaveQuery()
 {
     // Use JSONB type for PostgreSQL
@@ -130,7 +159,8 @@ QMap<QString, QVariant> TokenRepository::prepareParamsForSave(TokenModel* token)
     params["last_used_at"] = token->lastUsedAt().toUTC();
 
     // Log the parameter details for debugging
-    LOG_DEBUG(QString("Prepared save parameters for token: %1").arg(token->tokenId()));
+    LOG_FIELDS(Logger::Debug, "Prepared save parameters for token",
+               LogField::secret("token", token->tokenId()));
 
     return params;
 }
@@ -142,16 +172,16 @@ QMap<QString, QVariant> TokenRepository::prepareParamsForUpdate(TokenModel* toke
     params["revocation_reason"] = token->revocationReason();
 
     // Log the update action
-    LOG_DEBUG(QString("Prepared update parameters for token: %1 (revoked: %2)")
-              .arg(token->tokenId())
-              .arg(token->isRevoked() ? "yes" : "no"));
+    LOG_FIELDS(Logger::Debug, "Prepared update parameters for token",
+               LogField::secret("token", token->tokenId()),
+               LogField::value("revoked", token->isRevoked()));
 
     return params;
 }
 
 bool TokenRepository::validateModel(TokenModel* model, QStringList& errors)
 {
-    LOG_DEBUG(QString("Validating token model: %1").arg(model->tokenId()));
+    LOG_FIELDS(Logger::Debug, "Validating token model", LogField::secret("token", model->tokenId()));
 
     // Validate required fields
     if (model->tokenId().isEmpty()) {
@@ -177,7 +207,7 @@ bool TokenRepository::validateModel(TokenModel* model, QStringList& errors)
     if (!errors.isEmpty()) {
         LOG_WARNING(QString("Token validation failed: %1").arg(errors.join(", ")));
     } else {
-        LOG_DEBUG(QString("Token validation successful for: %1").arg(model->tokenId()));
+        LOG_FIELDS(Logger::Debug, "Token validation successful", LogField::secret("token", model->tokenId()));
     }
 
     return errors.isEmpty();
@@ -188,8 +218,9 @@ TokenModel* TokenRepository::createModelFromQuery(const QSqlQuery &query)
     // Use ModelFactory pattern for consistency instead of manual creation
     TokenModel* token = ModelFactory::createTokenFromQuery(query);
 
-    LOG_DEBUG(QString("Created token model from query: %1 (type: %2)")
-              .arg(token->tokenId(), token->tokenType()));
+    LOG_FIELDS(Logger::Debug, "Created token model from query",
+               LogField::secret("token", token->tokenId()),
+               LogField::value("type", token->tokenType()));
 
     return token;
 }
@@ -207,13 +238,16 @@ bool TokenRepository::saveToken(const QString& token, const QString& tokenType,
 
     // Check if token already exists
     bool tokenExists = this->tokenExists(token);
-    LOG_DEBUG(QString("Token exists check: %1 - %2").arg(token).arg(tokenExists ? "yes" : "no"));
+    LOG_FIELDS(Logger::Debug, "Token exists check",
+               LogField::secret("token", token),
+               LogField::value("exists", tokenExists));
 
     if (tokenExists) {
         // Update existing token
         auto existingToken = getById(QUuid(token));
         if (!existingToken) {
-            LOG_ERROR(QString("Token exists but could not be retrieved: %1").arg(token));
+            LOG_FIELDS(Logger::Error, "Token exists but could not be retrieved",
+                       LogField::secret("token", token));
             return false;
         }
 
@@ -235,9 +269,10 @@ bool TokenRepository::saveToken(const QString& token, const QString& tokenType,
         bool success = update(existingToken.data());
 
         if (success) {
-            LOG_INFO(QString("Token updated successfully: %1").arg(token));
+            LOG_FIELDS(Logger::Info, "Token updated successfully", LogField::secret("token", token));
         } else {
-            LOG_ERROR(QString("Failed to update token: %1 - %2").arg(token, lastError()));
+            LOG_FIELDS(Logger::Error, "Failed to update token",
+                       LogField::secret("token", token), LogField::value("error", lastError()));
         }
 
         return success;
@@ -266,9 +301,10 @@ bool TokenRepository::saveToken(const QString& token, const QString& tokenType,
         bool success = save(tokenModel);
 
         if (success) {
-            LOG_INFO(QString("Token saved successfully: %1").arg(token));
+            LOG_FIELDS(Logger::Info, "Token saved successfully", LogField::secret("token", token));
         } else {
-            LOG_ERROR(QString("Failed to save token: %1 - %2").arg(token, lastError()));
+            LOG_FIELDS(Logger::Error, "Failed to save token",
+                       LogField::secret("token", token), LogField::value("error", lastError()));
         }
 
         delete tokenModel;
@@ -278,13 +314,28 @@ bool TokenRepository::saveToken(const QString& token, const QString& tokenType,
 
 bool TokenRepository::validateToken(const QString& token, QJsonObject& tokenData)
 {
-    LOG_DEBUG(QString("Validating token: %1").arg(token));
+    LOG_FIELDS(Logger::Debug, "Validating token", LogField::secret("token", token));
 
     if (!ensureInitialized()) {
         LOG_ERROR("Cannot validate token: Repository not initialized");
         return false;
     }
 
+    // Without the bus a revocation on another node would go unnoticed
+    const bool cacheable = NotificationBus::instance().isListening();
+    const QString cacheKey = cacheable ? invalidationKey(token) : QString();
+    if (cacheable) {
+        auto cached = m_validTokens.find(cacheKey);
+        if (cached != m_validTokens.end()) {
+            const QDateTime now = QDateTime::currentDateTimeUtc();
+            if (cached->expiresAt > now && cached->checkedAt.secsTo(now) < ValidTokenCacheSeconds) {
+                tokenData = cached->tokenData;
+                return true;
+            }
+            m_validTokens.erase(cached);
+        }
+    }
+
     QMap<QString, QVariant> params;
     params["token_id"] = token;
 
@@ -298,13 +349,13 @@ bool TokenRepository::validateToken(const QString& token, QJsonObject& tokenData
     if (result) {
         // Check if token is revoked
         if (result->isRevoked()) {
-            LOG_WARNING(QString("Token is revoked: %1").arg(token));
+            LOG_FIELDS(Logger::Warning, "Token is revoked", LogField::secret("token", token));
             return false;
         }
 
         // Check if token is expired
         if (result->isExpired()) {
-            LOG_WARNING(QString("Token has expired: %1").arg(token));
+            LOG_FIELDS(Logger::Warning, "Token has expired", LogField::secret("token", token));
             return false;
         }
 
@@ -313,17 +364,24 @@ bool TokenRepository::validateToken(const QString& token, QJsonObject& tokenData
 
         // Extract token data
         tokenData = result->tokenData();
-        LOG_DEBUG(QString("Token validated successfully: %1").arg(token));
+
+        if (cacheable) {
+            if (m_validTokens.size() >= MaxCachedTokens) {
+                m_validTokens.clear();
+            }
+            m_validTokens.insert(cacheKey, {tokenData, result->expiresAt(), QDateTime::currentDateTimeUtc()});
+        }
+        LOG_FIELDS(Logger::Debug, "Token validated successfully", LogField::secret("token", token));
         return true;
     }
 
-    LOG_WARNING(QString("Token not found: %1").arg(token));
+    LOG_FIELDS(Logger::Warning, "Token not found", LogField::secret("token", token));
     return false;
 }
 
 bool TokenRepository::revokeToken(const QString& token, const QString& reason)
 {
-    LOG_DEBUG(QString("Revoking token: %1").arg(token));
+    LOG_FIELDS(Logger::Debug, "Revoking token", LogField::secret("token", token));
 
     if (!ensureInitialized()) {
         LOG_ERROR("Cannot revoke token: Repository not initialized");
@@ -332,7 +390,7 @@ bool TokenRepository::revokeToken(const QString& token, const QString& reason)
 
     auto existingToken = getById(QUuid(token));
     if (!existingToken) {
-        LOG_ERROR(QString("Token not found for revocation: %1").arg(token));
+        LOG_FIELDS(Logger::Error, "Token not found for revocation", LogField::secret("token", token));
         return false;
     }
 
@@ -346,11 +404,14 @@ bool TokenRepository::revokeToken(const QString& token, const QString& reason)
     bool success = update(existingToken.data());
 
     if (success) {
-        LOG_INFO(QString("Token revoked successfully: %1 (Reason: %2)")
-                .arg(token)
-                .arg(existingToken->revocationReason()));
+        // Other nodes hear of it through update(); this one must not wait for the round trip
+        dropCachedToken(invalidationKey(token));
+        LOG_FIELDS(Logger::Info, "Token revoked successfully",
+                   LogField::secret("token", token),
+                   LogField::value("reason", existingToken->revocationReason()));
     } else {
-        LOG_ERROR(QString("Failed to revoke token: %1 - %2").arg(token, lastError()));
+        LOG_FIELDS(Logger::Error, "Failed to revoke token",
+                   LogField::secret("token", token), LogField::value("error", lastError()));
     }
 
     return success;
@@ -379,6 +440,9 @@ bool TokenRepository::revokeAllUserTokens(const QUuid& userId, const QString& re
     bool success = executeModificationQuery(query, params);
 
     if (success) {
+        // Cached entries are keyed by token digest, not user, so every node drops them all
+        dropCachedToken(NotificationBus::AllKeys);
+        publishInvalidation(NotificationBus::AllKeys);
         LOG_INFO(QString("All tokens revoked for user: %1 (Reason: %2)")
                 .arg(userId.toString(), params["revocation_reason"].toString()));
     } else {
@@ -389,6 +453,15 @@ bool TokenRepository::revokeAllUserTokens(const QUuid& userId, const QString& re
     return success;
 }
 
+void TokenRepository::dropCachedToken(const QString& key)
+{
+    if (key == NotificationBus::AllKeys) {
+        m_validTokens.clear();
+    } else {
+        m_validTokens.remove(key);
+    }
+}
+
 bool TokenRepository::loadActiveTokens(QMap<QString, QJsonObject>& tokenMap)
 {
     LOG_DEBUG("Loading active tokens from database");
@@ -468,10 +541,10 @@ bool TokenRepository::updateTokenLastUsed(const QString& token)
     bool success = executeModificationQuery(query, params);
 
     if (success) {
-        LOG_DEBUG(QString("Updated last used time for token: %1").arg(token));
+        LOG_FIELDS(Logger::Debug, "Updated last used time for token", LogField::secret("token", token));
     } else {
-        LOG_WARNING(QString("Failed to update last used time for token: %1 - %2")
-                   .arg(token, lastError()));
+        LOG_FIELDS(Logger::Warning, "Failed to update last used time for token",
+                   LogField::secret("token", token), LogField::value("error", lastError()));
     }
 
     return success;
@@ -514,7 +587,9 @@ bool TokenRepository::tokenExists(const QString& token)
         delete *result;
     }
 
-    LOG_DEBUG(QString("Token existence check: %1 - %2").arg(token).arg(exists ? "exists" : "not found"));
+    LOG_FIELDS(Logger::Debug, "Token existence check",
+               LogField::secret("token", token),
+               LogField::value("exists", exists));
     return exists;
 }
 
@@ -551,7 +626,7 @@ QList<QSharedPointer<TokenModel>> TokenRepository::getTokensByUserId(const QUuid
 
 QSharedPointer<TokenModel> TokenRepository::getByTokenId(const QString &tokenId)
 {
-    LOG_DEBUG(QString("Getting token by ID: %1").arg(tokenId));
+    LOG_FIELDS(Logger::Debug, "Getting token by ID", LogField::secret("token", tokenId));
 
     if (!isInitialized()) {
         LOG_ERROR("Cannot get token: Repository not initialized");
@@ -572,10 +647,10 @@ QSharedPointer<TokenModel> TokenRepository::getByTokenId(const QString &tokenId)
     );
 
     if (result) {
-        LOG_INFO(QString("Token found: %1").arg(tokenId));
+        LOG_FIELDS(Logger::Info, "Token found", LogField::secret("token", tokenId));
         return QSharedPointer<TokenModel>(*result);
     } else {
-        LOG_WARNING(QString("Token not found: %1").arg(tokenId));
+        LOG_FIELDS(Logger::Warning, "Token not found", LogField::secret("token", tokenId));
         return nullptr;
     }
 }
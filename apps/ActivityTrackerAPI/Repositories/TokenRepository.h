@@ -7,6 +7,7 @@
 #include "logger/logger.h"
 #include <QJsonObject>
 #include <QDateTime>
+#include <QHash>
 
 /**
  * @brief Repository for managing auth tokens in the database
@@ -22,6 +23,9 @@ class TokenRepository : public BaseRepository<TokenModel>
 public:
     explicit TokenRepository(QObject *parent = nullptr);
 
+    // Payloads are token IDs
+    static const QString InvalidationChannel;
+
     /**
      * @brief Save a new token or update an existing one
      * @param token Token string
@@ -41,6 +45,10 @@ public:
 
     /**
      * @brief Validate a token and retrieve its data
+     *
+     * While the notification bus is listening, a validated token is trusted for
+     * up to a minute without a lookup, so last_used_at moves at that granularity.
+     *
      * @param token Token string to validate
      * @param tokenData Output parameter for token data
      * @return True if token is valid
@@ -96,6 +104,7 @@ public:
 protected:
     // Required BaseRepository abstract method implementations
     QString getEntityName() const override;
+    QString invalidationChannel() const override;
     QString getModelId(TokenModel* model) const override;
     QString buildSaveQuery() override;
     QString buildUpdateQuery() override;
@@ -110,6 +119,9 @@ protected:
     // Additional getters that override BaseRepository defaults
     QString getTableName() const override;
     QString getIdParamName() const override;
+    // Token IDs are the bearer tokens themselves, so only their SHA-256 leaves the process or reaches the log
+    QString invalidationKey(const QString& id) const override;
+    QString loggableId(const QString& id) const override;
 
     // Additional query helpers
     QString buildGetByTokenQuery();
@@ -117,6 +129,25 @@ protected:
     QString buildRevokeTokenQuery();
     QString buildRevokeAllUserTokensQuery();
     QString buildUpdateLastUsedQuery();
+
+private:
+    struct CachedToken {
+        QJsonObject tokenData;
+        QDateTime expiresAt;
+        QDateTime checkedAt;
+    };
+
+    /**
+     * @brief Forget a validated token
+     * @param key invalidationKey() of the token, or NotificationBus::AllKeys
+     */
+    void dropCachedToken(const QString& key);
+
+    static constexpr int ValidTokenCacheSeconds = 60;
+    static constexpr int MaxCachedTokens = 10000;
+
+    // Keyed by invalidationKey(), the form revocations arrive in from other nodes
+    QHash<QString, CachedToken> m_validTokens;
 };
 
 #endif // TOKENREPOSITORY_H
\ No newline at end of file
@@ -27,11 +27,18 @@ void UserRoleDisciplineRepository::setDisciplineRepository(DisciplineRepository*
     m_disciplineRepository = disciplineRepository;
 }
 
+const QString UserRoleDisciplineRepository::InvalidationChannel = QStringLiteral("user_role_discipline_invalidation");
+
 QString UserRoleDisciplineRepository::getEntityName() const
 {
     return "UserRoleDiscipline";
 }
 
+QString UserRoleDisciplineRepository::invalidationChannel() const
+{
+    return InvalidationChannel;
+}
+
 QString UserRoleDisciplineRepository::getTableName() const
 {
     return "user_role_disciplines";
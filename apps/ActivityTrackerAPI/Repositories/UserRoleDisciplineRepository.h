@@ -18,6 +18,9 @@ class UserRoleDisciplineRepository : public BaseRepository<UserRoleDisciplineMod
 public:
     explicit UserRoleDisciplineRepository(QObject *parent = nullptr);
 
+    // Payloads are assignment IDs, so subscribers holding per-user permissions drop them all
+    static const QString InvalidationChannel;
+
     void setUserRepository(UserRepository* userRepository);
     void setRoleRepository(RoleRepository* roleRepository);
     void setDisciplineRepository(DisciplineRepository* disciplineRepository);
@@ -48,6 +51,7 @@ public:
 protected:
     // Required BaseRepository abstract method implementations
     QString getEntityName() const override;
+    QString invalidationChannel() const override;
     QString getTableName() const override;
     QString getModelId(UserRoleDisciplineModel* model) const override;
     QString buildSaveQuery() override;
@@ -2,6 +2,8 @@
 #include <QDebug>
 #include <QUuid>
 #include "dbservice/dbmanager.h"
+#include "dbservice/notificationbus.h"
+#include "dbservice/replicamonitor.h"
 #include "Controllers/AuthController.h"
 #include "Controllers/MachineController.h"
 #include "Controllers/SessionController.h"
@@ -13,6 +15,12 @@
 #include "Controllers/BatchController.h"
 #include "Controllers/ServerStatusController.h"
 #include "Services/ADVerificationService.h"
+#include "Services/BatchSpool.h"
+#include "Services/BatchDedupeIndex.h"
+#include "Services/BatchWorkerPool.h"
+#include "Services/DailySummaryRefresher.h"
+#include "Services/PartitionMaintenanceScheduler.h"
+#include "Services/ArchiveStore.h"
 #include "Repositories/UserRepository.h"
 #include "Repositories/TokenRepository.h"
 #include "Repositories/MachineRepository.h"
@@ -33,6 +41,7 @@ ApiServer::ApiServer(QObject *parent)
 m_port(0),
 m_hostAddress(QHostAddress::Any),
 m_initialized(false),
+m_spoolWriterThreads(2),
 m_userRepository(nullptr),
 m_machineRepository(nullptr),
 m_sessionRepository(nullptr),
@@ -53,6 +62,23 @@ ApiServer::~ApiServer()
     // Stop the server if it's running
     stop();
 
+    NotificationBus::instance().stop();
+    ReplicaMonitor::instance().stop();
+
+    // Undrained batches stay in the spool for the next start
+    if (m_batchSpool) {
+        m_batchSpool->close();
+    }
+    if (m_batchWorkerPool) {
+        m_batchWorkerPool->stop();
+    }
+    if (m_dailySummaryRefresher) {
+        m_dailySummaryRefresher->stop();
+    }
+    if (m_partitionMaintenance) {
+        m_partitionMaintenance->stop();
+    }
+
     // Clean up repositories
     cleanupRepositories();
 }
@@ -78,15 +104,21 @@ bool ApiServer::initialize(const DbConfig& dbConfig)
              .arg(dbConfig.port())
              .arg(dbConfig.database()));
 
+    // Carries cache invalidations between API nodes; caches stay off until it listens
+    NotificationBus::instance().start(dbConfig);
+
     // Set up controllers
     try {
         setupControllers();
 
         // Schedule periodic token cleanup
         QTimer *tokenCleanupTimer = new QTimer(this);
-        connect(tokenCleanupTimer, &QTimer::timeout, []() {
+        connect(tokenCleanupTimer, &QTimer::timeout, [this]() {
             LOG_INFO("Running scheduled token cleanup");
             AuthFramework::instance().purgeExpiredTokens();
+            if (m_batchDedupeIndex) {
+                m_batchDedupeIndex->purgeExpired();
+            }
         });
         tokenCleanupTimer->start(30 * 60 * 1000); // Run every 30 minutes
 
@@ -104,6 +136,12 @@ bool ApiServer::initialize(const DbConfig& dbConfig)
     }
 }
 
+void ApiServer::enableBatchSpool(const QString& directory, int writerThreads)
+{
+    m_spoolDirectory = directory;
+    m_spoolWriterThreads = writerThreads;
+}
+
 bool ApiServer::start(quint16 port, const QHostAddress& address)
 {
     LOG_INFO(QString("Starting ApiServer on %1:%2").arg(address.toString()).arg(port));
@@ -318,6 +356,73 @@ void ApiServer::setupControllers()
             this);
         m_batchController->setAuthController(m_authController.get());
 
+        m_batchDedupeIndex = std::make_shared<BatchDedupeIndex>(m_sessionRepository);
+        m_batchController->setDedupeIndex(m_batchDedupeIndex.get());
+
+        if (m_batchWorkerThreads > 0) {
+            m_batchWorkerPool = std::make_shared<BatchWorkerPool>(m_batchWorkerThreads);
+            if (m_batchWorkerPool->start(DbManager::instance().config())) {
+                m_batchController->setWorkerPool(m_batchWorkerPool.get());
+            } else {
+                m_batchWorkerPool.reset();
+            }
+        }
+
+        // Keeps the summaries behind /api/users/<id>/stats current
+        if (m_maintenanceEnabled) {
+            m_dailySummaryRefresher = std::make_shared<DailySummaryRefresher>();
+            m_dailySummaryRefresher->start(DbManager::instance().config());
+        }
+
+        if (!m_archiveDirectory.isEmpty()) {
+            m_archiveStore = std::make_shared<ArchiveStore>(m_archiveDirectory);
+            m_archiveStore->setShared(m_archiveShared);
+            if (m_archiveStore->load()) {
+                m_activityEventRepository->setArchiveStore(m_archiveStore.get());
+                m_systemMetricsRepository->setArchiveStore(m_archiveStore.get());
+                LOG_INFO(QString("Detached partitions are archived to %1").arg(m_archiveDirectory));
+
+                // Another worker or node may do the exporting, so pick up the months it adds
+                if (!m_maintenanceEnabled || m_archiveShared) {
+                    QTimer* archiveReloadTimer = new QTimer(this);
+                    connect(archiveReloadTimer, &QTimer::timeout, this, [this]() {
+                        m_archiveStore->load();
+                    });
+                    archiveReloadTimer->start(5 * 60 * 1000);
+                }
+            } else {
+                LOG_ERROR(QString("Failed to load the archive at %1, detached partitions stay in the database")
+                         .arg(m_archiveDirectory));
+                m_archiveStore.reset();
+            }
+        }
+
+        // Creates the coming months' partitions before inserts need them
+        if (m_maintenanceEnabled && m_partitionMaintenanceHours > 0) {
+            m_partitionMaintenance = std::make_shared<PartitionMaintenanceScheduler>(m_partitionMaintenanceHours,
+                                                                                     m_partitionMonthsToKeep);
+            m_partitionMaintenance->setArchiveStore(m_archiveStore.get());
+            m_partitionMaintenance->setRetentionDays(m_retentionDays);
+            m_partitionMaintenance->start(DbManager::instance().config());
+        }
+
+        if (!m_spoolDirectory.isEmpty()) {
+            BatchSpool::Options spoolOptions;
+            spoolOptions.directory = m_spoolDirectory;
+            spoolOptions.writerThreads = m_spoolWriterThreads;
+            spoolOptions.sequenceTtlHours = BatchDedupeIndex::Options().sequenceTtlHours;
+
+            m_batchSpool = std::make_shared<BatchSpool>(spoolOptions);
+            if (m_batchSpool->open(DbManager::instance().config())) {
+                m_batchController->setBatchSpool(m_batchSpool.get());
+                LOG_INFO(QString("Batch uploads are spooled to %1").arg(m_spoolDirectory));
+            } else {
+                LOG_ERROR(QString("Failed to open batch spool at %1, batches will be written synchronously")
+                         .arg(m_spoolDirectory));
+                m_batchSpool.reset();
+            }
+        }
+
         m_serverStatusController = std::make_shared<ServerStatusController>(this);
 
         LOG_DEBUG("Registering controllers with server");
@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QString>
+#include <QHash>
 #include <QSqlError>
 #include <QHostAddress>
 #include <memory>
@@ -25,6 +26,12 @@ class ServerStatusController;
 
 // Forward declarations for services
 class ADVerificationService;
+class BatchSpool;
+class BatchDedupeIndex;
+class BatchWorkerPool;
+class DailySummaryRefresher;
+class PartitionMaintenanceScheduler;
+class ArchiveStore;
 
 // Forward declarations for repositories
 class UserRepository;
@@ -49,6 +56,31 @@ public:
     // Initialization
     bool initialize(const DbConfig& dbConfig);
 
+    // Acknowledge /api/batch uploads from a local spool; call before initialize()
+    void enableBatchSpool(const QString& directory, int writerThreads = 2);
+
+    // Threads writing synchronous batch arrays in parallel, 0 to write them inline; call before initialize()
+    void setBatchWorkerThreads(int workerThreads) { m_batchWorkerThreads = workerThreads; }
+
+    // Hours between partition maintenance runs, 0 to leave it to an external job; call before initialize()
+    void setPartitionMaintenanceHours(int hours) { m_partitionMaintenanceHours = hours; }
+
+    // Months of partitions kept attached, 0 to never detach them; call before initialize()
+    void setPartitionMonthsToKeep(int months) { m_partitionMonthsToKeep = months; }
+
+    // Export detached partitions to this directory and serve archived months from it; they are
+    // dropped from the database only if the directory is shared by every node; call before initialize()
+    void enableArchive(const QString& directory, bool shared) { m_archiveDirectory = directory; m_archiveShared = shared; }
+
+    // Days of raw rows kept per table before they are compacted; call before initialize()
+    void setRetentionDays(const QHash<QString, int>& retentionDays) { m_retentionDays = retentionDays; }
+
+    // Summary refresh and partition maintenance; only one process of a --workers group runs them; call before initialize()
+    void setMaintenanceEnabled(bool enabled) { m_maintenanceEnabled = enabled; }
+
+    // Share the port with other worker processes through SO_REUSEPORT; call before start()
+    void setReusePort(bool enabled) { m_server.setReusePort(enabled); }
+
     // Server management
     bool start(quint16 port = 8080, const QHostAddress& address = QHostAddress::Any);
     bool stop();
@@ -70,6 +102,21 @@ private:
 
     // Services
     std::shared_ptr<ADVerificationService> m_adVerificationService;
+    std::shared_ptr<BatchSpool> m_batchSpool;
+    std::shared_ptr<BatchDedupeIndex> m_batchDedupeIndex;
+    std::shared_ptr<BatchWorkerPool> m_batchWorkerPool;
+    std::shared_ptr<DailySummaryRefresher> m_dailySummaryRefresher;
+    std::shared_ptr<PartitionMaintenanceScheduler> m_partitionMaintenance;
+    int m_partitionMaintenanceHours = 6;
+    int m_partitionMonthsToKeep = 0;
+    bool m_maintenanceEnabled = true;
+    std::shared_ptr<ArchiveStore> m_archiveStore;
+    QString m_archiveDirectory;
+    bool m_archiveShared = false;
+    QHash<QString, int> m_retentionDays;
+    int m_batchWorkerThreads = 4;
+    QString m_spoolDirectory;
+    int m_spoolWriterThreads;
 
     // Controllers
     std::shared_ptr<AuthController> m_authController;
@@ -0,0 +1,83 @@
+#include "ShutdownSignal.h"
+#include <QSocketNotifier>
+#include "logger/logger.h"
+
+#ifdef Q_OS_UNIX
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+int ShutdownSignal::s_fds[2] = {-1, -1};
+
+ShutdownSignal::ShutdownSignal(QObject* parent)
+    : QObject(parent)
+{
+}
+
+ShutdownSignal::~ShutdownSignal()
+{
+#ifdef Q_OS_UNIX
+    if (m_notifier) {
+        ::signal(SIGTERM, SIG_DFL);
+        ::signal(SIGINT, SIG_DFL);
+        ::close(s_fds[0]);
+        ::close(s_fds[1]);
+        s_fds[0] = s_fds[1] = -1;
+    }
+#endif
+}
+
+bool ShutdownSignal::install()
+{
+#ifdef Q_OS_UNIX
+    if (m_notifier) {
+        return true;
+    }
+    if (s_fds[0] >= 0) {
+        LOG_WARNING("A shutdown signal handler is already installed");
+        return false;
+    }
+
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, s_fds) != 0) {
+        LOG_ERROR("Cannot create the socket pair for shutdown signals");
+        s_fds[0] = s_fds[1] = -1;
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(s_fds[1], QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &ShutdownSignal::onReadable);
+
+    struct sigaction action = {};
+    action.sa_handler = &ShutdownSignal::handleSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    ::sigaction(SIGTERM, &action, nullptr);
+    ::sigaction(SIGINT, &action, nullptr);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ShutdownSignal::handleSignal(int signalNumber)
+{
+#ifdef Q_OS_UNIX
+    // Only async-signal-safe calls here
+    const char byte = static_cast<char>(signalNumber);
+    ssize_t written = ::write(s_fds[0], &byte, sizeof(byte));
+    Q_UNUSED(written);
+#else
+    Q_UNUSED(signalNumber);
+#endif
+}
+
+void ShutdownSignal::onReadable()
+{
+#ifdef Q_OS_UNIX
+    char byte = 0;
+    if (::read(s_fds[1], &byte, sizeof(byte)) == sizeof(byte)) {
+        emit received(byte);
+    }
+#endif
+}
@@ -0,0 +1,38 @@
+#ifndef SHUTDOWNSIGNAL_H
+#define SHUTDOWNSIGNAL_H
+
+#include <QObject>
+
+class QSocketNotifier;
+
+/**
+ * @brief Delivers SIGTERM and SIGINT as a Qt signal on the main thread
+ *
+ * The handler only writes the signal number to a socket pair, and the event
+ * loop reads it back, so receivers may stop servers and log as usual. Only
+ * one instance can be installed per process.
+ */
+class ShutdownSignal : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ShutdownSignal(QObject* parent = nullptr);
+    ~ShutdownSignal();
+
+    // False where POSIX signals are unavailable; the default handlers stay in place
+    bool install();
+
+signals:
+    void received(int signalNumber);
+
+private slots:
+    void onReadable();
+
+private:
+    static void handleSignal(int signalNumber);
+
+    static int s_fds[2];
+    QSocketNotifier* m_notifier = nullptr;
+};
+
+#endif // SHUTDOWNSIGNAL_H
@@ -0,0 +1,157 @@
+#include "WorkerSupervisor.h"
+#include <QCoreApplication>
+#include <QTimer>
+#include "logger/logger.h"
+
+#ifdef Q_OS_UNIX
+#include <csignal>
+#include <unistd.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/prctl.h>
+#endif
+
+WorkerSupervisor::WorkerSupervisor(int workerCount, const QStringList& arguments, int drainSeconds, QObject* parent)
+    : QObject(parent),
+      m_arguments(arguments),
+      m_drainSeconds(drainSeconds)
+{
+    m_workers.resize(qMax(1, workerCount));
+}
+
+WorkerSupervisor::~WorkerSupervisor()
+{
+    for (Worker& worker : m_workers) {
+        if (worker.process && worker.process->state() != QProcess::NotRunning) {
+            worker.process->kill();
+            worker.process->waitForFinished(1000);
+        }
+    }
+}
+
+bool WorkerSupervisor::start()
+{
+    for (int i = 0; i < m_workers.size(); ++i) {
+        startWorker(i);
+    }
+
+    // A worker that cannot even launch is not going to launch on retry either
+    for (const Worker& worker : m_workers) {
+        if (!worker.process->waitForStarted()) {
+            LOG_ERROR(QString("Failed to launch worker: %1").arg(worker.process->errorString()));
+            shutdown();
+            return false;
+        }
+    }
+
+    LOG_INFO(QString("Supervising %1 worker processes").arg(m_workers.size()));
+    return true;
+}
+
+void WorkerSupervisor::startWorker(int index)
+{
+    if (m_stopping) {
+        return;
+    }
+
+    Worker& worker = m_workers[index];
+    if (!worker.process) {
+        worker.process = new QProcess(this);
+        worker.process->setProgram(QCoreApplication::applicationFilePath());
+        worker.process->setArguments(QStringList(m_arguments) << "--worker-index" << QString::number(index));
+        worker.process->setProcessChannelMode(QProcess::ForwardedChannels);
+#ifdef Q_OS_UNIX
+        worker.process->setChildProcessModifier([]() {
+            // Ctrl+C reaches only the supervisor, which forwards one SIGTERM, so workers still drain
+            ::setpgid(0, 0);
+#ifdef Q_OS_LINUX
+            // Workers must not outlive a supervisor that was killed outright
+            ::prctl(PR_SET_PDEATHSIG, SIGTERM);
+#endif
+        });
+#endif
+        connect(worker.process, &QProcess::finished, this, [this, index](int exitCode, QProcess::ExitStatus exitStatus) {
+            onWorkerFinished(index, exitCode, exitStatus);
+        });
+        // A failed launch emits no finished(), but still needs its retry
+        connect(worker.process, &QProcess::errorOccurred, this, [this, index](QProcess::ProcessError error) {
+            if (error == QProcess::FailedToStart) {
+                onWorkerFinished(index, -1, QProcess::CrashExit);
+            }
+        });
+    }
+
+    worker.uptime.start();
+    worker.process->start();
+    LOG_INFO(QString("Started worker %1").arg(index));
+}
+
+void WorkerSupervisor::onWorkerFinished(int index, int exitCode, QProcess::ExitStatus exitStatus)
+{
+    Worker& worker = m_workers[index];
+
+    if (m_stopping) {
+        LOG_INFO(QString("Worker %1 exited with code %2").arg(index).arg(exitCode));
+        if (!anyRunning()) {
+            emit finished();
+        }
+        return;
+    }
+
+    if (worker.uptime.elapsed() >= StableUptimeMs) {
+        worker.restartDelayMs = MinRestartDelayMs;
+    } else {
+        worker.restartDelayMs = qBound(MinRestartDelayMs, worker.restartDelayMs * 2, MaxRestartDelayMs);
+    }
+
+    LOG_ERROR(QString("Worker %1 %2 with code %3, restarting in %4 ms")
+             .arg(index)
+             .arg(exitStatus == QProcess::CrashExit ? "crashed" : "exited")
+             .arg(exitCode)
+             .arg(worker.restartDelayMs));
+
+    QTimer::singleShot(worker.restartDelayMs, this, [this, index]() {
+        startWorker(index);
+    });
+}
+
+void WorkerSupervisor::shutdown()
+{
+    if (m_stopping) {
+        return;
+    }
+    m_stopping = true;
+
+    LOG_INFO(QString("Draining %1 workers for up to %2 seconds").arg(m_workers.size()).arg(m_drainSeconds));
+
+    for (Worker& worker : m_workers) {
+        if (worker.process && worker.process->state() != QProcess::NotRunning) {
+            worker.process->terminate();
+        }
+    }
+
+    if (!anyRunning()) {
+        QTimer::singleShot(0, this, &WorkerSupervisor::finished);
+        return;
+    }
+
+    // Workers quit on their own once drained; allow a little extra for their shutdown
+    QTimer::singleShot((m_drainSeconds + 5) * 1000, this, [this]() {
+        for (Worker& worker : m_workers) {
+            if (worker.process && worker.process->state() != QProcess::NotRunning) {
+                LOG_WARNING("Worker did not exit after draining, killing it");
+                worker.process->kill();
+            }
+        }
+    });
+}
+
+bool WorkerSupervisor::anyRunning() const
+{
+    for (const Worker& worker : m_workers) {
+        if (worker.process && worker.process->state() != QProcess::NotRunning) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,57 @@
+#ifndef WORKERSUPERVISOR_H
+#define WORKERSUPERVISOR_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+
+/**
+ * @brief Runs the API as several processes that share one port
+ *
+ * Each worker is this executable started again with the same arguments plus
+ * --worker-index. Workers bind the port with SO_REUSEPORT, so the kernel
+ * spreads connections across them. A worker that exits is restarted with
+ * backoff. shutdown() tells every worker to drain and kills those that
+ * outlast the drain period.
+ */
+class WorkerSupervisor : public QObject
+{
+    Q_OBJECT
+public:
+    WorkerSupervisor(int workerCount, const QStringList& arguments, int drainSeconds, QObject* parent = nullptr);
+    ~WorkerSupervisor();
+
+    bool start();
+
+public slots:
+    void shutdown();
+
+signals:
+    // Every worker has exited after shutdown()
+    void finished();
+
+private:
+    struct Worker {
+        QProcess* process = nullptr;
+        QElapsedTimer uptime;
+        int restartDelayMs = 0;
+    };
+
+    void startWorker(int index);
+    void onWorkerFinished(int index, int exitCode, QProcess::ExitStatus exitStatus);
+    bool anyRunning() const;
+
+    static constexpr int MinRestartDelayMs = 1000;
+    static constexpr int MaxRestartDelayMs = 30000;
+    // A worker that stayed up this long is not crash-looping, so its backoff resets
+    static constexpr int StableUptimeMs = 60000;
+
+    QStringList m_arguments;
+    int m_drainSeconds;
+    QList<Worker> m_workers;
+    bool m_stopping = false;
+};
+
+#endif // WORKERSUPERVISOR_H
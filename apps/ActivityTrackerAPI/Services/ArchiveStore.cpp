@@ -0,0 +1,348 @@
+#include "ArchiveStore.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QReadLocker>
+#include <QSaveFile>
+#include <QWriteLocker>
+#include <algorithm>
+#include "logger/logger.h"
+
+namespace {
+
+const char* const ManifestName = "manifest.json";
+
+// Decode one compressed column of a row group into a value per row
+QVector<QVariant> decodeColumn(const QByteArray& blob, ArchiveStore::ColumnKind kind, quint32 rowCount)
+{
+    QVector<QVariant> values(rowCount);
+    const QByteArray raw = qUncompress(blob);
+    QDataStream in(raw);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    QByteArray nulls;
+    in >> nulls;
+
+    QStringList dictionary;
+    if (kind == ArchiveStore::ColumnKind::Dictionary) {
+        in >> dictionary;
+    }
+
+    qint64 previousMs = 0;
+    for (quint32 i = 0; i < rowCount; ++i) {
+        const bool isNull = i < static_cast<quint32>(nulls.size()) && nulls.at(i);
+        switch (kind) {
+        case ArchiveStore::ColumnKind::Time: {
+            qint64 delta = 0;
+            in >> delta;
+            previousMs += delta;
+            if (!isNull) {
+                values[i] = QDateTime::fromMSecsSinceEpoch(previousMs, Qt::UTC);
+            }
+            break;
+        }
+        case ArchiveStore::ColumnKind::Integer: {
+            qint64 value = 0;
+            in >> value;
+            if (!isNull) {
+                values[i] = value;
+            }
+            break;
+        }
+        case ArchiveStore::ColumnKind::Double: {
+            double value = 0;
+            in >> value;
+            if (!isNull) {
+                values[i] = value;
+            }
+            break;
+        }
+        case ArchiveStore::ColumnKind::Boolean: {
+            quint8 value = 0;
+            in >> value;
+            if (!isNull) {
+                values[i] = value != 0;
+            }
+            break;
+        }
+        case ArchiveStore::ColumnKind::Dictionary: {
+            quint32 index = 0;
+            in >> index;
+            if (!isNull && index < static_cast<quint32>(dictionary.size())) {
+                values[i] = dictionary.at(index);
+            }
+            break;
+        }
+        case ArchiveStore::ColumnKind::Text: {
+            QString value;
+            in >> value;
+            if (!isNull) {
+                values[i] = value;
+            }
+            break;
+        }
+        }
+    }
+
+    return values;
+}
+
+} // namespace
+
+ArchiveStore::ArchiveStore(const QString& directory)
+    : m_directory(directory)
+{
+}
+
+QString ArchiveStore::timeColumn(const QString& table)
+{
+    if (table == "system_metrics") {
+        return "measurement_time";
+    }
+    if (table == "app_usage") {
+        return "start_time";
+    }
+    return "event_time";
+}
+
+bool ArchiveStore::load()
+{
+    QWriteLocker locker(&m_lock);
+    m_partitions.clear();
+
+    QFile file(QDir(m_directory).filePath(ManifestName));
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        LOG_ERROR(QString("Cannot read archive manifest %1: %2").arg(file.fileName(), file.errorString()));
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        LOG_ERROR(QString("Invalid archive manifest %1: %2").arg(file.fileName(), parseError.errorString()));
+        return false;
+    }
+
+    for (const QJsonValue& value : doc.object()["partitions"].toArray()) {
+        const QJsonObject entry = value.toObject();
+        Partition partition;
+        partition.table = entry["table"].toString();
+        partition.partition = entry["partition"].toString();
+        partition.month = QDate::fromString(entry["month"].toString(), Qt::ISODate);
+        partition.file = entry["file"].toString();
+        partition.rows = entry["rows"].toInteger();
+        partition.bytes = entry["bytes"].toInteger();
+        partition.minTime = QDateTime::fromString(entry["min_time"].toString(), Qt::ISODateWithMs);
+        partition.maxTime = QDateTime::fromString(entry["max_time"].toString(), Qt::ISODateWithMs);
+        partition.archivedAt = QDateTime::fromString(entry["archived_at"].toString(), Qt::ISODate);
+        for (const QJsonValue& session : entry["sessions"].toArray()) {
+            partition.sessions.insert(session.toString());
+        }
+        m_partitions.append(partition);
+    }
+
+    LOG_INFO(QString("Loaded %1 archived partitions from %2").arg(m_partitions.size()).arg(m_directory));
+    return true;
+}
+
+bool ArchiveStore::addPartition(const Partition& partition)
+{
+    QWriteLocker locker(&m_lock);
+    for (int i = 0; i < m_partitions.size(); ++i) {
+        if (m_partitions[i].partition == partition.partition) {
+            m_partitions.removeAt(i);
+            break;
+        }
+    }
+    m_partitions.append(partition);
+    return saveManifest();
+}
+
+bool ArchiveStore::saveManifest() const
+{
+    QJsonArray partitions;
+    for (const Partition& partition : m_partitions) {
+        QJsonArray sessions;
+        for (const QString& session : partition.sessions) {
+            sessions.append(session);
+        }
+
+        QJsonObject entry;
+        entry["table"] = partition.table;
+        entry["partition"] = partition.partition;
+        entry["month"] = partition.month.toString(Qt::ISODate);
+        entry["file"] = partition.file;
+        entry["rows"] = partition.rows;
+        entry["bytes"] = partition.bytes;
+        entry["min_time"] = partition.minTime.toUTC().toString(Qt::ISODateWithMs);
+        entry["max_time"] = partition.maxTime.toUTC().toString(Qt::ISODateWithMs);
+        entry["archived_at"] = partition.archivedAt.toUTC().toString(Qt::ISODate);
+        entry["sessions"] = sessions;
+        partitions.append(entry);
+    }
+
+    QJsonObject manifest;
+    manifest["version"] = FileVersion;
+    manifest["partitions"] = partitions;
+
+    // QSaveFile replaces the manifest only once the new one is fully written
+    QSaveFile file(QDir(m_directory).filePath(ManifestName));
+    if (!file.open(QIODevice::WriteOnly)) {
+        LOG_ERROR(QString("Cannot write archive manifest %1: %2").arg(file.fileName(), file.errorString()));
+        return false;
+    }
+    file.write(QJsonDocument(manifest).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        LOG_ERROR(QString("Cannot write archive manifest %1: %2").arg(file.fileName(), file.errorString()));
+        return false;
+    }
+    return true;
+}
+
+bool ArchiveStore::isArchived(const QString& partition) const
+{
+    QReadLocker locker(&m_lock);
+    for (const Partition& entry : m_partitions) {
+        if (entry.partition == partition) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ArchiveStore::hasSession(const QString& table, const QUuid& sessionId) const
+{
+    const QString key = sessionId.toString(QUuid::WithoutBraces);
+    QReadLocker locker(&m_lock);
+    for (const Partition& entry : m_partitions) {
+        if (entry.table == table && entry.sessions.contains(key)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int ArchiveStore::visitSession(const QString& table, const QUuid& sessionId, const RowVisitor& visitor) const
+{
+    const QString key = sessionId.toString(QUuid::WithoutBraces);
+
+    QList<Partition> partitions;
+    {
+        QReadLocker locker(&m_lock);
+        for (const Partition& entry : m_partitions) {
+            if (entry.table == table && entry.sessions.contains(key)) {
+                partitions.append(entry);
+            }
+        }
+    }
+
+    std::sort(partitions.begin(), partitions.end(), [](const Partition& a, const Partition& b) {
+        return a.month < b.month;
+    });
+
+    int total = 0;
+    for (const Partition& entry : partitions) {
+        int rows = visitFile(QDir(m_directory).filePath(entry.file), key, visitor);
+        if (rows < 0) {
+            return -1;
+        }
+        total += rows;
+    }
+    return total;
+}
+
+int ArchiveStore::visitFile(const QString& path, const RowVisitor& visitor) const
+{
+    return visitFile(path, QString(), visitor);
+}
+
+int ArchiveStore::visitFile(const QString& path, const QString& sessionId, const RowVisitor& visitor) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        LOG_ERROR(QString("Cannot open archive file %1: %2").arg(path, file.errorString()));
+        return -1;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    QString table;
+    QString partition;
+    quint32 columnCount = 0;
+    in >> magic >> version >> table >> partition >> columnCount;
+    if (magic != FileMagic || version != FileVersion) {
+        LOG_ERROR(QString("%1 is not a version %2 archive file").arg(path).arg(FileVersion));
+        return -1;
+    }
+
+    QList<Column> columns;
+    int sessionColumn = -1;
+    for (quint32 i = 0; i < columnCount; ++i) {
+        Column column;
+        quint8 kind = 0;
+        in >> column.name >> kind;
+        column.kind = static_cast<ColumnKind>(kind);
+        if (column.name == "session_id") {
+            sessionColumn = columns.size();
+        }
+        columns.append(column);
+    }
+
+    int visited = 0;
+    while (!in.atEnd()) {
+        quint32 rowCount = 0;
+        in >> rowCount;
+        if (rowCount == 0) {
+            break;
+        }
+
+        QList<QByteArray> blobs;
+        for (int c = 0; c < columns.size(); ++c) {
+            QByteArray blob;
+            in >> blob;
+            blobs.append(blob);
+        }
+        if (in.status() != QDataStream::Ok) {
+            LOG_ERROR(QString("Archive file %1 is truncated").arg(path));
+            return -1;
+        }
+
+        // Only groups holding the session are decompressed past the session column
+        QVector<QVariant> sessions;
+        const bool filtered = sessionColumn >= 0 && !sessionId.isEmpty();
+        if (filtered) {
+            sessions = decodeColumn(blobs[sessionColumn], columns[sessionColumn].kind, rowCount);
+            if (!sessions.contains(QVariant(sessionId))) {
+                continue;
+            }
+        }
+
+        QList<QVector<QVariant>> values;
+        for (int c = 0; c < columns.size(); ++c) {
+            values.append(filtered && c == sessionColumn ? sessions : decodeColumn(blobs[c], columns[c].kind, rowCount));
+        }
+
+        for (quint32 r = 0; r < rowCount; ++r) {
+            if (filtered && sessions[r].toString() != sessionId) {
+                continue;
+            }
+            Row row;
+            for (int c = 0; c < columns.size(); ++c) {
+                row.insert(columns[c].name, values[c][r]);
+            }
+            visitor(row);
+            visited++;
+        }
+    }
+
+    return visited;
+}
@@ -0,0 +1,102 @@
+#ifndef ARCHIVESTORE_H
+#define ARCHIVESTORE_H
+
+#include <QDate>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QString>
+#include <QUuid>
+#include <QVariant>
+#include <functional>
+
+/**
+ * @brief Archived partitions on local disk and the read path over them
+ *
+ * PartitionArchiver exports each detached partition to one columnar file
+ * (<table>/<partition>.tmsc). Rows are sorted by the partition time column and
+ * stored in groups. Each column of a group is compressed on its own, and
+ * id and type columns are dictionary-encoded within the group. manifest.json
+ * lists every archived partition together with the sessions it holds, so a
+ * session lookup only opens the files that contain that session.
+ *
+ * Repositories consult the store for sessions whose rows have left the
+ * database, so the report endpoints cover archived months too. Rows only
+ * leave the database when the directory is shared, i.e. every API node
+ * reads the same files; otherwise the exports are kept next to the tables.
+ */
+class ArchiveStore
+{
+public:
+    enum class ColumnKind : quint8 {
+        Text = 0,
+        Dictionary = 1,
+        Time = 2,
+        Integer = 3,
+        Double = 4,
+        Boolean = 5
+    };
+
+    struct Column {
+        QString name;
+        ColumnKind kind = ColumnKind::Text;
+    };
+
+    struct Partition {
+        QString table;
+        QString partition;
+        QDate month;
+        QString file;
+        qint64 rows = 0;
+        qint64 bytes = 0;
+        QDateTime minTime;
+        QDateTime maxTime;
+        QDateTime archivedAt;
+        QSet<QString> sessions;
+    };
+
+    using Row = QHash<QString, QVariant>;
+    using RowVisitor = std::function<void(const Row&)>;
+
+    static constexpr quint32 FileMagic = 0x544D5343; // "TMSC"
+    static constexpr quint16 FileVersion = 1;
+
+    explicit ArchiveStore(const QString& directory);
+
+    QString directory() const { return m_directory; }
+
+    // The directory is on storage every API node reads, so exported partitions may be dropped
+    void setShared(bool shared) { m_shared = shared; }
+    bool isShared() const { return m_shared; }
+
+    // Read manifest.json; a missing manifest is an empty archive
+    bool load();
+
+    // Record an exported partition and rewrite the manifest
+    bool addPartition(const Partition& partition);
+
+    bool isArchived(const QString& partition) const;
+    bool hasSession(const QString& table, const QUuid& sessionId) const;
+
+    // Visit the archived rows of a session in time order; returns the number of rows or -1 on error
+    int visitSession(const QString& table, const QUuid& sessionId, const RowVisitor& visitor) const;
+
+    // Visit every row of one archive file in stored order; returns the number of rows or -1 on error
+    int visitFile(const QString& path, const RowVisitor& visitor) const;
+
+    // Partition time column of an archived table
+    static QString timeColumn(const QString& table);
+
+private:
+    bool saveManifest() const;
+    int visitFile(const QString& path, const QString& sessionId, const RowVisitor& visitor) const;
+
+    QString m_directory;
+    bool m_shared = false;
+    mutable QReadWriteLock m_lock;
+    QList<Partition> m_partitions;
+};
+
+#endif // ARCHIVESTORE_H
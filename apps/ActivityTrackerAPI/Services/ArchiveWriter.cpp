@@ -0,0 +1,154 @@
+#include "ArchiveWriter.h"
+#include <QHash>
+#include <QStringList>
+
+// Values of one column for the row group being written
+class ArchiveColumnBuffer
+{
+public:
+    explicit ArchiveColumnBuffer(ArchiveStore::ColumnKind kind) : m_kind(kind) {}
+
+    void append(const QVariant& value)
+    {
+        const bool isNull = value.isNull();
+        m_nulls.append(isNull ? 1 : 0);
+
+        switch (m_kind) {
+        case ArchiveStore::ColumnKind::Time: {
+            qint64 ms = m_previousMs;
+            if (!isNull) {
+                ms = value.toDateTime().toMSecsSinceEpoch();
+            }
+            m_stream << static_cast<qint64>(ms - m_previousMs);
+            m_previousMs = ms;
+            break;
+        }
+        case ArchiveStore::ColumnKind::Integer:
+            m_stream << static_cast<qint64>(isNull ? 0 : value.toLongLong());
+            break;
+        case ArchiveStore::ColumnKind::Double:
+            m_stream << (isNull ? 0.0 : value.toDouble());
+            break;
+        case ArchiveStore::ColumnKind::Boolean:
+            m_stream << static_cast<quint8>(!isNull && value.toBool() ? 1 : 0);
+            break;
+        case ArchiveStore::ColumnKind::Dictionary: {
+            quint32 index = 0;
+            if (!isNull) {
+                const QString text = value.toString();
+                auto it = m_dictionaryIndex.constFind(text);
+                if (it == m_dictionaryIndex.constEnd()) {
+                    it = m_dictionaryIndex.insert(text, static_cast<quint32>(m_dictionary.size()));
+                    m_dictionary.append(text);
+                }
+                index = it.value();
+            }
+            m_stream << index;
+            break;
+        }
+        case ArchiveStore::ColumnKind::Text:
+            m_stream << (isNull ? QString() : value.toString());
+            break;
+        }
+    }
+
+    // Compressed column block in the layout ArchiveStore reads back
+    QByteArray take()
+    {
+        QByteArray block;
+        QDataStream out(&block, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << m_nulls;
+        if (m_kind == ArchiveStore::ColumnKind::Dictionary) {
+            out << m_dictionary;
+        }
+        block.append(m_values);
+
+        m_nulls.clear();
+        m_values.clear();
+        m_stream.device()->seek(0);
+        m_dictionary.clear();
+        m_dictionaryIndex.clear();
+        m_previousMs = 0;
+
+        return qCompress(block, 9);
+    }
+
+private:
+    ArchiveStore::ColumnKind m_kind;
+    QByteArray m_nulls;
+    QByteArray m_values;
+    QDataStream m_stream{&m_values, QIODevice::WriteOnly};
+    QStringList m_dictionary;
+    QHash<QString, quint32> m_dictionaryIndex;
+    qint64 m_previousMs = 0;
+};
+
+ArchiveWriter::ArchiveWriter(const QString& path, int groupRows)
+    : m_file(path)
+    , m_groupRows(qMax(1, groupRows))
+{
+}
+
+ArchiveWriter::~ArchiveWriter()
+{
+    qDeleteAll(m_buffers);
+}
+
+bool ArchiveWriter::open(const QString& table, const QString& partition, const QList<ArchiveStore::Column>& columns)
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    m_out.setDevice(&m_file);
+    m_out.setVersion(QDataStream::Qt_6_0);
+    m_out << ArchiveStore::FileMagic << ArchiveStore::FileVersion << table << partition
+          << static_cast<quint32>(columns.size());
+    for (const ArchiveStore::Column& column : columns) {
+        m_out << column.name << static_cast<quint8>(column.kind);
+        m_buffers.append(new ArchiveColumnBuffer(column.kind));
+    }
+    return m_out.status() == QDataStream::Ok;
+}
+
+void ArchiveWriter::addValue(int column, const QVariant& value)
+{
+    m_buffers[column]->append(value);
+}
+
+void ArchiveWriter::endRow()
+{
+    if (++m_rowsInGroup >= m_groupRows) {
+        flushGroup();
+    }
+}
+
+void ArchiveWriter::flushGroup()
+{
+    if (m_rowsInGroup == 0) {
+        return;
+    }
+    m_out << static_cast<quint32>(m_rowsInGroup);
+    for (ArchiveColumnBuffer* buffer : m_buffers) {
+        m_out << buffer->take();
+    }
+    m_rowsInGroup = 0;
+}
+
+bool ArchiveWriter::finish()
+{
+    if (!m_file.isOpen()) {
+        return false;
+    }
+
+    flushGroup();
+    m_out << static_cast<quint32>(0);
+    m_file.close();
+    return m_out.status() == QDataStream::Ok && m_file.error() == QFile::NoError;
+}
+
+QString ArchiveWriter::errorString() const
+{
+    return m_file.errorString();
+}
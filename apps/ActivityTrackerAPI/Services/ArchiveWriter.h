@@ -0,0 +1,46 @@
+#ifndef ARCHIVEWRITER_H
+#define ARCHIVEWRITER_H
+
+#include <QDataStream>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QVariant>
+#include "Services/ArchiveStore.h"
+
+class ArchiveColumnBuffer;
+
+/**
+ * @brief Writes one archived partition in the columnar file format ArchiveStore reads
+ *
+ * Values are added column by column and endRow() closes each row; every
+ * groupRows rows the buffered columns are compressed and written as one row
+ * group. Rows are expected in time order, since time columns are stored as
+ * deltas. finish() writes the end marker; the file is complete only if it
+ * returns true.
+ */
+class ArchiveWriter
+{
+public:
+    explicit ArchiveWriter(const QString& path, int groupRows = 65536);
+    ~ArchiveWriter();
+
+    bool open(const QString& table, const QString& partition, const QList<ArchiveStore::Column>& columns);
+
+    void addValue(int column, const QVariant& value);
+    void endRow();
+
+    bool finish();
+    QString errorString() const;
+
+private:
+    void flushGroup();
+
+    QFile m_file;
+    QDataStream m_out;
+    int m_groupRows;
+    int m_rowsInGroup = 0;
+    QList<ArchiveColumnBuffer*> m_buffers;
+};
+
+#endif // ARCHIVEWRITER_H
@@ -0,0 +1,214 @@
+#include "BatchDedupeIndex.h"
+#include <QJsonArray>
+#include <QMutexLocker>
+#include "logger/logger.h"
+#include "Repositories/SessionRepository.h"
+
+namespace {
+
+const char* const BatchArrays[] = { "activity_events", "app_usages", "system_metrics", "session_events" };
+
+} // namespace
+
+BatchDedupeIndex::BatchDedupeIndex(SessionRepository* sessionRepository, const Options& options)
+    : m_sessionRepository(sessionRepository)
+    , m_options(options)
+    , m_receipts(options.maxReceipts)
+    , m_windows(options.maxSessions)
+{
+}
+
+QString BatchDedupeIndex::receiptKey(const QUuid& userId, const QString& idempotencyKey)
+{
+    return userId.toString(QUuid::WithoutBraces) + '/' + idempotencyKey;
+}
+
+bool BatchDedupeIndex::findReceipt(const QUuid& userId, const QString& idempotencyKey,
+                                   int& statusCode, QJsonObject& response)
+{
+    const QString key = receiptKey(userId, idempotencyKey);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (Receipt* receipt = m_receipts.object(key)) {
+            if (receipt->expiresAt > QDateTime::currentDateTimeUtc()) {
+                statusCode = receipt->statusCode;
+                response = receipt->response;
+                return true;
+            }
+            m_receipts.remove(key);
+            return false;
+        }
+    }
+
+    // Not in memory: the receipt may predate a restart or have been evicted
+    if (!m_sessionRepository || !m_sessionRepository->findBatchReceipt(userId, idempotencyKey, statusCode, response)) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_receipts.insert(key, new Receipt{statusCode, response,
+                                       QDateTime::currentDateTimeUtc().addSecs(m_options.receiptTtlHours * 3600)});
+    return true;
+}
+
+void BatchDedupeIndex::storeReceipt(const QUuid& userId, const QString& idempotencyKey, const QUuid& sessionId,
+                                    int statusCode, const QJsonObject& response)
+{
+    const QDateTime expiresAt = QDateTime::currentDateTimeUtc().addSecs(m_options.receiptTtlHours * 3600);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_receipts.insert(receiptKey(userId, idempotencyKey), new Receipt{statusCode, response, expiresAt});
+    }
+
+    if (m_sessionRepository &&
+        !m_sessionRepository->saveBatchReceipt(userId, idempotencyKey, sessionId, statusCode, response, expiresAt)) {
+        LOG_WARNING(QString("Batch receipt for key %1 is only held in memory").arg(idempotencyKey));
+    }
+}
+
+void BatchDedupeIndex::remember(SequenceWindow* window, qint64 sequence, int maxSequences)
+{
+    if (window->committed.contains(sequence)) {
+        return;
+    }
+
+    window->committed.insert(sequence);
+    window->order.enqueue(sequence);
+    if (window->order.size() > maxSequences) {
+        window->committed.remove(window->order.dequeue());
+    }
+}
+
+int BatchDedupeIndex::filterCommitted(const QUuid& sessionId, QJsonObject& batch)
+{
+    // Sequence numbers the memory window cannot vouch for are checked against the table
+    QList<qint64> unknown;
+    {
+        QMutexLocker locker(&m_mutex);
+        SequenceWindow* window = m_windows.object(sessionId);
+        for (const char* arrayKey : BatchArrays) {
+            const QJsonArray rows = batch[arrayKey].toArray();
+            for (const QJsonValue& row : rows) {
+                const QJsonValue seq = row.toObject().value("client_seq");
+                if (!seq.isUndefined() && (!window || !window->committed.contains(seq.toInteger()))) {
+                    unknown.append(seq.toInteger());
+                }
+            }
+        }
+    }
+
+    QSet<qint64> persisted;
+    if (m_sessionRepository && !unknown.isEmpty()) {
+        persisted = m_sessionRepository->findCommittedSequences(sessionId, unknown);
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    SequenceWindow* window = m_windows.object(sessionId);
+    if (!persisted.isEmpty()) {
+        if (!window) {
+            window = new SequenceWindow;
+            m_windows.insert(sessionId, window);
+        }
+        for (qint64 sequence : persisted) {
+            remember(window, sequence, m_options.maxSequencesPerSession);
+        }
+    }
+    if (!window) {
+        return 0;
+    }
+
+    int removed = 0;
+    for (const char* arrayKey : BatchArrays) {
+        if (!batch[arrayKey].isArray()) {
+            continue;
+        }
+
+        const QJsonArray rows = batch[arrayKey].toArray();
+        QJsonArray kept;
+        for (const QJsonValue& row : rows) {
+            const QJsonValue seq = row.toObject().value("client_seq");
+            if (!seq.isUndefined() &&
+                (window->committed.contains(seq.toInteger()) || persisted.contains(seq.toInteger()))) {
+                removed++;
+                continue;
+            }
+            kept.append(row);
+        }
+
+        if (kept.size() != rows.size()) {
+            batch[arrayKey] = kept;
+        }
+    }
+
+    if (removed > 0) {
+        LOG_INFO(QString("Skipped %1 rows already committed for session %2").arg(removed).arg(sessionId.toString()));
+    }
+
+    return removed;
+}
+
+void BatchDedupeIndex::markCommitted(const QUuid& sessionId, const QJsonObject& batch, const QJsonObject& results)
+{
+    QList<qint64> committed;
+    for (const char* arrayKey : BatchArrays) {
+        if (!batch[arrayKey].isArray()) {
+            continue;
+        }
+
+        QSet<int> failedIndices;
+        const QJsonArray failures = results[QString(arrayKey) + "_failures"].toArray();
+        for (const QJsonValue& failure : failures) {
+            failedIndices.insert(failure.toObject()["index"].toInt());
+        }
+
+        const QJsonArray rows = batch[arrayKey].toArray();
+        for (int i = 0; i < rows.size(); i++) {
+            const QJsonValue seq = rows[i].toObject().value("client_seq");
+            if (!seq.isUndefined() && !failedIndices.contains(i)) {
+                committed.append(seq.toInteger());
+            }
+        }
+    }
+
+    if (committed.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    SequenceWindow* window = m_windows.object(sessionId);
+    if (!window) {
+        window = new SequenceWindow;
+        m_windows.insert(sessionId, window);
+    }
+    for (qint64 sequence : committed) {
+        remember(window, sequence, m_options.maxSequencesPerSession);
+    }
+}
+
+QDateTime BatchDedupeIndex::sequenceExpiresAt() const
+{
+    return QDateTime::currentDateTimeUtc().addSecs(m_options.sequenceTtlHours * 3600);
+}
+
+int BatchDedupeIndex::purgeExpired()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        const QDateTime now = QDateTime::currentDateTimeUtc();
+        const QList<QString> keys = m_receipts.keys();
+        for (const QString& key : keys) {
+            Receipt* receipt = m_receipts.object(key);
+            if (receipt && receipt->expiresAt <= now) {
+                m_receipts.remove(key);
+            }
+        }
+    }
+
+    if (!m_sessionRepository) {
+        return 0;
+    }
+    return m_sessionRepository->purgeExpiredBatchReceipts() + m_sessionRepository->purgeExpiredBatchSequences();
+}
@@ -0,0 +1,84 @@
+#ifndef BATCHDEDUPEINDEX_H
+#define BATCHDEDUPEINDEX_H
+
+#include <QCache>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QMutex>
+#include <QQueue>
+#include <QSet>
+#include <QUuid>
+
+class SessionRepository;
+
+/**
+ * @brief Bounded dedupe index for resent /api/batch requests
+ *
+ * Agents retry a batch when a request times out, even if the server already
+ * committed it. Two keys stop the retry from inserting rows again:
+ *
+ * - The Idempotency-Key of the request. The response is kept in a
+ *   least-recently-used cache and in the batch_idempotency_keys table until it
+ *   expires, and a replay gets the stored response back.
+ * - The client_seq of each row, for batches that partly failed or were
+ *   regrouped by the agent. Each row claims its sequence number in
+ *   batch_client_sequences in the transaction that writes it, so a resend that
+ *   arrives while the first request is still committing waits for it and then
+ *   skips the row. Before that, sequence numbers known to be committed are
+ *   removed from the batch: a bounded window per session is checked in memory
+ *   first and the table for the rest.
+ */
+class BatchDedupeIndex
+{
+public:
+    struct Options {
+        int maxReceipts = 10000;
+        int receiptTtlHours = 24;
+        int maxSessions = 4096;
+        int maxSequencesPerSession = 8192;
+        int sequenceTtlHours = 24;
+    };
+
+    explicit BatchDedupeIndex(SessionRepository* sessionRepository, const Options& options = Options());
+
+    // Stored response for a key, from memory or the database
+    bool findReceipt(const QUuid& userId, const QString& idempotencyKey, int& statusCode, QJsonObject& response);
+    void storeReceipt(const QUuid& userId, const QString& idempotencyKey, const QUuid& sessionId,
+                      int statusCode, const QJsonObject& response);
+
+    // Remove rows whose client_seq was already committed for the session; returns the number removed
+    int filterCommitted(const QUuid& sessionId, QJsonObject& batch);
+
+    // Record in memory the client_seq of every row in the batch not listed in results["<key>_failures"]
+    void markCommitted(const QUuid& sessionId, const QJsonObject& batch, const QJsonObject& results = QJsonObject());
+
+    // Expiry for client_seq claims made now
+    QDateTime sequenceExpiresAt() const;
+
+    // Drop expired receipts from memory and expired receipts and sequences from the database
+    int purgeExpired();
+
+private:
+    struct Receipt {
+        int statusCode = 200;
+        QJsonObject response;
+        QDateTime expiresAt;
+    };
+
+    struct SequenceWindow {
+        QSet<qint64> committed;
+        QQueue<qint64> order;
+    };
+
+    static QString receiptKey(const QUuid& userId, const QString& idempotencyKey);
+    static void remember(SequenceWindow* window, qint64 sequence, int maxSequences);
+
+    SessionRepository* m_sessionRepository;
+    Options m_options;
+
+    QMutex m_mutex;
+    QCache<QString, Receipt> m_receipts;
+    QCache<QUuid, SequenceWindow> m_windows;
+};
+
+#endif // BATCHDEDUPEINDEX_H
@@ -0,0 +1,664 @@
+#include "BatchSpool.h"
+#include <QCborMap>
+#include <QCborValue>
+#include <QDateTime>
+#include <QDir>
+#include <QJsonArray>
+#include <QScopeGuard>
+#include <QSet>
+#include <QtEndian>
+#include "logger/logger.h"
+#include "Core/ModelFactory.h"
+#include "Repositories/ActivityEventRepository.h"
+#include "Repositories/AppUsageRepository.h"
+#include "Repositories/SystemMetricsRepository.h"
+#include "Repositories/SessionEventRepository.h"
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Record header: magic, payload length, payload checksum, reserved
+constexpr quint32 RecordMagic = 0x42534D54;     // "TMSB"
+constexpr int RecordHeaderSize = 12;
+
+// Bulk attempts for one batch array before falling back to row-by-row inserts
+constexpr int MaxBulkAttempts = 3;
+
+constexpr int InitialBackoffMs = 1000;
+constexpr int MaxBackoffMs = 30000;
+
+enum BatchTable {
+    ActivityEventsTable = 1 << 0,
+    AppUsagesTable = 1 << 1,
+    SystemMetricsTable = 1 << 2,
+    SessionEventsTable = 1 << 3
+};
+
+} // namespace
+
+/**
+ * @brief Database side of one spool writer thread
+ *
+ * Owns its own DbService instances, so its connections are created on and used
+ * from the writer thread only.
+ */
+class BatchSpoolWriter
+{
+public:
+    BatchSpoolWriter(const DbConfig& config, int rowsPerStatement, int sequenceTtlHours)
+        : m_activityEventService(config)
+        , m_appUsageService(config)
+        , m_systemMetricsService(config)
+        , m_sessionEventService(config)
+        , m_rowsPerStatement(rowsPerStatement)
+        , m_sequenceTtlHours(sequenceTtlHours)
+    {
+        m_activityEventRepository.initialize(&m_activityEventService);
+        m_appUsageRepository.initialize(&m_appUsageService);
+        m_systemMetricsRepository.initialize(&m_systemMetricsService);
+        m_sessionEventRepository.initialize(&m_sessionEventService);
+    }
+
+    bool isDatabaseReachable()
+    {
+        QSqlQuery query = m_activityEventService.createQuery();
+        return query.exec("SELECT 1");
+    }
+
+    // Write each array not yet marked in completedTables; false means retry later
+    bool write(const QJsonObject& batch, const QUuid& sessionId, const QUuid& userId,
+               const QDateTime& receivedAt, bool rowByRow, int& completedTables)
+    {
+        bool ok = true;
+
+        ok &= writeTable<ActivityEventModel>(m_activityEventRepository, batch, "activity_events", ActivityEventsTable,
+            sessionId, rowByRow, completedTables, [&](const QJsonObject& row, QString& error) {
+                return ModelFactory::createActivityEventFromBatch(row, sessionId, userId, receivedAt, error);
+            });
+
+        ok &= writeTable<AppUsageModel>(m_appUsageRepository, batch, "app_usages", AppUsagesTable,
+            sessionId, rowByRow, completedTables, [&](const QJsonObject& row, QString& error) {
+                return ModelFactory::createAppUsageFromBatch(row, sessionId, userId, receivedAt, error);
+            });
+
+        ok &= writeTable<SystemMetricsModel>(m_systemMetricsRepository, batch, "system_metrics", SystemMetricsTable,
+            sessionId, rowByRow, completedTables, [&](const QJsonObject& row, QString& error) {
+                return ModelFactory::createSystemMetricsFromBatch(row, sessionId, userId, receivedAt, error);
+            });
+
+        ok &= writeTable<SessionEventModel>(m_sessionEventRepository, batch, "session_events", SessionEventsTable,
+            sessionId, rowByRow, completedTables, [&](const QJsonObject& row, QString& error) {
+                return ModelFactory::createSessionEventFromBatch(row, sessionId, userId, receivedAt, error);
+            });
+
+        return ok;
+    }
+
+private:
+    template<typename Model, typename Repository, typename Builder>
+    bool writeTable(Repository& repository, const QJsonObject& batch, const QString& key, int table,
+                    const QUuid& sessionId, bool rowByRow, int& completedTables, Builder build)
+    {
+        const QJsonValue rows = batch.value(key);
+        if ((completedTables & table) || !rows.isArray()) {
+            completedTables |= table;
+            return true;
+        }
+
+        QList<Model*> models;
+        QList<QJsonValue> sequences;
+        auto cleanup = qScopeGuard([&models]() { qDeleteAll(models); });
+
+        const QJsonArray array = rows.toArray();
+        for (int i = 0; i < array.size(); ++i) {
+            QString error;
+            Model* model = array[i].isObject() ? build(array[i].toObject(), error) : nullptr;
+            if (model) {
+                models.append(model);
+                sequences.append(array[i].toObject().value("client_seq"));
+            } else {
+                LOG_WARNING(QString("Dropping spooled %1 row %2: %3")
+                           .arg(key)
+                           .arg(i)
+                           .arg(error.isEmpty() ? QString("not a valid JSON object") : error));
+            }
+        }
+
+        const QDateTime claimExpiresAt = QDateTime::currentDateTimeUtc().addSecs(m_sequenceTtlHours * 3600);
+
+        if (rowByRow) {
+            // A row the database keeps rejecting must not block the rest of the spool
+            int failed = 0;
+            int duplicates = 0;
+            for (int i = 0; i < models.size(); ++i) {
+                // A rejected row is dropped, so its claim may stay behind
+                if (!sequences[i].isUndefined()) {
+                    const auto claimed = repository.claimClientSequences(sessionId, {sequences[i].toInteger()},
+                                                                         claimExpiresAt);
+                    if (claimed && claimed->isEmpty()) {
+                        duplicates++;
+                        continue;
+                    }
+                }
+                if (!repository.save(models[i])) {
+                    failed++;
+                }
+            }
+            if (failed > 0) {
+                LOG_ERROR(QString("Dropped %1 of %2 spooled rows rejected by the database")
+                         .arg(failed).arg(models.size()));
+            }
+            if (duplicates > 0) {
+                LOG_INFO(QString("Skipped %1 spooled %2 rows already committed").arg(duplicates).arg(key));
+            }
+            completedTables |= table;
+            return true;
+        }
+
+        bool ok = repository.executeInTransaction([&]() {
+            QList<qint64> values;
+            for (const QJsonValue& seq : sequences) {
+                if (!seq.isUndefined()) {
+                    values.append(seq.toInteger());
+                }
+            }
+
+            // Claimed together with the insert, so a batch spooled twice is written once
+            const auto claimed = repository.claimClientSequences(sessionId, values, claimExpiresAt);
+            if (!claimed) {
+                return false;
+            }
+
+            QList<Model*> toInsert;
+            for (int i = 0; i < models.size(); ++i) {
+                if (sequences[i].isUndefined() || claimed->contains(sequences[i].toInteger())) {
+                    toInsert.append(models[i]);
+                }
+            }
+            if (toInsert.size() < models.size()) {
+                LOG_INFO(QString("Skipped %1 spooled %2 rows already committed")
+                        .arg(models.size() - toInsert.size()).arg(key));
+            }
+            return repository.saveAll(toInsert, m_rowsPerStatement) >= 0;
+        });
+        if (ok) {
+            completedTables |= table;
+        }
+        return ok;
+    }
+
+    DbService<ActivityEventModel> m_activityEventService;
+    DbService<AppUsageModel> m_appUsageService;
+    DbService<SystemMetricsModel> m_systemMetricsService;
+    DbService<SessionEventModel> m_sessionEventService;
+
+    ActivityEventRepository m_activityEventRepository;
+    AppUsageRepository m_appUsageRepository;
+    SystemMetricsRepository m_systemMetricsRepository;
+    SessionEventRepository m_sessionEventRepository;
+
+    int m_rowsPerStatement;
+    int m_sequenceTtlHours;
+};
+
+BatchSpool::BatchSpool(const Options& options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+{
+    LOG_DEBUG(QString("BatchSpool created for directory %1").arg(options.directory));
+}
+
+BatchSpool::~BatchSpool()
+{
+    close();
+}
+
+bool BatchSpool::open(const DbConfig& dbConfig)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_open) {
+        LOG_WARNING("BatchSpool already open");
+        return true;
+    }
+
+    m_dbConfig = dbConfig;
+
+    QDir dir(m_options.directory);
+    if (!dir.mkpath(".")) {
+        LOG_ERROR(QString("Cannot create spool directory %1").arg(m_options.directory));
+        return false;
+    }
+
+    // Segment numbers are zero-padded, so name order is append order
+    QStringList segmentFiles = dir.entryList(QStringList() << "segment-*.wal", QDir::Files, QDir::Name);
+    quint64 lastSegment = 0;
+    for (const QString& fileName : segmentFiles) {
+        bool ok = false;
+        quint64 segment = fileName.mid(8, fileName.length() - 12).toULongLong(&ok);
+        if (!ok) {
+            LOG_WARNING(QString("Ignoring unexpected spool file %1").arg(fileName));
+            continue;
+        }
+        recoverSegment(segment);
+        lastSegment = qMax(lastSegment, segment);
+    }
+
+    if (!m_entries.isEmpty()) {
+        LOG_INFO(QString("Recovered %1 undrained batches from spool %2")
+                .arg(m_entries.size()).arg(m_options.directory));
+    }
+
+    if (!openActiveSegment(lastSegment + 1)) {
+        return false;
+    }
+
+    m_stopping = false;
+    m_syncFailed = false;
+    m_open = true;
+
+    m_syncThread = QThread::create([this]() { syncLoop(); });
+    m_syncThread->start();
+
+    for (int i = 0; i < qMax(1, m_options.writerThreads); ++i) {
+        QThread* thread = QThread::create([this, i]() { writerLoop(i); });
+        thread->start();
+        m_writerThreads.append(thread);
+    }
+
+    LOG_INFO(QString("BatchSpool open at %1 with %2 writer threads")
+            .arg(m_options.directory).arg(m_writerThreads.size()));
+    return true;
+}
+
+void BatchSpool::close()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_open) {
+            return;
+        }
+        m_stopping = true;
+        m_syncRequested.wakeAll();
+        m_synced.wakeAll();
+        m_entriesAvailable.wakeAll();
+        m_stopRequested.wakeAll();
+    }
+
+    // Writers finish the batch they hold; the rest stays on disk
+    for (QThread* thread : m_writerThreads) {
+        thread->wait();
+        delete thread;
+    }
+    m_writerThreads.clear();
+
+    m_syncThread->wait();
+    delete m_syncThread;
+    m_syncThread = nullptr;
+
+    QMutexLocker locker(&m_mutex);
+    int pending = m_entries.size();
+    m_activeFile.close();
+    m_entries.clear();
+    m_segments.clear();
+    m_open = false;
+
+    LOG_INFO(QString("BatchSpool closed with %1 batches left to drain").arg(pending));
+}
+
+bool BatchSpool::isOpen() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_open && !m_stopping && !m_syncFailed;
+}
+
+QUuid BatchSpool::append(const QUuid& sessionId, const QUuid& userId, const QJsonObject& batch)
+{
+    QUuid batchId = QUuid::createUuid();
+
+    QCborMap payload;
+    payload[QStringLiteral("batch_id")] = batchId.toString(QUuid::WithoutBraces);
+    payload[QStringLiteral("session_id")] = sessionId.toString(QUuid::WithoutBraces);
+    payload[QStringLiteral("user_id")] = userId.toString(QUuid::WithoutBraces);
+    payload[QStringLiteral("received_at")] = QDateTime::currentMSecsSinceEpoch();
+    payload[QStringLiteral("data")] = QCborValue::fromJsonValue(batch);
+    QByteArray record = encodeRecord(payload.toCborValue().toCbor());
+
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_open || m_stopping || m_syncFailed) {
+        return QUuid();
+    }
+
+    while (m_activeFile.size() > 0 && m_activeFile.size() + record.size() > m_options.maxSegmentBytes) {
+        if (m_syncInFlight) {
+            m_synced.wait(&m_mutex);
+            continue;
+        }
+        if (!rollSegment()) {
+            return QUuid();
+        }
+    }
+
+    Entry entry;
+    entry.segment = m_activeSegment;
+    entry.offset = m_activeFile.size();
+    entry.length = record.size();
+
+    if (m_activeFile.write(record) != record.size()) {
+        LOG_ERROR(QString("Failed to append batch to spool: %1").arg(m_activeFile.errorString()));
+        m_activeFile.resize(entry.offset);
+        return QUuid();
+    }
+
+    m_segments[entry.segment].outstanding++;
+    quint64 sequence = ++m_appendSequence;
+    m_syncRequested.wakeOne();
+
+    // Group commit: wait for an fsync that covers this record
+    while (m_syncedSequence < sequence && !m_syncFailed) {
+        m_synced.wait(&m_mutex);
+    }
+
+    if (m_syncedSequence < sequence) {
+        m_segments[entry.segment].outstanding--;
+        return QUuid();
+    }
+
+    m_entries.enqueue(entry);
+    m_entriesAvailable.wakeOne();
+    return batchId;
+}
+
+int BatchSpool::pendingBatches() const
+{
+    QMutexLocker locker(&m_mutex);
+    int pending = 0;
+    for (const Segment& segment : m_segments) {
+        pending += segment.outstanding;
+    }
+    return pending;
+}
+
+QString BatchSpool::segmentPath(quint64 segment) const
+{
+    return QDir(m_options.directory).filePath(QString("segment-%1.wal").arg(segment, 20, 10, QChar('0')));
+}
+
+QString BatchSpool::ackPath(quint64 segment) const
+{
+    return QDir(m_options.directory).filePath(QString("segment-%1.ack").arg(segment, 20, 10, QChar('0')));
+}
+
+bool BatchSpool::openActiveSegment(quint64 segment)
+{
+    m_activeFile.setFileName(segmentPath(segment));
+    if (!m_activeFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered)) {
+        LOG_ERROR(QString("Cannot open spool segment %1: %2")
+                 .arg(m_activeFile.fileName(), m_activeFile.errorString()));
+        return false;
+    }
+
+    m_activeSegment = segment;
+    m_segments[segment] = Segment();
+    LOG_DEBUG(QString("Spooling to segment %1").arg(m_activeFile.fileName()));
+    return true;
+}
+
+bool BatchSpool::rollSegment()
+{
+    // Everything appended so far is in the active segment; make it durable before closing it
+    if (!syncHandle(m_activeFile.handle())) {
+        LOG_ERROR(QString("Failed to sync spool segment %1").arg(m_activeFile.fileName()));
+        m_syncFailed = true;
+        m_synced.wakeAll();
+        return false;
+    }
+    m_syncedSequence = m_appendSequence;
+    m_synced.wakeAll();
+
+    quint64 sealedSegment = m_activeSegment;
+    m_activeFile.close();
+    m_segments[sealedSegment].sealed = true;
+
+    if (m_segments[sealedSegment].outstanding == 0) {
+        QFile::remove(segmentPath(sealedSegment));
+        QFile::remove(ackPath(sealedSegment));
+        m_segments.remove(sealedSegment);
+    }
+
+    return openActiveSegment(sealedSegment + 1);
+}
+
+bool BatchSpool::recoverSegment(quint64 segment)
+{
+    QSet<qint64> drainedOffsets;
+    QFile ackFile(ackPath(segment));
+    if (ackFile.open(QIODevice::ReadOnly)) {
+        QByteArray acks = ackFile.readAll();
+        for (int i = 0; i + 8 <= acks.size(); i += 8) {
+            drainedOffsets.insert(qFromLittleEndian<qint64>(acks.constData() + i));
+        }
+    }
+
+    QFile file(segmentPath(segment));
+    if (!file.open(QIODevice::ReadWrite)) {
+        LOG_ERROR(QString("Cannot open spool segment %1: %2").arg(file.fileName(), file.errorString()));
+        return false;
+    }
+
+    Segment state;
+    state.sealed = true;
+
+    qint64 offset = 0;
+    while (offset < file.size()) {
+        QByteArray header = file.read(RecordHeaderSize);
+        quint32 length = header.size() == RecordHeaderSize ? qFromLittleEndian<quint32>(header.constData() + 4) : 0;
+        QByteArray payload = length > 0 ? file.read(length) : QByteArray();
+
+        bool valid = header.size() == RecordHeaderSize
+                     && qFromLittleEndian<quint32>(header.constData()) == RecordMagic
+                     && payload.size() == qint64(length)
+                     && qFromLittleEndian<quint16>(header.constData() + 8) == qChecksum(payload);
+        if (!valid) {
+            // A record torn by a crash before its fsync was never acknowledged
+            LOG_WARNING(QString("Truncating spool segment %1 at offset %2").arg(file.fileName()).arg(offset));
+            file.resize(offset);
+            break;
+        }
+
+        if (!drainedOffsets.contains(offset)) {
+            Entry entry;
+            entry.segment = segment;
+            entry.offset = offset;
+            entry.length = RecordHeaderSize + length;
+            m_entries.enqueue(entry);
+            state.outstanding++;
+        }
+
+        offset += RecordHeaderSize + length;
+    }
+    file.close();
+
+    if (state.outstanding == 0) {
+        QFile::remove(segmentPath(segment));
+        QFile::remove(ackPath(segment));
+    } else {
+        m_segments[segment] = state;
+    }
+
+    return true;
+}
+
+void BatchSpool::syncLoop()
+{
+    QMutexLocker locker(&m_mutex);
+
+    while (true) {
+        while (!m_stopping && m_syncedSequence == m_appendSequence) {
+            m_syncRequested.wait(&m_mutex);
+        }
+
+        if (m_syncedSequence == m_appendSequence || m_syncFailed) {
+            break;
+        }
+
+        quint64 target = m_appendSequence;
+        int handle = m_activeFile.handle();
+        m_syncInFlight = true;
+
+        locker.unlock();
+        bool ok = syncHandle(handle);
+        locker.relock();
+
+        m_syncInFlight = false;
+        if (ok) {
+            m_syncedSequence = qMax(m_syncedSequence, target);
+        } else {
+            LOG_ERROR(QString("Failed to sync spool segment %1, disabling the spool").arg(m_activeFile.fileName()));
+            m_syncFailed = true;
+        }
+        m_synced.wakeAll();
+    }
+}
+
+void BatchSpool::writerLoop(int writerIndex)
+{
+    LOG_DEBUG(QString("Spool writer %1 started").arg(writerIndex));
+
+    BatchSpoolWriter writer(m_dbConfig, m_options.rowsPerStatement, m_options.sequenceTtlHours);
+    int backoffMs = 0;
+
+    while (true) {
+        Entry entry;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_stopping && m_entries.isEmpty()) {
+                m_entriesAvailable.wait(&m_mutex);
+            }
+            if (m_stopping) {
+                break;
+            }
+            entry = m_entries.dequeue();
+        }
+
+        if (writeEntry(entry, writer)) {
+            completeEntry(entry);
+            backoffMs = 0;
+            continue;
+        }
+
+        // Keep the batch at the head of the queue and back off while the database is unavailable
+        backoffMs = backoffMs == 0 ? InitialBackoffMs : qMin(backoffMs * 2, MaxBackoffMs);
+        LOG_WARNING(QString("Spool writer %1 failed to write batch, retrying in %2 ms")
+                   .arg(writerIndex).arg(backoffMs));
+
+        QMutexLocker locker(&m_mutex);
+        m_entries.prepend(entry);
+        if (!m_stopping) {
+            m_stopRequested.wait(&m_mutex, backoffMs);
+        }
+    }
+
+    LOG_DEBUG(QString("Spool writer %1 stopped").arg(writerIndex));
+}
+
+bool BatchSpool::writeEntry(Entry& entry, BatchSpoolWriter& writer)
+{
+    QByteArray payload;
+    if (!readPayload(entry, payload)) {
+        LOG_ERROR(QString("Dropping unreadable spool record at %1:%2")
+                 .arg(segmentPath(entry.segment)).arg(entry.offset));
+        return true;
+    }
+
+    QCborMap record = QCborValue::fromCbor(payload).toMap();
+    QJsonObject batch = record.value(QStringLiteral("data")).toJsonValue().toObject();
+    QUuid sessionId(record.value(QStringLiteral("session_id")).toString());
+    QUuid userId(record.value(QStringLiteral("user_id")).toString());
+    QDateTime receivedAt = QDateTime::fromMSecsSinceEpoch(
+        record.value(QStringLiteral("received_at")).toInteger(QDateTime::currentMSecsSinceEpoch()), Qt::UTC);
+
+    // Only count attempts the database actually rejected, not outages
+    bool rowByRow = entry.attempts >= MaxBulkAttempts;
+    if (writer.write(batch, sessionId, userId, receivedAt, rowByRow, entry.completedTables)) {
+        LOG_DEBUG(QString("Drained spooled batch %1").arg(record.value(QStringLiteral("batch_id")).toString()));
+        return true;
+    }
+
+    if (writer.isDatabaseReachable()) {
+        entry.attempts++;
+    }
+    return false;
+}
+
+void BatchSpool::completeEntry(const Entry& entry)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // Not synced: a lost ack only means the batch is written again after a crash
+    QFile ackFile(ackPath(entry.segment));
+    if (ackFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        char offset[8];
+        qToLittleEndian<qint64>(entry.offset, offset);
+        ackFile.write(offset, sizeof(offset));
+        ackFile.close();
+    }
+
+    auto it = m_segments.find(entry.segment);
+    if (it == m_segments.end()) {
+        return;
+    }
+
+    it->outstanding--;
+    if (it->sealed && it->outstanding == 0) {
+        QFile::remove(segmentPath(entry.segment));
+        QFile::remove(ackPath(entry.segment));
+        m_segments.erase(it);
+    }
+}
+
+bool BatchSpool::readPayload(const Entry& entry, QByteArray& payload) const
+{
+    QFile file(segmentPath(entry.segment));
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(entry.offset)) {
+        return false;
+    }
+
+    QByteArray record = file.read(entry.length);
+    if (record.size() != entry.length || record.size() < RecordHeaderSize) {
+        return false;
+    }
+
+    payload = record.mid(RecordHeaderSize);
+    return qFromLittleEndian<quint16>(record.constData() + 8) == qChecksum(payload);
+}
+
+QByteArray BatchSpool::encodeRecord(const QByteArray& payload)
+{
+    QByteArray record(RecordHeaderSize, Qt::Uninitialized);
+    qToLittleEndian<quint32>(RecordMagic, record.data());
+    qToLittleEndian<quint32>(quint32(payload.size()), record.data() + 4);
+    qToLittleEndian<quint16>(qChecksum(payload), record.data() + 8);
+    qToLittleEndian<quint16>(0, record.data() + 10);
+    return record + payload;
+}
+
+bool BatchSpool::syncHandle(int handle)
+{
+    if (handle < 0) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return _commit(handle) == 0;
+#elif defined(Q_OS_MACOS)
+    return ::fsync(handle) == 0;
+#else
+    return ::fdatasync(handle) == 0;
+#endif
+}
@@ -0,0 +1,117 @@
+#ifndef BATCHSPOOL_H
+#define BATCHSPOOL_H
+
+#include <QObject>
+#include <QFile>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QUuid>
+#include <QWaitCondition>
+#include "dbservice/dbconfig.h"
+
+class BatchSpoolWriter;
+
+/**
+ * @brief Write-ahead spool for asynchronous /api/batch ingestion
+ *
+ * Validated batches are appended to numbered segment files in the spool
+ * directory and acknowledged once an fsync covers them. Appends that arrive
+ * while an fsync is running share the next one (group commit). Writer threads
+ * drain the spool into PostgreSQL with multi-row inserts, each on its own
+ * connection, and retry with backoff while the database is unavailable.
+ *
+ * Rows claim their client_seq in batch_client_sequences in the transaction
+ * that inserts them, so a batch spooled twice is written once.
+ *
+ * Drained batches are recorded in a per-segment .ack file; a segment and its
+ * .ack file are deleted once every batch in it is drained. Batches that were
+ * spooled but not acknowledged are queued again by open() after a restart.
+ */
+class BatchSpool : public QObject
+{
+    Q_OBJECT
+public:
+    struct Options {
+        QString directory = "spool";
+        qint64 maxSegmentBytes = 64 * 1024 * 1024;
+        int writerThreads = 2;
+        int rowsPerStatement = 500;
+        int sequenceTtlHours = 24;   ///< Lifetime of the rows' client_seq claims
+    };
+
+    explicit BatchSpool(const Options& options, QObject *parent = nullptr);
+    ~BatchSpool() override;
+
+    // Recover existing segments and start the sync and writer threads
+    bool open(const DbConfig& dbConfig);
+
+    // Stop the threads; undrained batches stay on disk for the next open()
+    void close();
+
+    bool isOpen() const;
+
+    // Durably append a batch; returns its ID, or a null QUuid if it could not be spooled
+    QUuid append(const QUuid& sessionId, const QUuid& userId, const QJsonObject& batch);
+
+    // Batches spooled but not yet written to the database
+    int pendingBatches() const;
+
+private:
+    struct Entry {
+        quint64 segment = 0;
+        qint64 offset = 0;
+        qint64 length = 0;
+        int attempts = 0;
+        int completedTables = 0;    ///< Bit per batch array already committed
+    };
+
+    struct Segment {
+        int outstanding = 0;
+        bool sealed = false;
+    };
+
+    QString segmentPath(quint64 segment) const;
+    QString ackPath(quint64 segment) const;
+    bool openActiveSegment(quint64 segment);
+    bool rollSegment();
+    bool recoverSegment(quint64 segment);
+
+    void syncLoop();
+    void writerLoop(int writerIndex);
+    bool writeEntry(Entry& entry, BatchSpoolWriter& writer);
+    void completeEntry(const Entry& entry);
+    bool readPayload(const Entry& entry, QByteArray& payload) const;
+
+    static QByteArray encodeRecord(const QByteArray& payload);
+    static bool syncHandle(int handle);
+
+    Options m_options;
+    DbConfig m_dbConfig;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_syncRequested;
+    QWaitCondition m_synced;
+    QWaitCondition m_entriesAvailable;
+    QWaitCondition m_stopRequested;
+
+    QFile m_activeFile;
+    quint64 m_activeSegment = 0;
+    quint64 m_appendSequence = 0;
+    quint64 m_syncedSequence = 0;
+    bool m_syncInFlight = false;
+    bool m_syncFailed = false;
+    bool m_stopping = false;
+    bool m_open = false;
+
+    QHash<quint64, Segment> m_segments;
+    QQueue<Entry> m_entries;
+
+    QThread* m_syncThread = nullptr;
+    QList<QThread*> m_writerThreads;
+};
+
+#endif // BATCHSPOOL_H
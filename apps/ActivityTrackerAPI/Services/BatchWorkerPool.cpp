@@ -0,0 +1,137 @@
+#include "BatchWorkerPool.h"
+#include <QMutexLocker>
+#include <QSemaphore>
+#include "logger/logger.h"
+#include "Repositories/ActivityEventRepository.h"
+#include "Repositories/AppUsageRepository.h"
+#include "Repositories/SystemMetricsRepository.h"
+#include "Repositories/SessionEventRepository.h"
+
+BatchWorkerPool::BatchWorkerPool(int workerCount)
+    : m_workerCount(qMax(1, workerCount))
+{
+}
+
+BatchWorkerPool::~BatchWorkerPool()
+{
+    stop();
+}
+
+bool BatchWorkerPool::start(const DbConfig& dbConfig)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_running) {
+        return true;
+    }
+
+    m_dbConfig = dbConfig;
+    m_stopping = false;
+
+    for (int i = 0; i < m_workerCount; ++i) {
+        QThread* thread = QThread::create([this, i]() { workerLoop(i); });
+        thread->start();
+        m_threads.append(thread);
+    }
+
+    m_running = true;
+    LOG_INFO(QString("BatchWorkerPool started with %1 workers").arg(m_workerCount));
+    return true;
+}
+
+void BatchWorkerPool::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_stopping = true;
+        m_tasksAvailable.wakeAll();
+    }
+
+    // Workers finish the tasks already queued so no runAll() caller is left waiting
+    for (QThread* thread : m_threads) {
+        thread->wait();
+        delete thread;
+    }
+    m_threads.clear();
+
+    QMutexLocker locker(&m_mutex);
+    m_running = false;
+    LOG_INFO("BatchWorkerPool stopped");
+}
+
+bool BatchWorkerPool::isRunning() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_running && !m_stopping;
+}
+
+void BatchWorkerPool::runAll(const QList<Task>& tasks)
+{
+    if (tasks.isEmpty()) {
+        return;
+    }
+
+    QSemaphore done;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const Task& task : tasks) {
+            m_tasks.enqueue(PendingTask{task, &done});
+        }
+        m_tasksAvailable.wakeAll();
+    }
+
+    done.acquire(tasks.size());
+}
+
+void BatchWorkerPool::workerLoop(int workerIndex)
+{
+    LOG_DEBUG(QString("Batch worker %1 started").arg(workerIndex));
+
+    // Connections are opened here so they belong to this thread
+    DbService<ActivityEventModel> activityEventService(m_dbConfig);
+    DbService<AppUsageModel> appUsageService(m_dbConfig);
+    DbService<SystemMetricsModel> systemMetricsService(m_dbConfig);
+    DbService<SessionEventModel> sessionEventService(m_dbConfig);
+
+    ActivityEventRepository activityEventRepository;
+    AppUsageRepository appUsageRepository;
+    SystemMetricsRepository systemMetricsRepository;
+    SessionEventRepository sessionEventRepository;
+    activityEventRepository.initialize(&activityEventService);
+    appUsageRepository.initialize(&appUsageService);
+    systemMetricsRepository.initialize(&systemMetricsService);
+    sessionEventRepository.initialize(&sessionEventService);
+
+    Repositories repositories;
+    repositories.activityEvents = &activityEventRepository;
+    repositories.appUsages = &appUsageRepository;
+    repositories.systemMetrics = &systemMetricsRepository;
+    repositories.sessionEvents = &sessionEventRepository;
+
+    while (true) {
+        PendingTask pending;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_stopping && m_tasks.isEmpty()) {
+                m_tasksAvailable.wait(&m_mutex);
+            }
+            if (m_tasks.isEmpty()) {
+                break;
+            }
+            pending = m_tasks.dequeue();
+        }
+
+        try {
+            pending.task(repositories);
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR(QString("Exception in batch worker %1: %2").arg(workerIndex).arg(e.what()));
+        }
+
+        pending.done->release();
+    }
+
+    LOG_DEBUG(QString("Batch worker %1 stopped").arg(workerIndex));
+}
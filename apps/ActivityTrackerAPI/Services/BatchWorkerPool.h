@@ -0,0 +1,68 @@
+#ifndef BATCHWORKERPOOL_H
+#define BATCHWORKERPOOL_H
+
+#include <QList>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
+#include <functional>
+#include "dbservice/dbconfig.h"
+
+class QSemaphore;
+class ActivityEventRepository;
+class AppUsageRepository;
+class SystemMetricsRepository;
+class SessionEventRepository;
+
+/**
+ * @brief Worker threads for writing the arrays of a synchronous batch in parallel
+ *
+ * A database connection can only be used by the thread that opened it. Each
+ * worker therefore opens its own connection per batch table and keeps it for
+ * the life of the pool. runAll() hands one task to each free worker and
+ * blocks until every task has finished.
+ */
+class BatchWorkerPool
+{
+public:
+    struct Repositories {
+        ActivityEventRepository* activityEvents = nullptr;
+        AppUsageRepository* appUsages = nullptr;
+        SystemMetricsRepository* systemMetrics = nullptr;
+        SessionEventRepository* sessionEvents = nullptr;
+    };
+
+    using Task = std::function<void(const Repositories&)>;
+
+    explicit BatchWorkerPool(int workerCount = 4);
+    ~BatchWorkerPool();
+
+    bool start(const DbConfig& dbConfig);
+    void stop();
+    bool isRunning() const;
+
+    // Run the tasks concurrently on the workers and wait for all of them
+    void runAll(const QList<Task>& tasks);
+
+private:
+    struct PendingTask {
+        Task task;
+        QSemaphore* done = nullptr;
+    };
+
+    void workerLoop(int workerIndex);
+
+    int m_workerCount;
+    DbConfig m_dbConfig;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_tasksAvailable;
+    QQueue<PendingTask> m_tasks;
+    bool m_stopping = false;
+    bool m_running = false;
+
+    QList<QThread*> m_threads;
+};
+
+#endif // BATCHWORKERPOOL_H
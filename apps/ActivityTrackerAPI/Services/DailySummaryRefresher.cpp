@@ -0,0 +1,114 @@
+#include "DailySummaryRefresher.h"
+#include <QDateTime>
+#include <QMutexLocker>
+#include "logger/logger.h"
+#include "Repositories/SessionRepository.h"
+
+namespace {
+
+const char* const TaskName = "daily_summary_refresh";
+
+}
+
+DailySummaryRefresher::DailySummaryRefresher(int intervalSeconds, int recentDays)
+    : m_intervalSeconds(qMax(1, intervalSeconds))
+    , m_recentDays(qMax(1, recentDays))
+{
+}
+
+DailySummaryRefresher::~DailySummaryRefresher()
+{
+    stop();
+}
+
+bool DailySummaryRefresher::start(const DbConfig& dbConfig)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_thread) {
+        return true;
+    }
+
+    m_dbConfig = dbConfig;
+    m_stopping = false;
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->start();
+
+    LOG_INFO(QString("DailySummaryRefresher started, refreshing the last %1 days every %2 seconds")
+             .arg(m_recentDays).arg(m_intervalSeconds));
+    return true;
+}
+
+void DailySummaryRefresher::stop()
+{
+    QThread* thread = nullptr;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_thread) {
+            return;
+        }
+        m_stopping = true;
+        m_wake.wakeAll();
+        thread = m_thread;
+        m_thread = nullptr;
+    }
+
+    thread->wait();
+    delete thread;
+    LOG_INFO("DailySummaryRefresher stopped");
+}
+
+void DailySummaryRefresher::run()
+{
+    // The connection is opened here so it belongs to this thread. The advisory
+    // lock is held by this connection, so it is released if the process dies.
+    DbService<SessionModel> sessionService(m_dbConfig);
+    SessionRepository sessionRepository;
+    sessionRepository.initialize(&sessionService);
+
+    while (true) {
+        runOnce(sessionService, sessionRepository);
+
+        QMutexLocker locker(&m_mutex);
+        if (!m_stopping) {
+            m_wake.wait(&m_mutex, static_cast<unsigned long>(m_intervalSeconds) * 1000);
+        }
+        if (m_stopping) {
+            break;
+        }
+    }
+}
+
+void DailySummaryRefresher::runOnce(DbService<SessionModel>& db, SessionRepository& sessionRepository)
+{
+    QMap<QString, QVariant> lockParams;
+    lockParams["task_name"] = TaskName;
+
+    bool locked = false;
+    int rows = db.executeVisitQuery("SELECT pg_try_advisory_lock(hashtext(:task_name)) AS locked", lockParams,
+                                    [&locked](const QSqlQuery& row) { locked = row.value("locked").toBool(); });
+    if (rows < 0) {
+        LOG_ERROR(QString("Daily summary refresh skipped, lock query failed: %1").arg(db.lastError()));
+        return;
+    }
+    if (!locked) {
+        LOG_DEBUG("Daily summary refresh skipped, another node is running it");
+        return;
+    }
+
+    const QDate today = QDateTime::currentDateTimeUtc().date();
+    const QDate fromDay = today.addDays(1 - m_recentDays);
+
+    int refreshed = sessionRepository.refreshDailySummaries(fromDay, today);
+    if (refreshed >= 0) {
+        LOG_DEBUG(QString("Refreshed %1 daily summaries from %2 to %3")
+                  .arg(refreshed)
+                  .arg(fromDay.toString(Qt::ISODate), today.toString(Qt::ISODate)));
+    }
+
+    refreshed = sessionRepository.refreshDirtyDailySummaries();
+    if (refreshed > 0) {
+        LOG_INFO(QString("Refreshed %1 daily summaries of days changed by late batches").arg(refreshed));
+    }
+
+    db.executeVisitQuery("SELECT pg_advisory_unlock(hashtext(:task_name))", lockParams, [](const QSqlQuery&) {});
+}
@@ -0,0 +1,45 @@
+#ifndef DAILYSUMMARYREFRESHER_H
+#define DAILYSUMMARYREFRESHER_H
+
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include "dbservice/dbconfig.h"
+#include "dbservice/dbservice.h"
+#include "Models/SessionModel.h"
+
+class SessionRepository;
+
+/**
+ * @brief Background thread that keeps user_daily_summaries current
+ *
+ * Each pass recomputes the last few UTC days, plus any older days that late
+ * batches changed, which the database notes in user_daily_summary_dirty_days.
+ * Several API nodes may share a database, so a pass only goes ahead on the
+ * node holding the advisory lock. The thread opens its own database
+ * connection, like the BatchWorkerPool workers.
+ */
+class DailySummaryRefresher
+{
+public:
+    explicit DailySummaryRefresher(int intervalSeconds = 300, int recentDays = 2);
+    ~DailySummaryRefresher();
+
+    bool start(const DbConfig& dbConfig);
+    void stop();
+
+private:
+    void run();
+    void runOnce(DbService<SessionModel>& db, SessionRepository& sessionRepository);
+
+    int m_intervalSeconds;
+    int m_recentDays;
+    DbConfig m_dbConfig;
+
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    bool m_stopping = false;
+    QThread* m_thread = nullptr;
+};
+
+#endif // DAILYSUMMARYREFRESHER_H
@@ -0,0 +1,244 @@
+#include "PartitionArchiver.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSqlField>
+#include <QSqlRecord>
+#include "logger/logger.h"
+#include "Services/ArchiveWriter.h"
+
+namespace {
+
+// Partitions named by create_partition_for_month(); the name is also what makes it safe to splice into SQL
+const QRegularExpression PartitionPattern(
+    "^(activity_events|system_metrics|app_usage|session_events)_y(\\d{4})m(\\d{2})$");
+
+ArchiveStore::ColumnKind columnKind(const QSqlField& field)
+{
+    switch (field.metaType().id()) {
+    case QMetaType::QDateTime:
+        return ArchiveStore::ColumnKind::Time;
+    case QMetaType::Bool:
+        return ArchiveStore::ColumnKind::Boolean;
+    case QMetaType::Short:
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+        return ArchiveStore::ColumnKind::Integer;
+    case QMetaType::Float:
+    case QMetaType::Double:
+        return ArchiveStore::ColumnKind::Double;
+    default:
+        break;
+    }
+
+    // Foreign keys and type names repeat heavily within a month
+    const QString name = field.name();
+    if (name.endsWith("_id") || name.endsWith("_type")) {
+        return ArchiveStore::ColumnKind::Dictionary;
+    }
+    return ArchiveStore::ColumnKind::Text;
+}
+
+} // namespace
+
+PartitionArchiver::PartitionArchiver(ArchiveStore* store, int fetchSize, int groupRows)
+    : m_store(store)
+    , m_fetchSize(qMax(100, fetchSize))
+    , m_groupRows(qMax(1000, groupRows))
+{
+}
+
+QStringList PartitionArchiver::archiveDetachedPartitions(DbService<SessionModel>& db)
+{
+    QStringList partitions;
+    db.executeVisitQuery(
+        "SELECT c.relname AS partition_name "
+        "FROM pg_class c "
+        "JOIN pg_namespace n ON n.oid = c.relnamespace "
+        "WHERE n.nspname = 'archive' AND c.relkind = 'r' "
+        "ORDER BY c.relname",
+        QMap<QString, QVariant>(),
+        [&partitions](const QSqlQuery& row) {
+            const QString name = row.value("partition_name").toString();
+            if (PartitionPattern.match(name).hasMatch()) {
+                partitions.append(name);
+            }
+        });
+
+    QStringList archived;
+    for (const QString& partition : partitions) {
+        if (archivePartition(db, partition)) {
+            archived.append(partition);
+        }
+    }
+    return archived;
+}
+
+bool PartitionArchiver::archivePartition(DbService<SessionModel>& db, const QString& partition)
+{
+    const QRegularExpressionMatch match = PartitionPattern.match(partition);
+    if (!match.hasMatch()) {
+        LOG_WARNING(QString("Not archiving %1, it is not a monthly partition").arg(partition));
+        return false;
+    }
+
+    const QString table = match.captured(1);
+    const QString timeColumn = ArchiveStore::timeColumn(table);
+    const QString relativePath = table + '/' + partition + ".tmsc";
+    const QString path = QDir(m_store->directory()).filePath(relativePath);
+
+    // Exported by an earlier run; dropped only once the file is known to hold every row
+    if (m_store->isArchived(partition)) {
+        return dropExported(db, partition, path);
+    }
+
+    const QString tempPath = path + ".tmp";
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSqlQuery shape = db.createQuery();
+    if (!shape.exec(QString("SELECT * FROM archive.%1 LIMIT 0").arg(partition))) {
+        LOG_ERROR(QString("Cannot read columns of archive.%1: %2").arg(partition, db.lastError()));
+        return false;
+    }
+
+    const QSqlRecord record = shape.record();
+    QList<ArchiveStore::Column> columns;
+    int sessionColumn = -1;
+    int timeIndex = -1;
+    for (int i = 0; i < record.count(); ++i) {
+        ArchiveStore::Column column;
+        column.name = record.fieldName(i);
+        column.kind = columnKind(record.field(i));
+        columns.append(column);
+        if (column.name == "session_id") {
+            sessionColumn = i;
+        } else if (column.name == timeColumn) {
+            timeIndex = i;
+        }
+    }
+
+    ArchiveWriter writer(tempPath, m_groupRows);
+    if (!writer.open(table, partition, columns)) {
+        LOG_ERROR(QString("Cannot create archive file %1: %2").arg(tempPath, writer.errorString()));
+        return false;
+    }
+
+    ArchiveStore::Partition entry;
+    entry.table = table;
+    entry.partition = partition;
+    entry.month = QDate(match.captured(2).toInt(), match.captured(3).toInt(), 1);
+    entry.file = relativePath;
+
+    bool ok = db.beginTransaction() &&
+              db.executeModificationQuery(
+                  QString("DECLARE archive_cursor NO SCROLL CURSOR FOR SELECT * FROM archive.%1 ORDER BY %2")
+                      .arg(partition, timeColumn),
+                  QMap<QString, QVariant>());
+
+    const QString fetchQuery = QString("FETCH FORWARD %1 FROM archive_cursor").arg(m_fetchSize);
+    while (ok) {
+        int rows = db.executeVisitQuery(fetchQuery, QMap<QString, QVariant>(), [&](const QSqlQuery& row) {
+            for (int i = 0; i < columns.size(); ++i) {
+                writer.addValue(i, row.value(i));
+            }
+            writer.endRow();
+            if (sessionColumn >= 0 && !row.isNull(sessionColumn)) {
+                entry.sessions.insert(row.value(sessionColumn).toString());
+            }
+            if (timeIndex >= 0 && !row.isNull(timeIndex)) {
+                const QDateTime time = row.value(timeIndex).toDateTime();
+                if (!entry.minTime.isValid()) {
+                    entry.minTime = time;
+                }
+                entry.maxTime = time;
+            }
+            entry.rows++;
+        });
+
+        if (rows < 0) {
+            ok = false;
+        } else if (rows == 0) {
+            break;
+        }
+    }
+
+    if (ok) {
+        db.executeModificationQuery("CLOSE archive_cursor", QMap<QString, QVariant>());
+        ok = db.commitTransaction();
+    } else {
+        db.rollbackTransaction();
+    }
+
+    if (!writer.finish() || !ok) {
+        LOG_ERROR(QString("Failed to export archive.%1: %2").arg(partition, ok ? writer.errorString() : db.lastError()));
+        QFile::remove(tempPath);
+        return false;
+    }
+
+    QFile::remove(path);
+    if (!QFile::rename(tempPath, path)) {
+        LOG_ERROR(QString("Cannot move archive file into place at %1").arg(path));
+        QFile::remove(tempPath);
+        return false;
+    }
+
+    // What reaches the manifest must read back complete
+    const int fileRows = m_store->visitFile(path, [](const ArchiveStore::Row&) {});
+    if (fileRows != entry.rows) {
+        LOG_ERROR(QString("Archive file %1 reads back %2 rows, exported %3; keeping archive.%4")
+                 .arg(path).arg(fileRows).arg(entry.rows).arg(partition));
+        QFile::remove(path);
+        return false;
+    }
+
+    entry.bytes = QFileInfo(path).size();
+    entry.archivedAt = QDateTime::currentDateTimeUtc();
+    if (!m_store->addPartition(entry)) {
+        return false;
+    }
+
+    LOG_INFO(QString("Archived %1: %2 rows, %3 sessions, %4 bytes")
+             .arg(partition)
+             .arg(entry.rows)
+             .arg(entry.sessions.size())
+             .arg(entry.bytes));
+
+    dropExported(db, partition, path);
+    return true;
+}
+
+bool PartitionArchiver::dropExported(DbService<SessionModel>& db, const QString& partition, const QString& path)
+{
+    // Only the node holding the maintenance lock wrote the file; other nodes can read it only
+    // if the directory is shared, so otherwise the table stays for them
+    if (!m_store->isShared()) {
+        LOG_DEBUG(QString("Keeping archive.%1, the archive directory is not shared between nodes").arg(partition));
+        return false;
+    }
+
+    qint64 tableRows = -1;
+    int rows = db.executeVisitQuery(QString("SELECT COUNT(*) AS row_count FROM archive.%1").arg(partition),
+                                    QMap<QString, QVariant>(),
+                                    [&tableRows](const QSqlQuery& row) { tableRows = row.value("row_count").toLongLong(); });
+    if (rows < 0) {
+        LOG_ERROR(QString("Cannot count rows of archive.%1: %2").arg(partition, db.lastError()));
+        return false;
+    }
+
+    const int fileRows = m_store->visitFile(path, [](const ArchiveStore::Row&) {});
+    if (fileRows != tableRows) {
+        LOG_ERROR(QString("Not dropping archive.%1: it has %2 rows, %3 holds %4")
+                 .arg(partition).arg(tableRows).arg(path).arg(fileRows));
+        return false;
+    }
+
+    LOG_WARNING(QString("Dropping archive.%1, its %2 rows are in %3").arg(partition).arg(tableRows).arg(path));
+    if (!db.executeModificationQuery(QString("DROP TABLE archive.%1").arg(partition), QMap<QString, QVariant>())) {
+        LOG_ERROR(QString("Exported archive.%1 but could not drop it: %2").arg(partition, db.lastError()));
+        return false;
+    }
+    return true;
+}
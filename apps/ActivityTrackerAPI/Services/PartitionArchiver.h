@@ -0,0 +1,38 @@
+#ifndef PARTITIONARCHIVER_H
+#define PARTITIONARCHIVER_H
+
+#include <QStringList>
+#include "dbservice/dbservice.h"
+#include "Models/SessionModel.h"
+#include "Services/ArchiveStore.h"
+
+/**
+ * @brief Exports partitions detached into the archive schema to an ArchiveStore
+ *
+ * Each partition is read through a server-side cursor in time order, written
+ * to a columnar file, read back to check its row count, and added to the
+ * manifest. It is dropped from the database only when the archive directory
+ * is shared between API nodes, and only after the file is read back again and
+ * matched against the table's row count. A partition whose export fails stays
+ * in the archive schema and is retried on the next maintenance run.
+ */
+class PartitionArchiver
+{
+public:
+    explicit PartitionArchiver(ArchiveStore* store, int fetchSize = 10000, int groupRows = 65536);
+
+    // Export every partition in the archive schema, dropping them if the store is shared;
+    // returns the partitions exported or dropped
+    QStringList archiveDetachedPartitions(DbService<SessionModel>& db);
+
+    bool archivePartition(DbService<SessionModel>& db, const QString& partition);
+
+private:
+    bool dropExported(DbService<SessionModel>& db, const QString& partition, const QString& path);
+
+    ArchiveStore* m_store;
+    int m_fetchSize;
+    int m_groupRows;
+};
+
+#endif // PARTITIONARCHIVER_H
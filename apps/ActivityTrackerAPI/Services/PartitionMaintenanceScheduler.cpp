@@ -0,0 +1,317 @@
+#include "PartitionMaintenanceScheduler.h"
+#include <QDateTime>
+#include <QHash>
+#include <QMutexLocker>
+#include <QSet>
+#include <QUuid>
+#include "logger/logger.h"
+#include "Services/PartitionArchiver.h"
+
+namespace {
+
+const char* const TaskName = "partition_maintenance";
+
+// Tables whose raw rows can be compacted, and the SQL function compacting one partition
+const QHash<QString, QString> CompactionFunctions = {
+    { "activity_events", "compact_activity_events_partition" }
+};
+
+// Postgres text[] literal for maintenance_history.affected_partitions
+QString toTextArray(const QStringList& values)
+{
+    QStringList quoted;
+    for (const QString& value : values) {
+        quoted.append('"' + value + '"');
+    }
+    return '{' + quoted.join(',') + '}';
+}
+
+} // namespace
+
+PartitionMaintenanceScheduler::PartitionMaintenanceScheduler(int intervalHours, int monthsToKeep)
+    : m_intervalHours(qMax(1, intervalHours))
+    , m_monthsToKeep(qMax(0, monthsToKeep))
+{
+}
+
+void PartitionMaintenanceScheduler::setRetentionDays(const QHash<QString, int>& retentionDays)
+{
+    for (auto it = retentionDays.constBegin(); it != retentionDays.constEnd(); ++it) {
+        if (!CompactionFunctions.contains(it.key())) {
+            LOG_WARNING(QString("No compaction is defined for table %1, its retention setting is ignored").arg(it.key()));
+        }
+    }
+    m_retentionDays = retentionDays;
+}
+
+PartitionMaintenanceScheduler::~PartitionMaintenanceScheduler()
+{
+    stop();
+}
+
+bool PartitionMaintenanceScheduler::start(const DbConfig& dbConfig)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_thread) {
+        return true;
+    }
+
+    m_dbConfig = dbConfig;
+    m_stopping = false;
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->start();
+
+    if (m_monthsToKeep > 0) {
+        LOG_INFO(QString("PartitionMaintenanceScheduler started, running every %1 hours and detaching partitions older than %2 months")
+                 .arg(m_intervalHours).arg(m_monthsToKeep));
+    } else {
+        LOG_INFO(QString("PartitionMaintenanceScheduler started, running every %1 hours and keeping all partitions")
+                 .arg(m_intervalHours));
+    }
+    return true;
+}
+
+void PartitionMaintenanceScheduler::stop()
+{
+    QThread* thread = nullptr;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_thread) {
+            return;
+        }
+        m_stopping = true;
+        m_wake.wakeAll();
+        thread = m_thread;
+        m_thread = nullptr;
+    }
+
+    thread->wait();
+    delete thread;
+    LOG_INFO("PartitionMaintenanceScheduler stopped");
+}
+
+void PartitionMaintenanceScheduler::run()
+{
+    // The connection is opened here so it belongs to this thread. The advisory
+    // lock is held by this connection, so it is released if the process dies.
+    DbService<SessionModel> db(m_dbConfig);
+
+    while (true) {
+        runOnce(db);
+
+        QMutexLocker locker(&m_mutex);
+        if (!m_stopping) {
+            m_wake.wait(&m_mutex, static_cast<unsigned long>(m_intervalHours) * 3600 * 1000);
+        }
+        if (m_stopping) {
+            break;
+        }
+    }
+}
+
+QStringList PartitionMaintenanceScheduler::listPartitions(DbService<SessionModel>& db)
+{
+    QStringList partitions;
+    db.executeVisitQuery(
+        "SELECT c.relname AS partition_name "
+        "FROM pg_inherits i "
+        "JOIN pg_class c ON c.oid = i.inhrelid "
+        "JOIN pg_class p ON p.oid = i.inhparent "
+        "JOIN pg_namespace n ON n.oid = p.relnamespace "
+        "WHERE n.nspname = 'public' "
+        "AND p.relname IN ('activity_events', 'system_metrics', 'app_usage', 'session_events')",
+        QMap<QString, QVariant>(),
+        [&partitions](const QSqlQuery& row) {
+            partitions.append(row.value("partition_name").toString());
+        });
+    return partitions;
+}
+
+QStringList PartitionMaintenanceScheduler::partitionsToDetach(const QStringList& partitions) const
+{
+    // Same cutoff as detach_old_partitions(): months before the first of the month monthsToKeep ago
+    const QDate monthAgo = QDate::currentDate().addMonths(-m_monthsToKeep);
+    const QDate cutoff(monthAgo.year(), monthAgo.month(), 1);
+
+    QStringList detached;
+    for (const QString& partition : partitions) {
+        const QDate month = QDate::fromString(partition.section("_y", -1) + "d01", "yyyy'm'MM'd'dd");
+        if (month.isValid() && month < cutoff) {
+            detached.append(partition);
+        }
+    }
+    detached.sort();
+    return detached;
+}
+
+void PartitionMaintenanceScheduler::runOnce(DbService<SessionModel>& db)
+{
+    QMap<QString, QVariant> lockParams;
+    lockParams["task_name"] = TaskName;
+
+    bool locked = false;
+    int rows = db.executeVisitQuery("SELECT pg_try_advisory_lock(hashtext(:task_name)) AS locked", lockParams,
+                                    [&locked](const QSqlQuery& row) { locked = row.value("locked").toBool(); });
+    if (rows < 0) {
+        LOG_ERROR(QString("Partition maintenance skipped, lock query failed: %1").arg(db.lastError()));
+        return;
+    }
+    if (!locked) {
+        LOG_INFO("Partition maintenance skipped, another node is running it");
+        return;
+    }
+
+    maintainPartitions(db);
+    compactExpiredRows(db);
+
+    db.executeVisitQuery("SELECT pg_advisory_unlock(hashtext(:task_name))", lockParams, [](const QSqlQuery&) {});
+}
+
+QString PartitionMaintenanceScheduler::beginHistory(DbService<SessionModel>& db, const QString& taskName)
+{
+    const QString runId = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    QMap<QString, QVariant> historyParams;
+    historyParams["id"] = runId;
+    historyParams["task_name"] = taskName;
+    historyParams["start_time"] = QDateTime::currentDateTimeUtc();
+    db.executeModificationQuery(
+        "INSERT INTO maintenance_history (id, task_name, start_time, status) "
+        "VALUES (:id, :task_name, :start_time, 'running')",
+        historyParams);
+    return runId;
+}
+
+void PartitionMaintenanceScheduler::finishHistory(DbService<SessionModel>& db, const QString& runId,
+                                                  const QString& error, const QStringList& affected)
+{
+    QMap<QString, QVariant> resultParams;
+    resultParams["id"] = runId;
+    resultParams["end_time"] = QDateTime::currentDateTimeUtc();
+    resultParams["status"] = error.isEmpty() ? "completed" : "failed";
+    resultParams["error_message"] = error.isEmpty() ? QVariant(QVariant::Invalid) : error;
+    resultParams["affected_partitions"] = toTextArray(affected);
+    db.executeModificationQuery(
+        "UPDATE maintenance_history SET "
+        "end_time = :end_time, "
+        "status = :status, "
+        "error_message = :error_message, "
+        "affected_partitions = CAST(:affected_partitions AS text[]) "
+        "WHERE id = :id",
+        resultParams);
+}
+
+void PartitionMaintenanceScheduler::maintainPartitions(DbService<SessionModel>& db)
+{
+    const QString runId = beginHistory(db, TaskName);
+    const QStringList before = listPartitions(db);
+
+    QMap<QString, QVariant> detachParams;
+    detachParams["months_to_keep"] = m_monthsToKeep;
+
+    QString error;
+    if (db.executeVisitQuery("SELECT create_future_partitions()", QMap<QString, QVariant>(),
+                             [](const QSqlQuery&) {}) < 0) {
+        error = QString("create_future_partitions failed: %1").arg(db.lastError());
+    } else if (m_monthsToKeep > 0) {
+        const QStringList detaching = partitionsToDetach(before);
+        if (!detaching.isEmpty()) {
+            LOG_WARNING(QString("Detaching %1 partitions older than %2 months: %3")
+                       .arg(detaching.size())
+                       .arg(m_monthsToKeep)
+                       .arg(detaching.join(", ")));
+            if (db.executeVisitQuery("SELECT detach_old_partitions(:months_to_keep)", detachParams,
+                                     [](const QSqlQuery&) {}) < 0) {
+                error = QString("detach_old_partitions failed: %1").arg(db.lastError());
+            }
+        }
+    }
+
+    // Exported partitions are dropped, so they are listed here rather than by the diff below
+    QStringList exported;
+    if (error.isEmpty() && m_archiveStore) {
+        PartitionArchiver archiver(m_archiveStore);
+        exported = archiver.archiveDetachedPartitions(db);
+    }
+
+    const QStringList after = listPartitions(db);
+    const QSet<QString> beforeSet(before.begin(), before.end());
+    const QSet<QString> afterSet(after.begin(), after.end());
+
+    QStringList affected;
+    for (const QString& name : after) {
+        if (!beforeSet.contains(name)) {
+            affected.append("created:" + name);
+        }
+    }
+    for (const QString& name : before) {
+        if (!afterSet.contains(name)) {
+            affected.append("archived:" + name);
+        }
+    }
+    for (const QString& name : exported) {
+        affected.append("exported:" + name);
+    }
+
+    finishHistory(db, runId, error, affected);
+
+    if (error.isEmpty()) {
+        LOG_INFO(QString("Partition maintenance completed, %1 partitions changed").arg(affected.size()));
+    } else {
+        LOG_ERROR(QString("Partition maintenance failed: %1").arg(error));
+    }
+}
+
+void PartitionMaintenanceScheduler::compactExpiredRows(DbService<SessionModel>& db)
+{
+    for (auto it = m_retentionDays.constBegin(); it != m_retentionDays.constEnd(); ++it) {
+        const QString& table = it.key();
+        const int days = it.value();
+        if (days <= 0 || !CompactionFunctions.contains(table)) {
+            continue;
+        }
+
+        // Whole days, so a compacted minute is never split across two runs
+        const QDateTime before(QDateTime::currentDateTimeUtc().date().addDays(-days), QTime(0, 0), Qt::UTC);
+        const QString runId = beginHistory(db, table + "_compaction");
+
+        QStringList partitions;
+        for (const QString& partition : listPartitions(db)) {
+            if (partition.startsWith(table + "_y")) {
+                partitions.append(partition);
+            }
+        }
+        partitions.sort();
+
+        QString error;
+        QStringList affected;
+        qint64 removed = 0;
+        for (const QString& partition : partitions) {
+            QMap<QString, QVariant> params;
+            params["partition"] = partition;
+            params["before"] = before;
+
+            // Each partition commits on its own, so a failure keeps the partitions already compacted
+            qint64 partitionRows = 0;
+            int rows = db.executeVisitQuery(
+                QString("SELECT %1(:partition, :before) AS removed").arg(CompactionFunctions.value(table)),
+                params,
+                [&partitionRows](const QSqlQuery& row) { partitionRows = row.value("removed").toLongLong(); });
+            if (rows < 0) {
+                error = QString("Compacting %1 failed: %2").arg(partition, db.lastError());
+                break;
+            }
+            if (partitionRows > 0) {
+                affected.append(QString("compacted:%1:%2").arg(partition).arg(partitionRows));
+                removed += partitionRows;
+            }
+        }
+
+        finishHistory(db, runId, error, affected);
+
+        if (error.isEmpty()) {
+            LOG_INFO(QString("Compacted %1 %2 rows older than %3 days").arg(removed).arg(table).arg(days));
+        } else {
+            LOG_ERROR(error);
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef PARTITIONMAINTENANCESCHEDULER_H
+#define PARTITIONMAINTENANCESCHEDULER_H
+
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QThread>
+#include <QWaitCondition>
+#include "dbservice/dbconfig.h"
+#include "dbservice/dbservice.h"
+#include "Models/SessionModel.h"
+
+class ArchiveStore;
+
+/**
+ * @brief Background thread that runs the partition maintenance functions
+ *
+ * Each run calls create_future_partitions(), which creates the partitions for
+ * the coming months. With monthsToKeep set, detach_old_partitions() then moves
+ * partitions older than that to the archive schema; by default nothing is
+ * detached, since reports read months back. The run is recorded in
+ * maintenance_history. Several API nodes may share a database, so a run
+ * only goes ahead on the node holding the advisory lock.
+ *
+ * With an ArchiveStore set, partitions in the archive schema are then exported
+ * to it and dropped from the database.
+ *
+ * Tables with a retention period have their older raw rows compacted into
+ * summary tables and removed, one partition at a time.
+ */
+class PartitionMaintenanceScheduler
+{
+public:
+    // monthsToKeep 0 never detaches partitions
+    explicit PartitionMaintenanceScheduler(int intervalHours = 6, int monthsToKeep = 0);
+    ~PartitionMaintenanceScheduler();
+
+    // Call before start()
+    void setArchiveStore(ArchiveStore* archiveStore) { m_archiveStore = archiveStore; }
+
+    // Days of raw rows to keep per table before compaction, 0 to keep them; call before start()
+    void setRetentionDays(const QHash<QString, int>& retentionDays);
+
+    bool start(const DbConfig& dbConfig);
+    void stop();
+
+private:
+    void run();
+    void runOnce(DbService<SessionModel>& db);
+    void maintainPartitions(DbService<SessionModel>& db);
+    void compactExpiredRows(DbService<SessionModel>& db);
+    QString beginHistory(DbService<SessionModel>& db, const QString& taskName);
+    void finishHistory(DbService<SessionModel>& db, const QString& runId, const QString& error,
+                       const QStringList& affected);
+    QStringList listPartitions(DbService<SessionModel>& db);
+    QStringList partitionsToDetach(const QStringList& partitions) const;
+
+    int m_intervalHours;
+    int m_monthsToKeep;
+    DbConfig m_dbConfig;
+    ArchiveStore* m_archiveStore = nullptr;
+    QHash<QString, int> m_retentionDays;
+
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    bool m_stopping = false;
+    QThread* m_thread = nullptr;
+};
+
+#endif // PARTITIONMAINTENANCESCHEDULER_H
@@ -0,0 +1,107 @@
+#include "IsoDateTime.h"
+
+namespace IsoDateTime {
+
+namespace {
+
+inline bool readDigits(const QChar *data, int count, int &value)
+{
+    value = 0;
+    for (int i = 0; i < count; ++i) {
+        const char16_t c = data[i].unicode();
+        if (c < u'0' || c > u'9') {
+            return false;
+        }
+        value = value * 10 + (c - u'0');
+    }
+    return true;
+}
+
+// Days since 1970-01-01 in the proleptic Gregorian calendar
+inline qint64 daysFromCivil(int year, int month, int day)
+{
+    year -= month <= 2;
+    const qint64 era = (year >= 0 ? year : year - 399) / 400;
+    const int yearOfEra = year - static_cast<int>(era * 400);
+    const int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+} // namespace
+
+QDateTime parse(const QString &text)
+{
+    const int length = text.size();
+    const QChar *data = text.constData();
+
+    // yyyy-MM-ddTHH:mm:ss is the shortest form handled here
+    if (length < 19 || data[4] != u'-' || data[7] != u'-' ||
+        (data[10] != u'T' && data[10] != u' ') || data[13] != u':' || data[16] != u':') {
+        return QDateTime::fromString(text, Qt::ISODate);
+    }
+
+    int year, month, day, hour, minute, second;
+    if (!readDigits(data, 4, year) || !readDigits(data + 5, 2, month) || !readDigits(data + 8, 2, day) ||
+        !readDigits(data + 11, 2, hour) || !readDigits(data + 14, 2, minute) || !readDigits(data + 17, 2, second) ||
+        !QDate::isValid(year, month, day) || hour > 23 || minute > 59 || second > 59) {
+        return QDateTime::fromString(text, Qt::ISODate);
+    }
+
+    int pos = 19;
+
+    // Fraction: keep milliseconds, ignore finer digits
+    int msec = 0;
+    if (pos < length && (data[pos] == u'.' || data[pos] == u',')) {
+        ++pos;
+        int digits = 0;
+        while (pos < length && data[pos].isDigit()) {
+            if (digits < 3) {
+                msec = msec * 10 + data[pos].digitValue();
+            }
+            ++digits;
+            ++pos;
+        }
+        if (digits == 0) {
+            return QDateTime::fromString(text, Qt::ISODate);
+        }
+        for (; digits < 3; ++digits) {
+            msec *= 10;
+        }
+    }
+
+    if (pos == length) {
+        return QDateTime(QDate(year, month, day), QTime(hour, minute, second, msec));
+    }
+
+    int offsetMinutes = 0;
+    if (data[pos] == u'Z' && pos + 1 == length) {
+        // UTC
+    } else if (data[pos] == u'+' || data[pos] == u'-') {
+        const int sign = data[pos] == u'-' ? -1 : 1;
+        const int rest = length - pos - 1;
+        int offsetHours = 0;
+        int offsetMins = 0;
+        bool ok = false;
+        if (rest == 5 && data[pos + 3] == u':') {
+            ok = readDigits(data + pos + 1, 2, offsetHours) && readDigits(data + pos + 4, 2, offsetMins);
+        } else if (rest == 4) {
+            ok = readDigits(data + pos + 1, 2, offsetHours) && readDigits(data + pos + 3, 2, offsetMins);
+        } else if (rest == 2) {
+            ok = readDigits(data + pos + 1, 2, offsetHours);
+        }
+        if (!ok || offsetHours > 23 || offsetMins > 59) {
+            return QDateTime::fromString(text, Qt::ISODate);
+        }
+        offsetMinutes = sign * (offsetHours * 60 + offsetMins);
+    } else {
+        return QDateTime::fromString(text, Qt::ISODate);
+    }
+
+    const qint64 msecsSinceEpoch = daysFromCivil(year, month, day) * 86400000LL
+                                   + ((hour * 60 + minute - offsetMinutes) * 60LL + second) * 1000LL
+                                   + msec;
+    return QDateTime::fromMSecsSinceEpoch(msecsSinceEpoch, Qt::UTC);
+}
+
+} // namespace IsoDateTime
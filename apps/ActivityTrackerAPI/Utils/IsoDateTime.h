@@ -0,0 +1,21 @@
+#ifndef ISODATETIME_H
+#define ISODATETIME_H
+
+#include <QDateTime>
+#include <QString>
+
+namespace IsoDateTime {
+
+/**
+ * @brief Parse the ISO-8601 timestamps agents send without going through QDateTime::fromString
+ *
+ * Handles yyyy-MM-ddTHH:mm:ss with an optional fraction and an optional Z,
+ * ±HH:mm or ±HHmm suffix. Times with a zone come back in UTC; times without one
+ * are local, as with Qt::ISODate. Other forms are passed to
+ * QDateTime::fromString(text, Qt::ISODate).
+ */
+QDateTime parse(const QString &text);
+
+} // namespace IsoDateTime
+
+#endif // ISODATETIME_H
@@ -0,0 +1,199 @@
+#include <QtTest/QtTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QUuid>
+
+#include "batchcbor/batchcbor.h"
+#include "logger/logger.h"
+#include "Core/ModelFactory.h"
+#include "Models/ActivityEventModel.h"
+#include "Models/EventTypes.h"
+#include "Utils/IsoDateTime.h"
+
+namespace {
+
+// The string comparison chain ModelFactory used before the shared lookup table
+EventTypes::ActivityEventType ifChainEventType(const QString &eventTypeStr)
+{
+    if (eventTypeStr == "mouse_move") {
+        return EventTypes::ActivityEventType::MouseMove;
+    } else if (eventTypeStr == "keyboard") {
+        return EventTypes::ActivityEventType::Keyboard;
+    } else if (eventTypeStr == "afk_start") {
+        return EventTypes::ActivityEventType::AfkStart;
+    } else if (eventTypeStr == "afk_end") {
+        return EventTypes::ActivityEventType::AfkEnd;
+    } else if (eventTypeStr == "app_focus") {
+        return EventTypes::ActivityEventType::AppFocus;
+    } else if (eventTypeStr == "app_unfocus") {
+        return EventTypes::ActivityEventType::AppUnfocus;
+    }
+    return EventTypes::ActivityEventType::MouseClick;
+}
+
+} // namespace
+
+/**
+ * @brief Measures decoding a 10k-event activity batch
+ *
+ * Compares the old per-row work (string comparison chain, QDateTime::fromString)
+ * with the lookup table and IsoDateTime::parse, times building the models
+ * for the whole batch, and times parsing the request body as JSON and as CBOR.
+ */
+class BatchDecodeBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_tempDir.isValid());
+        Logger::instance()->enableConsoleOutput(false);
+        Logger::instance()->setLogFile(m_tempDir.filePath("benchmark.log"));
+        Logger::instance()->setLogLevel(Logger::Warning);
+
+        const QStringList types = {"mouse_click", "mouse_move", "keyboard", "afk_start",
+                                   "afk_end", "app_focus", "app_unfocus"};
+        const QString appId = QUuid::createUuid().toString(QUuid::WithoutBraces);
+        QDateTime time = QDateTime::currentDateTimeUtc().addDays(-1);
+
+        for (int i = 0; i < EventCount; ++i) {
+            time = time.addMSecs(250 + (i % 7) * 113);
+
+            QJsonObject row;
+            row["event_type"] = types[i % types.size()];
+            row["event_time"] = time.toString(Qt::ISODateWithMs);
+            row["app_id"] = appId;
+            row["client_seq"] = i;
+            row["event_data"] = QJsonObject{{"x", i % 1920}, {"y", i % 1080}};
+            m_rows.append(row);
+
+            m_types.append(row["event_type"].toString());
+            m_times.append(row["event_time"].toString());
+        }
+
+        m_sessionId = QUuid::createUuid();
+        m_userId = QUuid::createUuid();
+
+        QJsonObject batch;
+        batch["session_id"] = m_sessionId.toString(QUuid::WithoutBraces);
+        batch["activity_events"] = m_rows;
+        m_jsonBody = QJsonDocument(batch).toJson(QJsonDocument::Compact);
+        m_cborBody = BatchCbor::encode(batch);
+        qInfo("Batch body: JSON %lld bytes, CBOR %lld bytes",
+              static_cast<long long>(m_jsonBody.size()), static_cast<long long>(m_cborBody.size()));
+    }
+
+    void lookupMatchesIfChain() {
+        for (const QString &type : m_types) {
+            EventTypes::ActivityEventType fromTable = EventTypes::ActivityEventType::MouseClick;
+            QVERIFY(EventTypes::activityEventTypeFromString(type, fromTable));
+            QCOMPARE(fromTable, ifChainEventType(type));
+            QCOMPARE(EventTypes::activityEventTypeToString(fromTable), type);
+        }
+    }
+
+    void fastParseMatchesQt() {
+        const QStringList samples = {
+            "2026-03-01T08:15:30Z", "2026-03-01T08:15:30.123Z", "2026-03-01T08:15:30.1234567Z",
+            "2026-03-01T08:15:30+02:00", "2026-03-01T08:15:30-0530", "2026-03-01T08:15:30",
+            "2024-02-29T23:59:59.999Z", "2026-02-30T08:15:30Z", "not a time"
+        };
+        for (const QString &sample : samples + m_times.mid(0, 100)) {
+            QDateTime expected = QDateTime::fromString(sample, Qt::ISODate);
+            QDateTime actual = IsoDateTime::parse(sample);
+            QCOMPARE(actual.isValid(), expected.isValid());
+            if (expected.isValid()) {
+                QCOMPARE(actual.toMSecsSinceEpoch(), expected.toMSecsSinceEpoch());
+            }
+        }
+    }
+
+    void eventTypeIfChain() {
+        int sum = 0;
+        QBENCHMARK {
+            for (const QString &type : m_types) {
+                sum += static_cast<int>(ifChainEventType(type));
+            }
+        }
+        QVERIFY(sum >= 0);
+    }
+
+    void eventTypeLookup() {
+        int sum = 0;
+        QBENCHMARK {
+            for (const QString &type : m_types) {
+                EventTypes::ActivityEventType eventType = EventTypes::ActivityEventType::MouseClick;
+                EventTypes::activityEventTypeFromString(type, eventType);
+                sum += static_cast<int>(eventType);
+            }
+        }
+        QVERIFY(sum >= 0);
+    }
+
+    void isoParseQt() {
+        qint64 sum = 0;
+        QBENCHMARK {
+            for (const QString &time : m_times) {
+                sum += QDateTime::fromString(time, Qt::ISODate).toMSecsSinceEpoch();
+            }
+        }
+        QVERIFY(sum != 0);
+    }
+
+    void isoParseFast() {
+        qint64 sum = 0;
+        QBENCHMARK {
+            for (const QString &time : m_times) {
+                sum += IsoDateTime::parse(time).toMSecsSinceEpoch();
+            }
+        }
+        QVERIFY(sum != 0);
+    }
+
+    void buildActivityEvents() {
+        const QDateTime receivedAt = QDateTime::currentDateTimeUtc();
+        QBENCHMARK {
+            for (const QJsonValue &row : m_rows) {
+                QString error;
+                delete ModelFactory::createActivityEventFromBatch(row.toObject(), m_sessionId, m_userId,
+                                                                  receivedAt, error);
+            }
+        }
+    }
+
+    void parseJsonBody() {
+        qsizetype rows = 0;
+        QBENCHMARK {
+            rows += QJsonDocument::fromJson(m_jsonBody).object()["activity_events"].toArray().size();
+        }
+        QVERIFY(rows > 0);
+    }
+
+    void decodeCborBody() {
+        qsizetype rows = 0;
+        QBENCHMARK {
+            QJsonObject batch;
+            QString error;
+            BatchCbor::decode(m_cborBody, batch, error);
+            rows += batch["activity_events"].toArray().size();
+        }
+        QVERIFY(rows > 0);
+    }
+
+private:
+    static constexpr int EventCount = 10000;
+
+    QTemporaryDir m_tempDir;
+    QJsonArray m_rows;
+    QStringList m_types;
+    QStringList m_times;
+    QUuid m_sessionId;
+    QUuid m_userId;
+    QByteArray m_jsonBody;
+    QByteArray m_cborBody;
+};
+
+QTEST_GUILESS_MAIN(BatchDecodeBenchmark)
+#include "BatchDecodeBenchmark.moc"
@@ -0,0 +1,107 @@
+-- Query plans for the app_usage and session_events repository queries on one month of
+-- generated data, with the indexes create_partition_for_month used to build and with the
+-- ones it builds now.
+--
+-- Run against a database that has Database/schema.sql loaded:
+--   psql -d activity_tracker -f benchmarks/partition_index_plans.sql
+--
+-- Everything is created in the plan_bench schema, which is dropped at the end.
+
+\set sessions 2000
+\set app_rows_per_session 400
+\set event_rows_per_session 20
+
+DROP SCHEMA IF EXISTS plan_bench CASCADE;
+CREATE SCHEMA plan_bench;
+
+-- create_partition_for_month() resolves table names through the search path, so it builds
+-- the partitions in plan_bench
+SET search_path = plan_bench, public;
+
+CREATE TABLE plan_bench.app_usage (
+    id uuid DEFAULT gen_random_uuid(),
+    session_id uuid,
+    app_id uuid,
+    start_time TIMESTAMP NOT NULL,
+    end_time TIMESTAMP,
+    is_active BOOLEAN DEFAULT true,
+    window_title TEXT,
+    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL,
+    updated_at TIMESTAMP NOT NULL
+) PARTITION BY RANGE (start_time);
+
+CREATE TABLE plan_bench.session_events (
+    id uuid DEFAULT gen_random_uuid(),
+    session_id uuid,
+    event_type session_event_type NOT NULL,
+    event_time TIMESTAMP NOT NULL,
+    user_id uuid,
+    machine_id uuid,
+    is_remote BOOLEAN DEFAULT false,
+    event_data JSONB DEFAULT '{}',
+    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL,
+    updated_at TIMESTAMP NOT NULL
+) PARTITION BY RANGE (event_time);
+
+-- The partitions as the previous create_partition_for_month() left them: created_at only
+CREATE TABLE plan_bench.app_usage_y2025m01 PARTITION OF plan_bench.app_usage
+    FOR VALUES FROM ('2025-01-01') TO ('2025-02-01');
+CREATE INDEX app_usage_y2025m01_created_at_idx ON plan_bench.app_usage_y2025m01 (created_at);
+
+CREATE TABLE plan_bench.session_events_y2025m01 PARTITION OF plan_bench.session_events
+    FOR VALUES FROM ('2025-01-01') TO ('2025-02-01');
+CREATE INDEX session_events_y2025m01_created_at_idx ON plan_bench.session_events_y2025m01 (created_at);
+
+CREATE TABLE plan_bench.session_ids AS
+SELECT gen_random_uuid() AS session_id,
+       timestamp '2025-01-01' + (n % 31) * interval '1 day' + interval '8 hours' AS login_time,
+       n
+FROM generate_series(1, :sessions) AS n;
+
+-- Rows are inserted in time order, the way the batch endpoint writes them
+INSERT INTO plan_bench.app_usage (session_id, app_id, start_time, end_time, is_active, window_title, updated_at)
+SELECT s.session_id,
+       md5((r % 25)::text)::uuid,
+       s.login_time + r * interval '70 seconds',
+       CASE WHEN r = :app_rows_per_session THEN NULL ELSE s.login_time + (r + 1) * interval '70 seconds' END,
+       r = :app_rows_per_session,
+       'window ' || r,
+       s.login_time
+FROM plan_bench.session_ids s
+         CROSS JOIN generate_series(1, :app_rows_per_session) AS r
+ORDER BY s.login_time + r * interval '70 seconds';
+
+INSERT INTO plan_bench.session_events (session_id, event_type, event_time, updated_at)
+SELECT s.session_id,
+       CASE WHEN r % 2 = 1 THEN 'login'::session_event_type ELSE 'logout'::session_event_type END,
+       s.login_time + r * interval '20 minutes',
+       s.login_time
+FROM plan_bench.session_ids s
+         CROSS JOIN generate_series(1, :event_rows_per_session) AS r
+ORDER BY s.login_time + r * interval '20 minutes';
+
+ANALYZE plan_bench.app_usage;
+ANALYZE plan_bench.session_events;
+
+SELECT session_id AS bench_session FROM plan_bench.session_ids WHERE n = :sessions / 2 \gset
+
+\echo '=== Before: created_at index only ==='
+\i benchmarks/partition_index_queries.sql
+
+-- Build the indexes the current function adds; the partitions already exist
+SELECT create_partition_for_month('app_usage', date '2025-01-01');
+SELECT create_partition_for_month('session_events', date '2025-01-01');
+ANALYZE plan_bench.app_usage;
+ANALYZE plan_bench.session_events;
+
+\echo '=== After: session and BRIN indexes ==='
+\i benchmarks/partition_index_queries.sql
+
+SELECT c.relname AS index_name, pg_size_pretty(pg_relation_size(c.oid)) AS size
+FROM pg_class c
+         JOIN pg_namespace n ON n.oid = c.relnamespace
+WHERE n.nspname = 'plan_bench' AND c.relkind = 'i'
+ORDER BY c.relname;
+
+RESET search_path;
+DROP SCHEMA plan_bench CASCADE;
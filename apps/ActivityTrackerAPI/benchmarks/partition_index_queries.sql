@@ -0,0 +1,25 @@
+-- Repository queries planned by partition_index_plans.sql; expects :'bench_session'
+
+\echo '--- AppUsageRepository::getBySessionId'
+EXPLAIN (ANALYZE, BUFFERS, COSTS OFF)
+SELECT * FROM app_usage WHERE session_id = :'bench_session' ORDER BY start_time DESC;
+
+\echo '--- AppUsageRepository::getActiveAppUsages'
+EXPLAIN (ANALYZE, BUFFERS, COSTS OFF)
+SELECT * FROM app_usage WHERE session_id = :'bench_session' AND is_active = true ORDER BY start_time DESC;
+
+\echo '--- AppUsageRepository::getTopApps (open rows)'
+EXPLAIN (ANALYZE, BUFFERS, COSTS OFF)
+SELECT app_id, COUNT(*) FROM app_usage WHERE session_id = :'bench_session' AND end_time IS NULL GROUP BY app_id;
+
+\echo '--- SessionEventRepository::getBySessionId'
+EXPLAIN (ANALYZE, BUFFERS, COSTS OFF)
+SELECT * FROM session_events WHERE session_id = :'bench_session' ORDER BY event_time DESC;
+
+\echo '--- SessionEventRepository::getByEventType'
+EXPLAIN (ANALYZE, BUFFERS, COSTS OFF)
+SELECT * FROM session_events WHERE session_id = :'bench_session' AND event_type = 'login' ORDER BY event_time DESC;
+
+\echo '--- Time range scan (one day)'
+EXPLAIN (ANALYZE, BUFFERS, COSTS OFF)
+SELECT COUNT(*) FROM app_usage WHERE start_time >= '2025-01-15' AND start_time < '2025-01-16';
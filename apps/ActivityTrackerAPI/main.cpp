@@ -4,9 +4,14 @@
 #include <QFile>
 #include <QDir>
 #include <QNetworkInterface>
+#include <QSettings>
 #include <QTimer>
 #include "Server/ApiServer.h"
+#include "Server/ShutdownSignal.h"
+#include "Server/WorkerSupervisor.h"
 #include "dbservice/dbconfig.h"
+#include "httpserver/server.h"
+#include "dbservice/querystats.h"
 #include "logger/logger.h"
 #include "Core/AuthFramework.h"
 
@@ -40,13 +45,6 @@ int main(int argc, char *argv[])
     Logger::instance()->setLogLevel(Logger::Debug);
     Logger::instance()->enableConsoleOutput(true);
 
-    QString logFilePath = "logs/activity_tracker_api.log";
-    QDir().mkpath("logs"); // Ensure log directory exists
-    Logger::instance()->setLogFile(logFilePath);
-
-    LOG_INFO("Starting Activity Tracker API");
-    LOG_INFO(QString("Application version: %1").arg(QCoreApplication::applicationVersion()));
-
     // Set up command line parser
     QCommandLineParser parser;
     parser.setApplicationDescription("Activity Tracker REST API Server");
@@ -74,6 +72,39 @@ int main(int argc, char *argv[])
                                     "info");
     parser.addOption(logLevelOption);
 
+    // Add per-category log level option
+    QCommandLineOption logCategoriesOption(QStringList() << "log-categories",
+                                         QCoreApplication::translate("main", "Per-category log levels, e.g. SessionController=debug,BaseRepository=warning"),
+                                         QCoreApplication::translate("main", "spec"));
+    parser.addOption(logCategoriesOption);
+
+    // Add log rate limit option
+    QCommandLineOption logRateLimitOption(QStringList() << "log-rate-limit",
+                                        QCoreApplication::translate("main", "Max debug/info messages per second from one call site (default: 0, unlimited)"),
+                                        QCoreApplication::translate("main", "messages"),
+                                        "0");
+    parser.addOption(logRateLimitOption);
+
+    // Add log format option
+    QCommandLineOption logFormatOption(QStringList() << "log-format",
+                                     QCoreApplication::translate("main", "Log file format (text, structured)"),
+                                     QCoreApplication::translate("main", "format"),
+                                     "text");
+    parser.addOption(logFormatOption);
+
+    // Add log rotation options
+    QCommandLineOption logMaxSizeOption(QStringList() << "log-max-size",
+                                      QCoreApplication::translate("main", "Rotate the log file after this many megabytes (default: 100, 0 disables)"),
+                                      QCoreApplication::translate("main", "megabytes"),
+                                      "100");
+    parser.addOption(logMaxSizeOption);
+
+    QCommandLineOption logRetainOption(QStringList() << "log-retain",
+                                     QCoreApplication::translate("main", "Number of rotated log files to keep (default: 14)"),
+                                     QCoreApplication::translate("main", "files"),
+                                     "14");
+    parser.addOption(logRetainOption);
+
     // Add host option (to specify which interface to bind to)
     QCommandLineOption hostOption(QStringList() << "h" << "host",
                                  QCoreApplication::translate("main", "Host interface to bind to (IP or 'all')"),
@@ -88,6 +119,77 @@ int main(int argc, char *argv[])
                                         "30");
     parser.addOption(tokenCleanupOption);
 
+    // Add asynchronous batch ingestion options
+    QCommandLineOption spoolDirOption(QStringList() << "spool-dir",
+                                    QCoreApplication::translate("main", "Spool /api/batch uploads to this directory and answer 202 before the database write"),
+                                    QCoreApplication::translate("main", "directory"));
+    parser.addOption(spoolDirOption);
+
+    QCommandLineOption spoolWritersOption(QStringList() << "spool-writers",
+                                        QCoreApplication::translate("main", "Number of threads draining the batch spool (default: 2)"),
+                                        QCoreApplication::translate("main", "threads"),
+                                        "2");
+    parser.addOption(spoolWritersOption);
+
+    QCommandLineOption batchWorkersOption(QStringList() << "batch-workers",
+                                        QCoreApplication::translate("main", "Threads writing the arrays of a synchronous batch in parallel, 0 to disable (default: 4)"),
+                                        QCoreApplication::translate("main", "threads"),
+                                        "4");
+    parser.addOption(batchWorkersOption);
+
+    QCommandLineOption partitionMaintenanceOption(QStringList() << "partition-maintenance",
+                                                QCoreApplication::translate("main", "Hours between partition maintenance runs, 0 to disable (default: 6)"),
+                                                QCoreApplication::translate("main", "hours"),
+                                                "6");
+    parser.addOption(partitionMaintenanceOption);
+
+    QCommandLineOption partitionMonthsOption(QStringList() << "partition-months",
+                                           QCoreApplication::translate("main", "Detach partitions older than this many months; reports cannot read detached months unless --archive-dir is set (default: 0, never)"),
+                                           QCoreApplication::translate("main", "months"),
+                                           "0");
+    parser.addOption(partitionMonthsOption);
+
+    QCommandLineOption archiveDirOption(QStringList() << "archive-dir",
+                                      QCoreApplication::translate("main", "Export detached partitions to columnar files in this directory"),
+                                      QCoreApplication::translate("main", "directory"));
+    parser.addOption(archiveDirOption);
+
+    QCommandLineOption archiveSharedOption(QStringList() << "archive-shared",
+                                         QCoreApplication::translate("main", "The --archive-dir is shared storage every API node reads, so exported partitions are dropped from the database"));
+    parser.addOption(archiveSharedOption);
+
+    QCommandLineOption slowQueryOption(QStringList() << "slow-query-ms",
+                                     QCoreApplication::translate("main", "Log statements slower than this many milliseconds, 0 to disable (default: 500)"),
+                                     QCoreApplication::translate("main", "milliseconds"),
+                                     "500");
+    parser.addOption(slowQueryOption);
+
+    QCommandLineOption explainSampleOption(QStringList() << "explain-sample",
+                                         QCoreApplication::translate("main", "Fraction of slow listing and report reads re-run under EXPLAIN (ANALYZE, BUFFERS) for the log (default: 0)"),
+                                         QCoreApplication::translate("main", "fraction"),
+                                         "0");
+    parser.addOption(explainSampleOption);
+
+    QCommandLineOption workersOption(QStringList() << "workers",
+                                   QCoreApplication::translate("main", "Worker processes sharing the port through SO_REUSEPORT, restarted if they exit; needs a platform with SO_REUSEPORT, not Windows (default: 1)"),
+                                   QCoreApplication::translate("main", "processes"),
+                                   "1");
+    parser.addOption(workersOption);
+
+    QCommandLineOption drainOption(QStringList() << "drain-seconds",
+                                 QCoreApplication::translate("main", "Seconds in-flight requests get to finish after SIGTERM (default: 10)"),
+                                 QCoreApplication::translate("main", "seconds"),
+                                 "10");
+    parser.addOption(drainOption);
+
+    // Set by the supervisor on the processes it starts
+    QCommandLineOption workerIndexOption(QStringList() << "worker-index",
+                                       QCoreApplication::translate("main", "Index of this worker process"),
+                                       QCoreApplication::translate("main", "index"),
+                                       "-1");
+    workerIndexOption.setFlags(QCommandLineOption::HiddenFromHelp);
+    parser.addOption(workerIndexOption);
+
     // If no arguments were passed, print the syntax
     if (argc <= 1) {
         parser.showHelp();
@@ -109,6 +211,26 @@ int main(int argc, char *argv[])
         tokenCleanupMinutes = 30; // Fallback to default if invalid
     }
 
+    const int workerCount = qMax(1, parser.value(workersOption).toInt());
+    const int workerIndex = parser.value(workerIndexOption).toInt();
+    const int drainSeconds = qMax(0, parser.value(drainOption).toInt());
+
+    // Workers rotate their logs independently, so each needs its own file. It is opened before
+    // the first log line, so nothing from a worker lands in the supervisor's file.
+    const QString logSuffix = workerIndex >= 0 ? QString(".worker%1").arg(workerIndex) : QString();
+    QDir().mkpath("logs"); // Ensure log directory exists
+    Logger::instance()->setLogFile(QString("logs/activity_tracker_api%1.log").arg(logSuffix));
+
+    LOG_INFO("Starting Activity Tracker API");
+    LOG_INFO(QString("Application version: %1").arg(QCoreApplication::applicationVersion()));
+
+    // Without SO_REUSEPORT every worker but the first would fail to bind and be restarted forever
+    if (workerCount > 1 && !Http::Server::reusePortSupported()) {
+        LOG_FATAL("--workers greater than 1 needs SO_REUSEPORT, which this platform does not support; "
+                  "run a single process or put several instances on different ports behind a load balancer");
+        return 1;
+    }
+
     // Set log level
     QString logLevel = parser.value(logLevelOption).toLower();
     if (logLevel == "debug") {
@@ -125,6 +247,42 @@ int main(int argc, char *argv[])
 
     LOG_INFO(QString("Log level set to: %1").arg(logLevel));
 
+    if (parser.isSet(logCategoriesOption)) {
+        Logger::instance()->setCategoryLevels(parser.value(logCategoriesOption));
+        LOG_INFO(QString("Log category levels set to: %1").arg(parser.value(logCategoriesOption)));
+    }
+
+    Logger::instance()->setRateLimit(parser.value(logRateLimitOption).toInt());
+
+    // Rotate daily and by size; old segments are compressed in the background
+    Logger::RotationPolicy rotationPolicy;
+    rotationPolicy.maxFileSize = qMax(0LL, parser.value(logMaxSizeOption).toLongLong()) * 1024 * 1024;
+    rotationPolicy.daily = true;
+    rotationPolicy.maxRetainedFiles = parser.value(logRetainOption).toInt();
+    Logger::instance()->setRotationPolicy(rotationPolicy);
+
+    // Structured logs are decoded offline with tms_logdecode
+    if (parser.value(logFormatOption).toLower() == "structured") {
+        Logger::instance()->setLogFormat(Logger::StructuredFormat, QString("logs/activity_tracker_api%1.cbor").arg(logSuffix));
+        LOG_INFO("Log file format set to: structured");
+    }
+
+    // The supervisor only starts workers; each of them connects to the database itself
+    if (workerCount > 1 && workerIndex < 0) {
+        WorkerSupervisor supervisor(workerCount, app.arguments().mid(1), drainSeconds);
+        ShutdownSignal shutdownSignal;
+        shutdownSignal.install();
+        QObject::connect(&shutdownSignal, &ShutdownSignal::received, &supervisor, &WorkerSupervisor::shutdown);
+        QObject::connect(&supervisor, &WorkerSupervisor::finished, &app, &QCoreApplication::quit);
+
+        LOG_INFO(QString("Starting %1 worker processes on port %2").arg(workerCount).arg(port));
+        if (!supervisor.start()) {
+            LOG_FATAL("Failed to start worker processes");
+            return 1;
+        }
+        return app.exec();
+    }
+
     // Get database configuration
     QString configPath = parser.value(configOption);
     DbConfig dbConfig;
@@ -174,6 +332,39 @@ int main(int argc, char *argv[])
         LOG_ERROR(QString("Server error: %1").arg(error));
     });
 
+    if (parser.isSet(spoolDirOption)) {
+        // A spool belongs to one process; a restarted worker drains what its predecessor left
+        QString spoolDir = parser.value(spoolDirOption);
+        if (workerIndex >= 0) {
+            spoolDir = QDir(spoolDir).filePath(QString("worker-%1").arg(workerIndex));
+        }
+        server.enableBatchSpool(spoolDir, qMax(1, parser.value(spoolWritersOption).toInt()));
+    }
+    server.setBatchWorkerThreads(qMax(0, parser.value(batchWorkersOption).toInt()));
+    server.setPartitionMaintenanceHours(qMax(0, parser.value(partitionMaintenanceOption).toInt()));
+    server.setPartitionMonthsToKeep(qMax(0, parser.value(partitionMonthsOption).toInt()));
+    if (parser.isSet(archiveDirOption)) {
+        server.enableArchive(parser.value(archiveDirOption), parser.isSet(archiveSharedOption));
+    }
+    server.setReusePort(workerIndex >= 0);
+    server.setMaintenanceEnabled(workerIndex <= 0);
+
+    // Per-statement timings are served at /api/status/queries
+    QueryStats::instance().setSlowQueryThreshold(parser.value(slowQueryOption).toInt());
+    QueryStats::instance().setExplainSampleRate(parser.value(explainSampleOption).toDouble());
+
+    // Days of raw rows kept per table before compaction, e.g. activity_events=30 under [Retention]
+    if (QFile::exists(configPath)) {
+        QSettings settings(configPath, QSettings::IniFormat);
+        settings.beginGroup("Retention");
+        QHash<QString, int> retentionDays;
+        for (const QString& table : settings.childKeys()) {
+            retentionDays.insert(table, settings.value(table).toInt());
+        }
+        settings.endGroup();
+        server.setRetentionDays(retentionDays);
+    }
+
     // Initialize and start the server
     bool initialized = server.initialize(dbConfig);
     if (!initialized) {
@@ -212,6 +403,20 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    // Stop accepting connections and give in-flight requests time to finish; a second signal quits at once
+    ShutdownSignal shutdownSignal;
+    shutdownSignal.install();
+    QObject::connect(&shutdownSignal, &ShutdownSignal::received, [&](int signalNumber) {
+        if (!server.isRunning()) {
+            QCoreApplication::quit();
+            return;
+        }
+
+        LOG_INFO(QString("Received signal %1, draining for %2 seconds").arg(signalNumber).arg(drainSeconds));
+        server.stop();
+        QTimer::singleShot(drainSeconds * 1000, &app, &QCoreApplication::quit);
+    });
+
     // Handle application shutdown
     QObject::connect(&app, &QCoreApplication::aboutToQuit, [&]() {
         LOG_INFO("Application shutting down");
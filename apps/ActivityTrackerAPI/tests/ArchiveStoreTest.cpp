@@ -0,0 +1,132 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+
+#include "Services/ArchiveStore.h"
+#include "Services/ArchiveWriter.h"
+
+class ArchiveStoreTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init() {
+        m_tempDir.reset(new QTemporaryDir());
+        QVERIFY(m_tempDir->isValid());
+
+        const QDateTime start(QDate(2024, 1, 1), QTime(8, 0), Qt::UTC);
+        m_rows.clear();
+        for (int i = 0; i < 8; ++i) {
+            ArchiveStore::Row row;
+            row["session_id"] = i % 3 == 0 ? m_sessionA : m_sessionB;
+            row["event_time"] = start.addSecs(i * 90).addMSecs(i);
+            row["event_type"] = i % 2 == 0 ? QVariant(QString("mouse")) : QVariant();
+            row["event_data"] = QString("payload %1").arg(i);
+            row["sequence"] = static_cast<qint64>(1000 + i);
+            row["cpu_usage"] = i % 4 == 3 ? QVariant() : QVariant(i * 1.5);
+            row["is_idle"] = i % 2 == 1;
+            m_rows.append(row);
+        }
+    }
+
+    void cleanup() {
+        m_tempDir.reset();
+    }
+
+    void testRoundTrip() {
+        // Three rows per group, so the last group is a partial one
+        const QString path = writeFile(3);
+
+        QList<ArchiveStore::Row> read;
+        ArchiveStore store(m_tempDir->path());
+        QCOMPARE(store.visitFile(path, [&read](const ArchiveStore::Row& row) { read.append(row); }), m_rows.size());
+        QCOMPARE(read.size(), m_rows.size());
+
+        for (int i = 0; i < m_rows.size(); ++i) {
+            const ArchiveStore::Row& expected = m_rows.at(i);
+            const ArchiveStore::Row& actual = read.at(i);
+            QCOMPARE(actual.value("session_id").toString(), expected.value("session_id").toString());
+            QCOMPARE(actual.value("event_time").toDateTime(), expected.value("event_time").toDateTime());
+            QCOMPARE(actual.value("event_type").isNull(), expected.value("event_type").isNull());
+            QCOMPARE(actual.value("event_type").toString(), expected.value("event_type").toString());
+            QCOMPARE(actual.value("event_data").toString(), expected.value("event_data").toString());
+            QCOMPARE(actual.value("sequence").toLongLong(), expected.value("sequence").toLongLong());
+            QCOMPARE(actual.value("cpu_usage").isNull(), expected.value("cpu_usage").isNull());
+            QCOMPARE(actual.value("cpu_usage").toDouble(), expected.value("cpu_usage").toDouble());
+            QCOMPARE(actual.value("is_idle").toBool(), expected.value("is_idle").toBool());
+        }
+    }
+
+    void testVisitSession() {
+        const QString path = writeFile(3);
+
+        ArchiveStore::Partition entry;
+        entry.table = "activity_events";
+        entry.partition = "activity_events_y2024m01";
+        entry.month = QDate(2024, 1, 1);
+        entry.file = QDir(m_tempDir->path()).relativeFilePath(path);
+        entry.rows = m_rows.size();
+        entry.sessions = {m_sessionA, m_sessionB};
+
+        ArchiveStore store(m_tempDir->path());
+        QVERIFY(store.addPartition(entry));
+
+        // The manifest is read back as another node would
+        ArchiveStore reloaded(m_tempDir->path());
+        QVERIFY(reloaded.load());
+        QVERIFY(reloaded.isArchived("activity_events_y2024m01"));
+        QVERIFY(reloaded.hasSession("activity_events", QUuid(m_sessionA)));
+
+        int visited = reloaded.visitSession("activity_events", QUuid(m_sessionA), [this](const ArchiveStore::Row& row) {
+            QCOMPARE(row.value("session_id").toString(), m_sessionA);
+        });
+        QCOMPARE(visited, 3);
+    }
+
+    void testTruncatedFile() {
+        const QString path = writeFile(3);
+
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.resize(file.size() - 10));
+        file.close();
+
+        ArchiveStore store(m_tempDir->path());
+        QCOMPARE(store.visitFile(path, [](const ArchiveStore::Row&) {}), -1);
+    }
+
+private:
+    QString writeFile(int groupRows) {
+        const QList<ArchiveStore::Column> columns = {
+            {"session_id", ArchiveStore::ColumnKind::Dictionary},
+            {"event_time", ArchiveStore::ColumnKind::Time},
+            {"event_type", ArchiveStore::ColumnKind::Dictionary},
+            {"event_data", ArchiveStore::ColumnKind::Text},
+            {"sequence", ArchiveStore::ColumnKind::Integer},
+            {"cpu_usage", ArchiveStore::ColumnKind::Double},
+            {"is_idle", ArchiveStore::ColumnKind::Boolean},
+        };
+
+        QDir(m_tempDir->path()).mkpath("activity_events");
+        const QString path = QDir(m_tempDir->path()).filePath("activity_events/activity_events_y2024m01.tmsc");
+
+        ArchiveWriter writer(path, groupRows);
+        if (!writer.open("activity_events", "activity_events_y2024m01", columns)) {
+            return QString();
+        }
+        for (const ArchiveStore::Row& row : m_rows) {
+            for (int c = 0; c < columns.size(); ++c) {
+                writer.addValue(c, row.value(columns[c].name));
+            }
+            writer.endRow();
+        }
+        return writer.finish() ? path : QString();
+    }
+
+    const QString m_sessionA = "6f1c2a4e-0d1b-4c36-9f43-2b7f6a1d9e01";
+    const QString m_sessionB = "a2b3c4d5-e6f7-4a8b-9c0d-1e2f3a4b5c6d";
+    QList<ArchiveStore::Row> m_rows;
+    QScopedPointer<QTemporaryDir> m_tempDir;
+};
+
+QTEST_MAIN(ArchiveStoreTest)
+#include "ArchiveStoreTest.moc"
@@ -0,0 +1,21 @@
+#ifndef TOOLCONFIG_H
+#define TOOLCONFIG_H
+
+#include <QFile>
+#include "dbservice/dbconfig.h"
+
+// Database settings for the command line tools: the INI file when one is
+// given, otherwise the DB_* environment variables against a local server
+inline DbConfig loadToolConfig(const QString& configPath)
+{
+    if (!configPath.isEmpty()) {
+        return DbConfig::fromFile(configPath);
+    }
+
+    if (!qEnvironmentVariableIsSet("DB_HOST")) {
+        qputenv("DB_HOST", "localhost");
+    }
+    return DbConfig::fromEnvironment();
+}
+
+#endif // TOOLCONFIG_H
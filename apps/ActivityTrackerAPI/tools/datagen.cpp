@@ -0,0 +1,665 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QTextStream>
+#include <QUuid>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <random>
+
+#include "dbservice/dbservice.h"
+#include "Models/SessionModel.h"
+#include "logger/logger.h"
+#include "ToolConfig.h"
+
+// Fills a database created from schema_with_views.sql with synthetic users,
+// machines and working days of tracked activity, for tms_querybench and load tests
+
+namespace {
+
+struct Options {
+    int users = 50;
+    int machines = 50;
+    int days = 30;
+    int eventsPerHour = 300;
+    int metricsIntervalSeconds = 60;
+    int batchRows = 1000;
+    quint32 seed = 42;
+};
+
+struct AppEntry {
+    const char* name;
+    const char* path;
+};
+
+// Ordered by popularity; picks follow a Zipf distribution over this list
+const AppEntry AppCatalog[] = {
+    { "chrome.exe", "C:\\Program Files\\Google\\Chrome\\Application\\chrome.exe" },
+    { "outlook.exe", "C:\\Program Files\\Microsoft Office\\root\\Office16\\OUTLOOK.EXE" },
+    { "Teams.exe", "C:\\Program Files\\WindowsApps\\MSTeams\\ms-teams.exe" },
+    { "code.exe", "C:\\Program Files\\Microsoft VS Code\\Code.exe" },
+    { "explorer.exe", "C:\\Windows\\explorer.exe" },
+    { "excel.exe", "C:\\Program Files\\Microsoft Office\\root\\Office16\\EXCEL.EXE" },
+    { "winword.exe", "C:\\Program Files\\Microsoft Office\\root\\Office16\\WINWORD.EXE" },
+    { "maya.exe", "C:\\Program Files\\Autodesk\\Maya2024\\bin\\maya.exe" },
+    { "houdini.exe", "C:\\Program Files\\Side Effects Software\\Houdini 20.0\\bin\\houdini.exe" },
+    { "nuke.exe", "C:\\Program Files\\Nuke15.0v2\\Nuke15.0.exe" },
+    { "photoshop.exe", "C:\\Program Files\\Adobe\\Adobe Photoshop 2024\\Photoshop.exe" },
+    { "slack.exe", "C:\\Users\\Public\\AppData\\Local\\slack\\slack.exe" },
+    { "blender.exe", "C:\\Program Files\\Blender Foundation\\Blender 4.1\\blender.exe" },
+    { "substance_painter.exe", "C:\\Program Files\\Adobe\\Adobe Substance 3D Painter\\Adobe Substance 3D Painter.exe" },
+    { "zbrush.exe", "C:\\Program Files\\Maxon ZBrush 2024\\ZBrush.exe" },
+    { "unrealeditor.exe", "C:\\Program Files\\Epic Games\\UE_5.3\\Engine\\Binaries\\Win64\\UnrealEditor.exe" },
+    { "powershell.exe", "C:\\Windows\\System32\\WindowsPowerShell\\v1.0\\powershell.exe" },
+    { "notepad++.exe", "C:\\Program Files\\Notepad++\\notepad++.exe" },
+    { "vlc.exe", "C:\\Program Files\\VideoLAN\\VLC\\vlc.exe" },
+    { "acrobat.exe", "C:\\Program Files\\Adobe\\Acrobat DC\\Acrobat\\Acrobat.exe" },
+    { "shotgrid.exe", "C:\\Program Files\\Shotgun\\ShotGrid.exe" },
+    { "rv.exe", "C:\\Program Files\\ShotGrid\\RV-2023.0.2\\bin\\rv.exe" },
+    { "mspaint.exe", "C:\\Windows\\System32\\mspaint.exe" },
+    { "calc.exe", "C:\\Windows\\System32\\calc.exe" }
+};
+
+QString literal(const QString& value)
+{
+    return '\'' + QString(value).replace('\'', "''") + '\'';
+}
+
+QString literal(const QUuid& id)
+{
+    return id.isNull() ? QString("NULL") : literal(id.toString(QUuid::WithoutBraces));
+}
+
+QString literal(const QDateTime& time)
+{
+    return time.isValid() ? literal(time.toUTC().toString("yyyy-MM-dd HH:mm:ss.zzz")) : QString("NULL");
+}
+
+QString literal(double value)
+{
+    return QString::number(value, 'f', 2);
+}
+
+// Rows for one table, sent as a single multi-row INSERT per batch. Every value
+// is generated here and written as a literal, so a batch is one round trip.
+class InsertBatch
+{
+public:
+    InsertBatch(DbService<SessionModel>& db, const QString& table, const QString& columns, int maxRows)
+        : m_db(db), m_table(table), m_columns(columns), m_maxRows(maxRows)
+    {
+    }
+
+    bool add(const QStringList& values)
+    {
+        m_rows.append('(' + values.join(", ") + ')');
+        return m_rows.size() < m_maxRows || flush();
+    }
+
+    bool flush()
+    {
+        if (m_rows.isEmpty()) {
+            return true;
+        }
+
+        const QString query = QString("INSERT INTO %1 (%2) VALUES %3").arg(m_table, m_columns, m_rows.join(", "));
+        const qsizetype rows = m_rows.size();
+        m_rows.clear();
+
+        if (!m_db.executeModificationQuery(query, QMap<QString, QVariant>())) {
+            LOG_ERROR(QString("Insert into %1 failed: %2").arg(m_table, m_db.lastError()));
+            return false;
+        }
+        m_inserted += rows;
+        return true;
+    }
+
+    QString table() const { return m_table; }
+    qint64 inserted() const { return m_inserted; }
+
+private:
+    DbService<SessionModel>& m_db;
+    QString m_table;
+    QString m_columns;
+    int m_maxRows;
+    QStringList m_rows;
+    qint64 m_inserted = 0;
+};
+
+struct SessionPlan {
+    QUuid id;
+    QUuid userId;
+    QUuid machineId;
+    QDateTime login;
+    QDateTime logout;
+    QUuid continuedFrom;
+    QDateTime previousEnd;
+    QUuid chainId;
+    int chainPosition = 1;
+    bool remote = false;
+};
+
+class Generator
+{
+public:
+    Generator(DbService<SessionModel>& db, const Options& options)
+        : m_db(db)
+        , m_options(options)
+        , m_rng(options.seed)
+        , m_sessions(db, "sessions",
+                     "id, user_id, machine_id, login_time, logout_time, continued_from_session, "
+                     "previous_session_end_time, time_since_previous_session, chain_id, chain_position, "
+                     "created_at, updated_at",
+                     options.batchRows)
+        , m_afkPeriods(db, "afk_periods", "session_id, start_time, end_time, created_at, updated_at",
+                       options.batchRows)
+        , m_activityEvents(db, "activity_events", "session_id, app_id, event_type, event_time, created_at, updated_at",
+                           options.batchRows)
+        , m_appUsage(db, "app_usage",
+                     "session_id, app_id, start_time, end_time, is_active, window_title, created_at, updated_at",
+                     options.batchRows)
+        , m_systemMetrics(db, "system_metrics",
+                          "session_id, cpu_usage, gpu_usage, memory_usage, measurement_time, created_at, updated_at",
+                          options.batchRows)
+        , m_sessionEvents(db, "session_events",
+                          "session_id, event_type, event_time, user_id, machine_id, terminal_session_id, is_remote, "
+                          "created_at, updated_at",
+                          options.batchRows)
+    {
+        QList<double> weights;
+        for (size_t rank = 1; rank <= std::size(AppCatalog); ++rank) {
+            weights.append(1.0 / std::pow(static_cast<double>(rank), 1.1));
+        }
+        m_appPick = std::discrete_distribution<int>(weights.begin(), weights.end());
+    }
+
+    bool run()
+    {
+        const QDate lastDay = QDateTime::currentDateTimeUtc().date().addDays(-1);
+        const QDate firstDay = lastDay.addDays(1 - m_options.days);
+
+        QTextStream out(stdout);
+        QElapsedTimer timer;
+        timer.start();
+
+        if (!ensurePartitions(firstDay, lastDay) || !insertApplications() || !insertUsersAndMachines()) {
+            return false;
+        }
+
+        for (QDate day = firstDay; day <= lastDay; day = day.addDays(1)) {
+            if (!m_db.beginTransaction()) {
+                LOG_ERROR(QString("Cannot begin transaction: %1").arg(m_db.lastError()));
+                return false;
+            }
+
+            const int sessions = generateDay(day);
+            if (sessions < 0 || !flushAll() || !m_db.commitTransaction()) {
+                m_db.rollbackTransaction();
+                LOG_ERROR(QString("Generating %1 failed").arg(day.toString(Qt::ISODate)));
+                return false;
+            }
+            out << day.toString(Qt::ISODate) << ": " << sessions << " sessions" << Qt::endl;
+        }
+
+        // Links are set afterwards so the forward reference never points at an uninserted row
+        m_db.executeModificationQuery(
+            "UPDATE sessions s SET continued_by_session = n.id "
+            "FROM sessions n "
+            "WHERE n.continued_from_session = s.id AND s.continued_by_session IS NULL",
+            QMap<QString, QVariant>());
+
+        m_db.executeVisitQuery(
+            QString("SELECT refresh_user_daily_summaries(%1::date, %2::date)")
+                .arg(literal(firstDay.toString(Qt::ISODate)), literal(lastDay.toString(Qt::ISODate))),
+            QMap<QString, QVariant>(), [](const QSqlQuery&) {});
+
+        m_db.executeModificationQuery(
+            "ANALYZE sessions, afk_periods, activity_events, app_usage, system_metrics, session_events",
+            QMap<QString, QVariant>());
+
+        const double seconds = timer.elapsed() / 1000.0;
+        qint64 total = 0;
+        out << Qt::endl;
+        for (const InsertBatch* batch : batches()) {
+            out << QString("%1 %2").arg(batch->table(), -16).arg(batch->inserted(), 12) << Qt::endl;
+            total += batch->inserted();
+        }
+        out << QString("%1 rows in %2 s (%3 rows/s)")
+                   .arg(total)
+                   .arg(seconds, 0, 'f', 1)
+                   .arg(seconds > 0 ? total / seconds : 0.0, 0, 'f', 0)
+            << Qt::endl;
+        return true;
+    }
+
+private:
+    QList<InsertBatch*> batches()
+    {
+        return { &m_sessions, &m_afkPeriods, &m_activityEvents, &m_appUsage, &m_systemMetrics, &m_sessionEvents };
+    }
+
+    bool flushAll()
+    {
+        for (InsertBatch* batch : batches()) {
+            if (!batch->flush()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ensurePartitions(const QDate& firstDay, const QDate& lastDay)
+    {
+        const QStringList tables = { "activity_events", "system_metrics", "app_usage", "session_events" };
+        for (QDate month(firstDay.year(), firstDay.month(), 1); month <= lastDay; month = month.addMonths(1)) {
+            for (const QString& table : tables) {
+                const QString query = QString("SELECT create_partition_for_month(%1, %2::date)")
+                                          .arg(literal(table), literal(month.toString(Qt::ISODate)));
+                if (m_db.executeVisitQuery(query, QMap<QString, QVariant>(), [](const QSqlQuery&) {}) < 0) {
+                    LOG_ERROR(QString("Cannot create partition of %1 for %2: %3")
+                                  .arg(table, month.toString("yyyy-MM"), m_db.lastError()));
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool insertApplications()
+    {
+        QStringList values;
+        for (const AppEntry& app : AppCatalog) {
+            values.append(QString("(%1, %2)").arg(literal(QString(app.name)), literal(QString(app.path))));
+        }
+        if (!m_db.executeModificationQuery(
+                QString("INSERT INTO applications (app_name, app_path) VALUES %1 "
+                        "ON CONFLICT (app_name, app_path) DO NOTHING")
+                    .arg(values.join(", ")),
+                QMap<QString, QVariant>())) {
+            LOG_ERROR(QString("Cannot insert applications: %1").arg(m_db.lastError()));
+            return false;
+        }
+
+        QHash<QString, QUuid> ids;
+        m_db.executeVisitQuery("SELECT id, app_name, app_path FROM applications", QMap<QString, QVariant>(),
+                               [&ids](const QSqlQuery& row) {
+                                   ids.insert(row.value("app_name").toString() + '|' + row.value("app_path").toString(),
+                                              row.value("id").toUuid());
+                               });
+
+        for (const AppEntry& app : AppCatalog) {
+            m_apps.append(qMakePair(ids.value(QString(app.name) + '|' + QString(app.path)), QString(app.name)));
+        }
+        return true;
+    }
+
+    bool insertUsersAndMachines()
+    {
+        const QDateTime created = QDateTime::currentDateTimeUtc().addDays(-m_options.days - 1);
+        const QStringList systems = { "Windows 11 Pro 23H2", "Windows 10 Pro 22H2", "Windows 11 Enterprise 23H2" };
+        const QStringList cpus = { "AMD Ryzen Threadripper PRO 5975WX", "Intel Xeon W-2295", "AMD Ryzen 9 7950X",
+                                   "Intel Core i9-13900K" };
+        const int ramSizes[] = { 32, 64, 128, 256 };
+
+        InsertBatch machines(m_db, "machines",
+                             "id, name, machine_unique_id, operating_system, cpu_info, ram_size_gb, ip_address, "
+                             "last_seen_at, created_at, updated_at",
+                             m_options.batchRows);
+        for (int i = 0; i < m_options.machines; ++i) {
+            const QUuid id = QUuid::createUuid();
+            m_machineIds.append(id);
+            machines.add({ literal(id),
+                           literal(QString("DG%1-WS%2").arg(m_options.seed).arg(i + 1, 4, 10, QChar('0'))),
+                           literal(QString("datagen-%1-%2").arg(m_options.seed).arg(i + 1)),
+                           literal(systems.at(pick(systems.size()))),
+                           literal(cpus.at(pick(cpus.size()))),
+                           QString::number(ramSizes[pick(4)]),
+                           literal(QString("10.%1.%2.%3").arg(m_options.seed % 256).arg(i / 250).arg(i % 250 + 2)),
+                           literal(created), literal(created), literal(created) });
+        }
+
+        InsertBatch users(m_db, "users", "id, name, email, password, active, verified, created_at, updated_at",
+                          m_options.batchRows);
+        for (int i = 0; i < m_options.users; ++i) {
+            const QUuid id = QUuid::createUuid();
+            m_userIds.append(id);
+            // Not a valid password hash, so generated users cannot log in
+            users.add({ literal(id),
+                        literal(QString("Datagen User %1").arg(i + 1)),
+                        literal(QString("user%1.s%2@datagen.local").arg(i + 1).arg(m_options.seed)),
+                        literal(QString("!")),
+                        "true", "true", literal(created), literal(created) });
+        }
+
+        if (!machines.flush() || !users.flush()) {
+            LOG_ERROR("Cannot insert users and machines; use another --seed to generate a second data set");
+            return false;
+        }
+        return true;
+    }
+
+    // Sessions of every user for one day; returns the number of sessions or -1 on error
+    int generateDay(const QDate& day)
+    {
+        const bool weekend = day.dayOfWeek() >= 6;
+        const QDateTime midnight(day, QTime(0, 0), Qt::UTC);
+        const QDateTime latestLogout = midnight.addSecs(23 * 3600 + 30 * 60);
+        int sessions = 0;
+
+        for (int u = 0; u < m_userIds.size(); ++u) {
+            if (!chance(weekend ? 0.08 : 0.92)) {
+                continue;
+            }
+
+            const QUuid machineId = chance(0.05) ? m_machineIds.at(pick(m_machineIds.size()))
+                                                 : m_machineIds.at(u % m_machineIds.size());
+
+            // Log in around a quarter to nine and stay for a working day
+            const double loginHour = std::clamp(normal(8.75, 0.6), 6.0, 11.0);
+            const double hours = std::clamp(8.3 * std::exp(normal(0.0, 0.18)), 1.0, 12.0);
+            QDateTime login = midnight.addSecs(static_cast<qint64>(loginHour * 3600));
+            QDateTime logout = std::min(login.addSecs(static_cast<qint64>(hours * 3600)), latestLogout);
+
+            SessionPlan first;
+            first.id = QUuid::createUuid();
+            first.userId = m_userIds.at(u);
+            first.machineId = machineId;
+            first.login = login;
+            first.logout = logout;
+            first.chainId = first.id;
+            first.remote = chance(0.03);
+
+            // Some days split at lunch into a continued session
+            const qint64 length = login.secsTo(logout);
+            if (length > 6 * 3600 && chance(0.15)) {
+                first.logout = login.addSecs(static_cast<qint64>(uniform(3.5, 4.5) * 3600));
+
+                SessionPlan second = first;
+                second.id = QUuid::createUuid();
+                second.login = first.logout.addSecs(static_cast<qint64>(uniform(30, 75) * 60));
+                second.logout = logout;
+                second.continuedFrom = first.id;
+                second.previousEnd = first.logout;
+                second.chainPosition = 2;
+
+                if (!generateSession(first) || !generateSession(second)) {
+                    return -1;
+                }
+                sessions += 2;
+            } else {
+                if (!generateSession(first)) {
+                    return -1;
+                }
+                sessions++;
+            }
+        }
+
+        return sessions;
+    }
+
+    bool generateSession(const SessionPlan& plan)
+    {
+        const QString sessionId = literal(plan.id);
+        const qint64 length = plan.login.secsTo(plan.logout);
+
+        bool ok = m_sessions.add({ sessionId, literal(plan.userId), literal(plan.machineId),
+                                   literal(plan.login), literal(plan.logout), literal(plan.continuedFrom),
+                                   literal(plan.previousEnd),
+                                   QString::number(plan.previousEnd.isValid() ? plan.previousEnd.secsTo(plan.login) : 0),
+                                   literal(plan.chainId), QString::number(plan.chainPosition),
+                                   literal(plan.login), literal(plan.logout) });
+        // Child rows reference the session, so it goes in first
+        ok = ok && m_sessions.flush();
+
+        const QString terminal = literal(plan.remote ? QString("RDP-Tcp#%1").arg(pick(90) + 10) : QString("Console"));
+        auto sessionEvent = [&](const char* type, const QDateTime& time) {
+            return m_sessionEvents.add({ sessionId, literal(QString(type)), literal(time), literal(plan.userId),
+                                         literal(plan.machineId), terminal, plan.remote ? "true" : "false",
+                                         literal(time), literal(time) });
+        };
+        ok = ok && sessionEvent("login", plan.login);
+
+        // Breaks away from the keyboard: a few per hour at most, from five minutes up
+        QList<QPair<QDateTime, QDateTime>> afk;
+        const int afkCount = poisson(length / 3600.0 * 0.6);
+        for (int i = 0; i < afkCount && length > 1200; ++i) {
+            const QDateTime start = plan.login.addSecs(static_cast<qint64>(uniform(300, length - 900)));
+            const QDateTime end = std::min(start.addSecs(300 + static_cast<qint64>(exponential(720))),
+                                           plan.logout.addSecs(-60));
+            if (end > start) {
+                afk.append(qMakePair(start, end));
+            }
+        }
+        std::sort(afk.begin(), afk.end());
+        for (int i = 1; i < afk.size();) {
+            if (afk[i].first < afk[i - 1].second.addSecs(60)) {
+                afk.removeAt(i);
+            } else {
+                ++i;
+            }
+        }
+
+        for (const auto& period : afk) {
+            ok = ok && m_afkPeriods.add({ sessionId, literal(period.first), literal(period.second),
+                                          literal(period.first), literal(period.second) });
+            ok = ok && activityEvent(sessionId, QUuid(), "afk_start", period.first);
+            ok = ok && activityEvent(sessionId, QUuid(), "afk_end", period.second);
+            if (period.first.secsTo(period.second) > 900 && chance(0.5)) {
+                ok = ok && sessionEvent("lock", period.first.addSecs(1));
+                ok = ok && sessionEvent("unlock", period.second.addSecs(-1));
+            }
+        }
+
+        // Focus moves between applications while the user is at the keyboard
+        QDateTime cursor = plan.login;
+        for (int i = 0; i <= afk.size() && ok; ++i) {
+            const QDateTime activeEnd = i < afk.size() ? afk[i].first : plan.logout;
+            while (cursor < activeEnd && ok) {
+                const qint64 span = std::clamp<qint64>(static_cast<qint64>(exponential(360)), 10, 5400);
+                const QDateTime segmentEnd = std::min(cursor.addSecs(span), activeEnd);
+                if (cursor.secsTo(segmentEnd) >= 5) {
+                    ok = appSegment(sessionId, cursor, segmentEnd);
+                }
+                cursor = segmentEnd;
+            }
+            if (i < afk.size()) {
+                cursor = std::max(cursor, afk[i].second);
+            }
+        }
+
+        ok = ok && metrics(sessionId, plan, afk);
+        ok = ok && sessionEvent("logout", plan.logout);
+        return ok;
+    }
+
+    bool appSegment(const QString& sessionId, const QDateTime& start, const QDateTime& end)
+    {
+        const auto& app = m_apps.at(m_appPick(m_rng));
+        const qint64 spanMs = start.msecsTo(end);
+
+        bool ok = m_appUsage.add({ sessionId, literal(app.first), literal(start), literal(end), "false",
+                                   literal(QString("%1 - document %2").arg(app.second).arg(pick(40) + 1)),
+                                   literal(start), literal(end) });
+        ok = ok && activityEvent(sessionId, app.first, "app_focus", start);
+
+        // Input comes in bursts: each focus period gets its own intensity
+        const double intensity = uniform(0.3, 1.7);
+        const int inputs = poisson(m_options.eventsPerHour * intensity * spanMs / 3600000.0);
+        for (int i = 0; i < inputs && ok; ++i) {
+            const double kind = uniform(0, 1);
+            const char* type = kind < 0.5 ? "keyboard" : (kind < 0.85 ? "mouse_move" : "mouse_click");
+            ok = activityEvent(sessionId, app.first, type,
+                               start.addMSecs(static_cast<qint64>(uniform(0, static_cast<double>(spanMs)))));
+        }
+
+        return ok && activityEvent(sessionId, app.first, "app_unfocus", end);
+    }
+
+    bool metrics(const QString& sessionId, const SessionPlan& plan, const QList<QPair<QDateTime, QDateTime>>& afk)
+    {
+        double cpu = uniform(5, 25);
+        double gpu = uniform(0, 8);
+        double memory = uniform(35, 65);
+        int afkIndex = 0;
+
+        for (QDateTime time = plan.login; time <= plan.logout; time = time.addSecs(m_options.metricsIntervalSeconds)) {
+            while (afkIndex < afk.size() && afk[afkIndex].second < time) {
+                afkIndex++;
+            }
+            const bool away = afkIndex < afk.size() && afk[afkIndex].first <= time;
+
+            // Mean-reverting walks with occasional render or compile spikes
+            cpu += 0.3 * ((away ? 4.0 : 22.0) - cpu) + normal(0, 7);
+            if (chance(0.02)) {
+                cpu = uniform(70, 99);
+            }
+            gpu = 0.6 * gpu + normal(away ? 1.0 : 4.0, 3) + (chance(0.05) ? uniform(30, 90) : 0.0);
+            memory += normal(0, 0.8);
+
+            cpu = std::clamp(cpu, 0.5, 99.5);
+            gpu = std::clamp(gpu, 0.0, 100.0);
+            memory = std::clamp(memory, 20.0, 95.0);
+
+            if (!m_systemMetrics.add({ sessionId, literal(cpu), literal(gpu), literal(memory), literal(time),
+                                       literal(time), literal(time) })) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool activityEvent(const QString& sessionId, const QUuid& appId, const char* type, const QDateTime& time)
+    {
+        return m_activityEvents.add({ sessionId, literal(appId), literal(QString(type)), literal(time),
+                                      literal(time), literal(time) });
+    }
+
+    int pick(int count) { return std::uniform_int_distribution<int>(0, count - 1)(m_rng); }
+    bool chance(double p) { return std::bernoulli_distribution(p)(m_rng); }
+    double uniform(double a, double b) { return std::uniform_real_distribution<double>(a, b)(m_rng); }
+    double normal(double mean, double sd) { return std::normal_distribution<double>(mean, sd)(m_rng); }
+    double exponential(double mean) { return std::exponential_distribution<double>(1.0 / mean)(m_rng); }
+    int poisson(double mean) { return mean > 0 ? std::poisson_distribution<int>(mean)(m_rng) : 0; }
+
+    DbService<SessionModel>& m_db;
+    Options m_options;
+    std::mt19937 m_rng;
+    std::discrete_distribution<int> m_appPick;
+
+    QList<QUuid> m_userIds;
+    QList<QUuid> m_machineIds;
+    QList<QPair<QUuid, QString>> m_apps;
+
+    InsertBatch m_sessions;
+    InsertBatch m_afkPeriods;
+    InsertBatch m_activityEvents;
+    InsertBatch m_appUsage;
+    InsertBatch m_systemMetrics;
+    InsertBatch m_sessionEvents;
+};
+
+bool positiveValue(const QCommandLineParser& parser, const QCommandLineOption& option, int& value)
+{
+    bool ok = false;
+    const int parsed = parser.value(option).toInt(&ok);
+    if (!ok || parsed <= 0) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tms_datagen");
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    Logger::instance()->setLogLevel(Logger::Warning);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generate synthetic Activity Tracker data in a local PostgreSQL database");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption configOption(QStringList() << "c" << "config",
+                                    QCoreApplication::translate("main", "Database config file (default: DB_* environment, localhost)"),
+                                    QCoreApplication::translate("main", "config"));
+    parser.addOption(configOption);
+
+    QCommandLineOption usersOption(QStringList() << "u" << "users",
+                                   QCoreApplication::translate("main", "Number of users"),
+                                   QCoreApplication::translate("main", "count"), "50");
+    parser.addOption(usersOption);
+
+    QCommandLineOption machinesOption(QStringList() << "m" << "machines",
+                                      QCoreApplication::translate("main", "Number of machines"),
+                                      QCoreApplication::translate("main", "count"), "50");
+    parser.addOption(machinesOption);
+
+    QCommandLineOption daysOption(QStringList() << "d" << "days",
+                                  QCoreApplication::translate("main", "Days of activity, ending yesterday"),
+                                  QCoreApplication::translate("main", "days"), "30");
+    parser.addOption(daysOption);
+
+    QCommandLineOption eventsOption("events-per-hour",
+                                    QCoreApplication::translate("main", "Average input events per active hour"),
+                                    QCoreApplication::translate("main", "count"), "300");
+    parser.addOption(eventsOption);
+
+    QCommandLineOption metricsOption("metrics-interval",
+                                     QCoreApplication::translate("main", "Seconds between system metric samples"),
+                                     QCoreApplication::translate("main", "seconds"), "60");
+    parser.addOption(metricsOption);
+
+    QCommandLineOption batchOption("batch-rows",
+                                   QCoreApplication::translate("main", "Rows per INSERT statement"),
+                                   QCoreApplication::translate("main", "rows"), "1000");
+    parser.addOption(batchOption);
+
+    QCommandLineOption seedOption("seed",
+                                  QCoreApplication::translate("main", "Random seed; each seed creates its own users and machines"),
+                                  QCoreApplication::translate("main", "seed"), "42");
+    parser.addOption(seedOption);
+
+    parser.process(app);
+
+    Options options;
+    int seed = 0;
+    if (!positiveValue(parser, usersOption, options.users) ||
+        !positiveValue(parser, machinesOption, options.machines) ||
+        !positiveValue(parser, daysOption, options.days) ||
+        !positiveValue(parser, eventsOption, options.eventsPerHour) ||
+        !positiveValue(parser, metricsOption, options.metricsIntervalSeconds) ||
+        !positiveValue(parser, batchOption, options.batchRows) ||
+        !positiveValue(parser, seedOption, seed)) {
+        QTextStream(stderr) << "Counts, intervals and the seed must be positive integers" << Qt::endl;
+        return 1;
+    }
+    options.seed = static_cast<quint32>(seed);
+
+    const DbConfig config = loadToolConfig(parser.value(configOption));
+    QTextStream(stdout) << QString("Generating %1 users, %2 machines, %3 days into %4@%5:%6/%7")
+                               .arg(options.users)
+                               .arg(options.machines)
+                               .arg(options.days)
+                               .arg(config.username(), config.host())
+                               .arg(config.port())
+                               .arg(config.database())
+                        << Qt::endl;
+
+    DbService<SessionModel> db(config);
+    if (!db.isConnectionValid()) {
+        QTextStream(stderr) << "Cannot connect to the database: " << db.lastError() << Qt::endl;
+        return 1;
+    }
+
+    Generator generator(db, options);
+    return generator.run() ? 0 : 1;
+}
@@ -0,0 +1,297 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QUuid>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+
+#include "dbservice/dbmanager.h"
+#include "logger/logger.h"
+#include "Repositories/ActivityEventRepository.h"
+#include "Repositories/AfkPeriodRepository.h"
+#include "Repositories/AppUsageRepository.h"
+#include "Repositories/SessionEventRepository.h"
+#include "Repositories/SessionRepository.h"
+#include "Repositories/SystemMetricsRepository.h"
+#include "Services/ArchiveStore.h"
+#include "ToolConfig.h"
+
+// Times the repository aggregate methods behind the report endpoints against
+// a populated database (see tms_datagen) and reports latency percentiles
+
+namespace {
+
+struct Sample {
+    QUuid sessionId;
+    QUuid userId;
+    QDateTime loginTime;
+};
+
+struct Benchmark {
+    QString name;
+    std::function<void(const Sample&)> call;
+    QList<qint64> nanoseconds;
+};
+
+double percentileMs(const QList<qint64>& sorted, double percentile)
+{
+    if (sorted.isEmpty()) {
+        return 0.0;
+    }
+    // Nearest rank
+    const qsizetype rank = qBound<qsizetype>(1, static_cast<qsizetype>(std::ceil(percentile / 100.0 * sorted.size())),
+                                             sorted.size());
+    return sorted.at(rank - 1) / 1e6;
+}
+
+QList<Sample> sampleSessions(DbService<SessionModel>& db, int count)
+{
+    QList<Sample> samples;
+    QMap<QString, QVariant> params;
+    params["count"] = count;
+
+    db.executeVisitQuery(
+        "SELECT id, user_id, login_time FROM sessions "
+        "WHERE logout_time IS NOT NULL "
+        "ORDER BY random() LIMIT :count",
+        params,
+        [&samples](const QSqlQuery& row) {
+            Sample sample;
+            sample.sessionId = row.value("id").toUuid();
+            sample.userId = row.value("user_id").toUuid();
+            sample.loginTime = row.value("login_time").toDateTime();
+            sample.loginTime.setTimeSpec(Qt::UTC);
+            samples.append(sample);
+        });
+    return samples;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tms_querybench");
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    Logger::instance()->setLogLevel(Logger::Warning);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Time Activity Tracker repository aggregates against a local PostgreSQL database");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption configOption(QStringList() << "c" << "config",
+                                    QCoreApplication::translate("main", "Database config file (default: DB_* environment, localhost)"),
+                                    QCoreApplication::translate("main", "config"));
+    parser.addOption(configOption);
+
+    QCommandLineOption iterationsOption(QStringList() << "n" << "iterations",
+                                        QCoreApplication::translate("main", "Timed calls per method"),
+                                        QCoreApplication::translate("main", "count"), "200");
+    parser.addOption(iterationsOption);
+
+    QCommandLineOption warmupOption("warmup",
+                                    QCoreApplication::translate("main", "Untimed calls per method before measuring"),
+                                    QCoreApplication::translate("main", "count"), "20");
+    parser.addOption(warmupOption);
+
+    QCommandLineOption samplesOption("samples",
+                                     QCoreApplication::translate("main", "Distinct random sessions to rotate through"),
+                                     QCoreApplication::translate("main", "count"), "50");
+    parser.addOption(samplesOption);
+
+    QCommandLineOption filterOption(QStringList() << "f" << "filter",
+                                    QCoreApplication::translate("main", "Only run methods matching this regular expression"),
+                                    QCoreApplication::translate("main", "regex"));
+    parser.addOption(filterOption);
+
+    QCommandLineOption archiveOption("archive-dir",
+                                     QCoreApplication::translate("main", "Include archived partitions from this directory"),
+                                     QCoreApplication::translate("main", "directory"));
+    parser.addOption(archiveOption);
+
+    QCommandLineOption jsonOption(QStringList() << "j" << "json",
+                                  QCoreApplication::translate("main", "Write the report as JSON"));
+    parser.addOption(jsonOption);
+
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const int iterations = parser.value(iterationsOption).toInt();
+    const int warmup = qMax(0, parser.value(warmupOption).toInt());
+    const int sampleCount = parser.value(samplesOption).toInt();
+    if (iterations <= 0 || sampleCount <= 0) {
+        err << "Iterations and samples must be positive" << Qt::endl;
+        return 1;
+    }
+
+    const QRegularExpression filter(parser.value(filterOption));
+    if (!filter.isValid()) {
+        err << "Invalid filter: " << filter.errorString() << Qt::endl;
+        return 1;
+    }
+
+    if (!DbManager::instance().initialize(loadToolConfig(parser.value(configOption)))) {
+        err << "Cannot connect to the database" << Qt::endl;
+        return 1;
+    }
+
+    std::unique_ptr<ArchiveStore> archiveStore;
+    if (parser.isSet(archiveOption)) {
+        archiveStore = std::make_unique<ArchiveStore>(parser.value(archiveOption));
+        if (!archiveStore->load()) {
+            err << "Cannot load the archive manifest" << Qt::endl;
+            return 1;
+        }
+    }
+
+    // Wired the same way ApiServer::setupControllers does
+    SessionRepository sessionRepository;
+    SessionEventRepository sessionEventRepository;
+    ActivityEventRepository activityEventRepository;
+    AfkPeriodRepository afkPeriodRepository;
+    AppUsageRepository appUsageRepository;
+    SystemMetricsRepository systemMetricsRepository;
+
+    sessionRepository.initialize(&DbManager::instance().getService<SessionModel>());
+    sessionEventRepository.initialize(&DbManager::instance().getService<SessionEventModel>());
+    activityEventRepository.initialize(&DbManager::instance().getService<ActivityEventModel>());
+    afkPeriodRepository.initialize(&DbManager::instance().getService<AfkPeriodModel>());
+    appUsageRepository.initialize(&DbManager::instance().getService<AppUsageModel>());
+    systemMetricsRepository.initialize(&DbManager::instance().getService<SystemMetricsModel>());
+    sessionRepository.setSessionEventRepository(&sessionEventRepository);
+    activityEventRepository.setArchiveStore(archiveStore.get());
+    systemMetricsRepository.setArchiveStore(archiveStore.get());
+
+    const QList<Sample> samples = sampleSessions(DbManager::instance().getService<SessionModel>(), sampleCount);
+    if (samples.isEmpty()) {
+        err << "No finished sessions to sample; run tms_datagen first" << Qt::endl;
+        return 1;
+    }
+
+    // The user-level reports cover the 30 days up to the sampled session
+    auto reportStart = [](const Sample& s) { return QDateTime(s.loginTime.date().addDays(-29), QTime(0, 0), Qt::UTC); };
+    auto reportEnd = [](const Sample& s) { return QDateTime(s.loginTime.date().addDays(1), QTime(0, 0), Qt::UTC); };
+
+    QList<Benchmark> benchmarks = {
+        { "SessionRepository::getUserSessionStats", [&](const Sample& s) {
+              sessionRepository.getUserSessionStats(s.userId, reportStart(s), reportEnd(s));
+          }, {} },
+        { "SessionRepository::getSessionChain", [&](const Sample& s) {
+              sessionRepository.getSessionChain(s.sessionId);
+          }, {} },
+        { "SessionRepository::getSessionChainStats", [&](const Sample& s) {
+              sessionRepository.getSessionChainStats(s.sessionId);
+          }, {} },
+        { "AppUsageRepository::getTopApps", [&](const Sample& s) {
+              appUsageRepository.getTopApps(s.sessionId);
+          }, {} },
+        { "AppUsageRepository::getAppUsageSummary", [&](const Sample& s) {
+              appUsageRepository.getAppUsageSummary(s.sessionId);
+          }, {} },
+        { "AppUsageRepository::getUserTopApps", [&](const Sample& s) {
+              appUsageRepository.getUserTopApps(s.userId, reportStart(s).date(), s.loginTime.date());
+          }, {} },
+        { "ActivityEventRepository::getActivitySummary", [&](const Sample& s) {
+              activityEventRepository.getActivitySummary(s.sessionId);
+          }, {} },
+        { "AfkPeriodRepository::getAfkSummary", [&](const Sample& s) {
+              afkPeriodRepository.getAfkSummary(s.sessionId);
+          }, {} },
+        { "SessionEventRepository::getSessionEventSummary", [&](const Sample& s) {
+              sessionEventRepository.getSessionEventSummary(s.sessionId);
+          }, {} },
+        { "SystemMetricsRepository::getAverageMetrics", [&](const Sample& s) {
+              systemMetricsRepository.getAverageMetrics(s.sessionId);
+          }, {} },
+        { "SystemMetricsRepository::getBucketedMetricsTimeSeries", [&](const Sample& s) {
+              systemMetricsRepository.getBucketedMetricsTimeSeries(s.sessionId, "cpu_usage", 300);
+          }, {} },
+        { "SystemMetricsRepository::getDownsampledMetricsTimeSeries", [&](const Sample& s) {
+              systemMetricsRepository.getDownsampledMetricsTimeSeries(s.sessionId, "cpu_usage", 500);
+          }, {} }
+    };
+
+    QElapsedTimer timer;
+    for (Benchmark& benchmark : benchmarks) {
+        if (!benchmark.name.contains(filter)) {
+            continue;
+        }
+        if (!parser.isSet(jsonOption)) {
+            err << "Running " << benchmark.name << Qt::endl;
+        }
+
+        for (int i = 0; i < warmup + iterations; ++i) {
+            const Sample& sample = samples.at(i % samples.size());
+            timer.start();
+            benchmark.call(sample);
+            const qint64 elapsed = timer.nsecsElapsed();
+            if (i >= warmup) {
+                benchmark.nanoseconds.append(elapsed);
+            }
+        }
+        std::sort(benchmark.nanoseconds.begin(), benchmark.nanoseconds.end());
+    }
+
+    QJsonArray report;
+    if (!parser.isSet(jsonOption)) {
+        out << QString("%1 %2 %3 %4 %5 %6 %7 %8")
+                   .arg("method", -55).arg("calls", 6).arg("min", 9).arg("p50", 9)
+                   .arg("p90", 9).arg("p95", 9).arg("p99", 9).arg("max", 9)
+            << Qt::endl;
+    }
+
+    for (const Benchmark& benchmark : benchmarks) {
+        const QList<qint64>& ns = benchmark.nanoseconds;
+        if (ns.isEmpty()) {
+            continue;
+        }
+
+        if (parser.isSet(jsonOption)) {
+            QJsonObject entry;
+            entry["method"] = benchmark.name;
+            entry["calls"] = ns.size();
+            entry["min_ms"] = ns.first() / 1e6;
+            entry["p50_ms"] = percentileMs(ns, 50);
+            entry["p90_ms"] = percentileMs(ns, 90);
+            entry["p95_ms"] = percentileMs(ns, 95);
+            entry["p99_ms"] = percentileMs(ns, 99);
+            entry["max_ms"] = ns.last() / 1e6;
+            report.append(entry);
+        } else {
+            out << QString("%1 %2 %3 %4 %5 %6 %7 %8")
+                       .arg(benchmark.name, -55)
+                       .arg(ns.size(), 6)
+                       .arg(ns.first() / 1e6, 9, 'f', 2)
+                       .arg(percentileMs(ns, 50), 9, 'f', 2)
+                       .arg(percentileMs(ns, 90), 9, 'f', 2)
+                       .arg(percentileMs(ns, 95), 9, 'f', 2)
+                       .arg(percentileMs(ns, 99), 9, 'f', 2)
+                       .arg(ns.last() / 1e6, 9, 'f', 2)
+                << Qt::endl;
+        }
+    }
+
+    if (parser.isSet(jsonOption)) {
+        QJsonObject result;
+        result["iterations"] = iterations;
+        result["samples"] = samples.size();
+        result["methods"] = report;
+        out << QJsonDocument(result).toJson();
+    } else {
+        out << QString("Times in ms over %1 sampled sessions").arg(samples.size()) << Qt::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+// Columnar CBOR encoding of /api/batch bodies, written by the agent and read by the API.
+// Each array of row objects becomes a table of columns, so keys are written once per
+// batch instead of once per row:
+//
+//   { "v": 1,
+//     "fields":  { "session_id": ..., "client_batch_id": ... },
+//     "strings": [ interned strings ],
+//     "tables":  { "activity_events": { "n": rows, "cols": [ [name, kind, values], ... ] } } }
+//
+// A row without the key holds undefined. Typed columns are only used when every value
+// decodes back to the same JSON, so decode(encode(batch)) gives back the batch.
+namespace BatchCbor {
+
+// Bumped on any change to the layout or the column kinds. It is sent in the body and as
+// the version parameter of the Content-Type; a server without it answers 415.
+constexpr int FormatVersion = 1;
+
+// Content-Type of encode()'s output, naming FormatVersion
+QByteArray contentType();
+
+// Message of the 415 response to a body in a format version the server does not read
+constexpr const char* UnsupportedFormatMessage = "Unsupported batch format";
+
+enum ColumnKind {
+    PlainColumn = 0,       // plain CBOR values
+    StringColumn = 1,      // indices into "strings"
+    TimeMsColumn = 2,      // ISO time with milliseconds as delta-encoded UTC milliseconds
+    TimeSecondsColumn = 3, // ISO time in seconds as delta-encoded UTC milliseconds
+    IntegerColumn = 4      // delta-encoded integers
+};
+
+QByteArray encode(const QJsonObject& batch);
+
+// Decode a body into the object the agent encoded; unsupportedVersion is set when the
+// body is in another format version rather than malformed
+bool decode(const QByteArray& body, QJsonObject& batch, QString& error, bool* unsupportedVersion = nullptr);
+
+// Whether a Content-Type names this format, and in a version this build reads
+bool isCborContentType(const QByteArray& contentType);
+bool isSupportedContentType(const QByteArray& contentType);
+
+} // namespace BatchCbor
@@ -0,0 +1,374 @@
+#include "batchcbor/batchcbor.h"
+#include <QCborArray>
+#include <QCborMap>
+#include <QCborValue>
+#include <QDateTime>
+#include <QHash>
+#include <QJsonArray>
+#include <QStringList>
+#include <QVector>
+#include <cmath>
+
+namespace BatchCbor {
+
+namespace {
+
+// Largest integer a JSON number (double) holds exactly
+const double MaxExactInteger = 9007199254740992.0;
+
+bool isTable(const QJsonValue &value)
+{
+    if (!value.isArray()) {
+        return false;
+    }
+    const QJsonArray rows = value.toArray();
+    for (const QJsonValue &row : rows) {
+        if (!row.isObject()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isExactInteger(const QJsonValue &value)
+{
+    if (!value.isDouble()) {
+        return false;
+    }
+    const double number = value.toDouble();
+    return std::floor(number) == number && std::fabs(number) < MaxExactInteger;
+}
+
+// The time as UTC milliseconds, if formatting it back gives the same string
+bool timeRoundTrips(const QString &text, Qt::DateFormat format, qint64 &msecs)
+{
+    const QDateTime time = QDateTime::fromString(text, Qt::ISODate);
+    if (!time.isValid() || time.toUTC().toString(format) != text) {
+        return false;
+    }
+    msecs = time.toMSecsSinceEpoch();
+    return true;
+}
+
+ColumnKind chooseKind(const QVector<QJsonValue> &values)
+{
+    bool allStrings = true;
+    bool allIntegers = true;
+    for (const QJsonValue &value : values) {
+        if (value.isUndefined()) {
+            continue;
+        }
+        allStrings = allStrings && value.isString();
+        allIntegers = allIntegers && isExactInteger(value);
+    }
+
+    if (allIntegers) {
+        return IntegerColumn;
+    }
+    if (!allStrings) {
+        return PlainColumn;
+    }
+
+    for (ColumnKind kind : {TimeMsColumn, TimeSecondsColumn}) {
+        const Qt::DateFormat format = kind == TimeMsColumn ? Qt::ISODateWithMs : Qt::ISODate;
+        bool roundTrips = true;
+        for (const QJsonValue &value : values) {
+            qint64 msecs = 0;
+            if (!value.isUndefined() && !timeRoundTrips(value.toString(), format, msecs)) {
+                roundTrips = false;
+                break;
+            }
+        }
+        if (roundTrips) {
+            return kind;
+        }
+    }
+
+    return StringColumn;
+}
+
+class StringTable
+{
+public:
+    int indexOf(const QString &text) {
+        auto it = m_indices.constFind(text);
+        if (it != m_indices.constEnd()) {
+            return it.value();
+        }
+        const int index = m_strings.size();
+        m_indices.insert(text, index);
+        m_strings.append(text);
+        return index;
+    }
+
+    QCborArray strings() const { return m_strings; }
+
+private:
+    QHash<QString, int> m_indices;
+    QCborArray m_strings;
+};
+
+QCborArray encodeColumn(const QVector<QJsonValue> &values, ColumnKind kind, StringTable &strings)
+{
+    const QCborValue undefined(QCborSimpleType::Undefined);
+    QCborArray encoded;
+    qint64 previous = 0;
+
+    for (const QJsonValue &value : values) {
+        if (value.isUndefined()) {
+            encoded.append(undefined);
+            continue;
+        }
+
+        switch (kind) {
+        case StringColumn:
+            encoded.append(strings.indexOf(value.toString()));
+            break;
+        case TimeMsColumn:
+        case TimeSecondsColumn: {
+            qint64 msecs = 0;
+            timeRoundTrips(value.toString(), kind == TimeMsColumn ? Qt::ISODateWithMs : Qt::ISODate, msecs);
+            encoded.append(msecs - previous);
+            previous = msecs;
+            break;
+        }
+        case IntegerColumn: {
+            const qint64 number = static_cast<qint64>(value.toDouble());
+            encoded.append(number - previous);
+            previous = number;
+            break;
+        }
+        case PlainColumn:
+            encoded.append(QCborValue::fromJsonValue(value));
+            break;
+        }
+    }
+
+    return encoded;
+}
+
+QCborMap encodeTable(const QJsonArray &rows, StringTable &strings)
+{
+    // Columns in the order their keys first appear
+    QStringList names;
+    QHash<QString, int> nameIndex;
+    for (const QJsonValue &row : rows) {
+        const QJsonObject object = row.toObject();
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+            if (!nameIndex.contains(it.key())) {
+                nameIndex.insert(it.key(), names.size());
+                names.append(it.key());
+            }
+        }
+    }
+
+    QVector<QVector<QJsonValue>> columns(names.size(), QVector<QJsonValue>(rows.size(), QJsonValue(QJsonValue::Undefined)));
+    for (int i = 0; i < rows.size(); ++i) {
+        const QJsonObject object = rows[i].toObject();
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+            columns[nameIndex.value(it.key())][i] = it.value();
+        }
+    }
+
+    QCborArray cols;
+    for (int c = 0; c < names.size(); ++c) {
+        const ColumnKind kind = chooseKind(columns[c]);
+        cols.append(QCborArray{names[c], static_cast<int>(kind), encodeColumn(columns[c], kind, strings)});
+    }
+
+    QCborMap table;
+    table[QLatin1String("n")] = rows.size();
+    table[QLatin1String("cols")] = cols;
+    return table;
+}
+
+// A body cannot describe more rows than this, whatever "n" claims
+const qint64 MaxRowsPerTable = 1000000;
+
+bool decodeColumn(const QCborArray &column, const QVector<QString> &strings, QVector<QJsonObject> &rows,
+                  QString &error)
+{
+    if (column.size() != 3 || !column[0].isString() || !column[1].isInteger() || !column[2].isArray()) {
+        error = "Malformed column";
+        return false;
+    }
+
+    const QString name = column[0].toString();
+    const qint64 kind = column[1].toInteger();
+    const QCborArray values = column[2].toArray();
+    if (values.size() != rows.size()) {
+        error = QString("Column %1 has %2 values for %3 rows").arg(name).arg(values.size()).arg(rows.size());
+        return false;
+    }
+
+    qint64 previous = 0;
+    for (qsizetype i = 0; i < values.size(); ++i) {
+        const QCborValue value = values[i];
+        if (value.isUndefined()) {
+            continue;
+        }
+
+        switch (kind) {
+        case PlainColumn:
+            rows[i].insert(name, value.toJsonValue());
+            break;
+        case StringColumn: {
+            const qint64 index = value.isInteger() ? value.toInteger() : -1;
+            if (index < 0 || index >= strings.size()) {
+                error = QString("Column %1 has an invalid string index").arg(name);
+                return false;
+            }
+            rows[i].insert(name, strings[index]);
+            break;
+        }
+        case TimeMsColumn:
+        case TimeSecondsColumn:
+        case IntegerColumn: {
+            if (!value.isInteger()) {
+                error = QString("Column %1 has a non-integer value").arg(name);
+                return false;
+            }
+            previous += value.toInteger();
+            if (kind == IntegerColumn) {
+                rows[i].insert(name, previous);
+            } else {
+                const QDateTime time = QDateTime::fromMSecsSinceEpoch(previous, Qt::UTC);
+                rows[i].insert(name, time.toString(kind == TimeMsColumn ? Qt::ISODateWithMs : Qt::ISODate));
+            }
+            break;
+        }
+        default:
+            error = QString("Column %1 has unknown kind %2").arg(name).arg(kind);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool decodeTable(const QCborMap &table, const QVector<QString> &strings, QJsonArray &result, QString &error)
+{
+    const qint64 rowCount = table.value(QLatin1String("n")).toInteger(-1);
+    if (rowCount < 0 || rowCount > MaxRowsPerTable) {
+        error = "Invalid row count";
+        return false;
+    }
+
+    QVector<QJsonObject> rows(rowCount);
+    const QCborArray columns = table.value(QLatin1String("cols")).toArray();
+    for (const QCborValue &column : columns) {
+        if (!decodeColumn(column.toArray(), strings, rows, error)) {
+            return false;
+        }
+    }
+
+    for (const QJsonObject &row : rows) {
+        result.append(row);
+    }
+    return true;
+}
+
+// Value of the version parameter, 0 if absent
+int contentTypeVersion(const QByteArray &contentType)
+{
+    const QList<QByteArray> parts = contentType.split(';');
+    for (int i = 1; i < parts.size(); ++i) {
+        const QByteArray parameter = parts[i].trimmed();
+        if (parameter.startsWith("version=")) {
+            return parameter.mid(8).toInt();
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+QByteArray contentType()
+{
+    return "application/cbor; version=" + QByteArray::number(FormatVersion);
+}
+
+bool isCborContentType(const QByteArray &contentType)
+{
+    return contentType.startsWith("application/cbor");
+}
+
+bool isSupportedContentType(const QByteArray &contentType)
+{
+    // Agents from before the parameter existed sent version 1 without it
+    const int version = contentTypeVersion(contentType);
+    return isCborContentType(contentType) && (version == 0 || version == FormatVersion);
+}
+
+QByteArray encode(const QJsonObject &batch)
+{
+    StringTable strings;
+    QCborMap fields;
+    QCborMap tables;
+
+    for (auto it = batch.constBegin(); it != batch.constEnd(); ++it) {
+        if (isTable(it.value())) {
+            tables[it.key()] = encodeTable(it.value().toArray(), strings);
+        } else {
+            fields[it.key()] = QCborValue::fromJsonValue(it.value());
+        }
+    }
+
+    QCborMap root;
+    root[QLatin1String("v")] = FormatVersion;
+    root[QLatin1String("fields")] = fields;
+    root[QLatin1String("strings")] = strings.strings();
+    root[QLatin1String("tables")] = tables;
+    return root.toCborValue().toCbor();
+}
+
+bool decode(const QByteArray &body, QJsonObject &batch, QString &error, bool *unsupportedVersion)
+{
+    QCborParserError parseError;
+    const QCborValue root = QCborValue::fromCbor(body, &parseError);
+    if (parseError.error != QCborError::NoError) {
+        error = parseError.errorString();
+        return false;
+    }
+    if (!root.isMap()) {
+        error = "Batch body is not a CBOR map";
+        return false;
+    }
+
+    const QCborMap map = root.toMap();
+    if (map.value(QLatin1String("v")).toInteger() != FormatVersion) {
+        error = QString("Unsupported batch format version %1").arg(map.value(QLatin1String("v")).toInteger());
+        if (unsupportedVersion) {
+            *unsupportedVersion = true;
+        }
+        return false;
+    }
+
+    QVector<QString> strings;
+    const QCborArray stringArray = map.value(QLatin1String("strings")).toArray();
+    strings.reserve(stringArray.size());
+    for (const QCborValue &value : stringArray) {
+        strings.append(value.toString());
+    }
+
+    QJsonObject result;
+    const QCborMap fields = map.value(QLatin1String("fields")).toMap();
+    for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) {
+        result.insert(it.key().toString(), it.value().toJsonValue());
+    }
+
+    const QCborMap tables = map.value(QLatin1String("tables")).toMap();
+    for (auto it = tables.constBegin(); it != tables.constEnd(); ++it) {
+        QJsonArray rows;
+        if (!decodeTable(it.value().toMap(), strings, rows, error)) {
+            error = QString("%1: %2").arg(it.key().toString(), error);
+            return false;
+        }
+        result.insert(it.key().toString(), rows);
+    }
+
+    batch = result;
+    return true;
+}
+
+} // namespace BatchCbor
@@ -1,4 +1,5 @@
 #pragma once
+#include <QList>
 #include <QString>
 
 class DbConfig {
@@ -13,10 +14,20 @@ public:
     QString password() const { return m_password; }
     int port() const { return m_port; }
 
+    // Read replicas share the primary's database name and credentials
+    QList<DbConfig> replicas() const { return m_replicas; }
+    // Staleness allowed for reads routed as QueryRouting::StaleTolerant
+    int maxReplicaLagSeconds() const { return m_maxReplicaLagSeconds; }
+
 private:
+    // "host[:port]" entries separated by commas
+    void setReplicas(const QString& hosts);
+
     QString m_host;
     QString m_database;
     QString m_username;
     QString m_password;
     int m_port;
+    QList<DbConfig> m_replicas;
+    int m_maxReplicaLagSeconds = 30;
 };
\ No newline at end of file
@@ -2,15 +2,27 @@
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
+#include <QElapsedTimer>
 #include <functional>
 #include <optional>
 #include "dbconfig.h"
+#include "querystats.h"
+#include "replicamonitor.h"
 #include "logger/logger.h"
 
+// Where a SELECT may run. Writes, and reads inside a transaction, always use the primary;
+// a replica that is unreachable or lagging too far falls back to the primary as well.
+enum class QueryRouting {
+    Primary,        // must see the latest writes
+    ReadOnly,       // a replica no more than a second behind, counting the age of its lag sample
+    StaleTolerant   // a replica within DbConfig::maxReplicaLagSeconds()
+};
+
 template<typename T>
 class DbService {
 public:
     using QueryProcessor = std::function<T*(const QSqlQuery&)>;
+    using RowVisitor = std::function<void(const QSqlQuery&)>;
 
     explicit DbService(const DbConfig& config);
     ~DbService();
@@ -19,13 +31,23 @@ public:
     QList<T*> executeSelectQuery(
         const QString& queryStr,
         const QMap<QString, QVariant>& params,
-        const QueryProcessor& processor);
+        const QueryProcessor& processor,
+        QueryRouting routing = QueryRouting::Primary);
 
     // Execute a SELECT query and return single result
     std::optional<T*> executeSingleSelectQuery(
         const QString& queryStr,
         const QMap<QString, QVariant>& params,
-        const QueryProcessor& processor);
+        const QueryProcessor& processor,
+        QueryRouting routing = QueryRouting::Primary);
+
+    // Execute a SELECT query and hand each row to the visitor without creating models.
+    // Returns the number of rows visited, or -1 if the query failed.
+    int executeVisitQuery(
+        const QString& queryStr,
+        const QMap<QString, QVariant>& params,
+        const RowVisitor& visitor,
+        QueryRouting routing = QueryRouting::Primary);
 
     // Execute an INSERT, UPDATE, or DELETE query
     bool executeModificationQuery(
@@ -48,6 +70,11 @@ public:
     // Rollback a transaction
     bool rollbackTransaction();
 
+    // Savepoints inside an open transaction, so one failed statement does not abort it
+    bool createSavepoint(const QString& name);
+    bool releaseSavepoint(const QString& name);
+    bool rollbackToSavepoint(const QString& name);
+
     // Check if connection is valid
     bool isConnectionValid() const;
 
@@ -58,9 +85,65 @@ public:
     QSqlQuery createQuery();
 
 private:
+    // Times one statement and reports it to QueryStats when it goes out of scope.
+    // explainOn is the connection that ran a statement safe to re-run under EXPLAIN ANALYZE;
+    // leave it invalid for anything that may write, lock or call a volatile function.
+    class QueryTiming {
+    public:
+        QueryTiming(DbService* service, const QString& queryStr, const QMap<QString, QVariant>& params,
+                    const QSqlDatabase& explainOn = QSqlDatabase());
+        ~QueryTiming();
+
+        bool prepared(bool ok);
+        bool executed(bool ok);
+        void setRows(qint64 rows) { m_rows = rows; }
+        void setExplainOn(const QSqlDatabase& db) { m_explainDb = db; }
+
+    private:
+        DbService* m_service;
+        const QString& m_queryStr;
+        const QMap<QString, QVariant>& m_params;
+        QSqlDatabase m_explainDb;
+        bool m_ok = false;
+        qint64 m_rows = -1;
+        qint64 m_prepareNs = 0;
+        qint64 m_execNs = 0;
+        qint64 m_markNs = 0;
+        QElapsedTimer m_timer;
+    };
+
+    // A replica whose connection failed is skipped until the monitor has sampled it again
+    static constexpr int ReplicaEjectMs = ReplicaMonitor::SampleIntervalMs;
+
+    struct Replica {
+        DbConfig config;
+        QString key;
+        QString connectionName;
+        QSqlDatabase db;
+        QElapsedTimer ejected;
+    };
+
     void initializeDatabase(const DbConfig& config);
     bool ensureConnected();
+    // Connection for a read: a replica in round-robin order if its sampled lag is low enough, else
+    // the primary. Never waits on a lag query; only the first read on a replica opens its connection.
+    QSqlDatabase connectionFor(QueryRouting routing);
+    // Take a replica out of rotation when a statement on it failed for connection reasons; true if
+    // the statement should be retried on the primary
+    bool replicaFailed(const QSqlDatabase& db, const QSqlError& error);
+    // Prepare, bind and execute on query's connection
+    bool runStatement(QSqlQuery& query, const QString& queryStr, const QMap<QString, QVariant>& params,
+                      QueryTiming& timing);
+    bool executeSavepointCommand(const QString& command, const QString& name);
+    // Connection a slow read may be explained on: only reads the caller routed away from the
+    // primary, which declares them free of side effects
+    QSqlDatabase explainableOn(const QSqlDatabase& db, QueryRouting routing) const;
+    // Plan of a slow read-only statement, run on db in a transaction that is rolled back
+    QString explainQuery(QSqlDatabase db, const QString& queryStr, const QMap<QString, QVariant>& params);
     QString m_connectionName;
     QSqlDatabase m_db;
     DbConfig m_config;
+    bool m_inTransaction = false;
+    QList<Replica> m_replicas;
+    int m_nextReplica = 0;
 };
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <QUuid>
 #include <QSqlDriver>
 #include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QStringList>
 
 template<typename T>
 DbService<T>::DbService(const DbConfig& config)
@@ -15,10 +17,30 @@ DbService<T>::DbService(const DbConfig& config)
                        .arg(QUuid::createUuid().toString(QUuid::WithoutBraces));
 
     initializeDatabase(config);
+
+    // Replica connections are opened on the first read routed to them; their lag is sampled elsewhere
+    for (const DbConfig& replicaConfig : config.replicas()) {
+        Replica replica;
+        replica.config = replicaConfig;
+        replica.key = ReplicaMonitor::keyFor(replicaConfig);
+        replica.connectionName = QString("%1_replica%2").arg(m_connectionName).arg(m_replicas.size());
+        m_replicas.append(replica);
+    }
+    if (!m_replicas.isEmpty()) {
+        ReplicaMonitor::instance().watch(config.replicas());
+    }
 }
 
 template<typename T>
 DbService<T>::~DbService() {
+    for (Replica& replica : m_replicas) {
+        if (replica.db.isValid()) {
+            replica.db.close();
+            replica.db = QSqlDatabase();
+            QSqlDatabase::removeDatabase(replica.connectionName);
+        }
+    }
+
     // Close the database connection if open
     if (m_db.isOpen()) {
         LOG_DEBUG(QString("Closing database connection: %1").arg(m_connectionName));
@@ -73,86 +95,220 @@ bool DbService<T>::ensureConnected() {
     return true;
 }
 
+template<typename T>
+QSqlDatabase DbService<T>::connectionFor(QueryRouting routing) {
+    // Reads inside a transaction must see its uncommitted writes
+    if (routing == QueryRouting::Primary || m_replicas.isEmpty() || m_inTransaction) {
+        return m_db;
+    }
+
+    const double allowedLag = routing == QueryRouting::ReadOnly
+                              ? qMin(1, m_config.maxReplicaLagSeconds())
+                              : m_config.maxReplicaLagSeconds();
+    ReplicaMonitor& monitor = ReplicaMonitor::instance();
+
+    for (int i = 0; i < m_replicas.size(); ++i) {
+        const int index = (m_nextReplica + i) % m_replicas.size();
+        Replica& replica = m_replicas[index];
+        if (replica.ejected.isValid() && !replica.ejected.hasExpired(ReplicaEjectMs)) {
+            continue;
+        }
+
+        const double lag = monitor.lagSeconds(replica.key);
+        if (lag < 0 || lag > allowedLag) {
+            continue;
+        }
+
+        if (!replica.db.isValid()) {
+            replica.db = QSqlDatabase::addDatabase("QPSQL", replica.connectionName);
+            replica.db.setHostName(replica.config.host());
+            replica.db.setDatabaseName(replica.config.database());
+            replica.db.setUserName(replica.config.username());
+            replica.db.setPassword(replica.config.password());
+            replica.db.setPort(replica.config.port());
+            replica.db.setConnectOptions("application_name=DBService;connect_timeout=2");
+        }
+
+        // The monitor reached it moments ago, so this connect is not expected to wait
+        if (!replica.db.isOpen() && !replica.db.open()) {
+            LOG_WARNING(QString("Read replica %1 is unreachable: %2").arg(replica.key, replica.db.lastError().text()));
+            replica.ejected.start();
+            continue;
+        }
+
+        m_nextReplica = (index + 1) % m_replicas.size();
+        return replica.db;
+    }
+
+    return m_db;
+}
+
+template<typename T>
+bool DbService<T>::replicaFailed(const QSqlDatabase& db, const QSqlError& error) {
+    if (db.connectionName() == m_connectionName) {
+        return false;
+    }
+
+    // Only errors about the connection say anything about the replica; a bad statement fails on
+    // the primary too. Lost connections come without a SQLSTATE, refused ones with class 08 or
+    // 57P0x, and a replica that stopped serving reads with a recovery conflict (40001).
+    const QString state = error.nativeErrorCode();
+    const bool connectionError = error.type() == QSqlError::ConnectionError
+                                 || state.isEmpty()
+                                 || state.startsWith("08")
+                                 || state.startsWith("57P0")
+                                 || state == "40001";
+    if (!connectionError) {
+        return false;
+    }
+
+    for (Replica& replica : m_replicas) {
+        if (replica.connectionName == db.connectionName()) {
+            LOG_WARNING(QString("Query failed on read replica %1, retrying on the primary: %2")
+                       .arg(replica.key, error.text()));
+            replica.db.close();
+            replica.ejected.start();
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename T>
+bool DbService<T>::runStatement(
+    QSqlQuery& query,
+    const QString& queryStr,
+    const QMap<QString, QVariant>& params,
+    QueryTiming& timing)
+{
+    // Use exec(QString) for statements without parameters to prevent prepared statement usage
+    if (params.isEmpty()) {
+        return timing.executed(query.exec(queryStr));
+    }
+
+    if (!timing.prepared(query.prepare(queryStr))) {
+        return false;
+    }
+
+    for (auto it = params.constBegin(); it != params.constEnd(); ++it) {
+        query.bindValue(":" + it.key(), it.value());
+    }
+    return timing.executed(query.exec());
+}
+
 template<typename T>
 QList<T*> DbService<T>::executeSelectQuery(
     const QString& queryStr,
     const QMap<QString, QVariant>& params,
-    const QueryProcessor& processor)
+    const QueryProcessor& processor,
+    QueryRouting routing)
 {
     if (!ensureConnected()) {
         LOG_ERROR("Cannot execute query, database is not connected");
         return QList<T*>();
     }
 
+    QSqlDatabase db = connectionFor(routing);
+
     QElapsedTimer timer;
     timer.start();
+    QueryTiming timing(this, queryStr, params, explainableOn(db, routing));
 
     QList<T*> results;  // Changed from QVector<T*> to QList<T*>
 
     try {
-        // For queries without parameters, create a new connection to avoid prepared statement issues
-        if (params.isEmpty()) {
-            // Create a direct query without using prepare/bind
-            QSqlQuery query(m_db);
+        QSqlQuery query(db);
+        bool executed = runStatement(query, queryStr, params, timing);
+        if (!executed && replicaFailed(db, query.lastError())) {
+            query = QSqlQuery(m_db);
+            timing.setExplainOn(explainableOn(m_db, routing));
+            executed = runStatement(query, queryStr, params, timing);
+        }
 
-            // Use exec(QString) instead of exec() to prevent prepare statement usage
-            if (!query.exec(queryStr)) {
-                LOG_ERROR(QString("Query failed: %1\nQuery: %2")
-                         .arg(query.lastError().text(), queryStr));
-                return QList<T*>();
+        if (!executed) {
+            LOG_ERROR(QString("Query failed: %1\nQuery: %2")
+                     .arg(query.lastError().text(), queryStr));
+            if (!params.isEmpty()) {
+                LOG_DATA(Logger::Error, params);
             }
+            return QList<T*>();
+        }
 
-            // Process results
-            while (query.next()) {
-                results.append(processor(query));
-            }
+        // Process results
+        while (query.next()) {
+            results.append(processor(query));
+        }
 
-            LOG_DEBUG(QString("Query executed in %1 ms, returned %2 rows")
-                     .arg(timer.elapsed())
-                     .arg(results.size()));
+        timing.setRows(results.size());
+        LOG_DEBUG(QString("Query executed in %1 ms, returned %2 rows")
+                 .arg(timer.elapsed())
+                 .arg(results.size()));
 
-            return results;
-        } else {
-            // For parameterized queries, use prepare/bind
-            QSqlQuery query(m_db);
-            if (!query.prepare(queryStr)) {
-                LOG_ERROR(QString("Query preparation failed: %1\nQuery: %2")
-                         .arg(query.lastError().text(), queryStr));
-                return QList<T*>();
-            }
+        return results;
+    }
+    catch (const std::exception& ex) {
+        LOG_ERROR(QString("Exception during query execution: %1\nQuery: %2")
+                 .arg(ex.what(), queryStr));
+        return QList<T*>();
+    }
+}
 
-            // Bind parameters
-            for (auto it = params.constBegin(); it != params.constEnd(); ++it) {
-                query.bindValue(":" + it.key(), it.value());
-            }
+template<typename T>
+int DbService<T>::executeVisitQuery(
+    const QString& queryStr,
+    const QMap<QString, QVariant>& params,
+    const RowVisitor& visitor,
+    QueryRouting routing)
+{
+    if (!ensureConnected()) {
+        LOG_ERROR("Cannot execute query, database is not connected");
+        return -1;
+    }
 
-            if (!query.exec()) {
-                LOG_ERROR(QString("Query failed: %1\nQuery: %2")
-                         .arg(query.lastError().text(), queryStr));
-                QMap<QString, QVariant> errorParams;
-                for (auto it = params.constBegin(); it != params.constEnd(); ++it) {
-                    errorParams[it.key()] = it.value();
-                }
-                LOG_DATA(Logger::Error, errorParams);
-                return QList<T*>();
-            }
+    QSqlDatabase db = connectionFor(routing);
 
-            // Process results
-            while (query.next()) {
-                results.append(processor(query));
-            }
+    QElapsedTimer timer;
+    timer.start();
+    QueryTiming timing(this, queryStr, params, explainableOn(db, routing));
 
-            LOG_DEBUG(QString("Query executed in %1 ms, returned %2 rows")
-                     .arg(timer.elapsed())
-                     .arg(results.size()));
+    try {
+        QSqlQuery query(db);
+        // Rows are read once, so the driver need not keep them all for scrolling back
+        query.setForwardOnly(true);
+
+        bool executed = runStatement(query, queryStr, params, timing);
+        if (!executed && replicaFailed(db, query.lastError())) {
+            query = QSqlQuery(m_db);
+            query.setForwardOnly(true);
+            timing.setExplainOn(explainableOn(m_db, routing));
+            executed = runStatement(query, queryStr, params, timing);
+        }
 
-            return results;
+        if (!executed) {
+            LOG_ERROR(QString("Query failed: %1\nQuery: %2")
+                     .arg(query.lastError().text(), queryStr));
+            if (!params.isEmpty()) {
+                LOG_DATA(Logger::Error, params);
+            }
+            return -1;
+        }
+
+        int rows = 0;
+        while (query.next()) {
+            visitor(query);
+            ++rows;
         }
+        timing.setRows(rows);
+
+        LOG_DEBUG(QString("Query executed in %1 ms, visited %2 rows")
+                 .arg(timer.elapsed())
+                 .arg(rows));
+        return rows;
     }
     catch (const std::exception& ex) {
         LOG_ERROR(QString("Exception during query execution: %1\nQuery: %2")
                  .arg(ex.what(), queryStr));
-        return QList<T*>();
+        return -1;
     }
 }
 
@@ -160,76 +316,51 @@ template<typename T>
 std::optional<T*> DbService<T>::executeSingleSelectQuery(
     const QString& queryStr,
     const QMap<QString, QVariant>& params,
-    const QueryProcessor& processor)
+    const QueryProcessor& processor,
+    QueryRouting routing)
 {
     if (!ensureConnected()) {
         LOG_ERROR("Cannot execute query, database is not connected");
         return std::nullopt;
     }
 
+    QSqlDatabase db = connectionFor(routing);
+
     QElapsedTimer timer;
     timer.start();
+    QueryTiming timing(this, queryStr, params, explainableOn(db, routing));
 
     try {
-        // For queries without parameters, use direct execution
-        if (params.isEmpty()) {
-            QSqlQuery query(m_db);
-
-            // Use exec(QString) instead of exec() to prevent prepare statement usage
-            if (!query.exec(queryStr)) {
-                LOG_ERROR(QString("Query failed: %1\nQuery: %2")
-                         .arg(query.lastError().text(), queryStr));
-                return std::nullopt;
-            }
+        QSqlQuery query(db);
+        bool executed = runStatement(query, queryStr, params, timing);
+        if (!executed && replicaFailed(db, query.lastError())) {
+            query = QSqlQuery(m_db);
+            timing.setExplainOn(explainableOn(m_db, routing));
+            executed = runStatement(query, queryStr, params, timing);
+        }
 
-            // Process the first result
-            if (query.next()) {
-                T* result = processor(query);
-                LOG_DEBUG(QString("Query executed in %1 ms, returned 1 row")
-                         .arg(timer.elapsed()));
-                return result;
+        if (!executed) {
+            LOG_ERROR(QString("Query failed: %1\nQuery: %2")
+                     .arg(query.lastError().text(), queryStr));
+            if (!params.isEmpty()) {
+                LOG_DATA(Logger::Error, params);
             }
-
-            LOG_DEBUG(QString("Query executed in %1 ms, returned 0 rows")
-                     .arg(timer.elapsed()));
             return std::nullopt;
-        } else {
-            // For parameterized queries, use prepare/bind
-            QSqlQuery query(m_db);
-            if (!query.prepare(queryStr)) {
-                LOG_ERROR(QString("Query preparation failed: %1\nQuery: %2")
-                         .arg(query.lastError().text(), queryStr));
-                return std::nullopt;
-            }
-
-            // Bind parameters
-            for (auto it = params.constBegin(); it != params.constEnd(); ++it) {
-                query.bindValue(":" + it.key(), it.value());
-            }
-
-            if (!query.exec()) {
-                LOG_ERROR(QString("Query failed: %1\nQuery: %2")
-                         .arg(query.lastError().text(), queryStr));
-                QMap<QString, QVariant> errorParams;
-                for (auto it = params.constBegin(); it != params.constEnd(); ++it) {
-                    errorParams[it.key()] = it.value();
-                }
-                LOG_DATA(Logger::Error, errorParams);
-                return std::nullopt;
-            }
-
-            // Process the first result
-            if (query.next()) {
-                T* result = processor(query);
-                LOG_DEBUG(QString("Query executed in %1 ms, returned 1 row")
-                         .arg(timer.elapsed()));
-                return result;
-            }
+        }
 
-            LOG_DEBUG(QString("Query executed in %1 ms, returned 0 rows")
+        // Process the first result
+        if (query.next()) {
+            timing.setRows(1);
+            T* result = processor(query);
+            LOG_DEBUG(QString("Query executed in %1 ms, returned 1 row")
                      .arg(timer.elapsed()));
-            return std::nullopt;
+            return result;
         }
+
+        timing.setRows(0);
+        LOG_DEBUG(QString("Query executed in %1 ms, returned 0 rows")
+                 .arg(timer.elapsed()));
+        return std::nullopt;
     }
     catch (const std::exception& ex) {
         LOG_ERROR(QString("Exception during query execution: %1\nQuery: %2")
@@ -250,6 +381,7 @@ bool DbService<T>::executeModificationQuery(
 
     QElapsedTimer timer;
     timer.start();
+    QueryTiming timing(this, queryStr, params);
 
     try {
         // For queries without parameters, use direct execution
@@ -257,12 +389,13 @@ bool DbService<T>::executeModificationQuery(
             QSqlQuery query(m_db);
 
             // Use exec(QString) instead of exec() to prevent prepare statement usage
-            if (!query.exec(queryStr)) {
+            if (!timing.executed(query.exec(queryStr))) {
                 LOG_ERROR(QString("Query failed: %1\nQuery: %2")
                          .arg(query.lastError().text(), queryStr));
                 return false;
             }
 
+            timing.setRows(query.numRowsAffected());
             LOG_DEBUG(QString("Query executed in %1 ms, affected %2 rows")
                      .arg(timer.elapsed())
                      .arg(query.numRowsAffected()));
@@ -270,7 +403,7 @@ bool DbService<T>::executeModificationQuery(
         } else {
             // For parameterized queries, use prepare/bind
             QSqlQuery query(m_db);
-            if (!query.prepare(queryStr)) {
+            if (!timing.prepared(query.prepare(queryStr))) {
                 LOG_ERROR(QString("Query preparation failed: %1\nQuery: %2")
                          .arg(query.lastError().text(), queryStr));
                 return false;
@@ -281,7 +414,7 @@ bool DbService<T>::executeModificationQuery(
                 query.bindValue(":" + it.key(), it.value());
             }
 
-            if (!query.exec()) {
+            if (!timing.executed(query.exec())) {
                 LOG_ERROR(QString("Query failed: %1\nQuery: %2")
                          .arg(query.lastError().text(), queryStr));
                 QMap<QString, QVariant> errorParams;
@@ -292,6 +425,7 @@ bool DbService<T>::executeModificationQuery(
                 return false;
             }
 
+            timing.setRows(query.numRowsAffected());
             LOG_DEBUG(QString("Query executed in %1 ms, affected %2 rows")
                      .arg(timer.elapsed())
                      .arg(query.numRowsAffected()));
@@ -318,6 +452,7 @@ bool DbService<T>::beginTransaction() {
     }
 
     bool success = m_db.transaction();
+    m_inTransaction = success;
     if (!success) {
         LOG_ERROR(QString("Failed to begin transaction: %1").arg(m_db.lastError().text()));
     } else {
@@ -335,6 +470,7 @@ bool DbService<T>::commitTransaction() {
     }
 
     bool success = m_db.commit();
+    m_inTransaction = false;
     if (!success) {
         LOG_ERROR(QString("Failed to commit transaction: %1").arg(m_db.lastError().text()));
     } else {
@@ -352,6 +488,7 @@ bool DbService<T>::rollbackTransaction() {
     }
 
     bool success = m_db.rollback();
+    m_inTransaction = false;
     if (!success) {
         LOG_ERROR(QString("Failed to rollback transaction: %1").arg(m_db.lastError().text()));
     } else {
@@ -361,6 +498,44 @@ bool DbService<T>::rollbackTransaction() {
     return success;
 }
 
+template<typename T>
+bool DbService<T>::executeSavepointCommand(const QString& command, const QString& name) {
+    if (!m_db.isOpen()) {
+        LOG_ERROR(QString("Cannot %1 %2, database is not connected").arg(command.toLower(), name));
+        return false;
+    }
+
+    // Savepoint names cannot be bound as parameters
+    static const QRegularExpression validName("^[A-Za-z_][A-Za-z0-9_]*$");
+    if (!validName.match(name).hasMatch()) {
+        LOG_ERROR(QString("Invalid savepoint name: %1").arg(name));
+        return false;
+    }
+
+    QSqlQuery query(m_db);
+    if (!query.exec(command + " " + name)) {
+        LOG_ERROR(QString("Failed to %1 %2: %3").arg(command.toLower(), name, query.lastError().text()));
+        return false;
+    }
+
+    return true;
+}
+
+template<typename T>
+bool DbService<T>::createSavepoint(const QString& name) {
+    return executeSavepointCommand("SAVEPOINT", name);
+}
+
+template<typename T>
+bool DbService<T>::releaseSavepoint(const QString& name) {
+    return executeSavepointCommand("RELEASE SAVEPOINT", name);
+}
+
+template<typename T>
+bool DbService<T>::rollbackToSavepoint(const QString& name) {
+    return executeSavepointCommand("ROLLBACK TO SAVEPOINT", name);
+}
+
 template<typename T>
 bool DbService<T>::isConnectionValid() const {
     return m_db.isOpen() && m_db.isValid();
@@ -407,10 +582,11 @@ bool DbService<T>::executeInsertWithReturningId(
 
     QElapsedTimer timer;
     timer.start();
+    QueryTiming timing(this, query, params);
 
     try {
         QSqlQuery sqlQuery(m_db);
-        if (!sqlQuery.prepare(query)) {
+        if (!timing.prepared(sqlQuery.prepare(query))) {
             LOG_ERROR(QString("Query preparation failed: %1\nQuery: %2")
                      .arg(sqlQuery.lastError().text(), query));
             return false;
@@ -422,7 +598,7 @@ bool DbService<T>::executeInsertWithReturningId(
         }
 
         // Execute the query
-        if (!sqlQuery.exec()) {
+        if (!timing.executed(sqlQuery.exec())) {
             LOG_ERROR(QString("Query failed: %1\nQuery: %2")
                      .arg(sqlQuery.lastError().text(), query));
             QMap<QString, QVariant> errorParams;
@@ -435,6 +611,7 @@ bool DbService<T>::executeInsertWithReturningId(
 
         // Get the returned ID
         if (sqlQuery.next()) {
+            timing.setRows(1);
             QVariant idValue = sqlQuery.value(idColumnName);
             if (!idValue.isNull()) {
                 idHandler(idValue);
@@ -456,3 +633,109 @@ bool DbService<T>::executeInsertWithReturningId(
     }
 }
 
+
+template<typename T>
+DbService<T>::QueryTiming::QueryTiming(
+    DbService* service,
+    const QString& queryStr,
+    const QMap<QString, QVariant>& params,
+    const QSqlDatabase& explainOn)
+    : m_service(service)
+    , m_queryStr(queryStr)
+    , m_params(params)
+    , m_explainDb(explainOn)
+{
+    m_timer.start();
+}
+
+template<typename T>
+bool DbService<T>::QueryTiming::prepared(bool ok) {
+    const qint64 now = m_timer.nsecsElapsed();
+    m_prepareNs += now - m_markNs;
+    m_markNs = now;
+    return ok;
+}
+
+template<typename T>
+bool DbService<T>::QueryTiming::executed(bool ok) {
+    const qint64 now = m_timer.nsecsElapsed();
+    m_execNs += now - m_markNs;
+    m_markNs = now;
+    m_ok = ok;
+    return ok;
+}
+
+template<typename T>
+DbService<T>::QueryTiming::~QueryTiming() {
+    const qint64 totalNs = m_timer.nsecsElapsed();
+    QueryStats& stats = QueryStats::instance();
+    stats.record(m_queryStr, m_prepareNs, m_execNs, totalNs, m_rows, m_ok);
+
+    if (!stats.isSlow(totalNs)) {
+        return;
+    }
+
+    // Re-running the statement is only safe outside the caller's transaction
+    QString plan;
+    if (m_ok && m_explainDb.isValid() && stats.shouldExplain()) {
+        plan = m_service->explainQuery(m_explainDb, m_queryStr, m_params);
+    }
+
+    LOG_WARNING(QString("Slow query: %1 ms, %2 rows%3\nQuery: %4")
+               .arg(totalNs / 1e6, 0, 'f', 1)
+               .arg(m_rows)
+               .arg(m_ok ? QString() : QString(", failed"))
+               .arg(QueryStats::normalize(m_queryStr)));
+    if (!plan.isEmpty()) {
+        LOG_WARNING(QString("Slow query plan:\n%1").arg(plan));
+    }
+
+    stats.recordSlowQuery(m_queryStr, totalNs, m_rows, plan);
+}
+
+template<typename T>
+QSqlDatabase DbService<T>::explainableOn(const QSqlDatabase& db, QueryRouting routing) const {
+    // SELECT also calls functions that detach partitions or take advisory locks, so the
+    // statement text proves nothing; routing a read to replicas is the caller's promise.
+    // The primary connection inside a transaction would also see the caller's writes.
+    if (routing == QueryRouting::Primary || (m_inTransaction && db.connectionName() == m_connectionName)) {
+        return QSqlDatabase();
+    }
+    return db;
+}
+
+template<typename T>
+QString DbService<T>::explainQuery(QSqlDatabase db, const QString& queryStr, const QMap<QString, QVariant>& params) {
+    if (!db.transaction()) {
+        return QString();
+    }
+
+    QStringList lines;
+    {
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        const QString explainStr = "EXPLAIN (ANALYZE, BUFFERS) " + queryStr;
+
+        bool executed = false;
+        if (params.isEmpty()) {
+            executed = query.exec(explainStr);
+        } else if (query.prepare(explainStr)) {
+            for (auto it = params.constBegin(); it != params.constEnd(); ++it) {
+                query.bindValue(":" + it.key(), it.value());
+            }
+            executed = query.exec();
+        }
+
+        if (executed) {
+            while (query.next()) {
+                lines.append(query.value(0).toString());
+            }
+        } else {
+            LOG_WARNING(QString("Could not explain slow query: %1").arg(query.lastError().text()));
+        }
+    }
+
+    // The statement ran for real under ANALYZE; undo anything it may have changed
+    db.rollback();
+    return lines.join('\n');
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "dbservice.hpp"
+#include "dbconfig.h"
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QTimer>
+#include <functional>
+
+// Cross-node cache invalidation over PostgreSQL LISTEN/NOTIFY. Writers NOTIFY
+// on their own connection, so a notification sent inside a transaction is only
+// delivered if the transaction commits. Each process keeps one extra connection
+// that LISTENs on the subscribed channels and needs a running event loop.
+class NotificationBus : public QObject {
+    Q_OBJECT
+public:
+    using Handler = std::function<void(const QString& payload)>;
+
+    // Payload telling subscribers to drop everything cached for the channel
+    static const QString AllKeys;
+
+    static NotificationBus& instance();
+
+    // Opens the listening connection; call from the thread whose event loop should deliver notifications
+    bool start(const DbConfig& config);
+    void stop();
+
+    // Caches must not outlive a lost connection, since notifications sent meanwhile are gone
+    bool isListening() const { return m_listening; }
+
+    // The handler runs on the context's thread for every payload, and with AllKeys after a reconnect
+    void subscribe(const QString& channel, QObject* context, Handler handler);
+
+    template<typename T>
+    static bool publish(DbService<T>& db, const QString& channel, const QString& payload);
+
+private slots:
+    void onNotification(const QString& channel, QSqlDriver::NotificationSource source, const QVariant& payload);
+    void checkConnection();
+
+private:
+    struct Subscriber {
+        QPointer<QObject> context;
+        Handler handler;
+    };
+
+    NotificationBus() = default;
+    ~NotificationBus() override;
+    NotificationBus(const NotificationBus&) = delete;
+    NotificationBus& operator=(const NotificationBus&) = delete;
+
+    bool connectAndListen();
+    bool listen(const QString& channel);
+    void dispatch(const QString& channel, const QString& payload);
+    void closeConnection();
+
+    static constexpr int CheckIntervalMs = 10000;
+
+    DbConfig m_config;
+    QString m_connectionName;
+    QSqlDatabase m_db;
+    QTimer* m_checkTimer = nullptr;
+    bool m_started = false;
+    bool m_listening = false;
+    QHash<QString, QList<Subscriber>> m_subscribers;
+};
+
+template<typename T>
+bool NotificationBus::publish(DbService<T>& db, const QString& channel, const QString& payload) {
+    QMap<QString, QVariant> params;
+    params["channel"] = channel;
+    params["payload"] = payload;
+
+    if (!db.executeModificationQuery("SELECT pg_notify(:channel, :payload)", params)) {
+        LOG_WARNING(QString("Failed to publish invalidation on %1: %2").arg(channel, db.lastError()));
+        return false;
+    }
+    return true;
+}
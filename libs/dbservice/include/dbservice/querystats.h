@@ -0,0 +1,74 @@
+#pragma once
+#include <QDateTime>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+
+// Per-statement timings collected by every DbService, keyed by the SQL text
+// with literals and whitespace normalised so spliced values share one entry
+class QueryStats {
+public:
+    struct Entry {
+        QString sql;
+        qint64 calls = 0;
+        qint64 errors = 0;
+        qint64 rows = 0;
+        qint64 totalNs = 0;
+        qint64 maxNs = 0;
+        qint64 prepareNs = 0;
+        qint64 execNs = 0;
+    };
+
+    struct SlowQuery {
+        QString sql;
+        QDateTime at;
+        qint64 elapsedNs = 0;
+        qint64 rows = 0;
+        QString plan;
+    };
+
+    static QueryStats& instance();
+
+    // Collapse whitespace and replace numeric and string literals with '?'
+    static QString normalize(const QString& sql);
+
+    // prepareNs is zero for statements run without binding; totalNs includes fetching rows
+    void record(const QString& sql, qint64 prepareNs, qint64 execNs, qint64 totalNs, qint64 rows, bool ok);
+
+    // Statements slower than the threshold are logged and kept; 0 disables
+    void setSlowQueryThreshold(int ms);
+    int slowQueryThreshold() const { return m_slowThresholdMs.load(); }
+    bool isSlow(qint64 totalNs) const;
+
+    // Fraction of slow reads routed off the primary to re-run under EXPLAIN (ANALYZE, BUFFERS)
+    void setExplainSampleRate(double rate);
+    double explainSampleRate() const { return m_explainSampleRate.load(); }
+    bool shouldExplain();
+
+    void recordSlowQuery(const QString& sql, qint64 elapsedNs, qint64 rows, const QString& plan);
+
+    // The statements with the most total time, and the most recent slow ones
+    QJsonObject snapshot(int limit) const;
+    void reset();
+
+private:
+    QueryStats() = default;
+    QueryStats(const QueryStats&) = delete;
+    QueryStats& operator=(const QueryStats&) = delete;
+
+    QString normalizedFor(const QString& sql);
+
+    static constexpr int MaxSlowQueries = 50;
+    static constexpr int MaxNormalizedCache = 4096;
+
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    QHash<QString, QString> m_normalized;
+    QList<SlowQuery> m_slowQueries;
+    QDateTime m_since = QDateTime::currentDateTimeUtc();
+    std::atomic<int> m_slowThresholdMs{0};
+    std::atomic<double> m_explainSampleRate{0.0};
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include "dbconfig.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+// Samples the replication lag of the read replicas on a background thread with
+// its own connections, so routing a read never waits on a connect or lag query.
+// One monitor serves every DbService in the process.
+class ReplicaMonitor {
+public:
+    static ReplicaMonitor& instance();
+
+    // Starts sampling these replicas; later calls only add replicas not yet watched
+    void watch(const QList<DbConfig>& replicas);
+    void stop();
+
+    // Staleness bound in seconds: the lag at the last sample plus the age of that sample,
+    // -1 while unknown, unreachable or not streaming from the primary
+    double lagSeconds(const QString& key) const;
+
+    // Short enough that a caught-up replica stays within QueryRouting::ReadOnly's second
+    static constexpr int SampleIntervalMs = 500;
+
+    static QString keyFor(const DbConfig& replica);
+
+private:
+    ReplicaMonitor() = default;
+    ~ReplicaMonitor();
+    ReplicaMonitor(const ReplicaMonitor&) = delete;
+    ReplicaMonitor& operator=(const ReplicaMonitor&) = delete;
+
+    void run();
+    // Lag in seconds, or -1 with error set
+    double sample(const DbConfig& replica, const QString& connectionName, QString& error);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    QList<DbConfig> m_replicas;
+    struct Sample {
+        double lagSeconds = -1;
+        QElapsedTimer sampledAt;
+    };
+    QHash<QString, Sample> m_samples;
+    bool m_stopping = false;
+    QThread* m_thread = nullptr;
+};
@@ -21,6 +21,8 @@ DbConfig DbConfig::fromEnvironment() {
     config.m_username = env.value("DB_USER", "postgres");
     config.m_password = env.value("DB_PASSWORD", "logics22");
     config.m_port = env.value("DB_PORT", "5432").toInt();
+    config.m_maxReplicaLagSeconds = env.value("DB_REPLICA_MAX_LAG", "30").toInt();
+    config.setReplicas(env.value("DB_REPLICAS"));
 
     return config;
 }
@@ -35,7 +37,31 @@ DbConfig DbConfig::fromFile(const QString& configPath) {
     config.m_username = settings.value("username", "postgres").toString();
     config.m_password = settings.value("password", "").toString();
     config.m_port = settings.value("port", 5432).toInt();
+    config.m_maxReplicaLagSeconds = settings.value("max_replica_lag", 30).toInt();
+    // QSettings splits unquoted comma lists itself
+    config.setReplicas(settings.value("replicas").toStringList().join(','));
     settings.endGroup();
 
     return config;
-}
\ No newline at end of file
+}
+
+void DbConfig::setReplicas(const QString& hosts) {
+    m_replicas.clear();
+    for (const QString& entry : hosts.split(',', Qt::SkipEmptyParts)) {
+        const QString hostPort = entry.trimmed();
+        if (hostPort.isEmpty()) {
+            continue;
+        }
+
+        DbConfig replica = *this;
+        replica.m_replicas.clear();
+        const int colon = hostPort.lastIndexOf(':');
+        if (colon > 0) {
+            replica.m_host = hostPort.left(colon);
+            replica.m_port = hostPort.mid(colon + 1).toInt();
+        } else {
+            replica.m_host = hostPort;
+        }
+        m_replicas.append(replica);
+    }
+}
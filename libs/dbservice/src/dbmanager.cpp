@@ -50,6 +50,12 @@ bool DbManager::initialize(const DbConfig& config) {
     m_initialized = true;
     LOG_INFO(QString("DbManager successfully initialized for database %1 on host %2")
             .arg(config.database(), config.host()));
+    for (const DbConfig& replica : config.replicas()) {
+        LOG_INFO(QString("Reporting reads may use replica %1:%2 (max lag %3 s)")
+                .arg(replica.host())
+                .arg(replica.port())
+                .arg(config.maxReplicaLagSeconds()));
+    }
     return true;
 }
 
@@ -0,0 +1,163 @@
+#include "dbservice/notificationbus.h"
+#include <QMetaObject>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QUuid>
+
+const QString NotificationBus::AllKeys = QStringLiteral("*");
+
+NotificationBus& NotificationBus::instance() {
+    static NotificationBus instance;
+    return instance;
+}
+
+NotificationBus::~NotificationBus() {
+    closeConnection();
+}
+
+bool NotificationBus::start(const DbConfig& config) {
+    if (m_started) {
+        return m_listening;
+    }
+
+    m_config = config;
+    m_connectionName = QString("notificationbus_%1").arg(QUuid::createUuid().toString(QUuid::WithoutBraces));
+    m_started = true;
+
+    // Also retries the connection when the first attempt fails
+    m_checkTimer = new QTimer(this);
+    connect(m_checkTimer, &QTimer::timeout, this, &NotificationBus::checkConnection);
+    m_checkTimer->start(CheckIntervalMs);
+
+    if (!connectAndListen()) {
+        LOG_WARNING("Notification bus could not connect, cross-node caches stay disabled until it does");
+        return false;
+    }
+
+    LOG_INFO(QString("Notification bus listening on %1 channels").arg(m_subscribers.size()));
+    return true;
+}
+
+void NotificationBus::stop() {
+    if (!m_started) {
+        return;
+    }
+
+    if (m_checkTimer) {
+        m_checkTimer->stop();
+        m_checkTimer->deleteLater();
+        m_checkTimer = nullptr;
+    }
+
+    closeConnection();
+    m_started = false;
+}
+
+void NotificationBus::subscribe(const QString& channel, QObject* context, Handler handler) {
+    const bool newChannel = !m_subscribers.contains(channel);
+    m_subscribers[channel].append({context, std::move(handler)});
+
+    if (newChannel && m_listening && !listen(channel)) {
+        // Without this channel the node would cache entries nobody can invalidate
+        closeConnection();
+    }
+}
+
+bool NotificationBus::connectAndListen() {
+    m_db = QSqlDatabase::addDatabase("QPSQL", m_connectionName);
+    m_db.setHostName(m_config.host());
+    m_db.setDatabaseName(m_config.database());
+    m_db.setUserName(m_config.username());
+    m_db.setPassword(m_config.password());
+    m_db.setPort(m_config.port());
+    m_db.setConnectOptions("application_name=DBService;connect_timeout=5");
+
+    if (!m_db.open()) {
+        LOG_ERROR(QString("Notification bus connection failed: %1").arg(m_db.lastError().text()));
+        closeConnection();
+        return false;
+    }
+
+    connect(m_db.driver(),
+            QOverload<const QString&, QSqlDriver::NotificationSource, const QVariant&>::of(&QSqlDriver::notification),
+            this, &NotificationBus::onNotification);
+
+    for (auto it = m_subscribers.constBegin(); it != m_subscribers.constEnd(); ++it) {
+        if (!listen(it.key())) {
+            closeConnection();
+            return false;
+        }
+    }
+
+    m_listening = true;
+    return true;
+}
+
+bool NotificationBus::listen(const QString& channel) {
+    if (!m_db.driver()->subscribeToNotification(channel)) {
+        LOG_ERROR(QString("Notification bus failed to listen on %1: %2")
+                 .arg(channel, m_db.driver()->lastError().text()));
+        return false;
+    }
+    return true;
+}
+
+void NotificationBus::closeConnection() {
+    m_listening = false;
+
+    if (m_db.isValid()) {
+        if (m_db.isOpen()) {
+            m_db.close();
+        }
+        m_db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(m_connectionName);
+    }
+}
+
+void NotificationBus::checkConnection() {
+    if (m_listening) {
+        // A dropped LISTEN connection raises nothing, so probe it
+        QSqlQuery probe(m_db);
+        if (probe.exec("SELECT 1")) {
+            return;
+        }
+
+        LOG_WARNING(QString("Notification bus lost its connection: %1").arg(probe.lastError().text()));
+        closeConnection();
+    }
+
+    if (!connectAndListen()) {
+        return;
+    }
+
+    // Anything published while disconnected was missed
+    LOG_INFO("Notification bus reconnected, flushing subscribed caches");
+    for (auto it = m_subscribers.constBegin(); it != m_subscribers.constEnd(); ++it) {
+        dispatch(it.key(), AllKeys);
+    }
+}
+
+void NotificationBus::onNotification(const QString& channel, QSqlDriver::NotificationSource source, const QVariant& payload) {
+    Q_UNUSED(source);
+    // Writes from this process come back too, which keeps one code path for local and remote invalidation
+    dispatch(channel, payload.toString());
+}
+
+void NotificationBus::dispatch(const QString& channel, const QString& payload) {
+    auto it = m_subscribers.find(channel);
+    if (it == m_subscribers.end()) {
+        return;
+    }
+
+    QList<Subscriber>& subscribers = it.value();
+    for (int i = subscribers.size() - 1; i >= 0; --i) {
+        if (!subscribers[i].context) {
+            subscribers.removeAt(i);
+        }
+    }
+
+    for (const Subscriber& subscriber : subscribers) {
+        Handler handler = subscriber.handler;
+        QMetaObject::invokeMethod(subscriber.context.data(), [handler, payload]() { handler(payload); });
+    }
+}
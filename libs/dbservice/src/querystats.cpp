@@ -0,0 +1,168 @@
+#include "dbservice/querystats.h"
+#include <QJsonArray>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <algorithm>
+
+QueryStats& QueryStats::instance() {
+    static QueryStats instance;
+    return instance;
+}
+
+QString QueryStats::normalize(const QString& sql) {
+    static const QRegularExpression stringLiteral("'(?:[^']|'')*'");
+    static const QRegularExpression numberLiteral("(?<![\\w$:])-?\\d+(?:\\.\\d+)?\\b");
+    // Multi-row VALUES lists and IN lists vary in length with the batch
+    static const QRegularExpression repeatedTuple("(\\([^()]*\\))(?:\\s*,\\s*\\([^()]*\\))+");
+    static const QRegularExpression placeholderList("\\(\\s*\\?(?:\\s*,\\s*\\?)+\\s*\\)");
+
+    QString normalized = sql.simplified();
+    normalized.replace(stringLiteral, "?");
+    normalized.replace(numberLiteral, "?");
+    normalized.replace(repeatedTuple, "\\1, ...");
+    normalized.replace(placeholderList, "(?, ...)");
+    return normalized;
+}
+
+QString QueryStats::normalizedFor(const QString& sql) {
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_normalized.constFind(sql);
+        if (it != m_normalized.constEnd()) {
+            return it.value();
+        }
+    }
+
+    const QString normalized = normalize(sql);
+
+    QMutexLocker locker(&m_mutex);
+    // Statements with spliced values never repeat; start over rather than grow without bound
+    if (m_normalized.size() >= MaxNormalizedCache) {
+        m_normalized.clear();
+    }
+    m_normalized.insert(sql, normalized);
+    return normalized;
+}
+
+void QueryStats::record(const QString& sql, qint64 prepareNs, qint64 execNs, qint64 totalNs, qint64 rows, bool ok) {
+    const QString normalized = normalizedFor(sql);
+
+    QMutexLocker locker(&m_mutex);
+    Entry& entry = m_entries[normalized];
+    if (entry.sql.isEmpty()) {
+        entry.sql = normalized;
+    }
+    entry.calls++;
+    if (!ok) {
+        entry.errors++;
+    }
+    entry.rows += qMax<qint64>(0, rows);
+    entry.totalNs += totalNs;
+    entry.maxNs = qMax(entry.maxNs, totalNs);
+    entry.prepareNs += prepareNs;
+    entry.execNs += execNs;
+}
+
+void QueryStats::setSlowQueryThreshold(int ms) {
+    m_slowThresholdMs = qMax(0, ms);
+}
+
+bool QueryStats::isSlow(qint64 totalNs) const {
+    const int thresholdMs = m_slowThresholdMs.load();
+    return thresholdMs > 0 && totalNs >= static_cast<qint64>(thresholdMs) * 1000000;
+}
+
+void QueryStats::setExplainSampleRate(double rate) {
+    m_explainSampleRate = qBound(0.0, rate, 1.0);
+}
+
+bool QueryStats::shouldExplain() {
+    const double rate = m_explainSampleRate.load();
+    return rate > 0.0 && QRandomGenerator::global()->generateDouble() < rate;
+}
+
+void QueryStats::recordSlowQuery(const QString& sql, qint64 elapsedNs, qint64 rows, const QString& plan) {
+    SlowQuery slow;
+    slow.sql = normalizedFor(sql);
+    slow.at = QDateTime::currentDateTimeUtc();
+    slow.elapsedNs = elapsedNs;
+    slow.rows = rows;
+    slow.plan = plan;
+
+    QMutexLocker locker(&m_mutex);
+    m_slowQueries.append(slow);
+    while (m_slowQueries.size() > MaxSlowQueries) {
+        m_slowQueries.removeFirst();
+    }
+}
+
+QJsonObject QueryStats::snapshot(int limit) const {
+    QList<Entry> entries;
+    QList<SlowQuery> slowQueries;
+    QDateTime since;
+    {
+        QMutexLocker locker(&m_mutex);
+        entries = m_entries.values();
+        slowQueries = m_slowQueries;
+        since = m_since;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.totalNs > b.totalNs;
+    });
+
+    qint64 allNs = 0;
+    qint64 allCalls = 0;
+    for (const Entry& entry : entries) {
+        allNs += entry.totalNs;
+        allCalls += entry.calls;
+    }
+
+    QJsonArray statements;
+    for (int i = 0; i < entries.size() && (limit <= 0 || i < limit); ++i) {
+        const Entry& entry = entries.at(i);
+        QJsonObject statement;
+        statement["sql"] = entry.sql;
+        statement["calls"] = entry.calls;
+        statement["errors"] = entry.errors;
+        statement["rows"] = entry.rows;
+        statement["total_ms"] = entry.totalNs / 1e6;
+        statement["mean_ms"] = entry.calls > 0 ? entry.totalNs / 1e6 / entry.calls : 0.0;
+        statement["max_ms"] = entry.maxNs / 1e6;
+        statement["prepare_ms"] = entry.prepareNs / 1e6;
+        statement["exec_ms"] = entry.execNs / 1e6;
+        statement["share_percent"] = allNs > 0 ? 100.0 * entry.totalNs / allNs : 0.0;
+        statements.append(statement);
+    }
+
+    QJsonArray slow;
+    for (auto it = slowQueries.crbegin(); it != slowQueries.crend(); ++it) {
+        QJsonObject query;
+        query["sql"] = it->sql;
+        query["at"] = it->at.toString(Qt::ISODateWithMs);
+        query["elapsed_ms"] = it->elapsedNs / 1e6;
+        query["rows"] = it->rows;
+        if (!it->plan.isEmpty()) {
+            query["plan"] = it->plan;
+        }
+        slow.append(query);
+    }
+
+    QJsonObject result;
+    result["since"] = since.toString(Qt::ISODate);
+    result["distinct_statements"] = static_cast<qint64>(entries.size());
+    result["calls"] = allCalls;
+    result["total_ms"] = allNs / 1e6;
+    result["slow_query_threshold_ms"] = m_slowThresholdMs.load();
+    result["explain_sample_rate"] = m_explainSampleRate.load();
+    result["statements"] = statements;
+    result["slow_queries"] = slow;
+    return result;
+}
+
+void QueryStats::reset() {
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_slowQueries.clear();
+    m_since = QDateTime::currentDateTimeUtc();
+}
@@ -0,0 +1,165 @@
+#include "dbservice/replicamonitor.h"
+#include "logger/logger.h"
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QUuid>
+
+ReplicaMonitor& ReplicaMonitor::instance() {
+    static ReplicaMonitor instance;
+    return instance;
+}
+
+ReplicaMonitor::~ReplicaMonitor() {
+    stop();
+}
+
+QString ReplicaMonitor::keyFor(const DbConfig& replica) {
+    return QString("%1:%2").arg(replica.host()).arg(replica.port());
+}
+
+void ReplicaMonitor::watch(const QList<DbConfig>& replicas) {
+    QMutexLocker locker(&m_mutex);
+    for (const DbConfig& replica : replicas) {
+        const QString key = keyFor(replica);
+        if (!m_samples.contains(key)) {
+            m_replicas.append(replica);
+            m_samples.insert(key, Sample());
+        }
+    }
+
+    if (!m_thread && !m_replicas.isEmpty()) {
+        m_stopping = false;
+        m_thread = QThread::create([this]() { run(); });
+        m_thread->start();
+    } else {
+        m_wake.wakeAll();
+    }
+}
+
+void ReplicaMonitor::stop() {
+    QThread* thread = nullptr;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_thread) {
+            return;
+        }
+        m_stopping = true;
+        m_wake.wakeAll();
+        thread = m_thread;
+        m_thread = nullptr;
+    }
+
+    thread->wait();
+    delete thread;
+}
+
+double ReplicaMonitor::lagSeconds(const QString& key) const {
+    QMutexLocker locker(&m_mutex);
+    const Sample sample = m_samples.value(key);
+    if (sample.lagSeconds < 0 || !sample.sampledAt.isValid()) {
+        return -1;
+    }
+
+    // Anything committed since the sample may be missing as well
+    return sample.lagSeconds + sample.sampledAt.elapsed() / 1000.0;
+}
+
+void ReplicaMonitor::run() {
+    // Connections are opened in this thread and stay with it
+    const QString prefix = QString("replicamonitor_%1").arg(QUuid::createUuid().toString(QUuid::WithoutBraces));
+    QStringList connectionNames;
+
+    while (true) {
+        QList<DbConfig> replicas;
+        {
+            QMutexLocker locker(&m_mutex);
+            replicas = m_replicas;
+        }
+
+        for (int i = 0; i < replicas.size(); ++i) {
+            const QString connectionName = QString("%1_%2").arg(prefix).arg(i);
+            if (!connectionNames.contains(connectionName)) {
+                connectionNames.append(connectionName);
+            }
+
+            // Timed from the start of the query, the latest point the lag it reports can describe
+            Sample result;
+            result.sampledAt.start();
+            QString error;
+            result.lagSeconds = sample(replicas.at(i), connectionName, error);
+
+            QMutexLocker locker(&m_mutex);
+            const QString key = keyFor(replicas.at(i));
+            // Reported when a replica drops out or comes back, not on every sample
+            const Sample previous = m_samples.value(key);
+            const bool wasUsable = !previous.sampledAt.isValid() || previous.lagSeconds >= 0;
+            if (result.lagSeconds < 0 && wasUsable) {
+                LOG_WARNING(QString("Read replica %1 taken out of rotation: %2").arg(key, error));
+            } else if (result.lagSeconds >= 0 && !wasUsable) {
+                LOG_INFO(QString("Read replica %1 is back in rotation").arg(key));
+            }
+            m_samples.insert(key, result);
+        }
+
+        QMutexLocker locker(&m_mutex);
+        if (!m_stopping) {
+            m_wake.wait(&m_mutex, SampleIntervalMs);
+        }
+        if (m_stopping) {
+            break;
+        }
+    }
+
+    for (const QString& connectionName : connectionNames) {
+        QSqlDatabase::database(connectionName, false).close();
+        QSqlDatabase::removeDatabase(connectionName);
+    }
+}
+
+double ReplicaMonitor::sample(const DbConfig& replica, const QString& connectionName, QString& error) {
+    QSqlDatabase db = QSqlDatabase::database(connectionName, false);
+    if (!db.isValid()) {
+        db = QSqlDatabase::addDatabase("QPSQL", connectionName);
+        db.setHostName(replica.host());
+        db.setDatabaseName(replica.database());
+        db.setUserName(replica.username());
+        db.setPassword(replica.password());
+        db.setPort(replica.port());
+        db.setConnectOptions("application_name=DBService;connect_timeout=2");
+    }
+
+    if (!db.isOpen() && !db.open()) {
+        error = QString("unreachable: %1").arg(db.lastError().text());
+        return -1;
+    }
+
+    // Caught up when everything received has been replayed; otherwise the age of the last replayed
+    // commit. Received equals replayed also once the WAL receiver has lost the primary, so a
+    // replica counts only while it streams. Without pg_read_all_stats the status column reads
+    // NULL, and only the receiver process being alive is checked.
+    QSqlQuery query(db);
+    if (!query.exec("SELECT NOT pg_is_in_recovery() "
+                    "OR EXISTS (SELECT 1 FROM pg_stat_wal_receiver "
+                    "WHERE status IS NULL OR status = 'streaming') AS streaming, "
+                    "CASE "
+                    "WHEN NOT pg_is_in_recovery() THEN 0 "
+                    "WHEN pg_last_wal_receive_lsn() = pg_last_wal_replay_lsn() THEN 0 "
+                    "ELSE EXTRACT(EPOCH FROM now() - pg_last_xact_replay_timestamp()) END AS lag") ||
+        !query.next() || query.isNull("lag")) {
+        error = QString("cannot read replication lag: %1").arg(query.lastError().text());
+        // Reconnect on the next sample in case the session is broken
+        query.finish();
+        db.close();
+        return -1;
+    }
+
+    if (!query.value("streaming").toBool()) {
+        error = "not streaming from the primary";
+        return -1;
+    }
+
+    const double lag = query.value("lag").toDouble();
+    LOG_DEBUG(QString("Read replica %1 lag %2 s").arg(keyFor(replica)).arg(lag));
+    return lag;
+}
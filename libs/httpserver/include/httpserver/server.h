@@ -16,6 +16,12 @@ namespace Http {
         ~Server() override;
 
         void registerController(std::shared_ptr<Controller> controller);
+
+        // Bind with SO_REUSEPORT so several processes can share the port; call before start()
+        void setReusePort(bool enabled) { reusePort = enabled; }
+        // Whether this platform has SO_REUSEPORT; without it a shared port cannot be bound
+        static bool reusePortSupported();
+
         bool start(quint16 port = 8080, const QHostAddress& address = QHostAddress::Any);
         void stop();
         bool isRunning() const;
@@ -23,9 +29,12 @@ namespace Http {
         QHostAddress address() const;
 
     private:
+        bool listenReusePort(quint16 port, const QHostAddress& address);
+
         QHttpServer server;
         QTcpServer tcpServer;
         std::vector<std::shared_ptr<Controller>> controllers;
+        bool reusePort = false;
     };
 
 } // namespace Http
\ No newline at end of file
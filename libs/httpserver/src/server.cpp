@@ -1,6 +1,13 @@
 #include "httpserver/server.h"
 #include <QDebug>
 
+#ifdef Q_OS_UNIX
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
 namespace Http {
 
     Server::Server(QObject* parent)
@@ -18,7 +25,8 @@ namespace Http {
     }
 
     bool Server::start(quint16 port, const QHostAddress& address) {
-        if (!tcpServer.listen(address, port)) {
+        const bool listening = reusePort ? listenReusePort(port, address) : tcpServer.listen(address, port);
+        if (!listening) {
             qDebug() << "TCP Server failed to start!";
             return false;
         }
@@ -28,6 +36,69 @@ namespace Http {
         return true;
     }
 
+    bool Server::reusePortSupported() {
+#if defined(Q_OS_UNIX) && defined(SO_REUSEPORT)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool Server::listenReusePort(quint16 port, const QHostAddress& address) {
+#if defined(Q_OS_UNIX) && defined(SO_REUSEPORT)
+        // QTcpServer cannot set options before bind, so build the socket and hand it over
+        const bool ipv6 = address == QHostAddress::Any || address.protocol() == QAbstractSocket::IPv6Protocol;
+        int fd = ::socket(ipv6 ? AF_INET6 : AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            qDebug() << "Failed to create listening socket";
+            return false;
+        }
+
+        int on = 1;
+        int off = 0;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0) {
+            qDebug() << "SO_REUSEPORT is not supported";
+            ::close(fd);
+            return false;
+        }
+
+        int bound = -1;
+        if (ipv6) {
+            sockaddr_in6 addr = {};
+            addr.sin6_family = AF_INET6;
+            addr.sin6_port = htons(port);
+            if (address == QHostAddress::Any) {
+                // Dual stack, like QTcpServer::listen(QHostAddress::Any)
+                ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+                addr.sin6_addr = in6addr_any;
+            } else {
+                const Q_IPV6ADDR ip = address.toIPv6Address();
+                memcpy(&addr.sin6_addr, ip.c, sizeof(ip.c));
+            }
+            bound = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        } else {
+            sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            addr.sin_addr.s_addr = htonl(address.toIPv4Address());
+            bound = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        }
+
+        if (bound != 0 || ::listen(fd, SOMAXCONN) != 0 || !tcpServer.setSocketDescriptor(fd)) {
+            qDebug() << "Failed to bind a shared listening socket";
+            ::close(fd);
+            return false;
+        }
+        return true;
+#else
+        qDebug() << "SO_REUSEPORT is not available on this platform";
+        Q_UNUSED(port);
+        Q_UNUSED(address);
+        return false;
+#endif
+    }
+
     void Server::stop() {
         if (tcpServer.isListening()) {
             tcpServer.close();
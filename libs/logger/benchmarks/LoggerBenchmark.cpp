@@ -0,0 +1,75 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QUuid>
+
+#include "logger/logger.h"
+
+/**
+ * @brief Measures the cost of LOG_* calls whose level is filtered out
+ *
+ * A disabled call should cost a relaxed atomic load and a branch; the
+ * QString::arg formatting inside the macro must never run.
+ */
+class LoggerBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_tempDir.isValid());
+        Logger::instance()->enableConsoleOutput(false);
+        Logger::instance()->setLogFile(m_tempDir.filePath("benchmark.log"));
+        Logger::instance()->setLogLevel(Logger::Warning);
+    }
+
+    void disabledArgumentsAreNotEvaluated() {
+        int evaluated = 0;
+        auto expensive = [&evaluated]() {
+            ++evaluated;
+            return QString("expensive");
+        };
+
+        LOG_DEBUG(expensive());
+        LOG_INFO(expensive());
+        QCOMPARE(evaluated, 0);
+
+        LOG_WARNING(expensive());
+        QCOMPARE(evaluated, 1);
+    }
+
+    void disabledDebugCall() {
+        const QString sessionId = QUuid::createUuid().toString(QUuid::WithoutBraces);
+        QBENCHMARK {
+            LOG_DEBUG(QString("Query executed in %1 ms, returned %2 rows for session %3")
+                      .arg(12).arg(340).arg(sessionId));
+        }
+    }
+
+    void disabledInfoCall() {
+        QBENCHMARK {
+            LOG_INFO(QString("%1 saved successfully with ID: %2").arg("ActivityEvent", "42"));
+        }
+    }
+
+    void disabledDataCall() {
+        QMap<QString, QVariant> data;
+        data["query"] = "SELECT 1";
+        data["rows"] = 1;
+        QBENCHMARK {
+            LOG_DATA(Logger::Debug, data);
+        }
+    }
+
+    // Reference point: the pre-check cost when formatting is done by the caller
+    void preformattedDebugCall() {
+        QBENCHMARK {
+            Logger::instance()->debug(QString("Query executed in %1 ms").arg(12), Q_FUNC_INFO, __LINE__);
+        }
+    }
+
+private:
+    QTemporaryDir m_tempDir;
+};
+
+QTEST_GUILESS_MAIN(LoggerBenchmark)
+#include "LoggerBenchmark.moc"
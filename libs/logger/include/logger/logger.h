@@ -9,6 +9,13 @@
 #include <QDebug>
 #include <QMap>
 #include <QThread>
+#include <QHash>
+#include <QPair>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QVariant>
+#include <atomic>
+#include <functional>
 
 // Define the logger_global macro for export/import
 #if defined(_MSC_VER) || defined(WIN64) || defined(_WIN64) || defined(__WIN64__) || defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
@@ -25,6 +32,85 @@
 #  define LOGGER_EXPORT DECL_IMPORT
 #endif
 
+// Lowest level compiled into the LOG_* macros. Release builds (QT_NO_DEBUG) strip
+// LOG_DEBUG entirely unless LOGGER_KEEP_DEBUG_LOGS is defined.
+#ifndef LOGGER_COMPILED_MIN_LEVEL
+#  if defined(QT_NO_DEBUG) && !defined(LOGGER_KEEP_DEBUG_LOGS)
+#    define LOGGER_COMPILED_MIN_LEVEL 1
+#  else
+#    define LOGGER_COMPILED_MIN_LEVEL 0
+#  endif
+#endif
+
+/**
+ * @brief A typed key/value attached to a log record, resolved only when the record is written
+ *
+ * Redaction of secrets, SQL interpolation and lazy producers all run after the
+ * level, category and rate-limit filters have admitted the record.
+ */
+class LOGGER_EXPORT LogField {
+public:
+    enum Kind {
+        Value,   ///< Plain value, written as is
+        Secret,  ///< Credential; only a short SHA-256 fingerprint is written
+        Sql,     ///< Query template interpolated with its bound parameters
+        Lazy     ///< Value computed by a callback
+    };
+
+    /**
+     * @brief Creates a plain value field
+     * @param name The field name
+     * @param value The field value
+     */
+    static LogField value(const QString& name, const QVariant& value);
+    /**
+     * @brief Creates a field for a token, password or other secret
+     * @param name The field name
+     * @param secret The raw secret, never written to the log
+     */
+    static LogField secret(const QString& name, const QString& secret);
+    /**
+     * @brief Creates a field showing a query with its parameter values substituted
+     *
+     * Parameters whose name contains "token", "password" or "secret" are redacted.
+     * @param name The field name
+     * @param query The query template with :name placeholders
+     * @param params The bound parameter values
+     */
+    static LogField sql(const QString& name, const QString& query, const QMap<QString, QVariant>& params);
+    /**
+     * @brief Creates a field whose value is computed only if the record is written
+     * @param name The field name
+     * @param producer Callback returning the value
+     */
+    static LogField lazy(const QString& name, std::function<QVariant()> producer);
+
+    /**
+     * @brief Returns a stable, non-reversible fingerprint of a secret
+     * @param secret The raw secret
+     * @return "sha256:" followed by the first 12 hex digits, or "<empty>"
+     */
+    static QString redact(const QString& secret);
+
+    QString name() const { return m_name; }
+    Kind kind() const { return m_kind; }
+
+    /**
+     * @brief Produces the value to write, applying redaction or interpolation
+     * @return The resolved value
+     */
+    QVariant resolve() const;
+
+private:
+    LogField(const QString& name, Kind kind);
+
+    QString m_name;
+    Kind m_kind;
+    QVariant m_value;
+    QMap<QString, QVariant> m_params;
+    std::function<QVariant()> m_producer;
+};
+
 /**
  * @brief Singleton logger class that provides thread-safe logging functionality
  *
@@ -47,6 +133,24 @@ public:
         Fatal     ///< Critical errors that may cause program termination
     };
 
+    /**
+     * @brief On-disk encodings supported for the log file
+     */
+    enum LogFormat {
+        TextFormat,       ///< Human readable lines (default)
+        StructuredFormat  ///< Compact CBOR records, see logger/logrecord.h
+    };
+
+    /**
+     * @brief When the active log file is rolled over and how many old segments are kept
+     */
+    struct RotationPolicy {
+        qint64 maxFileSize = 0;     ///< Rotate once the file reaches this many bytes, 0 disables
+        bool daily = false;         ///< Rotate at local midnight
+        int maxRetainedFiles = 5;   ///< Rotated segments kept on disk
+        bool compress = true;       ///< Gzip rotated segments on a background thread
+    };
+
     /**
      * @brief Gets the singleton instance of the logger
     * @return Pointer to the Logger instance
@@ -63,6 +167,52 @@ public:
      * @param level The minimum LogLevel to output
      */
     void setLogLevel(LogLevel level);
+    /**
+     * @brief Overrides the log level for one category
+     *
+     * A category is a class name (e.g. "SyncManager") or a method
+     * (e.g. "BaseRepository::save") matched against the call site; the most
+     * specific matching category wins over the default level.
+     * @param category The class or Class::method name
+     * @param level The minimum LogLevel for that category
+     */
+    void setCategoryLevel(const QString& category, LogLevel level);
+    /**
+     * @brief Replaces all category levels from a spec like "SyncManager=debug,DbService=warning"
+     * @param spec Comma separated category=level pairs, empty clears all overrides
+     * @return False if any entry could not be parsed (valid entries are still applied)
+     */
+    bool setCategoryLevels(const QString& spec);
+    /**
+     * @brief Removes all category level overrides
+     */
+    void clearCategoryLevels();
+    /**
+     * @brief Limits how many Debug/Info records one call site may emit per interval
+     *
+     * Excess records are dropped and reported as a single "suppressed N" record
+     * when the call site next logs in a new interval. Warnings and above are never limited.
+     * @param maxMessages Records allowed per interval and call site, 0 disables limiting
+     * @param intervalMs Length of the interval in milliseconds
+     */
+    void setRateLimit(int maxMessages, int intervalMs = 1000);
+    /**
+     * @brief Sets the encoding used for the log file
+     *
+     * Reopens the log file, so text and structured records never share a file.
+     * Console output stays human readable.
+     * @param format The LogFormat to write
+     * @param filePath Log file to open, empty to reopen the current one
+     */
+    void setLogFormat(LogFormat format, const QString& filePath = QString());
+    /**
+     * @brief Sets the rotation policy for the log file
+     *
+     * Rotation renames the active file and reopens a fresh one while holding the
+     * write lock; compression and pruning of old segments run in the background.
+     * @param policy The RotationPolicy to apply
+     */
+    void setRotationPolicy(const RotationPolicy& policy);
     /**
      * @brief Enables or disables console output
      * @param enable True to enable console output, false to disable
@@ -125,11 +275,61 @@ public:
     void logData(LogLevel level, const QMap<QString, QVariant>& data, const QString& source = QString(), int line = -1);
 
     /**
-     * @brief Gets the current log level
-     * @return The current log level
+     * @brief Logs a message with typed fields that are resolved only if the record is written
+     * @param level The log level
+     * @param message The log message
+     * @param fields The fields to attach, see LogField
+     * @param source The source function or class name
+     * @param line The line number where the log was called
+     */
+    void logFields(LogLevel level, const QString& message, const QList<LogField>& fields,
+                   const QString& source = QString(), int line = -1);
+
+    /**
+     * @brief Gets the default log level
+     * @return The default log level, ignoring category overrides
      */
     LogLevel getLogLevel() const;
 
+    /**
+     * @brief Checks whether a message at the given level could be emitted
+     *
+     * Lock-free, so the LOG_* macros can call it before evaluating their arguments.
+     * Tests against the most verbose of the default and category levels; the
+     * category and rate-limit filters are applied afterwards in log().
+     * @param level The log level to check
+     * @return True if messages at this level pass the current filter
+     */
+    static bool isEnabled(LogLevel level) {
+        return level >= LOGGER_COMPILED_MIN_LEVEL && level >= m_logLevel.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Gets the current log file encoding
+     * @return The current log format
+     */
+    LogFormat getLogFormat() const;
+
+    /**
+     * @brief Gets the current rotation policy
+     * @return The current rotation policy
+     */
+    RotationPolicy getRotationPolicy() const;
+
+    /**
+     * @brief Gets the category level overrides
+     * @return Map of category to minimum log level
+     */
+    QMap<QString, LogLevel> getCategoryLevels() const;
+
+    /**
+     * @brief Parses a level name such as "debug" or "WARNING"
+     * @param name The level name
+     * @param level Receives the parsed level
+     * @return True if the name was recognised
+     */
+    static bool parseLogLevel(const QString& name, LogLevel* level);
+
     /**
      * @brief Gets the current log file path
      * @return The current log file path
@@ -149,11 +349,40 @@ private:
     static Logger* m_instance;
     QFile m_logFile;
     QTextStream m_logStream;
-    LogLevel m_logLevel;
-    bool m_consoleOutput;
-    QMutex m_mutex;
+    static std::atomic<LogLevel> m_logLevel;   ///< Most verbose of default and category levels
+    LogLevel m_defaultLevel;
+    std::atomic<LogFormat> m_logFormat;
+    std::atomic<bool> m_consoleOutput;
+    mutable QMutex m_mutex;
     QString m_logFilePath;
 
+    // Category and rate-limit filtering, only consulted while m_filtersActive is set
+    struct RateState {
+        qint64 windowStartMs = 0;
+        int emitted = 0;
+        int suppressed = 0;
+    };
+    std::atomic<bool> m_filtersActive;
+    QMap<QString, LogLevel> m_categoryLevels;
+    QHash<QString, LogLevel> m_resolvedLevels;
+    QHash<QPair<QString, int>, RateState> m_rateStates;
+    int m_rateLimitMessages;
+    int m_rateLimitIntervalMs;
+    QElapsedTimer m_rateClock;
+
+    // Rotation state
+    RotationPolicy m_rotationPolicy;
+    qint64 m_logFileSize;
+    qint64 m_nextRotationMs;
+    // Size the file must reach before rotation is retried after a failed rename, 0 normally
+    qint64 m_rotationRetrySize;
+    QThreadPool m_housekeepingPool;
+
+    // Structured format state, reset whenever a new file segment is started
+    QElapsedTimer m_monotonicClock;
+    QHash<QPair<QString, int>, quint32> m_callSites;
+    quint32 m_nextCallSiteId;
+
     /**
      * @brief Converts a LogLevel to its string representation
      * @param level The LogLevel to convert
@@ -169,6 +398,86 @@ private:
      * @return Formatted log message string
      */
     QString formatLogMessage(LogLevel level, const QString& message, const QString& source, int line = -1);
+    /**
+     * @brief Reduces a Q_FUNC_INFO string to a short Class::method form
+     * @param source The raw source string
+     * @return The cleaned-up source name
+     */
+    static QString cleanSourceInfo(const QString& source);
+    /**
+     * @brief Filters, formats and writes a record to the configured outputs
+     * @param level The log level
+     * @param message The log message, may be empty when fields are given
+     * @param fields Typed fields attached to the record, resolved after filtering
+     * @param source The source function or class name
+     * @param line The line number where the log was called
+     */
+    void writeRecord(LogLevel level, const QString& message, const QList<LogField>& fields,
+                     const QString& source, int line);
+    /**
+     * @brief Applies category levels and rate limits to a record that passed isEnabled()
+     * @param level The log level
+     * @param source The source function or class name
+     * @param line The line number where the log was called
+     * @param suppressedCount Receives the number of records dropped at this call site in the previous interval
+     * @return True if the record should be written
+     */
+    bool admitRecord(LogLevel level, const QString& source, int line, int* suppressedCount);
+    /**
+     * @brief Finds the minimum level for a call site from the category overrides
+     * @param source The source function or class name
+     * @return The level of the most specific matching category, or the default level
+     */
+    LogLevel resolveLevel(const QString& source);
+    /**
+     * @brief Recomputes m_logLevel and m_filtersActive after a filter change
+     */
+    void updateEffectiveLevel();
+    /**
+     * @brief Writes a formatted message to the console at the matching Qt message level
+     * @param level The log level
+     * @param formattedMessage The formatted message
+     */
+    void writeToConsole(LogLevel level, const QString& formattedMessage);
+    /**
+     * @brief Opens m_logFilePath in the mode required by the current format
+     * @return True if the file was opened
+     */
+    bool openLogFile();
+    /**
+     * @brief Rotates the log file if the pending write would violate the rotation policy
+     * @param pendingBytes Size of the record about to be written
+     */
+    void rotateIfNeeded(qint64 pendingBytes);
+    /**
+     * @brief Renames the active log file aside and opens a fresh one
+     */
+    void rotateLogFile();
+    /**
+     * @brief Compresses a rotated segment and prunes segments beyond the retention limit
+     *
+     * Runs on m_housekeepingPool, never on a logging thread.
+     * @param rotatedPath The segment that was just rotated out
+     * @param activePath The active log file path, used to find sibling segments
+     * @param policy The policy in effect when the segment was rotated
+     */
+    static void compressAndPrune(const QString& rotatedPath, const QString& activePath, const RotationPolicy& policy);
+    /**
+     * @brief Writes the segment header and resets call-site interning
+     */
+    void writeStructuredHeader();
+    /**
+     * @brief Returns the interned id for a call site, emitting its definition on first use
+     * @param source The source function or class name
+     * @param line The line number
+     * @return The call-site id
+     */
+    quint32 internCallSite(const QString& source, int line);
+    /**
+     * @brief Writes one event record in StructuredFormat
+     */
+    void writeStructuredEvent(LogLevel level, const QString& message, const QMap<QString, QVariant>& fields,
+                              const QString& source, int line);
     /**
      * @brief Writes a message to the log file
      * @param message The formatted message to write
@@ -176,12 +485,46 @@ private:
     void writeToLog(const QString& message);
 };
 
+// Logs at the given level; the message expression is only evaluated when the level is enabled
+#define LOG_AT_LEVEL(level, msg) \
+    do { \
+        if (Logger::isEnabled(level)) { \
+            Logger::instance()->log(level, msg, Q_FUNC_INFO, __LINE__); \
+        } \
+    } while (0)
+
 // Convenience macros with line number
-#define LOG_DEBUG(msg) Logger::instance()->debug(msg, Q_FUNC_INFO, __LINE__)
-#define LOG_INFO(msg) Logger::instance()->info(msg, Q_FUNC_INFO, __LINE__)
-#define LOG_WARNING(msg) Logger::instance()->warning(msg, Q_FUNC_INFO, __LINE__)
-#define LOG_ERROR(msg) Logger::instance()->error(msg, Q_FUNC_INFO, __LINE__)
-#define LOG_FATAL(msg) Logger::instance()->fatal(msg, Q_FUNC_INFO, __LINE__)
+#define LOG_DEBUG(msg) LOG_AT_LEVEL(Logger::Debug, msg)
+#define LOG_INFO(msg) LOG_AT_LEVEL(Logger::Info, msg)
+#define LOG_WARNING(msg) LOG_AT_LEVEL(Logger::Warning, msg)
+#define LOG_ERROR(msg) LOG_AT_LEVEL(Logger::Error, msg)
+#define LOG_FATAL(msg) LOG_AT_LEVEL(Logger::Fatal, msg)
+
+// Emits only every n-th execution of this statement; the message is not evaluated for skipped calls
+#define LOG_SAMPLED(level, n, msg) \
+    do { \
+        static std::atomic<unsigned int> logSampleCounter{0}; \
+        if (Logger::isEnabled(level) && logSampleCounter.fetch_add(1, std::memory_order_relaxed) % (n) == 0) { \
+            Logger::instance()->log(level, QString(msg) + QString(" [sampled 1/%1]").arg(n), Q_FUNC_INFO, __LINE__); \
+        } \
+    } while (0)
+
+#define LOG_DEBUG_SAMPLED(n, msg) LOG_SAMPLED(Logger::Debug, n, msg)
+#define LOG_INFO_SAMPLED(n, msg) LOG_SAMPLED(Logger::Info, n, msg)
+
+// Macro for logging a message with typed fields, e.g.
+// LOG_FIELDS(Logger::Debug, "Validating token", LogField::secret("token", token));
+#define LOG_FIELDS(level, msg, ...) \
+    do { \
+        if (Logger::isEnabled(level)) { \
+            Logger::instance()->logFields(level, msg, QList<LogField>{ __VA_ARGS__ }, Q_FUNC_INFO, __LINE__); \
+        } \
+    } while (0)
 
 // Macro for logging with data
-#define LOG_DATA(level, data) Logger::instance()->logData(level, data, Q_FUNC_INFO, __LINE__)
\ No newline at end of file
+#define LOG_DATA(level, data) \
+    do { \
+        if (Logger::isEnabled(level)) { \
+            Logger::instance()->logData(level, data, Q_FUNC_INFO, __LINE__); \
+        } \
+    } while (0)
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QtGlobal>
+
+/**
+ * @brief Layout of the records written by Logger in StructuredFormat
+ *
+ * A structured log file is a sequence of CBOR maps keyed by small integers.
+ * Every map carries its kind under LogRecord::Kind. A Header record starts each
+ * file segment and resets the call-site table; CallSite records intern a source
+ * location the first time it logs; Event records reference it by id.
+ */
+namespace LogRecord {
+
+constexpr int FormatVersion = 1;
+
+// Common key present in every record
+constexpr int Kind = 0;
+
+enum RecordKind {
+    HeaderRecord = 0,
+    CallSiteRecord = 1,
+    EventRecord = 2
+};
+
+// HeaderRecord keys
+constexpr int HeaderVersion = 1;
+constexpr int HeaderPid = 2;
+constexpr int HeaderWallClockMs = 3;   ///< Epoch milliseconds matching monotonic time 0
+constexpr int HeaderApplication = 4;
+
+// CallSiteRecord keys
+constexpr int CallSiteId = 1;
+constexpr int CallSiteSource = 2;
+constexpr int CallSiteLine = 3;
+
+// EventRecord keys
+constexpr int EventLevel = 1;
+constexpr int EventMonotonicNs = 2;    ///< Nanoseconds since the segment header
+constexpr int EventCallSite = 3;
+constexpr int EventThread = 4;
+constexpr int EventMessage = 5;        ///< Omitted when the record only has fields
+constexpr int EventFields = 6;         ///< Typed key/value map from LOG_DATA
+
+} // namespace LogRecord
@@ -0,0 +1,100 @@
+#include "logger/logger.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <algorithm>
+
+namespace {
+
+bool isSensitiveName(const QString& name) {
+    return name.contains("token", Qt::CaseInsensitive)
+        || name.contains("password", Qt::CaseInsensitive)
+        || name.contains("secret", Qt::CaseInsensitive);
+}
+
+QString formatSqlValue(const QString& name, const QVariant& value) {
+    if (value.isNull()) {
+        return "NULL";
+    }
+    if (isSensitiveName(name)) {
+        return "'" + LogField::redact(value.toString()) + "'";
+    }
+    if (value.typeId() == QMetaType::QString) {
+        return "'" + value.toString() + "'";
+    }
+    if (value.typeId() == QMetaType::QDateTime) {
+        return "'" + value.toDateTime().toUTC().toString(Qt::ISODateWithMs) + "'";
+    }
+    return value.toString();
+}
+
+} // namespace
+
+LogField::LogField(const QString& name, Kind kind)
+    : m_name(name)
+    , m_kind(kind)
+{
+}
+
+LogField LogField::value(const QString& name, const QVariant& value) {
+    LogField field(name, Value);
+    field.m_value = value;
+    return field;
+}
+
+LogField LogField::secret(const QString& name, const QString& secret) {
+    LogField field(name, Secret);
+    field.m_value = secret;
+    return field;
+}
+
+LogField LogField::sql(const QString& name, const QString& query, const QMap<QString, QVariant>& params) {
+    LogField field(name, Sql);
+    field.m_value = query;
+    field.m_params = params;
+    return field;
+}
+
+LogField LogField::lazy(const QString& name, std::function<QVariant()> producer) {
+    LogField field(name, Lazy);
+    field.m_producer = std::move(producer);
+    return field;
+}
+
+QString LogField::redact(const QString& secret) {
+    if (secret.isEmpty()) {
+        return "<empty>";
+    }
+
+    QByteArray digest = QCryptographicHash::hash(secret.toUtf8(), QCryptographicHash::Sha256);
+    return "sha256:" + QString::fromLatin1(digest.toHex().left(12));
+}
+
+QVariant LogField::resolve() const {
+    switch (m_kind) {
+        case Value:
+            return m_value;
+
+        case Secret:
+            return redact(m_value.toString());
+
+        case Sql: {
+            QString query = m_value.toString();
+
+            // Longest names first so ":user" does not clobber ":user_id"
+            QStringList names = m_params.keys();
+            std::sort(names.begin(), names.end(), [](const QString& a, const QString& b) {
+                return a.size() > b.size();
+            });
+
+            for (const QString& paramName : names) {
+                query.replace(":" + paramName, formatSqlValue(paramName, m_params.value(paramName)));
+            }
+            return query;
+        }
+
+        case Lazy:
+            return m_producer ? m_producer() : QVariant();
+    }
+
+    return QVariant();
+}
@@ -1,12 +1,79 @@
 #include "logger/logger.h"
+#include "logger/logrecord.h"
+#include <QCborMap>
+#include <QCborValue>
 #include <QCoreApplication>
 #include <QDir>
 #include <QRegularExpression>
 #include <QStandardPaths>
+#include <QFileInfo>
+
+#ifdef LOGGER_HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 // Initialize static member to nullptr
 Logger* Logger::m_instance = nullptr;
 
+// Kept outside the instance so the LOG_* macros can test it without locking
+std::atomic<Logger::LogLevel> Logger::m_logLevel{Logger::Info};
+
+namespace {
+
+// Timestamp inserted between base name and suffix of rotated segments; sorts chronologically
+const char* const kRotationStampFormat = "yyyyMMdd-hhmmsszzz";
+
+// True if category occurs in source as a whole identifier path, e.g. "SyncManager" in "void SyncManager::sync()"
+bool matchesCategory(const QString& source, const QString& category) {
+    auto isIdentifierChar = [](QChar c) { return c.isLetterOrNumber() || c == '_'; };
+
+    qsizetype from = 0;
+    while ((from = source.indexOf(category, from)) >= 0) {
+        qsizetype end = from + category.size();
+        bool startsAtBoundary = from == 0 || !isIdentifierChar(source.at(from - 1));
+        bool endsAtBoundary = end >= source.size() || !isIdentifierChar(source.at(end));
+        if (startsAtBoundary && endsAtBoundary) {
+            return true;
+        }
+        from = end;
+    }
+    return false;
+}
+
+qint64 nextMidnightMs() {
+    return QDateTime(QDate::currentDate().addDays(1), QTime(0, 0)).toMSecsSinceEpoch();
+}
+
+#ifdef LOGGER_HAVE_ZLIB
+bool gzipFile(const QString& sourcePath, const QString& targetPath) {
+    QFile source(sourcePath);
+    if (!source.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    gzFile target = gzopen(QFile::encodeName(targetPath).constData(), "wb6");
+    if (!target) {
+        return false;
+    }
+
+    bool success = true;
+    while (!source.atEnd()) {
+        QByteArray chunk = source.read(64 * 1024);
+        if (gzwrite(target, chunk.constData(), static_cast<unsigned>(chunk.size())) != chunk.size()) {
+            success = false;
+            break;
+        }
+    }
+
+    if (gzclose(target) != Z_OK) {
+        success = false;
+    }
+    return success;
+}
+#endif
+
+} // namespace
+
 // Use Meyer's singleton pattern with double-checked locking for thread safety
 Logger* Logger::instance() {
     // Use double-checked locking for thread safety
@@ -24,10 +91,23 @@ Logger* Logger::instance() {
 
 Logger::Logger(QObject* parent)
     : QObject(parent)
-    , m_logLevel(Info)
+    , m_defaultLevel(Info)
+    , m_logFormat(TextFormat)
     , m_consoleOutput(true)
     , m_logFilePath("")
+    , m_filtersActive(false)
+    , m_rateLimitMessages(0)
+    , m_rateLimitIntervalMs(1000)
+    , m_logFileSize(0)
+    , m_nextRotationMs(0)
+    , m_rotationRetrySize(0)
+    , m_nextCallSiteId(0)
 {
+    m_rateClock.start();
+
+    // Compression must never compete with the application for more than one core
+    m_housekeepingPool.setMaxThreadCount(1);
+
     // Default log file location
     QString logDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     QDir().mkpath(logDir);
@@ -36,16 +116,14 @@ Logger::Logger(QObject* parent)
     // Instead of calling setLogFile which calls log methods,
     // initialize the file directly
     m_logFilePath = logPath;
-    m_logFile.setFileName(logPath);
-
-    if (m_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-        m_logStream.setDevice(&m_logFile);
-    } else {
+    if (!openLogFile()) {
         qWarning() << "Failed to open log file:" << logPath;
     }
 }
 
 Logger::~Logger() {
+    m_housekeepingPool.waitForDone();
+
     if (m_logFile.isOpen()) {
         m_logStream.flush();
         m_logFile.close();
@@ -55,19 +133,14 @@ Logger::~Logger() {
 void Logger::setLogFile(const QString& filePath) {
     QMutexLocker locker(&m_mutex);
 
-    if (m_logFile.isOpen()) {
-        m_logStream.flush();
-        m_logFile.close();
-    }
-
     m_logFilePath = filePath;
-    m_logFile.setFileName(filePath);
-    bool opened = m_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+    bool opened = openLogFile();
 
     if (opened) {
-        m_logStream.setDevice(&m_logFile);
         // Use direct logging without going through log() to avoid potential recursion
-        writeToLog(formatLogMessage(Info, QString("Log file opened: %1").arg(filePath), ""));
+        if (m_logFormat == TextFormat) {
+            writeToLog(formatLogMessage(Info, QString("Log file opened: %1").arg(filePath), ""));
+        }
     } else {
         qWarning() << "Failed to open log file:" << filePath;
     }
@@ -75,9 +148,88 @@ void Logger::setLogFile(const QString& filePath) {
 
 void Logger::setLogLevel(LogLevel level) {
     QMutexLocker locker(&m_mutex);
-    m_logLevel = level;
+    m_defaultLevel = level;
+    updateEffectiveLevel();
     // Directly log without using log() to avoid potential recursion
-    writeToLog(formatLogMessage(Info, QString("Log level set to: %1").arg(logLevelToString(level)), ""));
+    if (m_logFormat == TextFormat) {
+        writeToLog(formatLogMessage(Info, QString("Log level set to: %1").arg(logLevelToString(level)), ""));
+    }
+}
+
+void Logger::setCategoryLevel(const QString& category, LogLevel level) {
+    QMutexLocker locker(&m_mutex);
+    m_categoryLevels.insert(category, level);
+    updateEffectiveLevel();
+}
+
+bool Logger::setCategoryLevels(const QString& spec) {
+    QMap<QString, LogLevel> categoryLevels;
+    bool valid = true;
+
+    const QStringList entries = spec.split(',', Qt::SkipEmptyParts);
+    for (const QString& entry : entries) {
+        QString category = entry.section('=', 0, 0).trimmed();
+        LogLevel level;
+        if (category.isEmpty() || !parseLogLevel(entry.section('=', 1).trimmed(), &level)) {
+            qWarning() << "Ignoring invalid log category entry:" << entry;
+            valid = false;
+            continue;
+        }
+        categoryLevels.insert(category, level);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_categoryLevels = categoryLevels;
+    updateEffectiveLevel();
+    return valid;
+}
+
+void Logger::clearCategoryLevels() {
+    QMutexLocker locker(&m_mutex);
+    m_categoryLevels.clear();
+    updateEffectiveLevel();
+}
+
+void Logger::setRateLimit(int maxMessages, int intervalMs) {
+    QMutexLocker locker(&m_mutex);
+    m_rateLimitMessages = qMax(0, maxMessages);
+    m_rateLimitIntervalMs = qMax(1, intervalMs);
+    m_rateStates.clear();
+    updateEffectiveLevel();
+}
+
+void Logger::updateEffectiveLevel() {
+    // No need for a mutex here as this is always called from within a locked method
+    LogLevel effective = m_defaultLevel;
+    for (auto it = m_categoryLevels.constBegin(); it != m_categoryLevels.constEnd(); ++it) {
+        effective = qMin(effective, it.value());
+    }
+
+    m_resolvedLevels.clear();
+    m_logLevel.store(effective, std::memory_order_relaxed);
+    m_filtersActive = !m_categoryLevels.isEmpty() || m_rateLimitMessages > 0;
+}
+
+void Logger::setLogFormat(LogFormat format, const QString& filePath) {
+    QMutexLocker locker(&m_mutex);
+    if (m_logFormat == format && (filePath.isEmpty() || filePath == m_logFilePath)) {
+        return;
+    }
+
+    m_logFormat = format;
+    if (!filePath.isEmpty()) {
+        m_logFilePath = filePath;
+    }
+
+    if (!openLogFile()) {
+        qWarning() << "Failed to reopen log file:" << m_logFilePath;
+    }
+}
+
+void Logger::setRotationPolicy(const RotationPolicy& policy) {
+    QMutexLocker locker(&m_mutex);
+    m_rotationPolicy = policy;
+    m_nextRotationMs = policy.daily ? nextMidnightMs() : 0;
 }
 
 bool Logger::enableConsoleOutput(bool enable) {
@@ -108,46 +260,183 @@ void Logger::fatal(const QString& message, const QString& source, int line) {
 
 void Logger::log(LogLevel level, const QString& message, const QString& source, int line) {
     // Only log if level is sufficient
-    if (level < m_logLevel) {
+    if (!isEnabled(level)) {
         return;
     }
 
-    // Create formatted message outside the lock to minimize lock time
-    QString formattedMessage = formatLogMessage(level, message, source, line);
+    writeRecord(level, message, QList<LogField>(), source, line);
+}
+
+void Logger::logData(LogLevel level, const QMap<QString, QVariant>& data, const QString& source, int line) {
+    if (!isEnabled(level)) {
+        return;
+    }
+
+    QList<LogField> fields;
+    fields.reserve(data.size());
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+        fields.append(LogField::value(it.key(), it.value()));
+    }
+
+    writeRecord(level, QString(), fields, source, line);
+}
+
+void Logger::logFields(LogLevel level, const QString& message, const QList<LogField>& fields,
+                       const QString& source, int line) {
+    if (!isEnabled(level)) {
+        return;
+    }
+
+    writeRecord(level, message, fields, source, line);
+}
+
+bool Logger::admitRecord(LogLevel level, const QString& source, int line, int* suppressedCount) {
+    if (!m_filtersActive) {
+        return true;
+    }
 
     QMutexLocker locker(&m_mutex);
-    writeToLog(formattedMessage);
-
-    if (m_consoleOutput) {
-        switch (level) {
-            case Debug:
-                qDebug().noquote() << formattedMessage;
-                break;
-            case Info:
-                qInfo().noquote() << formattedMessage;
-                break;
-            case Warning:
-                qWarning().noquote() << formattedMessage;
-                break;
-            case Error:
-            case Fatal:
-                qCritical().noquote() << formattedMessage;
-                break;
+    if (!m_categoryLevels.isEmpty() && level < resolveLevel(source)) {
+        return false;
+    }
+
+    if (m_rateLimitMessages <= 0 || level >= Warning) {
+        return true;
+    }
+
+    RateState& state = m_rateStates[qMakePair(source, line)];
+    qint64 now = m_rateClock.elapsed();
+    if (state.emitted == 0 || now - state.windowStartMs >= m_rateLimitIntervalMs) {
+        *suppressedCount = state.suppressed;
+        state.windowStartMs = now;
+        state.emitted = 0;
+        state.suppressed = 0;
+    }
+
+    if (state.emitted >= m_rateLimitMessages) {
+        ++state.suppressed;
+        return false;
+    }
+
+    ++state.emitted;
+    return true;
+}
+
+Logger::LogLevel Logger::resolveLevel(const QString& source) {
+    // No need for a mutex here as this is always called from within a locked method
+    auto cached = m_resolvedLevels.constFind(source);
+    if (cached != m_resolvedLevels.constEnd()) {
+        return cached.value();
+    }
+
+    // The longest matching category is the most specific one
+    LogLevel level = m_defaultLevel;
+    qsizetype bestLength = 0;
+    for (auto it = m_categoryLevels.constBegin(); it != m_categoryLevels.constEnd(); ++it) {
+        if (it.key().size() > bestLength && matchesCategory(source, it.key())) {
+            level = it.value();
+            bestLength = it.key().size();
         }
     }
+
+    m_resolvedLevels.insert(source, level);
+    return level;
 }
 
-void Logger::logData(LogLevel level, const QMap<QString, QVariant>& data, const QString& source, int line) {
-    if (level < m_logLevel) {
+void Logger::writeRecord(LogLevel level, const QString& message, const QList<LogField>& fieldList,
+                         const QString& source, int line) {
+    int suppressedCount = 0;
+    if (!admitRecord(level, source, line, &suppressedCount)) {
         return;
     }
 
-    QStringList logParts;
-    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
-        logParts.append(QString("%1: %2").arg(it.key(), it.value().toString()));
+    // Redaction and interpolation happen here, once the record is known to be written
+    QMap<QString, QVariant> fields;
+    for (const LogField& field : fieldList) {
+        fields.insert(field.name(), field.resolve());
+    }
+
+    const QString summary = suppressedCount > 0
+        ? QString("Suppressed %1 similar messages from this call site").arg(suppressedCount)
+        : QString();
+
+    const bool structured = m_logFormat == StructuredFormat;
+    const bool console = m_consoleOutput;
+
+    // Create formatted message outside the lock to minimize lock time
+    QString formattedMessage;
+    if (!structured || console) {
+        QString text = message;
+        if (!fields.isEmpty()) {
+            QStringList logParts;
+            for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) {
+                logParts.append(QString("%1: %2").arg(it.key(), it.value().toString()));
+            }
+            text = message.isEmpty() ? logParts.join(", ") : message + " - " + logParts.join(", ");
+        }
+        formattedMessage = formatLogMessage(level, text, source, line);
+    }
+
+    QString formattedSummary;
+    if (!summary.isEmpty() && (!structured || console)) {
+        formattedSummary = formatLogMessage(level, summary, source, line);
     }
 
-    log(level, logParts.join(", "), source, line);
+    QMutexLocker locker(&m_mutex);
+    if (structured) {
+        if (!summary.isEmpty()) {
+            writeStructuredEvent(level, summary, QMap<QString, QVariant>(), source, line);
+        }
+        writeStructuredEvent(level, message, fields, source, line);
+    } else {
+        if (!formattedSummary.isEmpty()) {
+            writeToLog(formattedSummary);
+        }
+        writeToLog(formattedMessage);
+    }
+
+    if (console) {
+        if (!formattedSummary.isEmpty()) {
+            writeToConsole(level, formattedSummary);
+        }
+        writeToConsole(level, formattedMessage);
+    }
+}
+
+void Logger::writeToConsole(LogLevel level, const QString& formattedMessage) {
+    switch (level) {
+        case Debug:
+            qDebug().noquote() << formattedMessage;
+            break;
+        case Info:
+            qInfo().noquote() << formattedMessage;
+            break;
+        case Warning:
+            qWarning().noquote() << formattedMessage;
+            break;
+        case Error:
+        case Fatal:
+            qCritical().noquote() << formattedMessage;
+            break;
+    }
+}
+
+bool Logger::parseLogLevel(const QString& name, LogLevel* level) {
+    const QString lower = name.trimmed().toLower();
+    if (lower == "debug") {
+        *level = Debug;
+    } else if (lower == "info") {
+        *level = Info;
+    } else if (lower == "warning") {
+        *level = Warning;
+    } else if (lower == "error") {
+        *level = Error;
+    } else if (lower == "fatal") {
+        *level = Fatal;
+    } else {
+        return false;
+    }
+    return true;
 }
 
 QString Logger::logLevelToString(LogLevel level) {
@@ -173,68 +462,296 @@ QString Logger::formatLogMessage(LogLevel level, const QString& message, const Q
         formattedMsg = QString("[%1] [%2] [PID:%3] [TID:%4] %5")
             .arg(timestamp, levelStr, pid, threadId, message);
     } else {
-        // Parse the source string to clean it up
-        QString sourceInfo = source;
+        // Add line number to source info if available
+        QString sourceInfo = cleanSourceInfo(source) + lineStr;
 
-        // First, remove parameters if any
-        int parenPos = source.indexOf('(');
-        if (parenPos > 0) {
-            sourceInfo = source.left(parenPos);
-        }
+        formattedMsg = QString("[%1] [%2] [PID:%3] [TID:%4] [%5] %6")
+            .arg(timestamp, levelStr, pid, threadId, sourceInfo, message);
+    }
 
-        // Case 1: Pattern like "getService<class UserRoleDisciplineModel>"
-        static QRegularExpression templatePattern("([a-zA-Z0-9_]+)<class\\s+([a-zA-Z0-9_]+)>");
-        QRegularExpressionMatch templateMatch = templatePattern.match(sourceInfo);
+    return formattedMsg;
+}
 
-        if (templateMatch.hasMatch()) {
-            // We have a match for the pattern methodName<class ClassName>
-            QString methodName = templateMatch.captured(1);
-            QString className = templateMatch.captured(2);
+QString Logger::cleanSourceInfo(const QString& source) {
+    // Parse the source string to clean it up
+    QString sourceInfo = source;
 
-            // Rearrange to ClassName::methodName format
-            sourceInfo = className + "::" + methodName;
-        }
-        // Case 2: Remove __cdecl and clean up the format
-        else if (sourceInfo.contains("__cdecl")) {
-            // Remove __cdecl
-            sourceInfo = sourceInfo.replace("__cdecl ", "");
-
-            // Special case for constructor patterns like "ClassName::ClassName"
-            if (sourceInfo.contains("::")) {
-                QStringList parts = sourceInfo.split("::");
-                if (parts.size() >= 2 && parts[parts.size()-2] == parts[parts.size()-1]) {
-                    // It's a constructor, keep the format clean
-                    sourceInfo = parts[parts.size()-2] + "::constructor";
-                }
+    // First, remove parameters if any
+    int parenPos = source.indexOf('(');
+    if (parenPos > 0) {
+        sourceInfo = source.left(parenPos);
+    }
+
+    // Case 1: Pattern like "getService<class UserRoleDisciplineModel>"
+    static QRegularExpression templatePattern("([a-zA-Z0-9_]+)<class\\s+([a-zA-Z0-9_]+)>");
+    QRegularExpressionMatch templateMatch = templatePattern.match(sourceInfo);
+
+    if (templateMatch.hasMatch()) {
+        // We have a match for the pattern methodName<class ClassName>
+        QString methodName = templateMatch.captured(1);
+        QString className = templateMatch.captured(2);
+
+        // Rearrange to ClassName::methodName format
+        sourceInfo = className + "::" + methodName;
+    }
+    // Case 2: Remove __cdecl and clean up the format
+    else if (sourceInfo.contains("__cdecl")) {
+        // Remove __cdecl
+        sourceInfo = sourceInfo.replace("__cdecl ", "");
+
+        // Special case for constructor patterns like "ClassName::ClassName"
+        if (sourceInfo.contains("::")) {
+            QStringList parts = sourceInfo.split("::");
+            if (parts.size() >= 2 && parts[parts.size()-2] == parts[parts.size()-1]) {
+                // It's a constructor, keep the format clean
+                sourceInfo = parts[parts.size()-2] + "::constructor";
             }
         }
+    }
 
-        // Add line number to source info if available
-        sourceInfo += lineStr;
+    return sourceInfo;
+}
 
-        formattedMsg = QString("[%1] [%2] [PID:%3] [TID:%4] [%5] %6")
-            .arg(timestamp, levelStr, pid, threadId, sourceInfo, message);
+bool Logger::openLogFile() {
+    // No need for a mutex here as this is always called from within a locked method
+    if (m_logFile.isOpen()) {
+        m_logStream.flush();
+        m_logFile.close();
     }
 
-    return formattedMsg;
+    m_logFile.setFileName(m_logFilePath);
+
+    QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Append;
+    if (m_logFormat == TextFormat) {
+        mode |= QIODevice::Text;
+    }
+
+    if (!m_logFile.open(mode)) {
+        return false;
+    }
+
+    m_logFileSize = m_logFile.size();
+    m_rotationRetrySize = 0;
+    if (m_rotationPolicy.daily) {
+        m_nextRotationMs = nextMidnightMs();
+    }
+
+    if (m_logFormat == TextFormat) {
+        m_logStream.setDevice(&m_logFile);
+    } else {
+        m_logStream.setDevice(nullptr);
+        writeStructuredHeader();
+    }
+    return true;
+}
+
+void Logger::writeStructuredHeader() {
+    m_monotonicClock.start();
+    m_callSites.clear();
+    m_nextCallSiteId = 0;
+
+    QCborMap header;
+    header.insert(LogRecord::Kind, LogRecord::HeaderRecord);
+    header.insert(LogRecord::HeaderVersion, LogRecord::FormatVersion);
+    header.insert(LogRecord::HeaderPid, QCoreApplication::applicationPid());
+    header.insert(LogRecord::HeaderWallClockMs, QDateTime::currentMSecsSinceEpoch());
+    header.insert(LogRecord::HeaderApplication, QCoreApplication::applicationName());
+
+    m_logFileSize += m_logFile.write(header.toCborValue().toCbor());
+    m_logFile.flush();
+}
+
+quint32 Logger::internCallSite(const QString& source, int line) {
+    const QPair<QString, int> key(source, line);
+    auto it = m_callSites.constFind(key);
+    if (it != m_callSites.constEnd()) {
+        return it.value();
+    }
+
+    // The source is cleaned once per call site instead of once per record
+    quint32 id = m_nextCallSiteId++;
+    m_callSites.insert(key, id);
+
+    QCborMap definition;
+    definition.insert(LogRecord::Kind, LogRecord::CallSiteRecord);
+    definition.insert(LogRecord::CallSiteId, id);
+    definition.insert(LogRecord::CallSiteSource, source.isEmpty() ? QString() : cleanSourceInfo(source));
+    definition.insert(LogRecord::CallSiteLine, line);
+
+    m_logFileSize += m_logFile.write(definition.toCborValue().toCbor());
+    return id;
+}
+
+void Logger::writeStructuredEvent(LogLevel level, const QString& message, const QMap<QString, QVariant>& fields,
+                                  const QString& source, int line) {
+    // No need for a mutex here as this is always called from within a locked method
+    if (!m_logFile.isOpen()) {
+        return;
+    }
+
+    // Rotate before interning so a new segment gets its own call-site definitions
+    rotateIfNeeded(message.size() + 32);
+
+    QCborMap event;
+    event.insert(LogRecord::Kind, LogRecord::EventRecord);
+    event.insert(LogRecord::EventLevel, static_cast<int>(level));
+    event.insert(LogRecord::EventMonotonicNs, m_monotonicClock.nsecsElapsed());
+    event.insert(LogRecord::EventCallSite, internCallSite(source, line));
+    event.insert(LogRecord::EventThread, static_cast<qint64>(reinterpret_cast<quintptr>(QThread::currentThreadId())));
+
+    if (!message.isEmpty()) {
+        event.insert(LogRecord::EventMessage, message);
+    }
+
+    if (!fields.isEmpty()) {
+        QCborMap fieldMap;
+        for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) {
+            fieldMap.insert(it.key(), QCborValue::fromVariant(it.value()));
+        }
+        event.insert(LogRecord::EventFields, fieldMap);
+    }
+
+    m_logFileSize += m_logFile.write(event.toCborValue().toCbor());
+    m_logFile.flush();
 }
 
 void Logger::writeToLog(const QString& message) {
     // No need for a mutex here as this is always called from within a locked method
     if (m_logFile.isOpen()) {
+        rotateIfNeeded(message.size() + 1);
+
         m_logStream << message << Qt::endl;
         m_logStream.flush();
+        m_logFileSize += message.size() + 1;
+    }
+}
+
+void Logger::rotateIfNeeded(qint64 pendingBytes) {
+    // No need for a mutex here as this is always called from within a locked method
+    bool sizeExceeded = m_rotationPolicy.maxFileSize > 0
+        && m_logFileSize > 0
+        && m_logFileSize + pendingBytes > qMax(m_rotationPolicy.maxFileSize, m_rotationRetrySize);
+    bool dayChanged = m_rotationPolicy.daily
+        && QDateTime::currentMSecsSinceEpoch() >= m_nextRotationMs;
+
+    if (sizeExceeded || dayChanged) {
+        rotateLogFile();
+    }
+}
+
+void Logger::rotateLogFile() {
+    // No need for a mutex here as this is always called from within a locked method
+    m_logStream.flush();
+    m_logFile.close();
+
+    QFileInfo info(m_logFilePath);
+    // UTC, so local time falling back an hour cannot make the newest segments sort as oldest
+    const QString stamp = QDateTime::currentDateTimeUtc().toString(kRotationStampFormat);
+    QString rotatedPath = info.dir().filePath(QString("%1.%2.%3").arg(info.completeBaseName(), stamp, info.suffix()));
+
+    // Two rotations within one millisecond, or a clock set back, would reuse a name; the
+    // sequence sorts after the plain stamp and is zero-padded so _010 sorts after _002,
+    // keeping retention's name order newest first
+    for (int sequence = 1; QFile::exists(rotatedPath) || QFile::exists(rotatedPath + ".gz"); ++sequence) {
+        rotatedPath = info.dir().filePath(QString("%1.%2_%3.%4")
+            .arg(info.completeBaseName(), stamp, QString("%1").arg(sequence, 3, 10, QChar('0')), info.suffix()));
+    }
+
+    // Rename is atomic on the same volume; if it fails we keep appending to the old file
+    bool renamed = QFile::rename(m_logFilePath, rotatedPath);
+    if (!renamed) {
+        qWarning() << "Failed to rotate log file:" << m_logFilePath;
+    }
+
+    if (!openLogFile()) {
+        qWarning() << "Failed to reopen log file after rotation:" << m_logFilePath;
+        return;
+    }
+
+    // Still the oversized file: retrying on every write would only repeat the warning, so wait
+    // until it grows by another maxFileSize (openLogFile() already moved the daily deadline)
+    if (!renamed) {
+        if (m_rotationPolicy.maxFileSize > 0) {
+            m_rotationRetrySize = m_logFileSize + m_rotationPolicy.maxFileSize;
+        }
+        return;
+    }
+
+    if (m_logFormat == TextFormat) {
+        writeToLog(formatLogMessage(Info, QString("Log file rotated, previous segment: %1").arg(rotatedPath), ""));
+    }
+
+    const QString activePath = m_logFilePath;
+    const RotationPolicy policy = m_rotationPolicy;
+    m_housekeepingPool.start([rotatedPath, activePath, policy]() {
+        compressAndPrune(rotatedPath, activePath, policy);
+    });
+}
+
+void Logger::compressAndPrune(const QString& rotatedPath, const QString& activePath, const RotationPolicy& policy) {
+#ifdef LOGGER_HAVE_ZLIB
+    if (policy.compress) {
+        // Write to a temporary name first so a partially compressed segment is never visible
+        QString compressedPath = rotatedPath + ".gz";
+        QString tempPath = compressedPath + ".tmp";
+        if (gzipFile(rotatedPath, tempPath) && QFile::rename(tempPath, compressedPath)) {
+            QFile::remove(rotatedPath);
+        } else {
+            QFile::remove(tempPath);
+        }
+    }
+#else
+    Q_UNUSED(rotatedPath);
+#endif
+
+    if (policy.maxRetainedFiles <= 0) {
+        return;
+    }
+
+    QFileInfo info(activePath);
+    QRegularExpression segmentPattern(QString("^%1\\.\\d{8}-\\d{9}(_\\d+)?\\.%2(\\.gz)?$")
+        .arg(QRegularExpression::escape(info.completeBaseName()),
+             QRegularExpression::escape(info.suffix())));
+
+    QStringList segments;
+    const QStringList candidates = info.dir().entryList(QStringList() << info.completeBaseName() + ".*",
+                                                        QDir::Files, QDir::Name | QDir::Reversed);
+    for (const QString& name : candidates) {
+        if (segmentPattern.match(name).hasMatch()) {
+            segments.append(name);
+        }
+    }
+
+    // Newest first thanks to the sortable timestamp, drop everything past the limit
+    for (int i = policy.maxRetainedFiles; i < segments.size(); ++i) {
+        QFile::remove(info.dir().filePath(segments.at(i)));
     }
 }
 
 Logger::LogLevel Logger::getLogLevel() const {
-    return m_logLevel;
+    QMutexLocker locker(&m_mutex);
+    return m_defaultLevel;
+}
+
+QMap<QString, Logger::LogLevel> Logger::getCategoryLevels() const {
+    QMutexLocker locker(&m_mutex);
+    return m_categoryLevels;
+}
+
+Logger::RotationPolicy Logger::getRotationPolicy() const {
+    QMutexLocker locker(&m_mutex);
+    return m_rotationPolicy;
+}
+
+Logger::LogFormat Logger::getLogFormat() const {
+    return m_logFormat;
 }
 
 QString Logger::getLogFilePath() const {
+    QMutexLocker locker(&m_mutex);
     return m_logFilePath;
 }
 
 bool Logger::isConsoleOutputEnabled() const {
     return m_consoleOutput;
-}
\ No newline at end of file
+}
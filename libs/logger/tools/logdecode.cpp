@@ -0,0 +1,249 @@
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCborMap>
+#include <QCborStreamReader>
+#include <QCborValue>
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include "logger/logrecord.h"
+
+#ifdef LOGDECODE_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+// Decodes log files written in Logger::StructuredFormat back into text or NDJSON
+
+namespace {
+
+const char* levelName(int level) {
+    static const char* names[] = { "DEBUG", "INFO", "WARNING", "ERROR", "FATAL" };
+    return (level >= 0 && level < 5) ? names[level] : "UNKNOWN";
+}
+
+const QStringList& levelNames() {
+    static const QStringList names = { "debug", "info", "warning", "error", "fatal" };
+    return names;
+}
+
+// -1 for a name that is not a level
+int levelFromName(const QString& name) {
+    return levelNames().indexOf(name.toLower());
+}
+
+bool isGzipped(QFile& file) {
+    return file.peek(2) == QByteArray("\x1f\x8b", 2);
+}
+
+// Rotated segments are gzip-compressed by the logger when it was built with zlib
+bool readGzipped(const QString& path, QByteArray& data, QString& error) {
+#ifdef LOGDECODE_HAVE_ZLIB
+    gzFile source = gzopen(QFile::encodeName(path).constData(), "rb");
+    if (!source) {
+        error = "cannot open compressed file";
+        return false;
+    }
+
+    char chunk[64 * 1024];
+    int read = 0;
+    while ((read = gzread(source, chunk, sizeof(chunk))) > 0) {
+        data.append(chunk, read);
+    }
+
+    // A compressed segment is only renamed into place once complete, so any error is corruption
+    if (read < 0) {
+        int code = Z_OK;
+        error = QString::fromUtf8(gzerror(source, &code));
+        gzclose(source);
+        return false;
+    }
+    gzclose(source);
+    return true;
+#else
+    Q_UNUSED(path);
+    Q_UNUSED(data);
+    error = "file is gzip-compressed and this build has no zlib support; decompress it with gunzip first";
+    return false;
+#endif
+}
+
+struct CallSite {
+    QString source;
+    int line = -1;
+};
+
+struct Segment {
+    qint64 pid = 0;
+    qint64 wallClockMs = 0;
+    QHash<quint32, CallSite> callSites;
+};
+
+QString fieldsToText(const QCborMap& fields) {
+    QStringList parts;
+    for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) {
+        parts.append(QString("%1: %2").arg(it.key().toString(), it.value().toVariant().toString()));
+    }
+    return parts.join(", ");
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tms_logdecode");
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Decode structured Activity Tracker log files");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption jsonOption(QStringList() << "j" << "json",
+                                  QCoreApplication::translate("main", "Write NDJSON instead of text"));
+    parser.addOption(jsonOption);
+
+    QCommandLineOption levelOption(QStringList() << "l" << "level",
+                                   QCoreApplication::translate("main", "Minimum level (debug, info, warning, error, fatal)"),
+                                   QCoreApplication::translate("main", "level"),
+                                   "debug");
+    parser.addOption(levelOption);
+
+    parser.addPositionalArgument("files", QCoreApplication::translate("main", "Structured log files to decode, rotated .gz segments included"));
+    parser.process(app);
+
+    const QStringList files = parser.positionalArguments();
+    if (files.isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    const bool json = parser.isSet(jsonOption);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    int exitCode = 0;
+
+    const int minLevel = levelFromName(parser.value(levelOption));
+    if (minLevel < 0) {
+        err << "Unknown level " << parser.value(levelOption) << "; expected one of: "
+            << levelNames().join(", ") << Qt::endl;
+        return 1;
+    }
+
+    for (const QString& path : files) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            err << "Cannot open " << path << ": " << file.errorString() << Qt::endl;
+            exitCode = 1;
+            continue;
+        }
+
+        QByteArray decompressed;
+        QBuffer decompressedBuffer(&decompressed);
+        QIODevice* device = &file;
+        if (isGzipped(file)) {
+            QString error;
+            if (!readGzipped(path, decompressed, error)) {
+                err << "Cannot decompress " << path << ": " << error << Qt::endl;
+                exitCode = 1;
+                continue;
+            }
+            decompressedBuffer.open(QIODevice::ReadOnly);
+            device = &decompressedBuffer;
+        }
+
+        QCborStreamReader reader(device);
+        Segment segment;
+
+        while (reader.isValid()) {
+            const QCborMap record = QCborValue::fromCbor(reader).toMap();
+            if (reader.lastError() != QCborError::NoError) {
+                break;
+            }
+
+            switch (record.value(LogRecord::Kind).toInteger(-1)) {
+                case LogRecord::HeaderRecord:
+                    segment = Segment();
+                    segment.pid = record.value(LogRecord::HeaderPid).toInteger();
+                    segment.wallClockMs = record.value(LogRecord::HeaderWallClockMs).toInteger();
+                    break;
+
+                case LogRecord::CallSiteRecord: {
+                    CallSite site;
+                    site.source = record.value(LogRecord::CallSiteSource).toString();
+                    site.line = static_cast<int>(record.value(LogRecord::CallSiteLine).toInteger(-1));
+                    segment.callSites.insert(static_cast<quint32>(record.value(LogRecord::CallSiteId).toInteger()), site);
+                    break;
+                }
+
+                case LogRecord::EventRecord: {
+                    const int level = static_cast<int>(record.value(LogRecord::EventLevel).toInteger());
+                    if (level < minLevel) {
+                        break;
+                    }
+
+                    const qint64 monotonicNs = record.value(LogRecord::EventMonotonicNs).toInteger();
+                    const QDateTime timestamp = QDateTime::fromMSecsSinceEpoch(segment.wallClockMs + monotonicNs / 1000000);
+                    const CallSite site = segment.callSites.value(static_cast<quint32>(record.value(LogRecord::EventCallSite).toInteger()));
+                    const qint64 threadId = record.value(LogRecord::EventThread).toInteger();
+                    const QCborMap fields = record.value(LogRecord::EventFields).toMap();
+                    QString message = record.value(LogRecord::EventMessage).toString();
+
+                    if (json) {
+                        QJsonObject object;
+                        object["time"] = timestamp.toString(Qt::ISODateWithMs);
+                        object["level"] = levelName(level);
+                        object["pid"] = segment.pid;
+                        object["tid"] = threadId;
+                        object["source"] = site.source;
+                        object["line"] = site.line;
+                        if (!message.isEmpty()) {
+                            object["message"] = message;
+                        }
+                        if (!fields.isEmpty()) {
+                            object["fields"] = fields.toJsonObject();
+                        }
+                        out << QJsonDocument(object).toJson(QJsonDocument::Compact) << '\n';
+                    } else {
+                        // Same "message - k: v" shape the text logger writes
+                        const QString fieldText = fieldsToText(fields);
+                        if (!fieldText.isEmpty()) {
+                            message = message.isEmpty() ? fieldText : message + " - " + fieldText;
+                        }
+                        QString sourceInfo = site.source;
+                        if (!sourceInfo.isEmpty() && site.line >= 0) {
+                            sourceInfo += QString(":%1").arg(site.line);
+                        }
+                        out << QString("[%1] [%2] [PID:%3] [TID:%4] ")
+                                   .arg(timestamp.toString("yyyy-MM-dd hh:mm:ss.zzz"), levelName(level))
+                                   .arg(segment.pid)
+                                   .arg(threadId);
+                        if (!sourceInfo.isEmpty()) {
+                            out << "[" << sourceInfo << "] ";
+                        }
+                        out << message << '\n';
+                    }
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+
+        // A truncated final record is expected after a crash; anything else is corruption
+        if (reader.lastError() != QCborError::NoError && reader.lastError() != QCborError::EndOfFile) {
+            err << "Stopped decoding " << path << " at offset " << reader.currentOffset()
+                << ": " << reader.lastError().toString() << Qt::endl;
+            exitCode = 1;
+        }
+    }
+
+    out.flush();
+    return exitCode;
+}